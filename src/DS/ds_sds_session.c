@@ -41,7 +41,9 @@
 #include "source/public/oscap_source.h"
 #include "source/xslt_priv.h"
 #include <libgen.h>
+#include <limits.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 struct ds_sds_session {
 	struct oscap_source *source;            ///< Source DataStream raw representation
@@ -51,6 +53,8 @@ struct ds_sds_session {
 	const char *datastream_id;              ///< ID of selected datastream
 	const char *checklist_id;               ///< ID of selected checklist
 	struct oscap_htable *component_sources;	///< oscap_source for parsed components
+	const struct ds_sds_element_range *datastream_range; ///< Position of the selected datastream
+	struct oscap_source *datastream_source; ///< Selected datastream parsed on its own
 };
 
 struct ds_sds_session *ds_sds_session_new_from_source(struct oscap_source *source)
@@ -74,6 +78,7 @@ void ds_sds_session_free(struct ds_sds_session *sds_session)
 			oscap_acquire_cleanup_dir(&(sds_session->temp_dir));
 		}
 		oscap_htable_free(sds_session->component_sources, (oscap_destruct_func) oscap_source_free);
+		oscap_source_free(sds_session->datastream_source);
 		oscap_free(sds_session);
 	}
 }
@@ -85,10 +90,56 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 	session->target_dir = NULL;
 	oscap_htable_free(session->component_sources, (oscap_destruct_func) oscap_source_free);
 	session->component_sources = oscap_htable_new();
+	oscap_source_free(session->datastream_source);
+	session->datastream_source = NULL;
+	session->datastream_range = NULL;
+}
+
+static void ds_sds_session_drop_xml_error(void *arg, const char *msg, xmlParserSeverities severity, xmlTextReaderLocatorPtr locator)
+{
+	// A malformed datastream is parsed again by the DOM parser which
+	// reports the errors, they would be shown twice otherwise.
+}
+
+/*
+ * Index the datastream straight from its serialized form (the file content)
+ * and record where the datastreams and components are. These are parsed
+ * one by one when they are needed, the DOM of the whole datastream isn't
+ * built at all.
+ */
+static struct ds_sds_index *ds_sds_session_index_serialized(struct ds_sds_session *session)
+{
+	const char *buffer;
+	size_t size;
+
+	if (oscap_source_get_serialized_memory(session->source, &buffer, &size) != 0 || size > INT_MAX) {
+		return NULL;
+	}
+	xmlTextReader *reader = xmlReaderForMemory(buffer, size, NULL, NULL, 0);
+	if (reader == NULL) {
+		return NULL;
+	}
+	xmlTextReaderSetErrorHandler(reader, ds_sds_session_drop_xml_error, NULL);
+	struct ds_sds_index *index = ds_sds_index_parse(reader);
+
+	// The index parser stops at the last component, a malformed document
+	// is left to the DOM parser to report.
+	int ret;
+	while ((ret = xmlTextReaderRead(reader)) == 1);
+	xmlFreeTextReader(reader);
+
+	if (index != NULL && (ret != 0 || ds_sds_index_scan(index, buffer, size) != 0)) {
+		ds_sds_index_free(index);
+		index = NULL;
+	}
+	return index;
 }
 
 struct ds_sds_index *ds_sds_session_get_sds_idx(struct ds_sds_session *session)
 {
+	if (session->index == NULL) {
+		session->index = ds_sds_session_index_serialized(session);
+	}
 	if (session->index == NULL) {
 		xmlTextReader *reader = oscap_source_get_xmlTextReader(session->source);
 		if (reader == NULL) {
@@ -100,6 +151,32 @@ struct ds_sds_index *ds_sds_session_get_sds_idx(struct ds_sds_session *session)
 	return session->index;
 }
 
+/*
+ * Returns 1 if the datastream has no index of positions and has to be
+ * loaded as a whole, 0 otherwise. The range is NULL if not found.
+ */
+int ds_sds_session_get_component_range(struct ds_sds_session *session, const char *component_id, const struct ds_sds_element_range **range)
+{
+	struct ds_sds_index *index = ds_sds_session_get_sds_idx(session);
+	if (index == NULL || !ds_sds_index_has_ranges(index)) {
+		return 1;
+	}
+	*range = ds_sds_index_get_component_range(index, component_id);
+	return 0;
+}
+
+struct oscap_source *ds_sds_session_new_range_source(struct ds_sds_session *session, const struct ds_sds_element_range *range, const char *filepath)
+{
+	const char *buffer;
+	size_t size;
+	if (oscap_source_get_serialized_memory(session->source, &buffer, &size) != 0) {
+		return NULL;
+	}
+	struct oscap_source_chunk chunks[4];
+	size_t count = ds_sds_index_get_range_chunks(session->index, range, buffer, chunks);
+	return oscap_source_new_from_chunks(chunks, count, filepath);
+}
+
 static const char *ds_sds_session_get_temp_dir(struct ds_sds_session *session)
 {
 	if (session->temp_dir == NULL) {
@@ -213,8 +290,26 @@ struct oscap_source *ds_sds_session_select_tailoring(struct ds_sds_session *sess
 
 xmlNode *ds_sds_session_get_selected_datastream(struct ds_sds_session *session)
 {
-	xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
-	xmlNode *datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	xmlNode *datastream = NULL;
+	struct ds_sds_index *index = ds_sds_session_get_sds_idx(session);
+
+	if (index != NULL && ds_sds_index_has_ranges(index)) {
+		const struct ds_sds_element_range *range = ds_sds_index_get_datastream_range(index, session->datastream_id);
+		if (range != NULL && range != session->datastream_range) {
+			oscap_source_free(session->datastream_source);
+			session->datastream_source = ds_sds_session_new_range_source(session, range, NULL);
+			session->datastream_range = range;
+		}
+		if (range != NULL && session->datastream_source != NULL) {
+			xmlDoc *doc = oscap_source_get_xmlDoc(session->datastream_source);
+			datastream = doc != NULL ? xmlDocGetRootElement(doc) : NULL;
+		}
+	}
+	else {
+		xmlDoc *doc = oscap_source_get_xmlDoc(session->source);
+		datastream = ds_sds_lookup_datastream_in_collection(doc, session->datastream_id);
+	}
+
 	if (datastream == NULL) {
 		const char* error = session->datastream_id ?
 			oscap_sprintf("Could not find any datastream of id '%s'", session->datastream_id) :
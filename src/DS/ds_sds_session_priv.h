@@ -29,6 +29,7 @@
 #include "common/util.h"
 #include "DS/public/scap_ds.h"
 #include "DS/public/ds_sds_session.h"
+#include "DS/sds_index_priv.h"
 #include <libxml/tree.h>
 
 OSCAP_HIDDEN_START;
@@ -38,6 +39,8 @@ xmlDoc *ds_sds_session_get_xmlDoc(struct ds_sds_session *session);
 int ds_sds_session_register_component_source(struct ds_sds_session *session, const char *relative_filepath, struct oscap_source *component);
 const char *ds_sds_session_get_target_dir(struct ds_sds_session *session);
 struct oscap_htable *ds_sds_session_get_component_sources(struct ds_sds_session *session);
+int ds_sds_session_get_component_range(struct ds_sds_session *session, const char *component_id, const struct ds_sds_element_range **range);
+struct oscap_source *ds_sds_session_new_range_source(struct ds_sds_session *session, const struct ds_sds_element_range *range, const char *filepath);
 
 OSCAP_HIDDEN_END;
 #endif
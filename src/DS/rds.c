@@ -32,6 +32,7 @@
 #include "common/_error.h"
 #include "common/util.h"
 #include "common/list.h"
+#include "common/elements.h"
 
 #include "ds_common.h"
 #include "ds_rds_session.h"
@@ -41,9 +42,11 @@
 #include "source/oscap_source_priv.h"
 
 #include <sys/stat.h>
+#include <ctype.h>
 #include <time.h>
 #include <libgen.h>
 #include <string.h>
+#include <strings.h>
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
@@ -605,11 +608,11 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 		char* asset_id = (char*)xmlGetProp(asset, BAD_CAST "id");
 		ds_rds_add_relationship(doc, relationships, "arfrel:isAbout",
 				"xccdf1", asset_id);
-		xmlFree(asset_id);
 
 		// We deliberately don't act on errors in inject refs as
 		// these aren't fatal errors.
 		ds_rds_report_inject_refs(doc, report, asset_id);
+		xmlFree(asset_id);
 	}
 
 	// 2) the root element is a Benchmark, TestResults are embedded within
@@ -672,9 +675,238 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
-static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources)
+static const char *ds_rds_find_str(const char *data, const char *end, const char *str)
+{
+	const size_t len = strlen(str);
+
+	for (; (size_t)(end - data) >= len; ++data) {
+		if (memcmp(data, str, len) == 0)
+			return data;
+	}
+	return NULL;
+}
+
+static const char *ds_rds_find_last_str(const char *data, const char *end, const char *str)
 {
-	*ret = NULL;
+	const size_t len = strlen(str);
+
+	for (; (size_t)(end - data) >= len; --end) {
+		if (memcmp(end - len, str, len) == 0)
+			return end - len;
+	}
+	return NULL;
+}
+
+/*
+ * Find the root element in a serialized XML document, i.e. the document
+ * without its XML declaration and the comments, processing instructions
+ * and white space around the root element. The length of the element is
+ * stored to `len'. NULL is returned if the document can't be embedded into
+ * another one as it is, i.e. if it is not encoded in UTF-8 or if it has
+ * a DOCTYPE.
+ */
+static const char *ds_rds_find_root_element(const char *data, size_t size, size_t *len)
+{
+	const char *end = data + size;
+
+	// UTF-8 byte order mark
+	if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+		data += 3;
+
+	if (end - data > 5 && memcmp(data, "<?xml", 5) == 0 && isspace((unsigned char)data[5])) {
+		const char *decl_end = ds_rds_find_str(data, end, "?>");
+		if (decl_end == NULL)
+			return NULL;
+
+		// the output is UTF-8, so is the copied document (or its ASCII subset)
+		const char *encoding = ds_rds_find_str(data, decl_end, "encoding");
+		if (encoding != NULL) {
+			encoding += strlen("encoding");
+			while (encoding < decl_end && (isspace((unsigned char)*encoding) || *encoding == '='))
+				++encoding;
+			if (encoding == decl_end || (*encoding != '"' && *encoding != '\''))
+				return NULL;
+
+			const char *value = encoding + 1;
+			const char *quote = memchr(value, *encoding, decl_end - value);
+			if (quote == NULL)
+				return NULL;
+
+			const size_t value_len = quote - value;
+			if (!(value_len == 5 && strncasecmp(value, "UTF-8", 5) == 0) &&
+			    !(value_len == 8 && strncasecmp(value, "US-ASCII", 8) == 0))
+				return NULL;
+		}
+		data = decl_end + 2;
+	}
+
+	// skip comments and processing instructions preceding the root element
+	for (;;) {
+		while (data < end && isspace((unsigned char)*data))
+			++data;
+
+		if (data == end || *data != '<')
+			return NULL;
+
+		if (end - data >= 4 && memcmp(data, "<!--", 4) == 0) {
+			data = ds_rds_find_str(data + 4, end, "-->");
+			if (data == NULL)
+				return NULL;
+			data += 3;
+		}
+		else if (end - data >= 2 && memcmp(data, "<?", 2) == 0) {
+			data = ds_rds_find_str(data + 2, end, "?>");
+			if (data == NULL)
+				return NULL;
+			data += 2;
+		}
+		else if (end - data >= 2 && memcmp(data, "<!", 2) == 0) {
+			// DOCTYPE, entities defined there couldn't be resolved
+			return NULL;
+		}
+		else {
+			break;
+		}
+	}
+
+	// and those following it, they would end up in the content of the parent
+	for (;;) {
+		const char *misc = NULL;
+
+		while (end > data && isspace((unsigned char)end[-1]))
+			--end;
+
+		if (end - data >= 3 && memcmp(end - 3, "-->", 3) == 0) {
+			misc = ds_rds_find_last_str(data, end - 3, "<!--");
+			// a comment doesn't contain "--", it's the end tag of e.g. <a-->
+			if (misc != NULL && ds_rds_find_str(misc + 4, end - 3, "--") != NULL)
+				misc = NULL;
+		}
+		else if (end - data >= 2 && memcmp(end - 2, "?>", 2) == 0) {
+			misc = ds_rds_find_last_str(data, end - 2, "<?");
+			if (misc != NULL && ds_rds_find_str(misc + 2, end - 2, "?>") != NULL)
+				misc = NULL;
+		}
+
+		if (misc == NULL)
+			break;
+		end = misc;
+	}
+
+	*len = end - data;
+	return data;
+}
+
+/*
+ * The DOCTYPE isn't embedded with the root element, so the references to
+ * the entities it declares are replaced by their content.
+ */
+static void ds_rds_substitute_entities(xmlNodePtr node)
+{
+	xmlNodePtr next;
+
+	for (xmlNodePtr child = node->children; child != NULL; child = next) {
+		next = child->next;
+
+		if (child->type == XML_ELEMENT_NODE) {
+			ds_rds_substitute_entities(child);
+			continue;
+		}
+
+		/* children of a reference point to the entity declaration */
+		xmlEntityPtr entity = (xmlEntityPtr) child->children;
+		if (child->type != XML_ENTITY_REF_NODE || entity == NULL || entity->children == NULL)
+			continue;
+
+		xmlNodePtr content = xmlNewDocNode(child->doc, NULL, BAD_CAST "content", NULL);
+		xmlAddChildList(content, xmlDocCopyNodeList(child->doc, entity->children));
+		ds_rds_substitute_entities(content);
+
+		while (content->children != NULL) {
+			xmlNodePtr c = content->children;
+			xmlUnlinkNode(c);
+			xmlAddPrevSibling(child, c);
+		}
+		xmlFreeNode(content);
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+	}
+}
+
+/*
+ * Write the document of given source as the content of the started node.
+ * The serialized root element is copied as it is. Documents which can't
+ * be copied are serialized from their DOM.
+ */
+static int ds_rds_write_source(xmlTextWriterPtr writer, xmlNodePtr parent, struct oscap_source *source)
+{
+	const char *serialized = NULL;
+	char *buffer = NULL;
+	size_t size = 0;
+
+	// The serialized document held by the source is used in place, it is
+	// copied only if the source has none.
+	if (oscap_source_get_serialized_memory(source, &serialized, &size) != 0) {
+		if (oscap_source_get_raw_memory(source, &buffer, &size) != 0)
+			return -1;
+		serialized = buffer;
+	}
+
+	int ret = 0;
+	size_t len = 0;
+	const char *root = ds_rds_find_root_element(serialized, size, &len);
+
+	if (root != NULL) {
+		if (oscap_xml_writer_write_raw(writer, parent, root, len) != 0)
+			ret = -1;
+	}
+	else {
+		xmlDoc *doc = oscap_source_get_xmlDoc(source);
+		if (doc == NULL) {
+			ret = -1;
+		}
+		else {
+			xmlNodePtr root_element = xmlDocGetRootElement(doc);
+			if (doc->intSubset != NULL) {
+				root_element = xmlDocCopyNode(root_element, doc, 1);
+				ds_rds_substitute_entities(root_element);
+			}
+
+			xmlBufferPtr buf = xmlBufferCreate();
+			xmlOutputBufferPtr out = xmlOutputBufferCreateBuffer(buf, NULL);
+
+			xmlNodeDumpOutput(out, doc, root_element, 0, 1, "UTF-8");
+			if (xmlOutputBufferClose(out) < 0 ||
+			    oscap_xml_writer_write_raw(writer, parent,
+					(const char *)xmlBufferContent(buf), xmlBufferLength(buf)) != 0)
+				ret = -1;
+
+			xmlBufferFree(buf);
+			if (root_element != xmlDocGetRootElement(doc))
+				xmlFreeNode(root_element);
+		}
+	}
+
+	free(buffer);
+	return ret;
+}
+
+struct ds_rds_export {
+	struct oscap_source *sds_source;
+	xmlDocPtr xccdf_result_file_doc;
+	struct oscap_htable *oval_result_sources;
+};
+
+/*
+ * The ARF is streamed instead of being built as a whole DOM. The skeleton
+ * document holds the envelope and the small parts (relationships, assets
+ * and XCCDF reports) while the source data stream and the OVAL results
+ * are copied to the output as they were serialized.
+ */
+static int ds_rds_write_arf(xmlTextWriterPtr writer, void *arg)
+{
+	struct ds_rds_export *export = arg;
+	int ret = 0;
 
 	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
 	xmlNodePtr root = xmlNewNode(NULL, BAD_CAST "asset-report-collection");
@@ -697,62 +929,104 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr x
 	xmlNodePtr assets = xmlNewNode(arf_ns, BAD_CAST "assets");
 	xmlAddChild(root, assets);
 
-	xmlNodePtr report_request = xmlNewNode(arf_ns, BAD_CAST "report-request");
-	xmlSetProp(report_request, BAD_CAST "id", BAD_CAST "collection1");
-
-	xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
+	xmlNodePtr reports = xmlNewNode(arf_ns, BAD_CAST "reports");
+	xmlAddChild(root, reports);
 
-	xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
-	xmlNodePtr sds_res_node = NULL;
-	xmlDOMWrapCloneNode(sds_wrap_ctxt, sds_doc, xmlDocGetRootElement(sds_doc),
-			&sds_res_node, doc, NULL, 1, 0);
-	xmlAddChild(arf_content, sds_res_node);
-	xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
-	xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
+	ds_rds_add_xccdf_test_results(doc, reports, export->xccdf_result_file_doc,
+			relationships, assets, "collection1");
 
-	xmlAddChild(report_request, arf_content);
+	if (oscap_xml_writer_start_node(writer, root) != 0)
+		ret = -1;
+	if (oscap_xml_writer_flush_node(writer, relationships) != 0)
+		ret = -1;
 
+	xmlNodePtr report_request = xmlNewNode(arf_ns, BAD_CAST "report-request");
+	xmlSetProp(report_request, BAD_CAST "id", BAD_CAST "collection1");
 	xmlAddChild(report_requests, report_request);
 
-	xmlNodePtr reports = xmlNewNode(arf_ns, BAD_CAST "reports");
+	xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
+	xmlAddChild(report_request, arf_content);
 
-	ds_rds_add_xccdf_test_results(doc, reports, xccdf_result_file_doc,
-			relationships, assets, "collection1");
+	if (oscap_xml_writer_start_node(writer, report_requests) != 0)
+		ret = -1;
+	if (oscap_xml_writer_start_node(writer, report_request) != 0)
+		ret = -1;
+	if (oscap_xml_writer_start_node(writer, arf_content) != 0)
+		ret = -1;
+	if (ds_rds_write_source(writer, arf_content, export->sds_source) != 0)
+		ret = -1;
+	if (oscap_xml_writer_end_node(writer, arf_content) != 0)
+		ret = -1;
+	if (oscap_xml_writer_end_node(writer, report_request) != 0)
+		ret = -1;
+	if (oscap_xml_writer_end_node(writer, report_requests) != 0)
+		ret = -1;
+
+	if (oscap_xml_writer_flush_node(writer, assets) != 0)
+		ret = -1;
+
+	if (oscap_xml_writer_start_node(writer, reports) != 0)
+		ret = -1;
+	while (reports->children != NULL) {
+		if (oscap_xml_writer_flush_node(writer, reports->children) != 0)
+			ret = -1;
+	}
 
 	unsigned int oval_report_suffix = 2;
-	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(oval_result_sources);
-	while (oscap_htable_iterator_has_more(hit)) {
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(export->oval_result_sources);
+	while (ret == 0 && oscap_htable_iterator_has_more(hit)) {
 		struct oscap_source *oval_source = oscap_htable_iterator_next_value(hit);
-		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
 
 		char* report_id = oscap_sprintf("oval%i", oval_report_suffix++);
-		ds_rds_create_report(doc, reports, oval_result_doc, report_id);
+		xmlNodePtr report = xmlNewNode(arf_ns, BAD_CAST "report");
+		xmlSetProp(report, BAD_CAST "id", BAD_CAST report_id);
+		xmlAddChild(reports, report);
 		oscap_free(report_id);
+
+		xmlNodePtr report_content = xmlNewNode(arf_ns, BAD_CAST "content");
+		xmlAddChild(report, report_content);
+
+		if (oscap_xml_writer_start_node(writer, report) != 0)
+			ret = -1;
+		if (oscap_xml_writer_start_node(writer, report_content) != 0)
+			ret = -1;
+		if (ds_rds_write_source(writer, report_content, oval_source) != 0)
+			ret = -1;
+		if (oscap_xml_writer_end_node(writer, report_content) != 0)
+			ret = -1;
+		if (oscap_xml_writer_end_node(writer, report) != 0)
+			ret = -1;
 	}
 	oscap_htable_iterator_free(hit);
 
-	xmlAddChild(root, reports);
+	if (oscap_xml_writer_end_node(writer, reports) != 0)
+		ret = -1;
+	if (oscap_xml_writer_end_node(writer, root) != 0)
+		ret = -1;
 
-	*ret = doc;
-	return 0;
+	xmlFreeDoc(doc);
+	return ret;
 }
 
 struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, const char *target_file)
 {
-	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
-	if (sds_doc == NULL) {
-		return NULL;
-	}
 	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(xccdf_result_source);
 	if (result_file_doc == NULL) {
 		return NULL;
 	}
 
-	xmlDocPtr rds_doc = NULL;
-	if (ds_rds_create_from_dom(&rds_doc, sds_doc, result_file_doc, oval_result_sources) != 0) {
+	struct ds_rds_export export = {
+		.sds_source = sds_source,
+		.xccdf_result_file_doc = result_file_doc,
+		.oval_result_sources = oval_result_sources
+	};
+
+	char *buffer = NULL;
+	size_t size = 0;
+	if (oscap_xml_save_writer_memory(&buffer, &size, ds_rds_write_arf, &export) != 0) {
 		return NULL;
 	}
-	return oscap_source_new_from_xmlDoc(rds_doc, target_file);
+	return oscap_source_new_take_memory(buffer, size, target_file);
 }
 
 int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const char** oval_result_files, const char* target_file)
@@ -191,14 +191,120 @@ static int ds_sds_dump_component_sce(xmlNode *script_node, const char *component
 	}
 }
 
+static bool ds_sds_node_uses_namespace(xmlNodePtr node, xmlNsPtr ns)
+{
+	if (node->ns == ns)
+		return true;
+
+	for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+		if (attr->ns == ns)
+			return true;
+	}
+	return false;
+}
+
+static void ds_sds_node_set_namespace(xmlNodePtr node, xmlNsPtr from, xmlNsPtr to)
+{
+	if (node->ns == from)
+		node->ns = to;
+
+	for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+		if (attr->ns == from)
+			attr->ns = to;
+	}
+}
+
+/*
+ * Declare the namespace on the topmost elements using it, like
+ * xmlDOMWrapCloneNode does for namespaces declared outside of the clone.
+ */
+static void ds_sds_push_namespace(xmlNodePtr node, xmlNsPtr inherited, xmlNsPtr declared)
+{
+	for (; node != NULL; node = node->next) {
+		if (node->type != XML_ELEMENT_NODE)
+			continue;
+
+		xmlNsPtr ns = declared;
+		if (ns == NULL && ds_sds_node_uses_namespace(node, inherited))
+			ns = xmlNewNs(node, inherited->href, inherited->prefix);
+
+		if (ns != NULL)
+			ds_sds_node_set_namespace(node, inherited, ns);
+
+		ds_sds_push_namespace(node->children, inherited, ns);
+	}
+}
+
+/*
+ * A component parsed on its own gets the namespaces declared by the
+ * ancestors in the datastream declared on its root. Move them where they
+ * are used, so that the component is dumped as it was composed.
+ */
+static void ds_sds_move_inherited_namespaces(xmlNodePtr root, size_t count)
+{
+	xmlNsPtr used = NULL;
+	xmlNsPtr *used_tail = &used;
+
+	for (size_t i = 0; i < count && root->nsDef != NULL; ++i) {
+		xmlNsPtr inherited = root->nsDef;
+		root->nsDef = inherited->next;
+		inherited->next = NULL;
+
+		if (ds_sds_node_uses_namespace(root, inherited)) {
+			*used_tail = inherited;
+			used_tail = &inherited->next;
+		}
+		else {
+			ds_sds_push_namespace(root->children, inherited, NULL);
+			xmlFreeNs(inherited);
+		}
+	}
+
+	// The namespaces used by the root follow its own declarations.
+	xmlNsPtr *tail = &root->nsDef;
+	while (*tail != NULL)
+		tail = &(*tail)->next;
+	*tail = used;
+}
+
 static int ds_sds_dump_component(const char* component_id, struct ds_sds_session *session, const char* filename, const char *relative_filepath)
 {
-	xmlDoc *doc = ds_sds_session_get_xmlDoc(session);
-	xmlNodePtr component = _lookup_component_in_collection(doc, component_id);
+	xmlDoc *doc = NULL;
+	xmlNodePtr component = NULL;
+	struct oscap_source *component_source = NULL;
+	const struct ds_sds_element_range *range = NULL;
+
+	if (ds_sds_session_get_component_range(session, component_id, &range) == 0) {
+		if (range != NULL && range->content != NULL && strcmp(range->content->name, "script") != 0) {
+			// The component is parsed straight from the serialized datastream,
+			// the datastream doesn't have to be loaded.
+			struct oscap_source *source = ds_sds_session_new_range_source(session, range->content, relative_filepath);
+			xmlDoc *component_doc = source != NULL ? oscap_source_get_xmlDoc(source) : NULL;
+			if (component_doc == NULL) {
+				oscap_source_free(source);
+				return -1;
+			}
+			ds_sds_move_inherited_namespaces(xmlDocGetRootElement(component_doc), range->content->namespace_count);
+			ds_sds_session_register_component_source(session, relative_filepath, source);
+			return 0;
+		}
+		if (range != NULL) {
+			component_source = ds_sds_session_new_range_source(session, range, NULL);
+			doc = component_source != NULL ? oscap_source_get_xmlDoc(component_source) : NULL;
+			component = doc != NULL ? xmlDocGetRootElement(doc) : NULL;
+		}
+	}
+	else {
+		doc = ds_sds_session_get_xmlDoc(session);
+		component = _lookup_component_in_collection(doc, component_id);
+	}
+
+	int ret = 0;
 	if (component == NULL)
 	{
 		oscap_seterr(OSCAP_EFAMILY_XML, "Component of given id '%s' was not found in the document.", component_id);
-		return -1;
+		ret = -1;
+		goto cleanup;
 	}
 
 	xmlNodePtr inner_root = node_get_child_element(component, NULL);
@@ -206,15 +312,13 @@ static int ds_sds_dump_component(const char* component_id, struct ds_sds_session
 	if (inner_root == NULL)
 	{
 		oscap_seterr(OSCAP_EFAMILY_XML, "Found component (id='%s') but it has no element contents, nothing to dump, skipping...", component_id);
-		return -1;
+		ret = -1;
+		goto cleanup;
 	}
 
 	// If the inner root is script, we have to treat it in a special way
 	if (strcmp((const char*)inner_root->name, "script") == 0) {
-		int ret = ds_sds_dump_component_sce(inner_root->children, component_id, filename);
-		if (ret != 0) {
-			return ret;
-		}
+		ret = ds_sds_dump_component_sce(inner_root->children, component_id, filename);
 	}
 	// Otherwise we create a new XML doc we will dump the contents to.
 	// We can't just dump node "innerXML" because namespaces have to be
@@ -222,13 +326,16 @@ static int ds_sds_dump_component(const char* component_id, struct ds_sds_session
 	else {
 		xmlDoc *new_doc = ds_doc_from_foreign_node(inner_root, doc);
 		if (new_doc == NULL) {
-			return -1;
+			ret = -1;
+			goto cleanup;
 		}
 		struct oscap_source *source = oscap_source_new_from_xmlDoc(new_doc, relative_filepath);
 		ds_sds_session_register_component_source(session, relative_filepath, source);
 	}
 
-	return 0;
+cleanup:
+	oscap_source_free(component_source);
+	return ret;
 }
 
 int ds_sds_dump_component_ref_as(xmlNodePtr component_ref, struct ds_sds_session *session, const char* target_dir, const char* relative_filepath)
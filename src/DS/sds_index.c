@@ -34,7 +34,9 @@
 #include "source/public/oscap_source.h"
 
 #include <libxml/xmlreader.h>
+#include <ctype.h>
 #include <string.h>
+#include <strings.h>
 
 struct ds_stream_index
 {
@@ -216,6 +218,11 @@ struct ds_sds_index
 	struct oscap_list *streams;
 
 	struct oscap_htable *benchmark_id_to_component_id;
+
+	// filled by ds_sds_index_scan, NULL otherwise
+	struct oscap_list *datastream_ranges;
+	struct oscap_htable *component_ranges;
+	size_t declaration_size;
 };
 
 struct ds_sds_index* ds_sds_index_new(void)
@@ -225,9 +232,24 @@ struct ds_sds_index* ds_sds_index_new(void)
 
 	ret->benchmark_id_to_component_id = oscap_htable_new();
 
+	ret->datastream_ranges = NULL;
+	ret->component_ranges = NULL;
+	ret->declaration_size = 0;
+
 	return ret;
 }
 
+static void ds_sds_element_range_free(struct ds_sds_element_range *range)
+{
+	if (range != NULL) {
+		oscap_free(range->id);
+		oscap_free(range->name);
+		oscap_free(range->namespaces);
+		ds_sds_element_range_free(range->content);
+		oscap_free(range);
+	}
+}
+
 void ds_sds_index_free(struct ds_sds_index* s)
 {
 	if (s != NULL) {
@@ -235,6 +257,9 @@ void ds_sds_index_free(struct ds_sds_index* s)
 
 		oscap_htable_free(s->benchmark_id_to_component_id, (oscap_destruct_func)oscap_free);
 
+		oscap_list_free(s->datastream_ranges, (oscap_destruct_func)ds_sds_element_range_free);
+		oscap_htable_free(s->component_ranges, (oscap_destruct_func)ds_sds_element_range_free);
+
 		oscap_free(s);
 	}
 }
@@ -518,3 +543,420 @@ void ds_stream_index_iterator_free(struct ds_stream_index_iterator *it)
 {
 	oscap_iterator_free((struct oscap_iterator*)it);
 }
+
+/*
+ * The scanner below only looks for the boundaries of elements and for
+ * the namespace declarations in their start tags, the rest of the document
+ * is skipped. Well-formedness isn't checked, that is left to the parser
+ * which reads the elements later.
+ */
+struct ds_sds_xmlns {
+	const char *prefix;
+	size_t prefix_len;
+	const char *decl;     // the whole xmlns:prefix="uri" attribute
+	size_t decl_len;
+};
+
+struct ds_sds_tag {
+	const char *name;
+	size_t name_len;
+	const char *id;
+	size_t id_len;
+	struct ds_sds_xmlns *xmlns;
+	size_t xmlns_count;
+	size_t xmlns_alloc;
+	bool empty;           // <name/>
+};
+
+static const char *ds_sds_scan_find(const char *p, const char *end, const char *str)
+{
+	const size_t len = strlen(str);
+
+	for (; (size_t)(end - p) >= len; ++p) {
+		if (memcmp(p, str, len) == 0)
+			return p;
+	}
+	return NULL;
+}
+
+static bool ds_sds_scan_starts(const char *p, const char *end, const char *str)
+{
+	const size_t len = strlen(str);
+	return (size_t)(end - p) >= len && memcmp(p, str, len) == 0;
+}
+
+static const char *ds_sds_scan_space(const char *p, const char *end)
+{
+	while (p < end && isspace((unsigned char)*p))
+		++p;
+	return p;
+}
+
+/* Read the start tag at p, return the position right after it or NULL. */
+static const char *ds_sds_scan_start_tag(const char *p, const char *end, struct ds_sds_tag *tag)
+{
+	tag->id = NULL;
+	tag->id_len = 0;
+	tag->xmlns_count = 0;
+	tag->empty = false;
+
+	tag->name = ++p;
+	while (p < end && !isspace((unsigned char)*p) && *p != '/' && *p != '>')
+		++p;
+	tag->name_len = p - tag->name;
+
+	for (;;) {
+		p = ds_sds_scan_space(p, end);
+		if (p == end)
+			return NULL;
+
+		if (*p == '>')
+			return p + 1;
+
+		if (*p == '/') {
+			if (p + 1 == end || p[1] != '>')
+				return NULL;
+			tag->empty = true;
+			return p + 2;
+		}
+
+		const char *attr = p;
+		while (p < end && !isspace((unsigned char)*p) && *p != '=' && *p != '/' && *p != '>')
+			++p;
+		const size_t attr_len = p - attr;
+
+		p = ds_sds_scan_space(p, end);
+		if (p == end || *p != '=')
+			return NULL;
+		p = ds_sds_scan_space(p + 1, end);
+		if (p == end || (*p != '"' && *p != '\''))
+			return NULL;
+
+		const char *value = p + 1;
+		const char *quote = memchr(value, *p, end - value);
+		if (quote == NULL)
+			return NULL;
+		p = quote + 1;
+
+		if (attr_len >= 5 && memcmp(attr, "xmlns", 5) == 0 && (attr_len == 5 || attr[5] == ':')) {
+			if (tag->xmlns_count == tag->xmlns_alloc) {
+				tag->xmlns_alloc = tag->xmlns_alloc > 0 ? 2 * tag->xmlns_alloc : 16;
+				tag->xmlns = oscap_realloc(tag->xmlns, tag->xmlns_alloc * sizeof(struct ds_sds_xmlns));
+			}
+			struct ds_sds_xmlns *ns = &tag->xmlns[tag->xmlns_count++];
+			ns->prefix = attr_len > 5 ? attr + 6 : attr + 5;
+			ns->prefix_len = attr_len > 5 ? attr_len - 6 : 0;
+			ns->decl = attr;
+			ns->decl_len = p - attr;
+		}
+		else if (attr_len == 2 && memcmp(attr, "id", 2) == 0) {
+			tag->id = value;
+			tag->id_len = quote - value;
+		}
+	}
+}
+
+static bool ds_sds_tag_declares(const struct ds_sds_tag *tag, const struct ds_sds_xmlns *ns)
+{
+	for (size_t i = 0; i < tag->xmlns_count; ++i) {
+		if (tag->xmlns[i].prefix_len == ns->prefix_len &&
+		    memcmp(tag->xmlns[i].prefix, ns->prefix, ns->prefix_len) == 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Declarations of the namespaces which are in scope of the element but
+ * declared by its ancestors (the nearest ancestor comes first). These are
+ * added to the start tag when the element is parsed on its own.
+ */
+static char *ds_sds_scan_inherited_namespaces(const struct ds_sds_tag *tag, const struct ds_sds_tag **ancestors, size_t count, size_t *decl_count)
+{
+	char *ret = NULL;
+	size_t len = 0;
+
+	*decl_count = 0;
+
+	for (int pass = 0; pass < 2; ++pass) {
+		size_t pos = 0;
+
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t j = 0; j < ancestors[i]->xmlns_count; ++j) {
+				const struct ds_sds_xmlns *ns = &ancestors[i]->xmlns[j];
+
+				bool shadowed = ds_sds_tag_declares(tag, ns);
+				for (size_t k = 0; k < i && !shadowed; ++k)
+					shadowed = ds_sds_tag_declares(ancestors[k], ns);
+				if (shadowed)
+					continue;
+
+				if (ret != NULL) {
+					ret[pos] = ' ';
+					memcpy(ret + pos + 1, ns->decl, ns->decl_len);
+					++*decl_count;
+				}
+				pos += ns->decl_len + 1;
+			}
+		}
+
+		if (ret == NULL) {
+			len = pos;
+			ret = oscap_alloc(len + 1);
+		}
+	}
+
+	ret[len] = '\0';
+	return ret;
+}
+
+static struct ds_sds_element_range *ds_sds_element_range_new(const char *buffer, const char *start,
+		const struct ds_sds_tag *tag, const struct ds_sds_tag **ancestors, size_t count)
+{
+	struct ds_sds_element_range *range = oscap_calloc(1, sizeof(struct ds_sds_element_range));
+
+	const char *local_name = memchr(tag->name, ':', tag->name_len);
+	local_name = local_name != NULL ? local_name + 1 : tag->name;
+
+	range->id = tag->id != NULL ? strndup(tag->id, tag->id_len) : NULL;
+	range->name = strndup(local_name, tag->name + tag->name_len - local_name);
+	range->offset = start - buffer;
+	range->name_end = tag->name + tag->name_len - buffer;
+	range->namespaces = ds_sds_scan_inherited_namespaces(tag, ancestors, count, &range->namespace_count);
+	return range;
+}
+
+static void ds_sds_index_add_range(struct oscap_list *datastreams, struct oscap_htable *components,
+		struct ds_sds_element_range *range)
+{
+	if (range->id != NULL && strcmp(range->name, "data-stream") == 0) {
+		oscap_list_add(datastreams, range);
+	}
+	else if (range->id != NULL &&
+	         (strcmp(range->name, "component") == 0 || strcmp(range->name, "extended-component") == 0) &&
+	         oscap_htable_add(components, range->id, range)) {
+		// the first component of given ID is used, as in the DOM
+	}
+	else {
+		ds_sds_element_range_free(range);
+	}
+}
+
+int ds_sds_index_scan(struct ds_sds_index *s, const char *buffer, size_t size)
+{
+	const char *p = buffer;
+	const char *end = buffer + size;
+
+	// UTF-8 byte order mark and the XML declaration are kept, they are
+	// passed to the parser together with any element of the document.
+	if (ds_sds_scan_starts(p, end, "\xEF\xBB\xBF"))
+		p += 3;
+	if (ds_sds_scan_starts(p, end, "<?xml") && p + 5 < end && isspace((unsigned char)p[5])) {
+		const char *decl_end = ds_sds_scan_find(p, end, "?>");
+		if (decl_end == NULL)
+			return -1;
+
+		// The scanner matches the markup byte by byte, it can't read
+		// documents in other encodings than UTF-8 (or its ASCII subset).
+		const char *encoding = ds_sds_scan_find(p, decl_end, "encoding");
+		if (encoding != NULL) {
+			encoding += strlen("encoding");
+			while (encoding < decl_end && (isspace((unsigned char)*encoding) || *encoding == '='))
+				++encoding;
+			if (encoding == decl_end || (*encoding != '"' && *encoding != '\''))
+				return -1;
+
+			const char *value = encoding + 1;
+			const char *quote = memchr(value, *encoding, decl_end - value);
+			if (quote == NULL)
+				return -1;
+
+			const size_t value_len = quote - value;
+			if (!(value_len == 5 && strncasecmp(value, "UTF-8", 5) == 0) &&
+			    !(value_len == 8 && strncasecmp(value, "US-ASCII", 8) == 0))
+				return -1;
+		}
+		p = decl_end + 2;
+	}
+	const size_t declaration_size = p - buffer;
+
+	for (;;) {
+		p = ds_sds_scan_space(p, end);
+		if (ds_sds_scan_starts(p, end, "<!--")) {
+			p = ds_sds_scan_find(p + 4, end, "-->");
+			if (p == NULL)
+				return -1;
+			p += 3;
+		}
+		else if (ds_sds_scan_starts(p, end, "<?")) {
+			p = ds_sds_scan_find(p + 2, end, "?>");
+			if (p == NULL)
+				return -1;
+			p += 2;
+		}
+		else {
+			break;
+		}
+	}
+
+	// DOCTYPE: entities declared there couldn't be resolved in the parts
+	if (p == end || *p != '<' || ds_sds_scan_starts(p, end, "<!"))
+		return -1;
+
+	struct ds_sds_tag root = { 0 }, top = { 0 }, tag = { 0 };
+	struct oscap_list *datastreams = oscap_list_new();
+	struct oscap_htable *components = oscap_htable_new();
+	struct ds_sds_element_range *top_range = NULL;
+	bool content_open = false;
+	int ret = -1;
+
+	p = ds_sds_scan_start_tag(p, end, &root);
+	int depth = (p == NULL || root.empty) ? 0 : 1;
+
+	while (depth > 0) {
+		p = memchr(p, '<', end - p);
+		if (p == NULL)
+			break;
+
+		if (ds_sds_scan_starts(p, end, "<!--")) {
+			p = ds_sds_scan_find(p + 4, end, "-->");
+			if (p == NULL)
+				break;
+			p += 3;
+		}
+		else if (ds_sds_scan_starts(p, end, "<![CDATA[")) {
+			p = ds_sds_scan_find(p + 9, end, "]]>");
+			if (p == NULL)
+				break;
+			p += 3;
+		}
+		else if (ds_sds_scan_starts(p, end, "<?")) {
+			p = ds_sds_scan_find(p + 2, end, "?>");
+			if (p == NULL)
+				break;
+			p += 2;
+		}
+		else if (ds_sds_scan_starts(p, end, "<!")) {
+			break;
+		}
+		else if (ds_sds_scan_starts(p, end, "</")) {
+			p = memchr(p, '>', end - p);
+			if (p == NULL)
+				break;
+			p += 1;
+
+			if (depth == 3 && content_open) {
+				top_range->content->size = (p - buffer) - top_range->content->offset;
+				content_open = false;
+			}
+			else if (depth == 2 && top_range != NULL) {
+				top_range->size = (p - buffer) - top_range->offset;
+				ds_sds_index_add_range(datastreams, components, top_range);
+				top_range = NULL;
+			}
+
+			if (--depth == 0)
+				ret = 0;
+		}
+		else if (depth == 1) {
+			const char *start = p;
+			p = ds_sds_scan_start_tag(p, end, &top);
+			if (p == NULL)
+				break;
+
+			const struct ds_sds_tag *ancestors[] = { &root };
+			top_range = ds_sds_element_range_new(buffer, start, &top, ancestors, 1);
+
+			if (top.empty) {
+				top_range->size = (p - buffer) - top_range->offset;
+				ds_sds_index_add_range(datastreams, components, top_range);
+				top_range = NULL;
+			}
+			else {
+				depth = 2;
+			}
+		}
+		else {
+			const char *start = p;
+			p = ds_sds_scan_start_tag(p, end, &tag);
+			if (p == NULL)
+				break;
+
+			if (depth == 2 && top_range != NULL && top_range->content == NULL) {
+				const struct ds_sds_tag *ancestors[] = { &top, &root };
+				top_range->content = ds_sds_element_range_new(buffer, start, &tag, ancestors, 2);
+				if (tag.empty)
+					top_range->content->size = (p - buffer) - top_range->content->offset;
+				else
+					content_open = true;
+			}
+
+			if (!tag.empty)
+				++depth;
+		}
+	}
+
+	ds_sds_element_range_free(top_range);
+	oscap_free(root.xmlns);
+	oscap_free(top.xmlns);
+	oscap_free(tag.xmlns);
+
+	if (ret != 0) {
+		oscap_list_free(datastreams, (oscap_destruct_func)ds_sds_element_range_free);
+		oscap_htable_free(components, (oscap_destruct_func)ds_sds_element_range_free);
+		return -1;
+	}
+
+	oscap_list_free(s->datastream_ranges, (oscap_destruct_func)ds_sds_element_range_free);
+	oscap_htable_free(s->component_ranges, (oscap_destruct_func)ds_sds_element_range_free);
+	s->datastream_ranges = datastreams;
+	s->component_ranges = components;
+	s->declaration_size = declaration_size;
+	return 0;
+}
+
+bool ds_sds_index_has_ranges(struct ds_sds_index *s)
+{
+	return s->component_ranges != NULL;
+}
+
+const struct ds_sds_element_range *ds_sds_index_get_datastream_range(struct ds_sds_index *s, const char *datastream_id)
+{
+	if (s->datastream_ranges == NULL)
+		return NULL;
+
+	const struct ds_sds_element_range *ret = NULL;
+	struct oscap_iterator *it = oscap_iterator_new(s->datastream_ranges);
+	while (oscap_iterator_has_more(it)) {
+		const struct ds_sds_element_range *range = oscap_iterator_next(it);
+		if (datastream_id == NULL || strcmp(range->id, datastream_id) == 0) {
+			ret = range;
+			break;
+		}
+	}
+	oscap_iterator_free(it);
+
+	return ret;
+}
+
+const struct ds_sds_element_range *ds_sds_index_get_component_range(struct ds_sds_index *s, const char *component_id)
+{
+	if (s->component_ranges == NULL)
+		return NULL;
+
+	return oscap_htable_get(s->component_ranges, component_id);
+}
+
+size_t ds_sds_index_get_range_chunks(struct ds_sds_index *s, const struct ds_sds_element_range *range,
+		const char *buffer, struct oscap_source_chunk *chunks)
+{
+	chunks[0].data = buffer;
+	chunks[0].size = s->declaration_size;
+	chunks[1].data = buffer + range->offset;
+	chunks[1].size = range->name_end - range->offset;
+	chunks[2].data = range->namespaces;
+	chunks[2].size = strlen(range->namespaces);
+	chunks[3].data = buffer + range->name_end;
+	chunks[3].size = range->offset + range->size - range->name_end;
+	return 4;
+}
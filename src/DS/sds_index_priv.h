@@ -28,11 +28,53 @@
 #include "common/public/oscap.h"
 #include "common/util.h"
 #include "DS/public/scap_ds.h"
+#include "source/oscap_source_priv.h"
 #include <libxml/xmlreader.h>
 
 OSCAP_HIDDEN_START;
 
 struct ds_sds_index* ds_sds_index_parse(xmlTextReaderPtr reader);
 
+/// Position of an element in a serialized source data stream
+struct ds_sds_element_range {
+	char *id;                                ///< @id of the element
+	char *name;                              ///< local name of the element
+	size_t offset;                           ///< offset of the start tag
+	size_t size;                             ///< size of the element including its end tag
+	size_t name_end;                         ///< offset right after the name in the start tag
+	char *namespaces;                        ///< declarations of the namespaces inherited from the ancestors
+	size_t namespace_count;                  ///< number of the inherited declarations
+	struct ds_sds_element_range *content;    ///< the first child element or NULL
+};
+
+/**
+ * Record the positions of data streams and components in the serialized
+ * data stream collection the index was parsed from. The document is only
+ * scanned, elements at the positions can be parsed separately later.
+ * Documents encoded in other encodings than UTF-8 and documents with
+ * a DOCTYPE can't be split this way.
+ * @return 0 on success, -1 if the document can't be split this way
+ */
+int ds_sds_index_scan(struct ds_sds_index *s, const char *buffer, size_t size);
+
+/// @return position of the data stream of given ID (NULL for the first one) or NULL
+const struct ds_sds_element_range *ds_sds_index_get_datastream_range(struct ds_sds_index *s, const char *datastream_id);
+/// @return position of the (extended) component of given ID or NULL
+const struct ds_sds_element_range *ds_sds_index_get_component_range(struct ds_sds_index *s, const char *component_id);
+/// @return true if the index holds positions recorded by ds_sds_index_scan()
+bool ds_sds_index_has_ranges(struct ds_sds_index *s);
+
+/**
+ * Split an element of the serialized data stream collection to pieces which
+ * make it a standalone document: the XML declaration, the start of the start
+ * tag, the inherited namespace declarations and the rest of the element.
+ * The inherited declarations come first in the nsDef list of the parsed
+ * element.
+ * @param chunks room for 4 pieces
+ * @return number of the pieces
+ */
+size_t ds_sds_index_get_range_chunks(struct ds_sds_index *s, const struct ds_sds_element_range *range,
+		const char *buffer, struct oscap_source_chunk *chunks);
+
 OSCAP_HIDDEN_END;
 #endif
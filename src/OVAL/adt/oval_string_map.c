@@ -191,7 +191,7 @@ void oval_string_map_free_string(struct oval_string_map *map)
 {
 	oval_string_map_free(map, oscap_free);
 }
-#else
+#elif defined(OVAL_STRINGMAP_RBT)
 # include <rbt/rbt.h>
 # include <assume.h>
 
@@ -330,4 +330,352 @@ struct oval_collection *oval_string_map_collect_values(struct oval_string_map *m
 	return (collection);
 }
 
-#endif /* OVAL_STRINGMAP_LINEAR */
+#else
+# include <stdint.h>
+# include <stdbool.h>
+# include <pthread.h>
+# include <assume.h>
+
+/*
+ * Open addressing table with linear probing. The slots only hold the hash
+ * of the key and an index to the entry array, so a probe sequence rarely
+ * leaves a cache line and the keys are compared only when the hashes
+ * match. Entries are stored in the order of insertion and the keys are
+ * copied into chunks which are freed together with the map. Sorted order,
+ * which the iterators guarantee, is provided by an array of pointers to the
+ * entries sorted by the first iterator created after an insertion and shared
+ * by the following ones. Iterators of a map which is no longer filled can
+ * be created concurrently; the array is published by a compare-and-swap,
+ * or under a mutex when the atomic builtins aren't available.
+ */
+#define OVAL_STRING_MAP_MINSLOTS 16
+#define OVAL_STRING_MAP_CHUNKSIZE 8192
+
+struct _oval_string_map_slot {
+	uint32_t hash;
+	uint32_t index; /* entry index + 1, 0 marks an empty slot */
+};
+
+struct _oval_string_map_entry {
+	const char *key;
+	void *val;
+};
+
+struct _oval_string_map_chunk {
+	struct _oval_string_map_chunk *next;
+	size_t used;
+	size_t size;
+	char data[];
+};
+
+struct oval_string_map {
+	struct _oval_string_map_slot *slots;
+	size_t mask;	/* number of slots - 1 */
+	struct _oval_string_map_entry *entries;
+	size_t count;
+	size_t alloc;
+	struct _oval_string_map_chunk *chunks;
+	struct _oval_string_map_entry **sorted; /* sorted entries, NULL if not built yet */
+};
+
+static inline uint32_t _oval_string_map_hash(const char *key)
+{
+	uint32_t h = UINT32_C(2166136261);
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)key; *p != '\0'; p++) {
+		h ^= *p;
+		h *= UINT32_C(16777619);
+	}
+
+	h ^= h >> 16;
+	h *= UINT32_C(0x85ebca6b);
+	h ^= h >> 13;
+
+	return (h);
+}
+
+struct oval_string_map *oval_string_map_new(void)
+{
+	struct oval_string_map *map = oscap_talloc(struct oval_string_map);
+
+	map->slots = oscap_calloc(OVAL_STRING_MAP_MINSLOTS, sizeof(struct _oval_string_map_slot));
+	map->mask = OVAL_STRING_MAP_MINSLOTS - 1;
+	map->entries = NULL;
+	map->count = 0;
+	map->alloc = 0;
+	map->chunks = NULL;
+	map->sorted = NULL;
+
+	return (map);
+}
+
+static const char *_oval_string_map_key_copy(struct oval_string_map *map, const char *key)
+{
+	struct _oval_string_map_chunk *chunk = map->chunks;
+	size_t len = strlen(key) + 1;
+	char *copy;
+
+	if (chunk == NULL || chunk->size - chunk->used < len) {
+		size_t size = len > OVAL_STRING_MAP_CHUNKSIZE / 4 ? len : OVAL_STRING_MAP_CHUNKSIZE;
+
+		chunk = oscap_alloc(sizeof(struct _oval_string_map_chunk) + size);
+		chunk->used = 0;
+		chunk->size = size;
+
+		if (size == len && map->chunks != NULL) {
+			/* keep filling the current chunk */
+			chunk->next = map->chunks->next;
+			map->chunks->next = chunk;
+		} else {
+			chunk->next = map->chunks;
+			map->chunks = chunk;
+		}
+	}
+
+	copy = chunk->data + chunk->used;
+	chunk->used += len;
+	memcpy(copy, key, len);
+
+	return (copy);
+}
+
+static struct _oval_string_map_entry *_oval_string_map_lookup(struct oval_string_map *map, const char *key, uint32_t hash, size_t *slot)
+{
+	size_t i;
+
+	for (i = hash & map->mask; map->slots[i].index != 0; i = (i + 1) & map->mask) {
+		if (map->slots[i].hash == hash) {
+			struct _oval_string_map_entry *entry = map->entries + map->slots[i].index - 1;
+
+			if (strcmp(entry->key, key) == 0)
+				return (entry);
+		}
+	}
+
+	*slot = i;
+	return (NULL);
+}
+
+static void _oval_string_map_grow(struct oval_string_map *map)
+{
+	size_t mask = map->mask * 2 + 1, i, j;
+	struct _oval_string_map_slot *slots;
+
+	slots = oscap_calloc(mask + 1, sizeof(struct _oval_string_map_slot));
+
+	for (i = 0; i <= map->mask; i++) {
+		if (map->slots[i].index == 0)
+			continue;
+		for (j = map->slots[i].hash & mask; slots[j].index != 0; j = (j + 1) & mask);
+		slots[j] = map->slots[i];
+	}
+
+	oscap_free(map->slots);
+	map->slots = slots;
+	map->mask = mask;
+}
+
+/*
+ * Returns 0 if the key was added, -1 if it is already in the map. The first
+ * value stored under a key is kept, like with the RB-tree backend.
+ */
+static int _oval_string_map_add(struct oval_string_map *map, const char *key, void *val)
+{
+	uint32_t hash = _oval_string_map_hash(key);
+	size_t slot;
+
+	if (_oval_string_map_lookup(map, key, hash, &slot) != NULL)
+		return (-1);
+
+	/* the entries may move and the new one isn't sorted */
+	oscap_free(map->sorted);
+	map->sorted = NULL;
+
+	/* keep the load factor at or below 3/4 */
+	if ((map->count + 1) * 4 > (map->mask + 1) * 3) {
+		_oval_string_map_grow(map);
+		for (slot = hash & map->mask; map->slots[slot].index != 0; slot = (slot + 1) & map->mask);
+	}
+
+	if (map->count == map->alloc) {
+		map->alloc = map->alloc == 0 ? OVAL_STRING_MAP_MINSLOTS : map->alloc * 2;
+		map->entries = oscap_realloc(map->entries, map->alloc * sizeof(struct _oval_string_map_entry));
+	}
+
+	map->entries[map->count].key = _oval_string_map_key_copy(map, key);
+	map->entries[map->count].val = val;
+	map->slots[slot].hash = hash;
+	map->slots[slot].index = (uint32_t)(++map->count);
+
+	return (0);
+}
+
+void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
+{
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if (_oval_string_map_add(map, key, val) != 0)
+		dW("Key already in the map: %s\n", key);
+}
+
+void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
+{
+	char *str = strdup(val);
+
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if (_oval_string_map_add(map, key, str) != 0)
+		oscap_free(str);
+}
+
+void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
+{
+	struct _oval_string_map_entry *entry;
+	size_t slot;
+
+	assume_d(map != NULL, NULL);
+	assume_d(key != NULL, NULL);
+
+	entry = _oval_string_map_lookup(map, key, _oval_string_map_hash(key), &slot);
+
+	return (entry != NULL ? entry->val : NULL);
+}
+
+void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
+{
+	struct _oval_string_map_chunk *chunk, *next;
+	size_t i;
+
+	assume_d(map != NULL, /* void */);
+
+	if (destroy != NULL)
+		for (i = 0; i < map->count; i++)
+			destroy(map->entries[i].val);
+
+	for (chunk = map->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		oscap_free(chunk);
+	}
+
+	oscap_free(map->sorted);
+	oscap_free(map->entries);
+	oscap_free(map->slots);
+	oscap_free(map);
+}
+
+void oval_string_map_free0(struct oval_string_map *map)
+{
+	oval_string_map_free(map, NULL);
+}
+
+void oval_string_map_free_string(struct oval_string_map *map)
+{
+	assume_d(map != NULL, /* void */);
+	oval_string_map_free(map, oscap_free);
+}
+
+static int _oval_string_map_entry_cmp(const void *a, const void *b)
+{
+	return strcmp((*(struct _oval_string_map_entry **)a)->key,
+		      (*(struct _oval_string_map_entry **)b)->key);
+}
+
+/* stores the sorted entries unless another thread has done it first */
+#if defined(HAVE_ATOMIC_BUILTINS)
+static bool _oval_string_map_publish(struct oval_string_map *map, struct _oval_string_map_entry **sorted)
+{
+	return __sync_bool_compare_and_swap(&map->sorted, NULL, sorted);
+}
+#else
+static pthread_mutex_t __oval_string_map_publish_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static bool _oval_string_map_publish(struct oval_string_map *map, struct _oval_string_map_entry **sorted)
+{
+	bool published = false;
+
+	pthread_mutex_lock(&__oval_string_map_publish_mtx);
+	if (map->sorted == NULL) {
+		map->sorted = sorted;
+		published = true;
+	}
+	pthread_mutex_unlock(&__oval_string_map_publish_mtx);
+
+	return (published);
+}
+#endif
+
+/* returns the entries sorted by their keys, the array is owned by the map */
+static struct _oval_string_map_entry **_oval_string_map_sorted(struct oval_string_map *map)
+{
+	struct _oval_string_map_entry **sorted;
+	size_t i;
+
+	if (map->count == 0 || map->sorted != NULL)
+		return (map->sorted);
+
+	sorted = oscap_alloc(map->count * sizeof(struct _oval_string_map_entry *));
+	for (i = 0; i < map->count; i++)
+		sorted[i] = map->entries + i;
+	qsort(sorted, map->count, sizeof(struct _oval_string_map_entry *), _oval_string_map_entry_cmp);
+
+	/* another thread may have built it in the meantime */
+	if (!_oval_string_map_publish(map, sorted)) {
+		oscap_free(sorted);
+		sorted = map->sorted;
+	}
+
+	return (sorted);
+}
+
+struct oval_iterator *oval_string_map_keys(struct oval_string_map *map)
+{
+	struct _oval_string_map_entry **sorted;
+	struct oval_iterator *it;
+	size_t i;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->count; i++)
+		oval_collection_iterator_add(it, (void *)sorted[i]->key);
+
+	return (it);
+}
+
+struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
+{
+	struct _oval_string_map_entry **sorted;
+	struct oval_iterator *it;
+	size_t i;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->count; i++)
+		oval_collection_iterator_add(it, sorted[i]->val);
+
+	return (it);
+}
+
+struct oval_collection *oval_string_map_collect_values(struct oval_string_map *map, struct oval_collection *collection)
+{
+	struct _oval_string_map_entry **sorted;
+	size_t i;
+
+	assume_d(map != NULL, NULL);
+
+	if (collection == NULL)
+		collection = oval_collection_new();
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->count; i++)
+		oval_collection_add(collection, sorted[i]->val);
+
+	return (collection);
+}
+
+#endif /* OVAL_STRINGMAP_OLD, OVAL_STRINGMAP_RBT */
@@ -34,6 +34,7 @@
 
 #include <string.h>
 #include <time.h>
+#include <inttypes.h>
 #include <assume.h>
 
 #include "oval_agent_api.h"
@@ -44,6 +45,7 @@
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
 #include "results/oval_results_impl.h"
+#include "results/oval_regex_cache_impl.h"
 #include "common/list.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
@@ -60,6 +62,7 @@ struct oval_agent_session {
 	struct oval_syschar_model    * sys_models[2];
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
+	oval_regex_cache_t    * regex_cache; /**< patterns compiled by the evaluation */
 };
 
 
@@ -103,12 +106,14 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 	ag_sess->cur_var_model = NULL;
 	ag_sess->sys_model = oval_syschar_model_new(model);
 	ag_sess->psess     = oval_probe_session_new(ag_sess->sys_model);
+	ag_sess->regex_cache = oval_regex_cache_new(OVAL_REGEX_CACHE_MAX);
 
 	/* probe sysinfo */
 	ret = oval_probe_query_sysinfo(ag_sess->psess, &sysinfo);
 	if (ret != 0) {
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_syschar_model_free(ag_sess->sys_model);
+		oval_regex_cache_free(ag_sess->regex_cache);
 		oscap_free(ag_sess);
 		return NULL;
 	}
@@ -163,6 +168,7 @@ int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
 	const char *title = NULL;
 	struct oval_result_system *rsystem;
 	struct oval_definition *oval_def;
+	oval_regex_cache_t *regex_cache;
 
 	oval_def = oval_definition_model_get_definition(ag_sess->def_model, id);
 	if (oval_def != NULL) {
@@ -170,14 +176,17 @@ int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
 	}
 	dI("Evaluating definition '%s': %s.\n", id, title);
 
+	regex_cache = oval_regex_cache_set(ag_sess->regex_cache);
+
 	/* probe */
 	ret = oval_probe_query_definition(ag_sess->psess, id);
-	if (ret == -1)
-		return ret;
+	if (ret != -1) {
+		rsystem = _oval_agent_get_first_result_system(ag_sess);
+		/* eval */
+		ret = oval_result_system_eval_definition(rsystem, id);
+	}
 
-	rsystem = _oval_agent_get_first_result_system(ag_sess);
-	/* eval */
-	ret = oval_result_system_eval_definition(rsystem, id);
+	oval_regex_cache_set(regex_cache);
 
 	return ret;
 }
@@ -217,7 +226,15 @@ struct oval_result_definition * oval_agent_get_result_definition(oval_agent_sess
 	return rdef;
 }
 
-int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
+/*
+ * Reset the session for a new set of external variable values. Instead of
+ * restarting the probes, only the results cached for objects and states which
+ * depend on the changed variables (`vars', NULL means all) are dropped.
+ */
+static int _oval_agent_reset_session(oval_agent_session_t *ag_sess, struct oval_string_map *vars)
+{
+	int ret;
+
 	ag_sess->cur_var_model = NULL;
 	oval_definition_model_clear_external_variables(ag_sess->def_model);
 
@@ -240,12 +257,24 @@ int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
         	oval_generator_set_product_name(generator, ag_sess->product_name);
 	}
 
-	oval_probe_session_destroy(ag_sess->psess);
-	ag_sess->psess = oval_probe_session_new(ag_sess->sys_model);
+	if (vars != NULL)
+		ret = oval_probe_hint_variables(ag_sess->psess, ag_sess->def_model, vars);
+	else
+		ret = oval_probe_session_reset(ag_sess->psess, NULL);
+
+	if (ret != 0) {
+		dW("Probe session reset failed, restarting the probes.\n");
+		oval_probe_session_destroy(ag_sess->psess);
+		ag_sess->psess = oval_probe_session_new(ag_sess->sys_model);
+	}
 
 	return 0;
 }
 
+int oval_agent_reset_session(oval_agent_session_t * ag_sess) {
+	return _oval_agent_reset_session(ag_sess, NULL);
+}
+
 int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 {
 	assume_d(ag_sess != NULL, -1);
@@ -259,8 +288,17 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	struct oval_definition_iterator *oval_def_it;
 	char   *id;
 	int ret = 0;
+	oval_regex_cache_t *regex_cache;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.\n");
+	regex_cache = oval_regex_cache_set(ag_sess->regex_cache);
+
+	/* let the probes collect the objects in parallel */
+	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it))
+		oval_probe_prefetch_definition(ag_sess->psess, oval_definition_iterator_next(oval_def_it));
+	oval_definition_iterator_free(oval_def_it);
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -290,6 +328,7 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 
 cleanup:
 	oval_definition_iterator_free(oval_def_it);
+	oval_regex_cache_set(regex_cache);
 	dI("OVAL agent finished evaluation.\n");
 	return ret;
 }
@@ -308,10 +347,19 @@ const char * oval_agent_get_filename(oval_agent_session_t * ag_sess) {
 
 void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 	if (ag_sess != NULL) {
+		struct oval_regex_stats rs;
+
+		if (ag_sess->regex_cache != NULL) {
+			oval_regex_cache_stats(ag_sess->regex_cache, &rs);
+			dI("Regex cache: entries=%"PRIu32", hits=%"PRIu64", misses=%"PRIu64", uncached=%"PRIu64".\n",
+			   rs.entries, rs.hits, rs.misses, rs.uncached);
+		}
+
 		oscap_free(ag_sess->product_name);
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_syschar_model_free(ag_sess->sys_model);
 		oval_results_model_free(ag_sess->res_model);
+		oval_regex_cache_free(ag_sess->regex_cache);
 	        oscap_free(ag_sess->filename);
 		oscap_free(ag_sess);
 	}
@@ -399,11 +447,12 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 	const char *var_name = NULL;
 	struct oscap_stringlist *value_list = NULL;
 	bool conflict = false;
+	struct oval_string_map *changed = oval_string_map_new();
 	struct oscap_htable *dict = _binding_iterator_to_dict(it);
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(dict);
 	struct oval_definition_model *def_model =
 			oval_results_model_get_definition_model(oval_agent_get_results_model(session));
-	while (!conflict && oscap_htable_iterator_has_more(hit)) {
+	while (oscap_htable_iterator_has_more(hit)) {
 		oscap_htable_iterator_next_kv(hit, &var_name, (void*) &value_list);
 		struct oval_variable *variable = oval_definition_model_get_variable(def_model, var_name);
 		if (variable != NULL) {
@@ -419,6 +468,7 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 				// As per OVAL 5.10.1, the Variable Schema does not allow multisets. Therefore,
 				// we will later create new variable model and export multiple variables docs.
 				conflict = true;
+				oval_string_map_put(changed, var_name, variable);
 				// Next, in the results model, there might be already some definitions, tests
 				// states, or objects. These might be dependent on the previous value of the
 				// given variable.
@@ -468,8 +518,9 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 
     if (conflict) {
         /* We have a conflict, clear session and external variables */
-        oval_agent_reset_session(session);
+        _oval_agent_reset_session(session, changed);
     }
+    oval_string_map_free(changed, NULL);
 
     if (!session->cur_var_model) {
 	    session->cur_var_model = oval_variable_model_new();
@@ -541,6 +592,11 @@ oval_agent_eval_multi_check(oval_agent_session_t *sess)
 	xccdf_test_result_type_t xccdf_result;
 	xccdf_test_result_type_t final_result = 0;
 
+	oval_def_it = oval_definition_model_get_definitions(sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it))
+		oval_probe_prefetch_definition(sess->psess, oval_definition_iterator_next(oval_def_it));
+	oval_definition_iterator_free(oval_def_it);
+
 	oval_def_it = oval_definition_model_get_definitions(sess->def_model);
 	if (!oval_definition_iterator_has_more(oval_def_it)) {
 		// We are evaluating oval, which has no definitions. We are in state
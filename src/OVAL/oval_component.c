@@ -53,6 +53,7 @@
 #include "oval_glob_to_regex.h"
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
+#include "results/oval_regex_cache_impl.h"
 #elif defined USE_REGEX_POSIX
 #include <regex.h>
 #endif
@@ -1906,12 +1907,13 @@ static bool _match(const char *pattern, const char *string)
 {
 	bool match = false;
 #if defined USE_REGEX_PCRE
-	pcre *re;
-	const char *error;
-	int erroffset = -1, ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
-	re = pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, NULL);
-	match = (pcre_exec(re, NULL, string, strlen(string), 0, 0, ovector, ovector_len) >= 0);
-	pcre_free(re);
+	oval_regex_t *re;
+	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
+	re = oval_regex_get(pattern, PCRE_UTF8, NULL, NULL);
+	if (re == NULL)
+		return false;
+	match = (oval_regex_exec(re, string, strlen(string), 0, 0, ovector, ovector_len) >= 0);
+	oval_regex_put(re);
 #elif defined USE_REGEX_POSIX
 	regex_t re;
 	regcomp(&re, pattern, REG_EXTENDED);
@@ -2140,11 +2142,11 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 	char *pattern;
 #if defined USE_REGEX_PCRE
 	int erroffset = -1;
-	pcre *re = NULL;
+	oval_regex_t *re = NULL;
 	const char *error;
 
 	pattern = oval_component_get_regex_pattern(component);
-	re = pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, NULL);
+	re = oval_regex_get(pattern, PCRE_UTF8, &error, &erroffset);
 	if (re == NULL) {
 		oscap_dlprintf(DBG_E, "pcre_compile() failed: \"%s\".\n", error);
 		return SYSCHAR_FLAG_ERROR;
@@ -2174,7 +2176,7 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 			for (i = 0; i < ovector_len; ++i)
 				ovector[i] = -1;
 
-			rc = pcre_exec(re, NULL, text, strlen(text), 0, 0, ovector, ovector_len);
+			rc = oval_regex_exec(re, text, strlen(text), 0, 0, ovector, ovector_len);
 			if (rc < -1) {
 				oscap_dlprintf(DBG_E, "pcre_exec() failed: %d.\n", rc);
 				flag = SYSCHAR_FLAG_ERROR;
@@ -2220,7 +2222,7 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 	}
 	oval_component_iterator_free(subcomps);
 #if defined USE_REGEX_PCRE
-        pcre_free(re);
+        oval_regex_put(re);
 #endif
 	return flag;
 }
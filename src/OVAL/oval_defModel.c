@@ -480,10 +480,12 @@ struct oval_test *oval_definition_model_get_new_test(struct oval_definition_mode
 	return test;
 }
 
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent)
+int oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent,
+				 xmlTextWriterPtr writer)
 {
 
 	xmlNodePtr root_node = NULL;
+	int ret = 0;
 
 	if (parent) { /* result file */
 		root_node = xmlNewTextChild(parent, NULL, BAD_CAST OVAL_ROOT_ELM_DEFINITIONS, NULL);
@@ -504,72 +506,105 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	xmlSetNs(root_node, ns_ind);
 	xmlSetNs(root_node, ns_lin);
 	xmlSetNs(root_node, ns_defntns);
+	if (oscap_xml_writer_start_node(writer, root_node) != 0)
+		ret = -1;
 
 	/* Always report the generator */
-	oval_generator_to_dom(definition_model->generator, doc, root_node);
+	if (ret == 0 && oscap_xml_writer_flush_node(writer, oval_generator_to_dom(definition_model->generator, doc, root_node)) != 0)
+		ret = -1;
 
 	/* Report definitions */
 	struct oval_definition_iterator *definitions = oval_definition_model_get_definitions(definition_model);
-	if (oval_definition_iterator_has_more(definitions)) {
+	if (ret == 0 && oval_definition_iterator_has_more(definitions)) {
 		xmlNode *definitions_node = NULL;
-		while(oval_definition_iterator_has_more(definitions)) {
+		while (ret == 0 && oval_definition_iterator_has_more(definitions)) {
 			struct oval_definition *definition = oval_definition_iterator_next(definitions);
 			if (definitions_node == NULL) {
 				definitions_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "definitions", NULL);
+				if (oscap_xml_writer_start_node(writer, definitions_node) != 0) {
+					ret = -1;
+					break;
+				}
 			}
-			oval_definition_to_dom(definition, doc, definitions_node);
+			if (oscap_xml_writer_flush_node(writer, oval_definition_to_dom(definition, doc, definitions_node)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, definitions_node) != 0)
+			ret = -1;
 	}
         oval_definition_iterator_free(definitions);
 
 	/* Report tests */
 	struct oval_test_iterator *tests = oval_definition_model_get_tests(definition_model);
-	if (oval_test_iterator_has_more(tests)) {
+	if (ret == 0 && oval_test_iterator_has_more(tests)) {
 		xmlNode *tests_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "tests", NULL);
-		while (oval_test_iterator_has_more(tests)) {
+		if (oscap_xml_writer_start_node(writer, tests_node) != 0)
+			ret = -1;
+		while (ret == 0 && oval_test_iterator_has_more(tests)) {
 			struct oval_test *test = oval_test_iterator_next(tests);
-			oval_test_to_dom(test, doc, tests_node);
+			if (oscap_xml_writer_flush_node(writer, oval_test_to_dom(test, doc, tests_node)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, tests_node) != 0)
+			ret = -1;
 	}
 	oval_test_iterator_free(tests);
 
 	/* Report objects */
 	struct oval_object_iterator *objects = oval_definition_model_get_objects(definition_model);
-	if (oval_object_iterator_has_more(objects)) {
+	if (ret == 0 && oval_object_iterator_has_more(objects)) {
 		xmlNode *objects_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "objects", NULL);
-		while(oval_object_iterator_has_more(objects)) {
+		if (oscap_xml_writer_start_node(writer, objects_node) != 0)
+			ret = -1;
+		while (ret == 0 && oval_object_iterator_has_more(objects)) {
 			struct oval_object *object = oval_object_iterator_next(objects);
 			if (oval_object_get_base_obj(object))
 				/* Skip internal objects */
 				continue;
-			oval_object_to_dom(object, doc, objects_node);
+			if (oscap_xml_writer_flush_node(writer, oval_object_to_dom(object, doc, objects_node)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, objects_node) != 0)
+			ret = -1;
 	}
 	oval_object_iterator_free(objects);
 
 	/* Report states */
 	struct oval_state_iterator *states = oval_definition_model_get_states(definition_model);
-	if (oval_state_iterator_has_more(states)) {
+	if (ret == 0 && oval_state_iterator_has_more(states)) {
 		xmlNode *states_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "states", NULL);
-		while (oval_state_iterator_has_more(states)) {
+		if (oscap_xml_writer_start_node(writer, states_node) != 0)
+			ret = -1;
+		while (ret == 0 && oval_state_iterator_has_more(states)) {
 			struct oval_state *state = oval_state_iterator_next(states);
-			oval_state_to_dom(state, doc, states_node);
+			if (oscap_xml_writer_flush_node(writer, oval_state_to_dom(state, doc, states_node)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, states_node) != 0)
+			ret = -1;
 	}
 	oval_state_iterator_free(states);
 
 	/* Report variables */
 	struct oval_variable_iterator *variables = oval_definition_model_get_variables(definition_model);
-	if (oval_variable_iterator_has_more(variables)) {
+	if (ret == 0 && oval_variable_iterator_has_more(variables)) {
 		xmlNode *variables_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "variables", NULL);
-		while (oval_variable_iterator_has_more(variables)) {
+		if (oscap_xml_writer_start_node(writer, variables_node) != 0)
+			ret = -1;
+		while (ret == 0 && oval_variable_iterator_has_more(variables)) {
 			struct oval_variable *variable = oval_variable_iterator_next(variables);
-			oval_variable_to_dom(variable, doc, variables_node);
+			if (oscap_xml_writer_flush_node(writer, oval_variable_to_dom(variable, doc, variables_node)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, variables_node) != 0)
+			ret = -1;
 	}
 	oval_variable_iterator_free(variables);
 
-	return root_node;
+	if (oscap_xml_writer_end_node(writer, root_node) != 0)
+		ret = -1;
+
+	return ret;
 }
 
 int oval_definition_model_export(struct oval_definition_model *model, const char *file)
@@ -585,7 +620,7 @@ int oval_definition_model_export(struct oval_definition_model *model, const char
 		return -1;
 	}
 
-	oval_definition_model_to_dom(model, doc, NULL);
+	oval_definition_model_to_dom(model, doc, NULL, NULL);
 	return oscap_xml_save_filename_free(file, doc);
 }
 
@@ -31,6 +31,7 @@
 #define OVAL_DEFINITIONS_IMPL
 
 #include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
 #include "public/oval_definitions.h"
 #include "public/oval_system_characteristics.h"
 #include "oval_parser_impl.h"
@@ -157,7 +158,7 @@ int oval_generator_parse_tag(xmlTextReader *, struct oval_parser_context *, void
 xmlNode *oval_generator_to_dom(struct oval_generator *, xmlDocPtr, xmlNode *);
 
 /* definition_model */
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent);
+int oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent, xmlTextWriterPtr writer);
 void oval_definition_model_optimize_by_filter_propagation(struct oval_definition_model *);
 
 struct oval_definition *oval_definition_model_get_new_definition(struct oval_definition_model *, const char *);
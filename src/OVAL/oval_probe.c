@@ -259,7 +259,12 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 			const char *flag_text = oval_syschar_collection_flag_get_text(sc_flg);
 			dI("System characteristics for %s_object '%s' already exist, flag: %s.\n", type_name, oid, flag_text);
 
-			if (sc_flg != SYSCHAR_FLAG_UNKNOWN || (flags & OVAL_PDFLAG_NOREPLY)) {
+			/*
+			 * An asynchronous request might be waiting for this syschar;
+			 * let the handler receive its result.
+			 */
+			if (sc_flg != SYSCHAR_FLAG_UNKNOWN ||
+			    ((flags & OVAL_PDFLAG_NOREPLY) && !oval_probe_ext_queued(psess->pext, sysc))) {
 				if (out_syschar)
 					*out_syschar = sysc;
 				return 0;
@@ -289,7 +294,7 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 		return ret;
 	}
 
-	if (!(flags & OVAL_PDFLAG_NOREPLY)) {
+	if (!(flags & OVAL_PDFLAG_NOREPLY) || oval_syschar_get_flag(sysc) != SYSCHAR_FLAG_UNKNOWN) {
 		vm = oval_string_map_new();
 		oval_obj_collect_var_refs(object, vm);
 		_syschar_add_bindings(sysc, vm);
@@ -466,6 +471,97 @@ static int oval_probe_query_criteria(oval_probe_session_t *sess, struct oval_cri
         return -1;
 }
 
+static void oval_probe_prefetch_criteria(oval_probe_session_t *sess, struct oval_criteria_node *cnode);
+
+/**
+ * Queue asynchronous collection of the objects referenced by the tests of
+ * the definition. The requests are sent to the probes right away so that
+ * the objects are collected in parallel while the caller evaluates other
+ * definitions; the results are received by @ref oval_probe_query_object.
+ * Objects which reference variables are left for the synchronous path
+ * because their variable instance isn't known yet.
+ */
+void oval_probe_prefetch_definition(oval_probe_session_t *sess, struct oval_definition *definition)
+{
+	struct oval_criteria_node *cnode;
+
+	if (definition == NULL)
+		return;
+
+	cnode = oval_definition_get_criteria(definition);
+
+	if (cnode != NULL)
+		oval_probe_prefetch_criteria(sess, cnode);
+}
+
+static void oval_probe_prefetch_object(oval_probe_session_t *sess, struct oval_object *object)
+{
+	struct oval_string_map *vm;
+	struct oval_iterator   *vm_it;
+	struct oval_syschar    *sysc;
+	oval_ph_t *ph;
+	bool has_refs;
+
+	if (oval_syschar_model_get_syschar(sess->sys_model, oval_object_get_id(object)) != NULL)
+		return;
+
+	ph = oval_probe_handler_get(sess->ph, oval_object_get_subtype(object));
+
+	if (ph == NULL || ph->func != &oval_probe_ext_handler)
+		return;
+
+	vm = oval_string_map_new();
+	oval_obj_collect_var_refs(object, vm);
+	vm_it    = oval_string_map_keys(vm);
+	has_refs = oval_collection_iterator_has_more(vm_it);
+	oval_collection_iterator_free(vm_it);
+	oval_string_map_free(vm, NULL);
+
+	if (has_refs)
+		return;
+
+	sysc = oval_syschar_new(sess->sys_model, object);
+
+	if (oval_probe_ext_queue(ph->uptr, sysc) != 0)
+		dD("Object '%s' not queued.\n", oval_object_get_id(object));
+}
+
+static void oval_probe_prefetch_criteria(oval_probe_session_t *sess, struct oval_criteria_node *cnode)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		struct oval_object *object;
+
+		if (test == NULL)
+			return;
+
+		object = oval_test_get_object(test);
+
+		if (object != NULL)
+			oval_probe_prefetch_object(sess, object);
+		return;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+
+		if (cnode_it == NULL)
+			return;
+
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			oval_probe_prefetch_criteria(sess, oval_criteria_node_iterator_next(cnode_it));
+
+		oval_criteria_node_iterator_free(cnode_it);
+		return;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:
+		oval_probe_prefetch_definition(sess, oval_criteria_node_get_definition(cnode));
+		return;
+	case OVAL_NODETYPE_UNKNOWN:
+		break;
+	}
+}
+
 #if 0
 const oval_probe_meta_t * const oval_probe_meta_get(void)
 {
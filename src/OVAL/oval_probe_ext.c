@@ -40,6 +40,7 @@
 #include "common/bfind.h"
 #include "common/debug_priv.h"
 #include "probes/public/probe-api.h"
+#include "probes/probe/dcache.h"
 #include "oval_probe_ext.h"
 #include "oval_sexp.h"
 #include "oval_probe_meta.h"
@@ -54,6 +55,7 @@ static oval_pdtbl_t *oval_pdtbl_new(void);
 static void          oval_pdtbl_free(oval_pdtbl_t *table);
 static int           oval_pdtbl_add(oval_pdtbl_t *table, oval_subtype_t type, int sd, const char *uri);
 static oval_pd_t    *oval_pdtbl_get(oval_pdtbl_t *table, oval_subtype_t type);
+static void          oval_pdreq_clear(oval_pd_t *pd);
 
 /*
  * oval_pext_
@@ -111,12 +113,58 @@ static oval_pdtbl_t *oval_pdtbl_new(void)
 	return (p_tbl);
 }
 
+/*
+ * Usage counters of the persistent caches of the probes closed so far
+ */
+static uint64_t oval_probe_cache_lookups = 0;
+static uint64_t oval_probe_cache_hits    = 0;
+
+static void oval_pd_cache_stats(SEAP_CTX_t *ctx, oval_pd_t *pd)
+{
+	SEXP_t *res, *r0, *r1;
+
+	res = SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_CACHE_STATS, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+
+	if (res == NULL)
+		return;
+
+	if (SEXP_listp(res) && SEXP_list_length(res) == 5) {
+		r0 = SEXP_list_nth(res, 1);
+		r1 = SEXP_list_nth(res, 2);
+
+		if (SEXP_numberp(r0) && SEXP_numberp(r1)) {
+			__sync_fetch_and_add(&oval_probe_cache_lookups, SEXP_number_getu_64(r0));
+			__sync_fetch_and_add(&oval_probe_cache_hits, SEXP_number_getu_64(r1));
+		}
+
+		SEXP_vfree(r0, r1, NULL);
+	}
+
+	SEXP_free(res);
+}
+
+void oval_probe_cache_stats(uint64_t *lookups, uint64_t *hits)
+{
+	__sync_synchronize();
+
+	if (lookups != NULL)
+		*lookups = oval_probe_cache_lookups;
+	if (hits != NULL)
+		*hits = oval_probe_cache_hits;
+}
+
 static void oval_pdtbl_free(oval_pdtbl_t *tbl)
 {
         register size_t i;
+        const char *cache_dir = getenv(PROBE_DCACHE_ENV);
 
         for (i = 0; i < tbl->count; ++i) {
+                if (cache_dir != NULL && cache_dir[0] != '\0')
+                        oval_pd_cache_stats(tbl->ctx, tbl->memb[i]);
+
                 SEAP_close(tbl->ctx, tbl->memb[i]->sd);
+                oval_pdreq_clear(tbl->memb[i]);
+                oscap_free(tbl->memb[i]->queue);
                 oscap_free(tbl->memb[i]->uri);
 		oscap_free(tbl->memb[i]);
         }
@@ -154,6 +202,13 @@ static int oval_pdtbl_add(oval_pdtbl_t *tbl, oval_subtype_t type, int sd, const
 	pd->sd      = sd;
 	pd->uri     = strdup(uri);
 
+	pd->req_cnt   = 0;
+	pd->req_pump  = false;
+	pd->queue     = NULL;
+	pd->queue_beg = 0;
+	pd->queue_end = 0;
+	pd->queue_max = 0;
+
 	tbl->memb = oscap_realloc(tbl->memb, sizeof(oval_pd_t *) * (++tbl->count));
 
 	assume_d(tbl->memb != NULL, -1);
@@ -176,6 +231,80 @@ static oval_pd_t *oval_pdtbl_get(oval_pdtbl_t * tbl, oval_subtype_t type)
 	return (pdp == NULL ? NULL : *pdp);
 }
 
+/*
+ * oval_pdreq_
+ *
+ * Outstanding asynchronous requests of a probe descriptor. The table
+ * is small (OVAL_PROBE_ASYNC_MAXREQ) so a linear search is sufficient.
+ * Note that the entries are moved on deletion; don't keep pointers to
+ * them across calls that might receive a message.
+ */
+static oval_pdreq_t *oval_pdreq_find(oval_pd_t *pd, SEAP_msgid_t id)
+{
+	register size_t i;
+
+	for (i = 0; i < pd->req_cnt; ++i)
+		if (pd->req[i].id == id)
+			return (pd->req + i);
+
+	return (NULL);
+}
+
+static oval_pdreq_t *oval_pdreq_findsys(oval_pd_t *pd, struct oval_syschar *sys)
+{
+	register size_t i;
+
+	for (i = 0; i < pd->req_cnt; ++i)
+		if (pd->req[i].sys == sys)
+			return (pd->req + i);
+
+	return (NULL);
+}
+
+static void oval_pdreq_del(oval_pd_t *pd, SEAP_msgid_t id)
+{
+	oval_pdreq_t *req;
+
+	if ((req = oval_pdreq_find(pd, id)) == NULL)
+		return;
+
+	SEAP_msg_free(req->reply);
+
+	if (--pd->req_cnt > 0)
+		*req = pd->req[pd->req_cnt];
+}
+
+/*
+ * Forget all outstanding requests. Used when the connection to the
+ * probe is closed; the syschars remain in the UNKNOWN state and will
+ * be evaluated synchronously when they are queried.
+ */
+static void oval_pdreq_clear(oval_pd_t *pd)
+{
+	register size_t i;
+
+	for (i = 0; i < pd->req_cnt; ++i)
+		SEAP_msg_free(pd->req[i].reply);
+
+	pd->req_cnt = 0;
+}
+
+static bool oval_pdqueue_remove(oval_pd_t *pd, struct oval_syschar *sys)
+{
+	register size_t i;
+
+	for (i = pd->queue_beg; i < pd->queue_end; ++i) {
+		if (pd->queue[i] == sys) {
+			memmove(pd->queue + i, pd->queue + i + 1,
+				sizeof(struct oval_syschar *) * (pd->queue_end - i - 1));
+			--pd->queue_end;
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
 /*
  * oval_probe_cmd_
  */
@@ -359,7 +488,34 @@ static inline const char *_probe_strerror(uint32_t error_code)
 	return codemsg;
 }
 
-static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msg_t *s_omsg, int flags)
+static inline int _handle_SEAP_error(oval_pd_t *pd, SEAP_err_t *err)
+{
+	/*
+	 * decide what to do based on the error code/type
+	 */
+	switch (err->type) {
+	case SEAP_ETYPE_USER:
+	{
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe at sd=%d (%s) reported an error: %s",
+				pd->sd, oval_subtype_to_str(pd->subtype), _probe_strerror(err->code));
+		break;
+	}
+	case SEAP_ETYPE_INT:
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error");
+		break;
+	}
+
+	SEAP_error_free(err);
+	errno = ECANCELED;
+
+	return (-1);
+}
+
+/*
+ * Returns 1 if the failure was caused by an error related to an other
+ * outstanding request, i.e. the caller should continue receiving.
+ */
+static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msgid_t id, int flags)
 {
 	protect_errno {
 		oscap_dlprintf(DBG_W, "Can't receive message: %u, %s.\n", errno, strerror(errno));
@@ -368,12 +524,19 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 	if (errno == ECANCELED) {
 		SEAP_err_t *err = NULL;
 
-		switch(SEAP_recverr_byid(ctx, pd->sd, &err,
-					 SEAP_msg_id(s_omsg)))
+		switch(SEAP_recverr_byid(ctx, pd->sd, &err, id))
 		{
 		case  0:
 			break;
 		case  1: /* no error found */
+			if (pd->req_cnt > (oval_pdreq_find(pd, id) != NULL ? 1 : 0)) {
+				/*
+				 * The error belongs to one of the other outstanding
+				 * requests; it stays queued until that one is received.
+				 */
+				return (1);
+			}
+
 			dE("Internal error: An error was signaled on sd=%d but the error queue is empty.\n");
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "SEAP_recverr_byid: internal error: empty error queue.");
 			return (-1);
@@ -383,26 +546,21 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 			return (-1);
 		}
 
+		return _handle_SEAP_error(pd, err);
+	}
+
+	if (errno == ESRCH) {
 		/*
-		 * decide what to do based on the error code/type
+		 * The probe process died and has already been reaped by the
+		 * scheme. Release the descriptor below; the probe is spawned
+		 * again on the next request.
 		 */
-		switch (err->type) {
-		case SEAP_ETYPE_USER:
-		{
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe at sd=%d (%s) reported an error: %s",
-					pd->sd, oval_subtype_to_str(pd->subtype), _probe_strerror(err->code));
-			break;
-		}
-		case SEAP_ETYPE_INT:
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error");
-			break;
-		}
+		oscap_dlprintf(DBG_W, "Probe %s (%s) died.\n",
+			       oval_subtype_to_str(pd->subtype), pd->uri);
 
-		SEAP_error_free(err);
-		return (-1);
-	}
-
-	if (flags & OVAL_PDFLAG_SLAVE) {
+		if (!oscap_err())
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe %s died", oval_subtype_to_str(pd->subtype));
+	} else if (flags & OVAL_PDFLAG_SLAVE) {
 		char errbuf[__ERRBUF_SIZE];
 
 		if (strerror_r (errno, errbuf, sizeof errbuf - 1) != 0)
@@ -427,9 +585,84 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 	}
 
 	pd->sd = -1;
+	oval_pdreq_clear(pd);
+
 	return (-1);
 }
 
+/*
+ * Receive the reply to the request with the given message ID. Replies to
+ * other outstanding (asynchronous) requests that arrive in the meantime are
+ * stored in the request table of the probe descriptor, errors reported for
+ * them stay in the error queue of the descriptor.
+ */
+static int oval_probe_comm_recv(SEAP_CTX_t *ctx, oval_pd_t *pd, SEAP_msgid_t id, int flags, SEAP_msg_t **out_msg)
+{
+	SEAP_msg_t   *s_imsg;
+	SEAP_msgid_t  r_id;
+	oval_pdreq_t *req;
+	SEXP_t       *s_rid;
+	int ret;
+
+	if ((req = oval_pdreq_find(pd, id)) != NULL) {
+		SEAP_err_t *err = NULL;
+
+		if (req->reply != NULL) {
+			*out_msg   = req->reply;
+			req->reply = NULL;
+			return (0);
+		}
+
+		if (SEAP_recverr_byid(ctx, pd->sd, &err, id) == 0)
+			return _handle_SEAP_error(pd, err);
+	}
+
+	for (;;) {
+		s_imsg = NULL;
+
+		if (SEAP_recvmsg(ctx, pd->sd, &s_imsg) != 0) {
+			protect_errno {
+				ret = _handle_SEAP_receive_failure(ctx, pd, id, flags);
+				SEAP_msg_free(s_imsg);
+			}
+
+			if (ret == 1)
+				continue;
+
+			return (ret);
+		}
+
+		s_rid = SEAP_msgattr_get(s_imsg, "reply-id");
+
+		if (s_rid == NULL) {
+			dW("Received a message without reply-id; assuming it's a reply to id=%u\n", (unsigned int)id);
+			*out_msg = s_imsg;
+			return (0);
+		}
+#if SEAP_MSGID_BITS == 64
+		r_id = SEXP_number_getu_64(s_rid);
+#else
+		r_id = SEXP_number_getu_32(s_rid);
+#endif
+		SEXP_free(s_rid);
+
+		if (r_id == id) {
+			*out_msg = s_imsg;
+			return (0);
+		}
+
+		req = oval_pdreq_find(pd, r_id);
+
+		if (req != NULL && req->reply == NULL) {
+			req->reply = s_imsg;
+		} else {
+			dW("Dropping unexpected reply: reply-id=%u, expected=%u\n",
+			   (unsigned int)r_id, (unsigned int)id);
+			SEAP_msg_free(s_imsg);
+		}
+	}
+}
+
 static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
 {
 	int retry, ret;
@@ -524,10 +757,12 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
                                         oscap_seterr (OSCAP_EFAMILY_OVAL, errbuf);
 
 				pd->sd = -1;
+				oval_pdreq_clear(pd);
 				return (-1);
 			}
 
 			pd->sd = -1;
+			oval_pdreq_clear(pd);
 
 			if (++retry <= OVAL_PROBE_MAXRETRY) {
 				oscap_dlprintf(DBG_I, "Send: retry %u/%u.\n", retry, OVAL_PROBE_MAXRETRY);
@@ -554,11 +789,9 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 		/* recv_retry: */
 		s_imsg = NULL;
 
-		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
+		ret = oval_probe_comm_recv(ctx, pd, SEAP_msg_id(s_omsg), flags, &s_imsg);
 		if (ret != 0) {
 			protect_errno {
-				ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
-				SEAP_msg_free(s_imsg);
 				SEAP_msg_free(s_omsg);
 			}
 			if (errno == ECONNABORTED) {
@@ -596,6 +829,44 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 	return (0);
 }
 
+/*
+ * Send a request without waiting for the reply. There are no retries here;
+ * if the request can't be sent, the object is left for the synchronous path.
+ */
+static int oval_probe_comm_async(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, SEAP_msgid_t *out_id)
+{
+	SEAP_msg_t *s_omsg;
+
+	if (pd->sd == -1) {
+		pd->sd = SEAP_connect(ctx, pd->uri, 0);
+
+		if (pd->sd < 0) {
+			dW("Can't connect: %u, %s.\n", errno, strerror(errno));
+			pd->sd = -1;
+			return (-1);
+		}
+	}
+
+	s_omsg = SEAP_msg_new();
+	SEAP_msg_set(s_omsg, (SEXP_t *) s_iobj);
+
+	if (SEAP_sendmsg(ctx, pd->sd, s_omsg) != 0) {
+		dW("Can't send message: %u, %s.\n", errno, strerror(errno));
+
+		SEAP_msg_free(s_omsg);
+		SEAP_close(ctx, pd->sd);
+		pd->sd = -1;
+		oval_pdreq_clear(pd);
+
+		return (-1);
+	}
+
+	*out_id = SEAP_msg_id(s_omsg);
+	SEAP_msg_free(s_omsg);
+
+	return (0);
+}
+
 static int oval_pdsc_typecmp(oval_subtype_t *a, oval_pdsc_t *b)
 {
         return (*a - b->type);
@@ -612,6 +883,35 @@ static oval_pdsc_t *oval_pdsc_lookup(oval_pdsc_t pdsc[], int count, oval_subtype
                            (int (*)(void *, void *))oval_pdsc_typecmp);
 }
 
+/*
+ * Get the SEAP scheme used to talk to the probe. The memfd scheme is
+ * used for the probes listed in OVAL_PROBE_MEMFD_ENV (names separated
+ * by spaces or commas, or "all").
+ */
+static const char *oval_pdsc_scheme(const oval_pdsc_t *dsc)
+{
+	const char *list, *p;
+	size_t nlen, tlen;
+
+	list = getenv(OVAL_PROBE_MEMFD_ENV);
+
+	if (list == NULL)
+		return (OVAL_PROBE_SCHEME);
+
+	nlen = strlen(dsc->name);
+
+	for (p = list; *p != '\0'; p += tlen) {
+		p   += strspn(p, " ,");
+		tlen = strcspn(p, " ,");
+
+		if ((tlen == 3 && strncmp(p, "all", 3) == 0) ||
+		    (tlen == nlen && strncmp(p, dsc->name, nlen) == 0))
+			return (OVAL_PROBE_SCHEME_MEMFD);
+	}
+
+	return (OVAL_PROBE_SCHEME);
+}
+
 static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_syschar_model *model, struct oval_sysinfo **out_sysinf)
 {
 	struct oval_sysinfo *sysinf;
@@ -788,7 +1088,7 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
 		}
 
                 probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                        "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
+                                        "%s://%s/%s", oval_pdsc_scheme(probe_dsc), probe_dir, probe_dsc->file);
 
                 if (probe_urilen >= sizeof probe_uri) {
                         oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
@@ -817,6 +1117,51 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+/*
+ * Get the probe descriptor for the given subtype; the descriptor is created
+ * if it doesn't exist yet.
+ * @return 0 on success, 1 if the subtype isn't supported, -1 on error
+ */
+static int oval_probe_ext_pdget(oval_pext_t *pext, oval_subtype_t type, oval_pd_t **out_pd)
+{
+	char         probe_uri[PATH_MAX + 1];
+	size_t       probe_urilen;
+	oval_pdsc_t *probe_dsc;
+	oval_pd_t   *pd;
+
+	pd = oval_pdtbl_get(pext->pdtbl, type);
+
+	if (pd == NULL) {
+		probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, type);
+
+		if (probe_dsc == NULL)
+			return (1);
+
+		probe_urilen = snprintf(probe_uri, sizeof probe_uri,
+					"%s://%s/%s", oval_pdsc_scheme(probe_dsc), pext->probe_dir, probe_dsc->file);
+
+		if (probe_urilen >= sizeof probe_uri) {
+			oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+			return (-1);
+		}
+
+		dI("Starting probe on URI '%s'.\n", probe_uri);
+
+		if (oval_pdtbl_add(pext->pdtbl, type, -1, probe_uri) != 0)
+			return (1);
+
+		pd = oval_pdtbl_get(pext->pdtbl, type);
+
+		if (pd == NULL) {
+			oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+			return (-1);
+		}
+	}
+
+	*out_pd = pd;
+	return (0);
+}
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -836,50 +1181,19 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
 		obj = oval_syschar_get_object(sys);
-                pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
-
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-                        char        *probe_dir;
-                        oval_pdsc_t *probe_dsc;
-
-                        probe_dir = pext->probe_dir;
-                        probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, oval_object_get_subtype(obj));
-
-			if (probe_dsc == NULL) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-				return (1);
-			}
-
-                        probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                                "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
-
-                        dI("Starting probe on URI '%s'.\n", probe_uri);
 
-                        if (oval_pdtbl_add(pext->pdtbl, oval_object_get_subtype(obj), -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
-
-			pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
-
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
-                }
+		switch (oval_probe_ext_pdget(pext, oval_object_get_subtype(obj), &pd)) {
+		case 0:
+			break;
+		case 1:
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			va_end(ap);
+			return (1);
+		default:
+			va_end(ap);
+			return (-1);
+		}
 
 		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
 
@@ -914,6 +1228,16 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
         case PROBE_HANDLER_ACT_RESET:
 	case PROBE_HANDLER_ACT_ABORT:
         {
+		SEXP_t *ids = NULL;
+
+		if (act == PROBE_HANDLER_ACT_RESET)
+			ids = va_arg(ap, SEXP_t *);
+
+                if (pext->pdtbl == NULL) {
+			va_end(ap);
+			return(0);
+		}
+
                 if (type == OVAL_SUBTYPE_ALL) {
                         /*
                          * Iterate thru probe descriptor table and execute the reset operation
@@ -928,7 +1252,7 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 				}
 
 				if (act == PROBE_HANDLER_ACT_RESET)
-					ret = oval_probe_ext_reset(pext->pdtbl->ctx, pd, pext);
+					ret = oval_probe_ext_reset(pext->pdtbl->ctx, pd, pext, ids);
 				else
 					ret = oval_probe_ext_abort(pext->pdtbl->ctx, pd, pext);
 
@@ -951,7 +1275,7 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
                                 return(0);
 
 			if (act == PROBE_HANDLER_ACT_RESET)
-				return oval_probe_ext_reset(pext->pdtbl->ctx, pd, pext);
+				return oval_probe_ext_reset(pext->pdtbl->ctx, pd, pext, ids);
 			else
 				return oval_probe_ext_abort(pext->pdtbl->ctx, pd, pext);
                 }
@@ -1047,6 +1371,138 @@ _ret:
         return(ret);
 }
 
+/*
+ * Send queued asynchronous requests while there are free request slots.
+ */
+static void oval_probe_ext_pump(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
+{
+	struct oval_syschar *sys;
+	struct oval_object  *obj;
+	SEXP_t *s_obj;
+	SEAP_msgid_t id;
+
+	/*
+	 * The object conversion may resolve variables and thus query other
+	 * objects. That might complete requests of this descriptor and get
+	 * us called again.
+	 */
+	if (pd->req_pump)
+		return;
+
+	pd->req_pump = true;
+
+	while (pd->req_cnt < OVAL_PROBE_ASYNC_MAXREQ && pd->queue_beg < pd->queue_end) {
+		sys = pd->queue[pd->queue_beg++];
+
+		if (oval_syschar_get_flag(sys) != SYSCHAR_FLAG_UNKNOWN)
+			continue;
+
+		obj = oval_syschar_get_object(sys);
+
+		if (oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(obj)), sys, &s_obj) != 0)
+			continue;
+
+		if (oval_syschar_get_flag(sys) != SYSCHAR_FLAG_UNKNOWN) {
+			SEXP_free(s_obj);
+			continue;
+		}
+
+		if (oval_probe_comm_async(ctx, pd, s_obj, &id) != 0) {
+			/* leave the rest for the synchronous path */
+			SEXP_free(s_obj);
+			pd->queue_beg = pd->queue_end;
+			break;
+		}
+
+		SEXP_free(s_obj);
+
+		pd->req[pd->req_cnt].id    = id;
+		pd->req[pd->req_cnt].sys   = sys;
+		pd->req[pd->req_cnt].reply = NULL;
+		++pd->req_cnt;
+	}
+
+	if (pd->queue_beg == pd->queue_end)
+		pd->queue_beg = pd->queue_end = 0;
+
+	pd->req_pump = false;
+}
+
+/*
+ * Receive the result of an asynchronous request.
+ */
+static int oval_probe_ext_complete(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags, SEXP_t **out_sexp)
+{
+	SEAP_msg_t  *s_imsg = NULL;
+	SEAP_msgid_t id;
+	int ret;
+
+	id  = oval_pdreq_findsys(pd, syschar)->id;
+	ret = oval_probe_comm_recv(ctx, pd, id, flags, &s_imsg);
+
+	protect_errno {
+		oval_pdreq_del(pd, id);
+	}
+
+	if (ret != 0)
+		return (ret);
+
+	*out_sexp = SEAP_msg_get(s_imsg);
+	SEAP_msg_free(s_imsg);
+
+	/* Refill the freed slot before the result gets converted */
+	oval_probe_ext_pump(ctx, pd, pext);
+
+	return (0);
+}
+
+int oval_probe_ext_queue(oval_pext_t *pext, struct oval_syschar *syschar)
+{
+	oval_pd_t *pd;
+	int ret;
+
+	if (pext->pdtbl == NULL)
+		return (1);
+
+	ret = oval_probe_ext_pdget(pext, oval_object_get_subtype(oval_syschar_get_object(syschar)), &pd);
+
+	if (ret != 0)
+		return (ret);
+
+	if (pd->queue_end == pd->queue_max) {
+		pd->queue_max = pd->queue_max > 0 ? pd->queue_max * 2 : OVAL_PROBE_ASYNC_MAXREQ;
+		pd->queue     = oscap_realloc(pd->queue, sizeof(struct oval_syschar *) * pd->queue_max);
+	}
+
+	pd->queue[pd->queue_end++] = syschar;
+	oval_probe_ext_pump(pext->pdtbl->ctx, pd, pext);
+
+	return (0);
+}
+
+bool oval_probe_ext_queued(oval_pext_t *pext, struct oval_syschar *syschar)
+{
+	oval_pd_t *pd;
+	register size_t i;
+
+	if (pext->pdtbl == NULL)
+		return (false);
+
+	pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(oval_syschar_get_object(syschar)));
+
+	if (pd == NULL)
+		return (false);
+
+	if (oval_pdreq_findsys(pd, syschar) != NULL)
+		return (true);
+
+	for (i = pd->queue_beg; i < pd->queue_end; ++i)
+		if (pd->queue[i] == syschar)
+			return (true);
+
+	return (false);
+}
+
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
 {
         SEXP_t *s_obj, *s_sys;
@@ -1058,14 +1514,25 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 		return (-1);
 	}
 
-	object = oval_syschar_get_object(syschar);
-	ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
+	if (oval_pdreq_findsys(pd, syschar) != NULL) {
+		/*
+		 * The request was already sent without the no-reply flag,
+		 * so store the result even if the caller doesn't need it.
+		 */
+		ret    = oval_probe_ext_complete(ctx, pd, pext, syschar, flags, &s_sys);
+		flags &= ~OVAL_PDFLAG_NOREPLY;
+	} else {
+		oval_pdqueue_remove(pd, syschar);
 
-	if (ret != 0)
-		return (1);
+		object = oval_syschar_get_object(syschar);
+		ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
-	SEXP_free(s_obj);
+		if (ret != 0)
+			return (1);
+
+		ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+		SEXP_free(s_obj);
+	}
 
 	if (ret != 0) {
 		switch (errno) {
@@ -1074,6 +1541,7 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 
 			SEAP_close(ctx, pd->sd);
 			pd->sd = -1;
+			oval_pdreq_clear(pd);
 			errno  = ECONNABORTED;
 		}
 		return (ret);
@@ -1100,11 +1568,38 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	return (ret);
 }
 
-int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
+int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, SEXP_t *ids)
 {
-        SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	SEAP_msg_t  *s_imsg;
+	SEAP_msgid_t id;
+	SEXP_t      *res;
+
+	/*
+	 * SEAP_cmd_exec() drops messages received while it waits for the
+	 * command reply. Receive the replies to outstanding asynchronous
+	 * requests first; their syschars stay in the UNKNOWN state and are
+	 * evaluated again (most likely from the probe cache) when queried.
+	 */
+	while (pd->req_cnt > 0) {
+		id = pd->req[0].id;
+		s_imsg = NULL;
 
-        return (0);
+		if (oval_probe_comm_recv(ctx, pd, id, 0, &s_imsg) != 0) {
+			oval_pdreq_clear(pd);
+			return (-1);
+		}
+
+		oval_pdreq_del(pd, id);
+		SEAP_msg_free(s_imsg);
+	}
+
+	res = SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, ids, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	SEXP_free(res);
+
+	/* Queued objects don't reference variables, continue prefetching */
+	oval_probe_ext_pump(ctx, pd, pext);
+
+	return (0);
 }
 
 #include <signal.h>
@@ -1133,6 +1628,7 @@ int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 
 	switch (dsc->scheme) {
 	case SCH_PIPE:
+	case SCH_MEMFD: /* sch_memfddata_t starts with sch_pipedata_t */
 	{
 		sch_pipedata_t *pipeinfo = (sch_pipedata_t *)dsc->scheme_data;
 
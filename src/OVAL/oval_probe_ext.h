@@ -29,10 +29,33 @@
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
 
+#ifndef OVAL_PROBE_ASYNC_MAXREQ
+/*
+ * Maximal number of outstanding asynchronous requests per probe. Keep this
+ * well below the probe's worker thread limit so that there are threads left
+ * for objects requested by the probe itself (set objects).
+ */
+# define OVAL_PROBE_ASYNC_MAXREQ 32
+#endif
+
+typedef struct {
+	SEAP_msgid_t         id;    /**< ID of the request message */
+	struct oval_syschar *sys;   /**< system characteristic waiting for the result */
+	SEAP_msg_t          *reply; /**< reply received while waiting for an other one */
+} oval_pdreq_t;
+
 typedef struct {
 	oval_subtype_t subtype;
 	int sd;
 	char *uri;
+
+	oval_pdreq_t          req[OVAL_PROBE_ASYNC_MAXREQ]; /**< outstanding asynchronous requests */
+	size_t                req_cnt;
+	bool                  req_pump;  /**< the request slots are being refilled */
+	struct oval_syschar **queue;     /**< syschars waiting for a free request slot */
+	size_t                queue_beg; /**< index of the first waiting syschar */
+	size_t                queue_end; /**< index past the last waiting syschar */
+	size_t                queue_max; /**< allocated size of the queue */
 } oval_pd_t;
 
 typedef struct {
@@ -69,9 +92,28 @@ oval_pext_t *oval_pext_new(void);
 void oval_pext_free(oval_pext_t *pext);
 int oval_probe_ext_init(oval_pext_t *pext);
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
-int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
+
+/**
+ * Reset the probe. Results of outstanding asynchronous requests are discarded.
+ * @param ids list of object and state ids whose cached results should be
+ *        dropped or NULL to drop all cached results
+ */
+int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, SEXP_t *ids);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
+/**
+ * Queue an asynchronous evaluation of a system characteristic. The request
+ * is sent to the probe as soon as there's a free request slot; the result is
+ * received and converted when the object is queried the next time.
+ * @return 0 if the syschar was queued, 1 if the object isn't handled by an external probe, -1 on error
+ */
+int oval_probe_ext_queue(oval_pext_t *pext, struct oval_syschar *syschar);
+
+/**
+ * Check whether there's a queued or outstanding asynchronous request for the syschar.
+ */
+bool oval_probe_ext_queued(oval_pext_t *pext, struct oval_syschar *syschar);
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...);
 int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...);
 
@@ -29,6 +29,8 @@
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
 #include "_oval_probe_session.h"
+#include "_oval_probe_handler.h"
+#include "collectVarRefs_impl.h"
 
 static int _oval_probe_hint_criteria(oval_probe_session_t *sess, struct oval_criteria_node *cnode, int variable_instance_hint);
 static int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *object, int variable_instance_hint);
@@ -99,3 +101,79 @@ int _oval_probe_hint_object(oval_probe_session_t *psess, struct oval_object *obj
 	}
 	return 0;
 }
+
+static bool _oval_probe_hint_refs(struct oval_string_map *refs, struct oval_string_map *vars)
+{
+	struct oval_string_iterator *ref_it;
+	bool found = false;
+
+	ref_it = (struct oval_string_iterator *)oval_string_map_keys(refs);
+	while (!found && oval_string_iterator_has_more(ref_it)) {
+		if (oval_string_map_get_value(vars, oval_string_iterator_next(ref_it)) != NULL)
+			found = true;
+	}
+	oval_string_iterator_free(ref_it);
+
+	return found;
+}
+
+/**
+ * Drops the results cached by the probes for all the objects and states of the
+ * definition model which (possibly indirectly) reference any of the given variables.
+ * The probes keep running and results of the other objects remain cached. This is
+ * the probe-side counterpart of @ref oval_probe_hint_definition.
+ * @param vars map of the changed variables (var id, var pointer)
+ * @returns 0 on success; -1 on error
+ */
+int oval_probe_hint_variables(oval_probe_session_t *sess, struct oval_definition_model *model, struct oval_string_map *vars)
+{
+	struct oval_object_iterator *obj_it;
+	struct oval_state_iterator *ste_it;
+	struct oval_string_map *refs;
+	oval_ph_t *ph;
+	SEXP_t *ids, *id;
+	int ret;
+
+	if ((ph = oval_probe_handler_get(sess->ph, OVAL_SUBTYPE_ALL)) == NULL)
+		return -1;
+
+	ids = SEXP_list_new(NULL);
+
+	obj_it = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *obj = oval_object_iterator_next(obj_it);
+
+		refs = oval_string_map_new();
+		oval_obj_collect_var_refs(obj, refs);
+		if (_oval_probe_hint_refs(refs, vars)) {
+			id = SEXP_string_newf("%s", oval_object_get_id(obj));
+			SEXP_list_add(ids, id);
+			SEXP_free(id);
+		}
+		oval_string_map_free(refs, NULL);
+	}
+	oval_object_iterator_free(obj_it);
+
+	ste_it = oval_definition_model_get_states(model);
+	while (oval_state_iterator_has_more(ste_it)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_it);
+
+		refs = oval_string_map_new();
+		oval_ste_collect_var_refs(ste, refs);
+		if (_oval_probe_hint_refs(refs, vars)) {
+			id = SEXP_string_newf("%s", oval_state_get_id(ste));
+			SEXP_list_add(ids, id);
+			SEXP_free(id);
+		}
+		oval_string_map_free(refs, NULL);
+	}
+	oval_state_iterator_free(ste_it);
+
+	if (SEXP_list_length(ids) == 0)
+		ret = 0;
+	else
+		ret = ph->func(OVAL_SUBTYPE_ALL, ph->uptr, PROBE_HANDLER_ACT_RESET, ids);
+
+	SEXP_free(ids);
+	return ret;
+}
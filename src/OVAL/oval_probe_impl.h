@@ -48,6 +48,8 @@
 OSCAP_HIDDEN_START;
 
 #define OVAL_PROBE_SCHEME "pipe"
+#define OVAL_PROBE_SCHEME_MEMFD "memfd"
+#define OVAL_PROBE_MEMFD_ENV "OSCAP_PROBE_MEMFD"
 
 #ifndef OVAL_PROBE_DIR
 # define OVAL_PROBE_DIR    "/usr/libexec/openscap"
@@ -69,6 +71,8 @@ const char *oval_subtype_to_str(oval_subtype_t subtype);
 oval_subtype_t oval_str_to_subtype(const char *str);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
+int oval_probe_hint_variables(oval_probe_session_t *sess, struct oval_definition_model *model, struct oval_string_map *vars);
+void oval_probe_prefetch_definition(oval_probe_session_t *sess, struct oval_definition *definition);
 
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
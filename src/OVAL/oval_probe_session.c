@@ -178,7 +178,7 @@ int oval_probe_session_reset(oval_probe_session_t *sess, struct oval_syschar_mod
 		return (-1);
 	}
 
-        if (ph->func(OVAL_SUBTYPE_ALL, ph->uptr, PROBE_HANDLER_ACT_RESET) != 0) {
+        if (ph->func(OVAL_SUBTYPE_ALL, ph->uptr, PROBE_HANDLER_ACT_RESET, NULL) != 0) {
                 return(-1);
         }
         if (sysch != NULL)
@@ -316,11 +316,12 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 	return sysitem;
 }
 
-xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
-			           oval_syschar_resolver resolver, void *user_arg)
+int oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
+			      oval_syschar_resolver resolver, void *user_arg, xmlTextWriterPtr writer)
 {
 
 	xmlNodePtr root_node = NULL;
+	int ret = 0;
 
 	if (parent) { /* result file */
 		root_node = xmlNewTextChild(parent, NULL, BAD_CAST OVAL_ROOT_ELM_SYSCHARS, NULL);
@@ -341,12 +342,16 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	xmlSetNs(root_node, ns_ind);
 	xmlSetNs(root_node, ns_lin);
 	xmlSetNs(root_node, ns_syschar);
+	if (oscap_xml_writer_start_node(writer, root_node) != 0)
+		ret = -1;
 
         /* Always report the generator */
-	oval_generator_to_dom(syschar_model->generator, doc, root_node);
+	if (ret == 0 && oscap_xml_writer_flush_node(writer, oval_generator_to_dom(syschar_model->generator, doc, root_node)) != 0)
+		ret = -1;
 
         /* Report sysinfo */
-	oval_sysinfo_to_dom(oval_syschar_model_get_sysinfo(syschar_model), doc, root_node);
+	if (ret == 0 && oscap_xml_writer_flush_node(writer, oval_sysinfo_to_dom(oval_syschar_model_get_sysinfo(syschar_model), doc, root_node)) != 0)
+		ret = -1;
 
 	struct oval_smc *resolved_smc = NULL;
 	struct oval_syschar_iterator *syschars = oval_syschar_model_get_syschars(syschar_model);
@@ -363,16 +368,19 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	}
 
 	struct oval_string_map *sysitem_map = oval_string_map_new();
-	if (oval_syschar_iterator_has_more(syschars)) {
+	if (ret == 0 && oval_syschar_iterator_has_more(syschars)) {
 		xmlNode *tag_objects = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "collected_objects", NULL);
+		if (oscap_xml_writer_start_node(writer, tag_objects) != 0)
+			ret = -1;
 
-		while (oval_syschar_iterator_has_more(syschars)) {
+		while (ret == 0 && oval_syschar_iterator_has_more(syschars)) {
 			struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
 			struct oval_object *object = oval_syschar_get_object(syschar);
 			if (oval_syschar_get_flag(syschar) == SYSCHAR_FLAG_UNKNOWN /* Skip unneeded syschars */
 			    || oval_object_get_base_obj(object)) /* Skip internal objects */
 				continue;
-			oval_syschar_to_dom(syschar, doc, tag_objects);
+			if (oscap_xml_writer_flush_node(writer, oval_syschar_to_dom(syschar, doc, tag_objects)) != 0)
+				ret = -1;
 			struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
 			while (oval_sysitem_iterator_has_more(sysitems)) {
 				struct oval_sysitem *sysitem = oval_sysitem_iterator_next(sysitems);
@@ -380,39 +388,56 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			}
 			oval_sysitem_iterator_free(sysitems);
 		}
+		if (oscap_xml_writer_end_node(writer, tag_objects) != 0)
+			ret = -1;
 	}
 	oval_smc_free0(resolved_smc);
 	oval_syschar_iterator_free(syschars);
 
 	struct oval_iterator *sysitems = oval_string_map_values(sysitem_map);
-	if (oval_collection_iterator_has_more(sysitems)) {
+	if (ret == 0 && oval_collection_iterator_has_more(sysitems)) {
 		xmlNode *tag_items = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "system_data", NULL);
-		while (oval_collection_iterator_has_more(sysitems)) {
+		if (oscap_xml_writer_start_node(writer, tag_items) != 0)
+			ret = -1;
+		while (ret == 0 && oval_collection_iterator_has_more(sysitems)) {
 			struct oval_sysitem *sysitem = (struct oval_sysitem *)
 			    oval_collection_iterator_next(sysitems);
-			oval_sysitem_to_dom(sysitem, doc, tag_items);
+			if (oscap_xml_writer_flush_node(writer, oval_sysitem_to_dom(sysitem, doc, tag_items)) != 0)
+				ret = -1;
 		}
+		if (oscap_xml_writer_end_node(writer, tag_items) != 0)
+			ret = -1;
 	}
 	oval_collection_iterator_free(sysitems);
 	oval_string_map_free(sysitem_map, NULL);
 
-	return root_node;
+	if (oscap_xml_writer_end_node(writer, root_node) != 0)
+		ret = -1;
+
+	return ret;
 }
 
-int oval_syschar_model_export(struct oval_syschar_model *model, const char *file)
+static int _oval_syschar_model_write(xmlTextWriterPtr writer, void *arg)
 {
-
-	__attribute__nonnull__(model);
-
-	LIBXML_TEST_VERSION;
-
 	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
 	if (doc == NULL) {
 		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
 
-	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL);
-	return oscap_xml_save_filename_free(file, doc);
+	/* The document holds only the elements being written. */
+	int ret = oval_syschar_model_to_dom((struct oval_syschar_model *) arg, doc, NULL, NULL, NULL, writer);
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+int oval_syschar_model_export(struct oval_syschar_model *model, const char *file)
+{
+
+	__attribute__nonnull__(model);
+
+	LIBXML_TEST_VERSION;
+
+	return oscap_xml_save_writer(file, _oval_syschar_model_write, model);
 }
 
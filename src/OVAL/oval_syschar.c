@@ -321,12 +321,13 @@ int oval_syschar_parse_tag(xmlTextReaderPtr reader, struct oval_parser_context *
 	return return_code;
 }
 
-void oval_syschar_to_dom(struct oval_syschar *syschar, xmlDoc * doc, xmlNode * tag_parent)
+xmlNode *oval_syschar_to_dom(struct oval_syschar *syschar, xmlDoc * doc, xmlNode * tag_parent)
 {
+	xmlNode *tag_syschar = NULL;
 
 	if (syschar) {
 		xmlNs *ns_syschar = xmlSearchNsByHref(doc, tag_parent, OVAL_SYSCHAR_NAMESPACE);
-		xmlNode *tag_syschar = xmlNewTextChild(tag_parent, ns_syschar, BAD_CAST "object", NULL);
+		tag_syschar = xmlNewTextChild(tag_parent, ns_syschar, BAD_CAST "object", NULL);
 
 		{		/*attributes */
 			struct oval_object *object = oval_syschar_get_object(syschar);
@@ -372,6 +373,7 @@ void oval_syschar_to_dom(struct oval_syschar *syschar, xmlDoc * doc, xmlNode * t
 			oval_sysitem_iterator_free(sysitems);
 		}
 	}
+	return tag_syschar;
 }
 
 int oval_syschar_get_variable_instance(const struct oval_syschar *syschar)
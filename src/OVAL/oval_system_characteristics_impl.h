@@ -31,6 +31,7 @@
 #ifndef OVAL_SYSCHAR_IMPL
 #define OVAL_SYSCHAR_IMPL
 
+#include <libxml/xmlwriter.h>
 #include "public/oval_system_characteristics.h"
 #include "oval_parser_impl.h"
 #include "adt/oval_smc_impl.h"
@@ -44,15 +45,15 @@ int oval_sysint_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, oval_s
 void oval_sysint_to_dom(struct oval_sysint *, xmlDoc *, xmlNode *);
 
 /* sysinfo */
-void oval_sysinfo_to_dom(struct oval_sysinfo *, xmlDoc *, xmlNode *);
+xmlNode *oval_sysinfo_to_dom(struct oval_sysinfo *, xmlDoc *, xmlNode *);
 int oval_sysinfo_parse_tag(xmlTextReaderPtr reader, struct oval_parser_context *);
 
 /* sysitem */
-void oval_sysitem_to_dom(struct oval_sysitem *, xmlDoc *, xmlNode *);
+xmlNode *oval_sysitem_to_dom(struct oval_sysitem *, xmlDoc *, xmlNode *);
 int oval_sysitem_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *usr);
 
 /* syschar */
-void oval_syschar_to_dom(struct oval_syschar *, xmlDoc *, xmlNode *);
+xmlNode *oval_syschar_to_dom(struct oval_syschar *, xmlDoc *, xmlNode *);
 int oval_syschar_parse_tag(xmlTextReaderPtr, struct oval_parser_context *context, void *);
 oval_syschar_collection_flag_t oval_syschar_flag_parse(xmlTextReaderPtr, char *, oval_syschar_collection_flag_t);
 oval_syschar_status_t oval_syschar_status_parse(xmlTextReaderPtr, char *, oval_syschar_status_t);
@@ -66,7 +67,7 @@ void oval_sysent_to_print(struct oval_sysent *, char *, int);
 
 /* syschar_model */
 typedef bool oval_syschar_resolver(struct oval_syschar *, void *);
-xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model *, xmlDocPtr, xmlNode *, oval_syschar_resolver, void *);
+int oval_syschar_model_to_dom(struct oval_syschar_model *, xmlDocPtr, xmlNode *, oval_syschar_resolver, void *, xmlTextWriterPtr);
 void oval_syschar_model_reset(struct oval_syschar_model *model);
 
 struct oval_syschar *oval_syschar_model_get_new_syschar(struct oval_syschar_model *, struct oval_object *);
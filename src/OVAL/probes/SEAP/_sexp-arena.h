@@ -0,0 +1,45 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef _SEXP_ARENA_H
+#define _SEXP_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "public/sexp-arena.h"
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+#define SEXP_MEMF_ARENA   0x01 /* allocated from an arena chunk */
+#define SEXP_MEMF_COUNTED 0x02 /* accounted in the statistics of a scope */
+#define SEXP_MEMF_BITS    2    /* kept in the spare bits of the headers */
+
+/*
+ * Memory for values and list blocks. The flags returned by SEXP_mem_alloc
+ * have to be stored along with the memory and passed to SEXP_mem_free.
+ */
+void *SEXP_mem_alloc (size_t align, size_t size, uint32_t *flags);
+void  SEXP_mem_free  (void *ptr, size_t size, uint32_t flags);
+
+OSCAP_HIDDEN_END;
+
+#endif /* _SEXP_ARENA_H */
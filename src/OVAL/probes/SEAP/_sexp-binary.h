@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef _SEXP_BINARY_H
+#define _SEXP_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Binary transport encoding of S-expressions
+ *
+ *  frame  := MAGIC <4: payload length, little endian> value
+ *  value  := [DTYPE <varint: n> <n: datatype name>] item
+ *  item   := FALSE | TRUE
+ *          | UINT <varint: n>            non-negative integer
+ *          | NINT <varint: ~n>           negative integer
+ *          | DOUBLE <8: IEEE 754, little endian>
+ *          | STRING <varint: n> <n: octets>
+ *          | LIST <varint: n> <n: value>
+ *
+ * Varints use 7 bits per octet, least significant group first, and the
+ * high bit set on all octets except the last one. The magic octet can't
+ * start a transport S-expression, so the receiver can tell the encodings
+ * apart by looking at the first octet of a message.
+ *
+ * Integers carry only their value and the decoder picks the same number
+ * type as the text parser would. Doubles are transferred bit-exact.
+ */
+#define SEXP_BFRAME_MAGIC 0xb5
+
+#define SEXP_BTAG_FALSE  0x01
+#define SEXP_BTAG_TRUE   0x02
+#define SEXP_BTAG_UINT   0x03
+#define SEXP_BTAG_NINT   0x04
+#define SEXP_BTAG_DOUBLE 0x05
+#define SEXP_BTAG_STRING 0x06
+#define SEXP_BTAG_LIST   0x07
+#define SEXP_BTAG_DTYPE  0x08
+
+#define SEXP_BFRAME_HDRSZ 5          /* magic + payload length */
+#define SEXP_BVARINT_MAX  10         /* max. octets of an encoded uint64_t */
+#define SEXP_BDEPTH_MAX   256        /* max. list nesting accepted by the decoder */
+
+OSCAP_HIDDEN_END;
+
+#endif /* _SEXP_BINARY_H */
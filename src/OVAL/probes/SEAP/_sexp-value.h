@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "_sexp-types.h"
+#include "_sexp-arena.h"
 #include "../../../common/util.h"
 
 OSCAP_HIDDEN_START;
@@ -41,9 +42,12 @@ typedef uint8_t SEXP_valtype_t;
 
 typedef struct {
         uint32_t refs;
-        size_t   size;
+        size_t   size  : sizeof (size_t) * 8 - SEXP_MEMF_BITS;
+        size_t   flags : SEXP_MEMF_BITS; /* SEXP_MEMF_* */
 } __attribute__ ((packed)) SEXP_valhdr_t;
 
+#define SEXP_VALHDR_SIZEMAX (SIZE_MAX >> SEXP_MEMF_BITS)
+
 typedef struct {
         uintptr_t      ptr;
         SEXP_valhdr_t *hdr;
@@ -57,6 +61,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -94,10 +99,17 @@ struct SEXP_val_list {
 struct SEXP_val_lblk {
         uintptr_t nxsz;
         uint16_t  real;
-        uint16_t  refs;
+        uint16_t  refs; /* SEXP_MEMF_* flags in the top bits */
         SEXP_t    memb[];
 } __attribute__ ((packed));
 
+#define SEXP_LBLK_FLAGSHIFT (16 - SEXP_MEMF_BITS)
+#define SEXP_LBLK_REFSMAX   ((uint16_t)((1 << SEXP_LBLK_FLAGSHIFT) - 1))
+#define SEXP_LBLK_REFS(lblk)  ((lblk)->refs & SEXP_LBLK_REFSMAX)
+#define SEXP_LBLK_FLAGS(lblk) ((uint32_t)((lblk)->refs >> SEXP_LBLK_FLAGSHIFT))
+
+#define SEXP_LBLK_SIZE(sz) (sizeof (struct SEXP_val_lblk) + (sizeof (SEXP_t) * (1 << (sz))))
+
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
 
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "public/sm_alloc.h"
+#include "../_sexp-atomic.h"
+#include "mpscq.h"
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+# define mpscq_barrier() __sync_synchronize ()
+#else
+static pthread_mutex_t __mpscq_barrier_mtx = PTHREAD_MUTEX_INITIALIZER;
+# define mpscq_barrier()                                         \
+        do {                                                    \
+                pthread_mutex_lock (&__mpscq_barrier_mtx);      \
+                pthread_mutex_unlock (&__mpscq_barrier_mtx);    \
+        } while (0)
+#endif
+
+#define MPSCQ_CACHELINE 64
+
+/*
+ * Slot `i' of the ring is free for position p (p % capacity == i) if its
+ * sequence number is p, and it holds the element enqueued at position p
+ * if the sequence number is p + 1. The consumer sets it to p + capacity
+ * when the element is dequeued.
+ */
+struct mpscq_slot {
+        volatile uint32_t seq;
+        uint32_t          _pad;
+        uint8_t           data[];
+};
+
+struct mpscq {
+        volatile uint32_t tail;     /* next position to be reserved by a producer */
+        uint8_t           _pad0[MPSCQ_CACHELINE - sizeof (uint32_t)];
+        uint32_t          head;     /* next position to be dequeued; consumer only */
+        volatile uint32_t c_wait;   /* the consumer waits for `notempty' */
+        volatile uint32_t p_wait;   /* number of producers waiting for `notfull' */
+        uint8_t           _pad1[MPSCQ_CACHELINE - 3 * sizeof (uint32_t)];
+
+        uint32_t        capacity;
+        uint32_t        mask;
+        size_t          elsize;
+        size_t          stride;     /* size of a slot */
+        uint8_t        *slots;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t  notempty;
+        pthread_cond_t  notfull;
+};
+
+#define MPSCQ_SLOT(q, pos) ((struct mpscq_slot *)((q)->slots + (size_t)((pos) & (q)->mask) * (q)->stride))
+
+mpscq_t *mpscq_new (uint32_t capacity, size_t elsize)
+{
+        mpscq_t *q;
+        uint32_t i;
+
+        if (capacity == 0 || capacity > (UINT32_C(1) << 30) || elsize == 0) {
+                errno = EINVAL;
+                return (NULL);
+        }
+
+        q = sm_talloc (mpscq_t);
+        memset (q, 0, sizeof (mpscq_t));
+
+        for (q->capacity = 1; q->capacity < capacity; q->capacity <<= 1);
+
+        q->mask   = q->capacity - 1;
+        q->elsize = elsize;
+        q->stride = (sizeof (struct mpscq_slot) + elsize + 7) & ~(size_t)7;
+        q->slots  = sm_alloc (q->stride * q->capacity);
+
+        for (i = 0; i < q->capacity; ++i)
+                MPSCQ_SLOT(q, i)->seq = i;
+
+        if (pthread_mutex_init (&q->mutex, NULL) != 0 ||
+            pthread_cond_init (&q->notempty, NULL) != 0 ||
+            pthread_cond_init (&q->notfull, NULL) != 0)
+        {
+                sm_free (q->slots);
+                sm_free (q);
+                return (NULL);
+        }
+
+        return (q);
+}
+
+uint32_t mpscq_capacity (const mpscq_t *q)
+{
+        return (q->capacity);
+}
+
+static void mpscq_lock (mpscq_t *q)
+{
+        if (pthread_mutex_lock (&q->mutex) != 0) {
+                dE("Can't lock the queue mutex: %u, %s\n", errno, strerror (errno));
+                abort ();
+        }
+}
+
+static void mpscq_unlock (mpscq_t *q)
+{
+        if (pthread_mutex_unlock (&q->mutex) != 0) {
+                dE("Can't unlock the queue mutex: %u, %s\n", errno, strerror (errno));
+                abort ();
+        }
+}
+
+/* Cancellation cleanup handler of the consumer */
+static void mpscq_cancel_unlock (void *arg)
+{
+        mpscq_t *q = (mpscq_t *)arg;
+
+        q->c_wait = 0;
+        mpscq_unlock (q);
+}
+
+/* Cancellation cleanup handler of a producer */
+static void mpscq_cancel_producer (void *arg)
+{
+        mpscq_t *q = (mpscq_t *)arg;
+
+        SEXP_atomic_dec_u32 (&q->p_wait);
+        mpscq_unlock (q);
+}
+
+/* Position `pos' is still occupied by an element of the previous round */
+static inline bool mpscq_full (mpscq_t *q, uint32_t pos)
+{
+        return ((int32_t)(MPSCQ_SLOT(q, pos)->seq - pos) < 0);
+}
+
+static inline bool mpscq_ready (mpscq_t *q, uint32_t pos)
+{
+        return (MPSCQ_SLOT(q, pos)->seq == pos + 1);
+}
+
+static void mpscq_wait_notfull (mpscq_t *q, uint32_t pos)
+{
+        mpscq_lock (q);
+        pthread_cleanup_push (mpscq_cancel_producer, q);
+        SEXP_atomic_inc_u32 (&q->p_wait);
+        mpscq_barrier ();
+
+        while (mpscq_full (q, pos)) {
+                if (pthread_cond_wait (&q->notfull, &q->mutex) != 0) {
+                        dE("An error ocured while waiting for the `notfull' condition: %u, %s\n",
+                           errno, strerror (errno));
+                        abort ();
+                }
+        }
+
+        pthread_cleanup_pop (1);
+}
+
+int mpscq_push (mpscq_t *q, const void *el, uint32_t count)
+{
+        struct mpscq_slot *slot;
+        uint32_t pos, last, i;
+
+        if (count == 0)
+                return (0);
+        if (count > q->capacity) {
+                errno = EINVAL;
+                return (-1);
+        }
+
+        /*
+         * Reserve `count' consecutive positions. The consumer frees the
+         * slots in order, so if the last slot of the range is free, all
+         * of them are.
+         */
+        for (;;) {
+                pos  = q->tail;
+                last = pos + count - 1;
+
+                if (MPSCQ_SLOT(q, last)->seq == last) {
+                        if (SEXP_atomic_cas_u32 (&q->tail, pos, pos + count))
+                                break;
+                } else if (mpscq_full (q, last))
+                        mpscq_wait_notfull (q, last);
+        }
+
+        mpscq_barrier ();
+
+        for (i = 0; i < count; ++i) {
+                slot = MPSCQ_SLOT(q, pos + i);
+                memcpy (slot->data, (const uint8_t *)el + (size_t)i * q->elsize, q->elsize);
+        }
+
+        mpscq_barrier ();
+
+        for (i = 0; i < count; ++i)
+                MPSCQ_SLOT(q, pos + i)->seq = pos + i + 1;
+
+        /*
+         * Wake up the consumer only if it waits. Either the consumer sees
+         * the published slots before it goes to sleep or we see the flag.
+         */
+        mpscq_barrier ();
+
+        if (q->c_wait) {
+                mpscq_lock (q);
+                pthread_cond_signal (&q->notempty);
+                mpscq_unlock (q);
+        }
+
+        return (0);
+}
+
+uint32_t mpscq_pop (mpscq_t *q, void *el, uint32_t max)
+{
+        uint32_t n, i;
+
+        if (max == 0)
+                return (0);
+
+        while (!mpscq_ready (q, q->head)) {
+                /* set between pthread_cleanup_push() and _pop(), i.e. setjmp() and longjmp() */
+                volatile int err = 0;
+
+                mpscq_lock (q);
+                pthread_cleanup_push (mpscq_cancel_unlock, q);
+                q->c_wait = 1;
+                mpscq_barrier ();
+
+                while (!mpscq_ready (q, q->head)) {
+                        if ((err = pthread_cond_wait (&q->notempty, &q->mutex)) != 0) {
+                                dE("An error ocured while waiting for the `notempty' condition: %d, %s\n",
+                                   err, strerror (err));
+                                break;
+                        }
+                }
+
+                pthread_cleanup_pop (1);
+
+                if (err != 0)
+                        return (0);
+        }
+
+        for (n = 1; n < max && mpscq_ready (q, q->head + n); ++n);
+
+        mpscq_barrier ();
+
+        for (i = 0; i < n; ++i)
+                memcpy ((uint8_t *)el + (size_t)i * q->elsize, MPSCQ_SLOT(q, q->head + i)->data, q->elsize);
+
+        mpscq_barrier ();
+
+        for (i = 0; i < n; ++i)
+                MPSCQ_SLOT(q, q->head + i)->seq = q->head + i + q->capacity;
+
+        q->head += n;
+
+        mpscq_barrier ();
+
+        if (q->p_wait > 0) {
+                mpscq_lock (q);
+                pthread_cond_broadcast (&q->notfull);
+                mpscq_unlock (q);
+        }
+
+        return (n);
+}
+
+void mpscq_free (mpscq_t *q)
+{
+        if (q == NULL)
+                return;
+
+        pthread_mutex_destroy (&q->mutex);
+        pthread_cond_destroy (&q->notempty);
+        pthread_cond_destroy (&q->notfull);
+
+        sm_free (q->slots);
+        sm_free (q);
+}
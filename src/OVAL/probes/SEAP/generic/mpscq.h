@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef MPSCQ_H
+#define MPSCQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Bounded multi-producer/single-consumer ring of fixed size elements.
+ *
+ * Producers reserve slots with a single compare-and-swap on the tail
+ * position and publish them by updating per-slot sequence numbers; the
+ * consumer drains published slots in order without taking a lock. The
+ * mutex and the condition variables are used only to put the consumer
+ * to sleep when the ring is empty and the producers when it is full,
+ * so the other side is signaled only if somebody actually waits.
+ */
+typedef struct mpscq mpscq_t;
+
+/**
+ * Create a new ring.
+ * @param capacity number of slots; rounded up to a power of two
+ * @param elsize size of an element in bytes
+ */
+mpscq_t *mpscq_new (uint32_t capacity, size_t elsize);
+
+/**
+ * Enqueue `count' elements stored in the array `el'. The elements are
+ * stored in consecutive slots reserved at once, i.e. they are not
+ * interleaved with elements of other producers. Blocks while there
+ * isn't enough free space; the function is a cancellation point while
+ * it waits.
+ * @retval 0 on success
+ * @retval -1 on error (count greater than the capacity of the ring)
+ */
+int mpscq_push (mpscq_t *q, const void *el, uint32_t count);
+
+/**
+ * Dequeue up to `max' elements into the array `el'. Blocks until at least
+ * one element is available. Must be called by a single thread only. The
+ * function is a cancellation point while it waits.
+ * @return number of dequeued elements, 0 on error
+ */
+uint32_t mpscq_pop (mpscq_t *q, void *el, uint32_t max);
+
+/**
+ * Get the number of slots.
+ */
+uint32_t mpscq_capacity (const mpscq_t *q);
+
+/**
+ * Free the ring. Elements still stored in the ring are discarded.
+ */
+void mpscq_free (mpscq_t *q);
+
+OSCAP_HIDDEN_END;
+
+#endif /* MPSCQ_H */
@@ -32,7 +32,9 @@
 #include <sys/types.h>
 #include <limits.h>
 #include <sys/uio.h>
+#include <sys/socket.h>
 #include <unistd.h>
+#include <stdbool.h>
 
 #include "common/debug_priv.h"
 #include "strbuf.h"
@@ -276,7 +278,7 @@ size_t strbuf_fwrite (FILE *fp, strbuf_t *buf)
         return (size);
 }
 
-ssize_t strbuf_write (strbuf_t *buf, int fd)
+static ssize_t __strbuf_writev (strbuf_t *buf, int fd, bool sock, int flags)
 {
         struct strblk *cur;
         ssize_t rsize, wsize;
@@ -323,10 +325,20 @@ ssize_t strbuf_write (strbuf_t *buf, int fd)
 		/*
 		 * Write
 		 */
-		wsize = writev (fd, iov, ioc);
+		if (sock) {
+			struct msghdr msg;
+
+			memset (&msg, 0, sizeof msg);
+			msg.msg_iov    = iov;
+			msg.msg_iovlen = ioc;
+
+			wsize = sendmsg (fd, &msg, flags);
+		} else
+			wsize = writev (fd, iov, ioc);
 
 		if (wsize < 0) {
-			dE("writev(%d, %p, %d) failed: %u, %s.\n", fd, iov, ioc, errno, strerror (errno));
+			dE("%s(%d, %p, %d) failed: %u, %s.\n", sock ? "sendmsg" : "writev",
+			   fd, iov, ioc, errno, strerror (errno));
                         free(iov);
 			return (-1);
 		}
@@ -339,3 +351,13 @@ ssize_t strbuf_write (strbuf_t *buf, int fd)
 
         return (rsize);
 }
+
+ssize_t strbuf_write (strbuf_t *buf, int fd)
+{
+        return __strbuf_writev (buf, fd, false, 0);
+}
+
+ssize_t strbuf_send (strbuf_t *buf, int fd, int flags)
+{
+        return __strbuf_writev (buf, fd, true, flags);
+}
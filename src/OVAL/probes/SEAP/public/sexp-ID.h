@@ -33,4 +33,10 @@ typedef uint64_t SEXP_ID_t;
 SEXP_ID_t SEXP_ID_v(const SEXP_t *s);
 SEXP_ID_t SEXP_ID_v2(const SEXP_t *s);
 
+/**
+ * Compute a 128-bit S-exp value identifier in a single pass
+ * over the value: id[0] = SEXP_ID_v(s), id[1] = SEXP_ID_v2(s)
+ */
+void SEXP_ID_v128(const SEXP_t *s, SEXP_ID_t id[2]);
+
 #endif /* SEXP_ID_H */
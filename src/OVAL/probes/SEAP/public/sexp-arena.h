@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef SEXP_ARENA_H
+#define SEXP_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An allocation scope for the values and list blocks of S-expressions
+ * created by one thread. In the SEXP_ARENA_CHUNKS mode they are carved
+ * out of large chunks instead of being allocated one by one. A chunk
+ * is released once the scope ended and everything allocated from it
+ * was freed, so values that outlive the scope (e.g. items stored in a
+ * cache) keep only their own chunks alive.
+ *
+ * In the SEXP_ARENA_HEAP mode the allocations are not changed and the
+ * scope only collects the statistics.
+ */
+typedef struct SEXP_arena SEXP_arena_t;
+
+typedef enum {
+        SEXP_ARENA_HEAP   = 0,
+        SEXP_ARENA_CHUNKS = 1
+} SEXP_arena_mode_t;
+
+typedef struct {
+        uint64_t alloc_cnt;  /**< number of values and list blocks allocated in the scope */
+        uint64_t free_cnt;   /**< number of them freed by the thread while in the scope */
+        size_t   bytes;      /**< bytes allocated in the scope and not freed yet */
+        size_t   peak_bytes; /**< maximum of `bytes' */
+        size_t   chunk_cnt;  /**< number of chunks allocated (SEXP_ARENA_CHUNKS only) */
+} SEXP_allocstats_t;
+
+/**
+ * Begin a new allocation scope in the calling thread. Scopes can be
+ * nested, the previous one is restored by SEXP_arena_end.
+ * @return the new scope or NULL on failure
+ */
+SEXP_arena_t *SEXP_arena_begin (SEXP_arena_mode_t mode);
+
+/**
+ * End an allocation scope. Must be called by the thread that began it.
+ * @param stats if not NULL, the statistics of the scope are stored here
+ */
+void SEXP_arena_end (SEXP_arena_t *arena, SEXP_allocstats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEXP_ARENA_H */
@@ -39,6 +39,14 @@ size_t SEXP_fprintfa (FILE *fp, const SEXP_t *s_exp);
 
 int SEXP_sbprintf_t (SEXP_t *s_exp, strbuf_t *sb);
 
+/**
+ * Append the binary transport encoding of an S-exp to a string buffer.
+ * The output is a single length-prefixed frame which can be decoded
+ * using SEXP_parse_b.
+ * @return 0 on success, -1 on error
+ */
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <sys/types.h>
 #include <sexp-types.h>
 
 typedef struct SEXP_psetup SEXP_psetup_t;
@@ -55,6 +56,18 @@ SEXP_t *SEXP_parse (const SEXP_psetup_t *psetup, char *buffer, size_t buflen, SE
 
 bool SEXP_pstate_errorp(SEXP_pstate_t *pstate);
 
+/**
+ * Decode one binary transport frame (see SEXP_sbprintf_b) from the
+ * beginning of a buffer.
+ * @param buffer the received data
+ * @param buflen length of the received data
+ * @param s_exp where to store the decoded S-exp
+ * @return the number of octets consumed, 0 if the buffer doesn't hold
+ * a complete frame yet or -1 on error (errno is set to EILSEQ if the
+ * data isn't a valid frame)
+ */
+ssize_t SEXP_parse_b (const void *buffer, size_t buflen, SEXP_t **s_exp);
+
 #ifdef __cplusplus
 }
 #endif
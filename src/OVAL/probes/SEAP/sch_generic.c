@@ -46,6 +46,20 @@
 
 #define DATA(ptr) ((sch_genericdata_t *)(ptr))
 
+/*
+ * Use the binary encoding if it was offered by the process that
+ * spawned us (see sch_pipe_connect).
+ */
+uint8_t sch_generic_encoding (void)
+{
+        const char *enc = getenv (SEAP_DESC_ENC_ENV);
+
+        if (enc != NULL && strcmp (enc, "text") != 0)
+                return (SEAP_DESC_ENC_BINARY);
+
+        return (SEAP_DESC_ENC_TEXT);
+}
+
 int sch_generic_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
 {
         (void)uri;
@@ -67,6 +81,7 @@ int sch_generic_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
                 data->ofd = fd;
 
         desc->scheme_data = data;
+        desc->encoding    = sch_generic_encoding ();
 
         return (0);
 }
@@ -79,6 +94,7 @@ int sch_generic_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags)
         data->ifd = ifd;
         data->ofd = ofd;
         desc->scheme_data = data;
+        desc->encoding    = sch_generic_encoding ();
 
         return (0);
 }
@@ -101,7 +117,8 @@ ssize_t sch_generic_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
         ret = 0;
         sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-        if (SEXP_sbprintf_t (sexp, sb) != 0)
+        if ((desc->encoding == SEAP_DESC_ENC_BINARY ?
+             SEXP_sbprintf_b (sexp, sb) : SEXP_sbprintf_t (sexp, sb)) != 0)
                 ret = -1;
         else
                 ret = strbuf_write (sb, DATA(desc->scheme_data)->ofd);
@@ -42,6 +42,8 @@ ssize_t sch_generic_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
 int sch_generic_close (SEAP_desc_t *desc, uint32_t flags);
 int sch_generic_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags);
 
+uint8_t sch_generic_encoding (void);
+
 OSCAP_HIDDEN_END;
 
 #endif /* SCH_GENERIC_H */
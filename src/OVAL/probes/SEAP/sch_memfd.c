@@ -0,0 +1,595 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
+#include <common/assume.h>
+
+#include "generic/common.h"
+#include "public/sm_alloc.h"
+#include "public/strbuf.h"
+#include "_sexp-types.h"
+#include "_seap-types.h"
+#include "_sexp-output.h"
+#include "_seap-scheme.h"
+#include "sch_memfd.h"
+#include "seap-descriptor.h"
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+# define sch_memfd_barrier() __sync_synchronize ()
+#else
+static pthread_mutex_t __sch_memfd_barrier_mtx = PTHREAD_MUTEX_INITIALIZER;
+# define sch_memfd_barrier()                                            \
+        do {                                                            \
+                pthread_mutex_lock (&__sch_memfd_barrier_mtx);          \
+                pthread_mutex_unlock (&__sch_memfd_barrier_mtx);        \
+        } while (0)
+#endif
+
+/*
+ * Layout of the memory file: the consumer positions of both rings, each
+ * in its own cache line, followed by the ring buffers. Ring 0 carries
+ * data from the connecting process to the spawned one, ring 1 the other
+ * way.
+ */
+#define SCH_MEMFD_HDRSIZE 4096
+#define SCH_MEMFD_LINE    64
+#define SCH_MEMFD_MAPSIZE (SCH_MEMFD_HDRSIZE + 2 * (size_t)SEAP_MEMFD_RINGSIZE)
+
+#define DATA(ptr) ((sch_memfddata_t *)(ptr))
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+#ifndef MFD_CLOEXEC
+# define MFD_CLOEXEC 0x0001U
+#endif
+
+static sch_memfddata_t *sch_memfd_data_new (void)
+{
+        sch_memfddata_t *data;
+
+        data = sm_talloc (sch_memfddata_t);
+        memset (data, 0, sizeof (sch_memfddata_t));
+
+        data->pipe.pfd = -1;
+        data->pipe.pid = -1;
+        data->pipe.pidfd = -1;
+        data->ifd = -1;
+        data->ofd = -1;
+
+        return (data);
+}
+
+static void sch_memfd_rings (sch_memfddata_t *data, int spawned)
+{
+        sch_memfd_ring_t ring[2];
+        int i;
+
+        if (data->map == NULL)
+                return;
+
+        for (i = 0; i < 2; ++i) {
+                ring[i].head = (uint64_t *)(data->map + i * SCH_MEMFD_LINE);
+                ring[i].data = data->map + SCH_MEMFD_HDRSIZE + i * (size_t)SEAP_MEMFD_RINGSIZE;
+        }
+
+        data->tx = ring[spawned ? 1 : 0];
+        data->rx = ring[spawned ? 0 : 1];
+}
+
+static int sch_memfd_create (void)
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+        return (int) syscall (SYS_memfd_create, "seap", MFD_CLOEXEC);
+#else
+        errno = ENOSYS;
+        return (-1);
+#endif
+}
+
+int sch_memfd_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        char    env[sizeof SEAP_MEMFD_ENV + 16];
+        int     mfd;
+        uint8_t encoding;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data = sch_memfd_data_new ();
+        mfd  = sch_memfd_create ();
+
+        if (mfd < 0) {
+                dW("memfd_create failed: %u, %s; all data will be sent over the socket\n",
+                   errno, strerror (errno));
+        } else if (ftruncate (mfd, SCH_MEMFD_MAPSIZE) != 0 ||
+                   (data->map = mmap (NULL, SCH_MEMFD_MAPSIZE, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED, mfd, 0)) == MAP_FAILED)
+        {
+                dW("Can't map the memory file: %u, %s; all data will be sent over the socket\n",
+                   errno, strerror (errno));
+                close (mfd);
+                mfd = -1;
+                data->map = NULL;
+        } else
+                data->mapsz = SCH_MEMFD_MAPSIZE;
+
+        /*
+         * The descriptor is created with close-on-exec so that processes
+         * spawned by other threads don't inherit it; only the probe does.
+         */
+        snprintf (env, sizeof env, "%s=%d", SEAP_MEMFD_ENV, mfd);
+
+        if (sch_pipe_spawn (&data->pipe, uri, flags, env, mfd, &encoding) != 0) {
+                protect_errno {
+                        if (mfd >= 0)
+                                close (mfd);
+                        if (data->map != NULL)
+                                munmap (data->map, data->mapsz);
+                        sm_free (data);
+                }
+                return (-1);
+        }
+
+        if (mfd >= 0)
+                close (mfd);
+
+        data->ifd = data->pipe.pfd;
+        data->ofd = data->pipe.pfd;
+        sch_memfd_rings (data, 0);
+
+        desc->scheme_data = (void *)data;
+        desc->encoding    = encoding;
+
+        return (0);
+}
+
+int sch_memfd_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_memfd_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        const char *env;
+        struct stat st;
+        int mfd;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+
+        data = sch_memfd_data_new ();
+        data->ifd = ifd;
+        data->ofd = ofd;
+
+        env = getenv (SEAP_MEMFD_ENV);
+        mfd = env != NULL ? (int) strtol (env, NULL, 10) : -1;
+
+        if (mfd >= 0) {
+                if (fstat (mfd, &st) != 0 || st.st_size != (off_t)SCH_MEMFD_MAPSIZE ||
+                    (data->map = mmap (NULL, SCH_MEMFD_MAPSIZE, PROT_READ | PROT_WRITE,
+                                       MAP_SHARED, mfd, 0)) == MAP_FAILED)
+                {
+                        dW("Can't map the memory file (fd=%d): %u, %s\n", mfd, errno, strerror (errno));
+                        data->map = NULL;
+                } else
+                        data->mapsz = SCH_MEMFD_MAPSIZE;
+
+                close (mfd);
+        }
+
+        sch_memfd_rings (data, 1);
+
+        desc->scheme_data = (void *)data;
+        desc->encoding    = sch_generic_encoding ();
+
+        return (0);
+}
+
+/*
+ * Called on EOF or on a failed write. On the connecting side this checks
+ * whether the spawned process died and sets errno to ESRCH if it did.
+ */
+static bool sch_memfd_peer_died (sch_memfddata_t *data)
+{
+        if (data->pipe.pid == -1)
+                return (false);
+
+        return sch_pipe_child_died (&data->pipe);
+}
+
+/*
+ * The connecting side talks over a socket and uses send(2) so that a
+ * dead peer results in EPIPE instead of SIGPIPE. The spawned side may
+ * have been given anything as ifd/ofd.
+ */
+static ssize_t sch_memfd_writev (sch_memfddata_t *data, struct iovec *iov, int iovcnt)
+{
+        struct msghdr msg;
+        ssize_t ret;
+
+        if (data->pipe.pid == -1)
+                return writev (data->ofd, iov, iovcnt);
+
+        memset (&msg, 0, sizeof msg);
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ret = sendmsg (data->ofd, &msg, MSG_NOSIGNAL);
+
+        if (ret < 0 && (errno == EPIPE || errno == ECONNRESET))
+                sch_memfd_peer_died (data);
+
+        return (ret);
+}
+
+/*
+ * Read the header of the next record. Returns 1 on success, 0 on EOF
+ * at a record boundary and -1 on error.
+ */
+static int sch_memfd_readhdr (sch_memfddata_t *data, uint64_t *hdr)
+{
+        uint8_t *p;
+        size_t   l;
+        ssize_t  ret;
+
+        p = (uint8_t *)hdr;
+        l = sizeof (uint64_t);
+
+        while (l > 0) {
+                ret = read (data->ifd, p, l);
+
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        return (-1);
+                } else if (ret == 0) {
+                        if (l == sizeof (uint64_t))
+                                return (0);
+
+                        errno = ENETRESET;
+                        return (-1);
+                }
+
+                p += ret;
+                l -= ret;
+        }
+
+        return (1);
+}
+
+ssize_t sch_memfd_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        uint64_t hdr;
+        ssize_t  ret;
+        size_t   n, off, cpy;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        for (;;) {
+                if (data->rx_ring > 0) {
+                        n   = data->rx_ring < len ? (size_t)data->rx_ring : len;
+                        off = (size_t)(data->rx_head & (SEAP_MEMFD_RINGSIZE - 1));
+                        cpy = SEAP_MEMFD_RINGSIZE - off;
+
+                        if (cpy > n)
+                                cpy = n;
+
+                        memcpy (buf, data->rx.data + off, cpy);
+                        memcpy ((uint8_t *)buf + cpy, data->rx.data, n - cpy);
+
+                        data->rx_head += n;
+                        data->rx_ring -= n;
+
+                        /* the data must be read before the space is released */
+                        sch_memfd_barrier ();
+                        *data->rx.head = data->rx_head;
+
+                        return ((ssize_t)n);
+                }
+
+                if (data->rx_inline > 0) {
+                        n   = data->rx_inline < len ? (size_t)data->rx_inline : len;
+                        ret = read (data->ifd, buf, n);
+
+                        if (ret > 0)
+                                data->rx_inline -= ret;
+                        else if (ret == 0) {
+                                if (!sch_memfd_peer_died (data))
+                                        errno = ENETRESET;
+                                return (-1);
+                        }
+
+                        return (ret);
+                }
+
+                switch (sch_memfd_readhdr (data, &hdr)) {
+                case  1:
+                        break;
+                case  0:
+                        if (sch_memfd_peer_died (data))
+                                return (-1);
+                        return (0);
+                default:
+                        return (-1);
+                }
+
+                if ((hdr & 1) == SEAP_MEMFD_RING) {
+                        if (data->map == NULL || (hdr >> 1) > SEAP_MEMFD_RINGSIZE) {
+                                dE("Invalid ring record: length=%llu\n", (unsigned long long)(hdr >> 1));
+                                errno = EILSEQ;
+                                return (-1);
+                        }
+
+                        data->rx_ring = hdr >> 1;
+                } else
+                        data->rx_inline = hdr >> 1;
+        }
+        /* NOTREACHED */
+        return (-1);
+}
+
+ssize_t sch_memfd_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        uint64_t hdr;
+        struct iovec iov[2];
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        hdr = ((uint64_t)len << 1) | SEAP_MEMFD_INLINE;
+
+        iov[0].iov_base = &hdr;
+        iov[0].iov_len  = sizeof hdr;
+        iov[1].iov_base = buf;
+        iov[1].iov_len  = len;
+
+        return (sch_memfd_writev (data, iov, 2) < 0 ? -1 : (ssize_t)len);
+}
+
+/*
+ * Copy the message (the strbuf content after the record header) to the
+ * ring buffer. Returns -1 if the message should be sent inline.
+ */
+static int sch_memfd_txring (sch_memfddata_t *data, strbuf_t *sb, uint64_t length)
+{
+        struct strblk *blk;
+        uint8_t *src;
+        uint64_t head, pos;
+        size_t   skip, n, off, cpy;
+
+        if (data->map == NULL || length < SEAP_MEMFD_MINSIZE)
+                return (-1);
+
+        head = *(volatile uint64_t *)data->tx.head;
+
+        if (length > SEAP_MEMFD_RINGSIZE - (data->tx_tail - head))
+                return (-1);
+
+        sch_memfd_barrier ();
+
+        pos  = data->tx_tail;
+        skip = sizeof (uint64_t);
+
+        for (blk = sb->beg; blk != NULL; blk = blk->next) {
+                src  = (uint8_t *)blk->data + skip;
+                n    = blk->size - skip;
+                skip = 0;
+
+                while (n > 0) {
+                        off = (size_t)(pos & (SEAP_MEMFD_RINGSIZE - 1));
+                        cpy = SEAP_MEMFD_RINGSIZE - off;
+
+                        if (cpy > n)
+                                cpy = n;
+
+                        memcpy (data->tx.data + off, src, cpy);
+
+                        pos += cpy;
+                        src += cpy;
+                        n   -= cpy;
+                }
+        }
+
+        data->tx_tail = pos;
+
+        return (0);
+}
+
+ssize_t sch_memfd_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        strbuf_t *sb;
+        uint64_t  hdr, length;
+        ssize_t   ret;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (sexp != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        sb  = strbuf_new (SEAP_STRBUF_MAX);
+        hdr = 0;
+
+        /* placeholder for the record header */
+        strbuf_add (sb, (const char *)&hdr, sizeof hdr);
+
+        if ((desc->encoding == SEAP_DESC_ENC_BINARY ?
+             SEXP_sbprintf_b (sexp, sb) : SEXP_sbprintf_t (sexp, sb)) != 0)
+                ret = -1;
+        else {
+                length = strbuf_length (sb) - sizeof hdr;
+
+                if (sch_memfd_txring (data, sb, length) == 0) {
+                        struct iovec iov;
+
+                        hdr = (length << 1) | SEAP_MEMFD_RING;
+                        iov.iov_base = &hdr;
+                        iov.iov_len  = sizeof hdr;
+                        ret = sch_memfd_writev (data, &iov, 1);
+                } else {
+                        hdr = (length << 1) | SEAP_MEMFD_INLINE;
+                        memcpy (sb->beg->data, &hdr, sizeof hdr);
+
+                        if (data->pipe.pid == -1)
+                                ret = strbuf_write (sb, data->ofd);
+                        else if ((ret = strbuf_send (sb, data->ofd, MSG_NOSIGNAL)) < 0 &&
+                                 (errno == EPIPE || errno == ECONNRESET))
+                                sch_memfd_peer_died (data);
+                }
+        }
+
+        protect_errno {
+                strbuf_free (sb);
+        }
+
+        return (ret);
+}
+
+int sch_memfd_close (SEAP_desc_t *desc, uint32_t flags)
+{
+        sch_memfddata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (data->pipe.pid != -1) {
+                if (sch_pipe_terminate (&data->pipe) != 0)
+                        return (-1);
+        } else {
+                if (data->ifd != -1)
+                        close (data->ifd);
+                if (data->ofd != -1 && data->ofd != data->ifd)
+                        close (data->ofd);
+        }
+
+        if (data->map != NULL)
+                munmap (data->map, data->mapsz);
+
+        sm_free (data);
+        desc->scheme_data = NULL;
+
+        return (0);
+}
+
+int sch_memfd_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+{
+        sch_memfddata_t *data;
+        fd_set *wptr, *rptr;
+        fd_set  fset;
+        int fd;
+        struct timeval *tv_ptr, tv;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        /* the rest of a ring record is already in the mapping */
+        if (ev == SEAP_IO_EVREAD && data->rx_ring > 0)
+                return (0);
+
+        /* watch the spawned process too */
+        if (data->pipe.pid != -1)
+                return sch_pipe_select_fd (&data->pipe,
+                                           ev == SEAP_IO_EVREAD ? data->ifd : data->ofd,
+                                           ev, timeout);
+
+        FD_ZERO(&fset);
+        tv_ptr = NULL;
+        wptr   = NULL;
+        rptr   = NULL;
+
+        switch (ev) {
+        case SEAP_IO_EVREAD:
+                fd = data->ifd;
+                FD_SET(fd, &fset);
+                rptr = &fset;
+                break;
+        case SEAP_IO_EVWRITE:
+                fd = data->ofd;
+                FD_SET(fd, &fset);
+                wptr = &fset;
+                break;
+        default:
+                abort ();
+        }
+
+        if (timeout > 0) {
+                tv.tv_sec  = (time_t)timeout;
+                tv.tv_usec = 0;
+                tv_ptr = &tv;
+        }
+
+        switch (select (fd + 1, rptr, wptr, NULL, tv_ptr)) {
+        case -1:
+                protect_errno {
+                        dI("FAIL: errno=%u, %s.\n", errno, strerror (errno));
+                }
+                return (-1);
+        case  0:
+                errno = ETIMEDOUT;
+                return (-1);
+        default:
+                return (FD_ISSET(fd, &fset) ? 0 : -1);
+        }
+        /* NOTREACHED */
+        return (-1);
+}
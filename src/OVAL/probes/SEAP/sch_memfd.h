@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef SCH_MEMFD_H
+#define SCH_MEMFD_H
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "sch_pipe.h"
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * The memfd scheme spawns the peer like the pipe scheme does and shares
+ * a memory file with it. The file holds one ring buffer per direction.
+ * Everything sent over the socket is split into records:
+ *
+ *  record := <8: header> [data]
+ *  header := (length << 1) | type
+ *
+ * Data of an inline record follows the header on the socket. Data of a
+ * ring record was copied to the sender's ring buffer before the header
+ * was sent and the receiver reads it straight from the shared mapping.
+ * Messages shorter than SEAP_MEMFD_MINSIZE, or messages that don't fit
+ * into the free space of the ring, are sent inline.
+ *
+ * The peer learns the descriptor number of the memory file from the
+ * environment variable below; -1 means that only inline records are
+ * used.
+ */
+#define SEAP_MEMFD_ENV      "OSCAP_SEAP_MEMFD"
+#define SEAP_MEMFD_RINGSIZE (16 * 1024 * 1024) /* must be a power of 2 */
+#define SEAP_MEMFD_MINSIZE  (64 * 1024)
+
+#define SEAP_MEMFD_INLINE 0
+#define SEAP_MEMFD_RING   1
+
+typedef struct {
+        uint64_t *head; /* consumer position, in the shared mapping */
+        uint8_t  *data;
+} sch_memfd_ring_t;
+
+typedef struct {
+        sch_pipedata_t pipe; /* must be first, see oval_probe_ext_abort */
+        int      ifd;
+        int      ofd;
+
+        uint8_t *map;        /* shared mapping or NULL */
+        size_t   mapsz;
+
+        sch_memfd_ring_t tx;
+        sch_memfd_ring_t rx;
+        uint64_t tx_tail;    /* producer position */
+        uint64_t rx_head;    /* consumer position */
+        uint64_t rx_ring;    /* data of the current ring record left to read */
+        uint64_t rx_inline;  /* data of the current inline record left to read */
+} sch_memfddata_t;
+
+int sch_memfd_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags);
+int sch_memfd_openfd (SEAP_desc_t *desc, int fd, uint32_t flags);
+int sch_memfd_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags);
+ssize_t sch_memfd_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_memfd_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_memfd_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
+int sch_memfd_close (SEAP_desc_t *desc, uint32_t flags);
+int sch_memfd_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags);
+
+OSCAP_HIDDEN_END;
+
+#endif /* SCH_MEMFD_H */
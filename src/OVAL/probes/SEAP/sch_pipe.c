@@ -38,6 +38,11 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#if defined(__linux__)
+# include <sys/syscall.h>
+#endif
 #include <common/assume.h>
 #include <common/_error.h>
 #include <errno.h>
@@ -54,6 +59,12 @@
 
 extern char **environ;
 
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+#define SCH_PIPE_REAP_TIMEOUT 1000 /* ms */
+
 #define MAX_WHITESPACE_CNT 64
 
 #ifndef PATH_MAX
@@ -160,43 +171,142 @@ fail:
         return (NULL);
 }
 
-static int check_child (pid_t pid, int waitf)
+/*
+ * Returns 0 if the child is running, -1 on error and 1 with errno set to
+ * ESRCH if it's dead. The descriptor may be used by several threads; the
+ * lock makes sure that only one of them reaps the child.
+ */
+int sch_pipe_check_child (sch_pipedata_t *data, int waitf)
 {
-        int status = -1;
+        int   status = -1;
+        int   ret    = 1;
+        pid_t pid;
 
-        switch (pid = waitpid (pid, &status, waitf ? 0 : WNOHANG)) {
-        case  0: return (0);
-        case -1: return (-1);
-        default:
-                /* child is dead */
-		if (WIFSIGNALED(status)) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe with PID=%ld has been killed with signal %d", (long)pid, WTERMSIG(status));
-			errno = EINTR;
-		}
-		if (WCOREDUMP(status)) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe with PID=%ld has core dumped.", (long)pid);
-			errno = EINTR;
-		}
-                if (WIFEXITED(status)) {
-                        errno = WEXITSTATUS(status);
+        pthread_mutex_lock (&data->reap_lock);
+
+        if (!data->reaped) {
+                switch (pid = waitpid (data->pid, &status, waitf ? 0 : WNOHANG)) {
+                case  0:
+                        ret = 0;
+                        break;
+                case -1:
+                        ret = -1;
+                        break;
+                default:
+                        /* child is dead */
+                        data->reaped = true;
+                        data->status = status;
+
+                        if (WIFSIGNALED(status))
+                                oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe with PID=%ld has been killed with signal %d", (long)pid, WTERMSIG(status));
+                        if (WCOREDUMP(status))
+                                oscap_seterr(OSCAP_EFAMILY_OVAL, "Probe with PID=%ld has core dumped.", (long)pid);
+                        if (WIFEXITED(status))
+                                dI("Probe with PID=%ld exited with status %d\n", (long)pid, WEXITSTATUS(status));
                 }
         }
-        return (1);
+
+        pthread_mutex_unlock (&data->reap_lock);
+
+        if (ret == 1)
+                errno = ESRCH;
+
+        return (ret);
 }
 
-int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+/*
+ * Called when an I/O operation on the socket failed or hit EOF. Returns
+ * true and sets errno to ESRCH if the failure was caused by the death of
+ * the child. The socket may be closed a moment before the child can be
+ * reaped, so wait for a while on the process descriptor if there's one.
+ */
+bool sch_pipe_child_died (sch_pipedata_t *data)
+{
+        struct pollfd pfd;
+
+        if (!data->reaped && data->pidfd != -1) {
+                pfd.fd      = data->pidfd;
+                pfd.events  = POLLIN;
+                pfd.revents = 0;
+
+                if (poll (&pfd, 1, SCH_PIPE_REAP_TIMEOUT) < 0)
+                        dI("poll(pidfd) failed: %u, %s\n", errno, strerror (errno));
+        }
+
+        if (sch_pipe_check_child (data, 0) == 1) {
+                dI("Probe with PID=%ld died\n", (long)data->pid);
+                return (true);
+        }
+
+        return (false);
+}
+
+static int sch_pipe_pidfd (pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+        return (int) syscall (SYS_pidfd_open, pid, 0);
+#else
+        errno = ENOSYS;
+        return (-1);
+#endif
+}
+
+/*
+ * Offer the binary encoding to the spawned process unless the text
+ * encoding is forced in our environment. Returns the environment for
+ * the new process, with the `env' variable added if it's not NULL, and
+ * sets the encoding used to send data to it.
+ */
+static char **sch_pipe_environ (const char *env, uint8_t *encoding)
+{
+        const char *enc;
+        char **envp;
+        size_t n, k;
+
+        enc = getenv (SEAP_DESC_ENC_ENV);
+
+        if (enc != NULL) {
+                *encoding = strcmp (enc, "text") == 0 ? SEAP_DESC_ENC_TEXT : SEAP_DESC_ENC_BINARY;
+
+                if (env == NULL)
+                        return (environ);
+        } else
+                *encoding = SEAP_DESC_ENC_BINARY;
+
+        for (n = 0; environ[n] != NULL; ++n);
+
+        envp = sm_alloc (sizeof (char *) * (n + 3));
+        memcpy (envp, environ, sizeof (char *) * n);
+        k = n;
+
+        if (enc == NULL)
+                envp[k++] = SEAP_DESC_ENC_ENV "=binary";
+        if (env != NULL)
+                envp[k++] = (char *)env;
+
+        envp[k] = NULL;
+
+        return (envp);
+}
+
+/*
+ * Spawn the process named by `uri' connected by a socket. The `env'
+ * variable is added to its environment and `keepfd', if not -1, is
+ * inherited by it even if it was opened with close-on-exec.
+ */
+int sch_pipe_spawn (sch_pipedata_t *data, const char *uri, uint32_t flags, const char *env, int keepfd, uint8_t *encoding)
 {
-        sch_pipedata_t *data;
         pid_t pid;
         int   pfd[2] = { -1, -1 };
+        char **envp;
 
-        assume_r (desc != NULL, -1, errno = EFAULT;);
-        assume_r (uri  != NULL, -1, errno = EFAULT;);
-        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
-
-        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
+        data->pidfd    = -1;
+        data->reaped   = false;
+        data->status   = -1;
         data->execpath = get_exec_path (uri, flags);
 
+        pthread_mutex_init (&data->reap_lock, NULL);
+
         if (data->execpath == NULL) {
                 errno = EINVAL;
                 goto fail1;
@@ -212,8 +322,12 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
         if (socketpair (AF_UNIX, SOCK_STREAM, 0, pfd) < 0)
                 goto fail1;
 
+        envp = sch_pipe_environ (env, encoding);
+
         switch (pid = fork ()) {
         case -1: /* error */
+                if (envp != environ)
+                        sm_free (envp);
                 goto fail1;
         case  0: /* child */
                 close (pfd[0]);
@@ -234,19 +348,36 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
                 if (dup2 (pfd[0], STDERR_FILENO) != STDERR_FILENO)
                         _exit (errno);
 #endif
-                execl (data->execpath, data->execpath, NULL);
+                if (keepfd != -1 &&
+                    fcntl (keepfd, F_SETFD, fcntl (keepfd, F_GETFD) & ~FD_CLOEXEC) != 0)
+                        _exit (errno);
+                {
+                        char *argv[2] = { data->execpath, NULL };
+                        execve (data->execpath, argv, envp);
+                }
                 _exit (errno);
         default: /* parent */
                 close (pfd[1]);
 
+                if (envp != environ)
+                        sm_free (envp);
+
                 data->pfd = pfd[0];
                 data->pid = pid;
 
-                if (check_child (data->pid, 0) != 0)
+                if (sch_pipe_check_child (data, 0) != 0)
                         goto fail2;
-        }
 
-        desc->scheme_data = (void *)data;
+                /*
+                 * The process descriptor becomes readable when the child
+                 * exits, see sch_pipe_select. Without it the death of the
+                 * child shows up as EOF or EPIPE on the socket.
+                 */
+                data->pidfd = sch_pipe_pidfd (pid);
+
+                if (data->pidfd < 0)
+                        dI("pidfd_open(%ld) failed: %u, %s\n", (long)pid, errno, strerror (errno));
+        }
 
         return (0);
 fail2:
@@ -257,11 +388,36 @@ fail1:
         protect_errno {
                 if (data->execpath != NULL)
                         sm_free (data->execpath);
-                sm_free (data);
+                data->execpath = NULL;
+                pthread_mutex_destroy (&data->reap_lock);
         }
         return (-1);
 }
 
+int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_pipedata_t *data;
+        uint8_t encoding;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
+
+        if (sch_pipe_spawn (data, uri, flags, NULL, -1, &encoding) != 0) {
+                protect_errno {
+                        sm_free (data);
+                }
+                return (-1);
+        }
+
+        desc->scheme_data = (void *)data;
+        desc->encoding    = encoding;
+
+        return (0);
+}
+
 int sch_pipe_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
 {
         errno = EOPNOTSUPP;
@@ -286,19 +442,20 @@ ssize_t sch_pipe_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
 
         assume_r (data != NULL, -1, errno = EBADF;);
 
-        if (check_child (data->pid, 0) == 0) {
-                if ((ret = read (data->pfd, buf, len)) == 0)
-			if (check_child(data->pid, 0))
-				return (-1);
+        ret = read (data->pfd, buf, len);
 
-		return (ret);
-        } else
-                return (-1);
+        if (ret == 0 || (ret < 0 && errno == ECONNRESET)) {
+                if (sch_pipe_child_died (data))
+                        return (-1);
+        }
+
+        return (ret);
 }
 
 ssize_t sch_pipe_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
 {
         sch_pipedata_t *data;
+        ssize_t         ret;
 
         assume_d (desc != NULL, -1, errno = EFAULT;);
         assume_d (buf  != NULL, -1, errno = EFAULT;);
@@ -307,15 +464,19 @@ ssize_t sch_pipe_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
 
         assume_r (data != NULL, -1, errno = EBADF;);
 
-        if (check_child (data->pid, 0) == 0)
-                return write (data->pfd, buf, len);
-        else
-                return (-1);
+        ret = send (data->pfd, buf, len, MSG_NOSIGNAL);
+
+        if (ret < 0 && (errno == EPIPE || errno == ECONNRESET))
+                sch_pipe_child_died (data);
+
+        return (ret);
 }
 
 ssize_t sch_pipe_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
 {
         sch_pipedata_t *data;
+        ssize_t   ret;
+        strbuf_t *sb;
 
         assume_d (desc != NULL, -1, errno = EFAULT;);
         assume_d (sexp != NULL, -1, errno = EFAULT;);
@@ -324,41 +485,37 @@ ssize_t sch_pipe_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
 
         assume_r (data != NULL, -1, errno = EBADF;);
 
-        if (check_child (data->pid, 0) != 0)
-                return (-1);
-        else {
-                ssize_t ret;
-		strbuf_t *sb;
+        ret = 0;
+        sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-                ret = 0;
-                sb  = strbuf_new (SEAP_STRBUF_MAX);
+        if ((desc->encoding == SEAP_DESC_ENC_BINARY ?
+             SEXP_sbprintf_b (sexp, sb) : SEXP_sbprintf_t (sexp, sb)) != 0)
+                ret = -1;
+        else {
+                ret = strbuf_send (sb, data->pfd, MSG_NOSIGNAL);
 
-                if (SEXP_sbprintf_t (sexp, sb) != 0)
-                        ret = -1;
-                else
-                        ret = strbuf_write (sb, data->pfd);
+                if (ret < 0 && (errno == EPIPE || errno == ECONNRESET))
+                        sch_pipe_child_died (data);
+        }
 
+        protect_errno {
                 strbuf_free (sb);
-
-                return (ret);
         }
+
+        return (ret);
 }
 
-int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
+int sch_pipe_terminate (sch_pipedata_t *data)
 {
         int try;
-        sch_pipedata_t *data;
-
-        assume_d (desc != NULL, -1, errno = EFAULT;);
 
-        data = (sch_pipedata_t *)desc->scheme_data;
-
-        assume_r (data != NULL, -1, errno = EBADF;);
+        if (sch_pipe_check_child (data, 0) == 1)
+                goto clean;
 
         kill (data->pid, SIGTERM);
 
         for (try = 0; try < 3; ++try) {
-                switch (check_child (data->pid, 1)) {
+                switch (sch_pipe_check_child (data, 1)) {
                 case  0:
                         kill (data->pid, SIGTERM);
                         break;
@@ -374,7 +531,7 @@ int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
          */
         kill (data->pid, SIGKILL);
 
-        switch (check_child (data->pid, 0)) {
+        switch (sch_pipe_check_child (data, 0)) {
         case  1:
                 break;
         default:
@@ -383,15 +540,16 @@ int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
 clean:
         close (data->pfd);
 
-        sm_free (data->execpath);
-        sm_free (data);
+        if (data->pidfd != -1)
+                close (data->pidfd);
 
-        desc->scheme_data = NULL;
+        sm_free (data->execpath);
+        pthread_mutex_destroy (&data->reap_lock);
 
         return (0);
 }
 
-int sch_pipe_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
 {
         sch_pipedata_t *data;
 
@@ -401,48 +559,79 @@ int sch_pipe_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags
 
         assume_r (data != NULL, -1, errno = EBADF;);
 
-        if (check_child (data->pid, 0) == 0) {
-                fd_set *wptr, *rptr;
-                fd_set  fset;
-                struct timeval *tv_ptr, tv;
+        if (sch_pipe_terminate (data) != 0)
+                return (-1);
 
-                FD_ZERO(&fset);
-                tv_ptr = NULL;
-                wptr   = NULL;
-                rptr   = NULL;
+        sm_free (data);
+        desc->scheme_data = NULL;
 
-                switch (ev) {
-                case SEAP_IO_EVREAD:
-                        FD_SET(data->pfd, &fset);
-                        rptr = &fset;
-                        break;
-                case SEAP_IO_EVWRITE:
-                        FD_SET(data->pfd, &fset);
-                        wptr = &fset;
-                        break;
-                default:
-                        abort ();
-                }
+        return (0);
+}
 
-                if (timeout > 0) {
-                        tv.tv_sec  = (time_t)timeout;
-                        tv.tv_usec = 0;
-                        tv_ptr = &tv;
-                }
+int sch_pipe_select_fd (sch_pipedata_t *data, int fd, int ev, uint16_t timeout)
+{
+        fd_set  rset, wset;
+        int     nfds, pidfd;
+        struct timeval *tv_ptr, tv;
 
-                assume_d (!(wptr == NULL && rptr == NULL), -1, errno = EINVAL;);
-                assume_d (!(wptr != NULL && rptr != NULL), -1, errno = EINVAL;);
+        FD_ZERO(&rset);
+        FD_ZERO(&wset);
+        tv_ptr = NULL;
 
-                switch (select (data->pfd + 1, rptr, wptr, NULL, tv_ptr)) {
-                case -1:
-                        return (-1);
-                case  0:
-                        errno = ETIMEDOUT;
-                        return (-1);
-                default:
-                        return (FD_ISSET(data->pfd, &fset) ? 0 : -1);
-                }
+        switch (ev) {
+        case SEAP_IO_EVREAD:
+                FD_SET(fd, &rset);
+                break;
+        case SEAP_IO_EVWRITE:
+                FD_SET(fd, &wset);
+                break;
+        default:
+                abort ();
         }
 
-        return (-1);
+        /* wake up when the child exits */
+        pidfd = data->reaped ? -1 : data->pidfd;
+        nfds  = fd;
+
+        if (pidfd != -1) {
+                FD_SET(pidfd, &rset);
+
+                if (pidfd > nfds)
+                        nfds = pidfd;
+        }
+
+        if (timeout > 0) {
+                tv.tv_sec  = (time_t)timeout;
+                tv.tv_usec = 0;
+                tv_ptr = &tv;
+        }
+
+        switch (select (nfds + 1, &rset, &wset, NULL, tv_ptr)) {
+        case -1:
+                return (-1);
+        case  0:
+                errno = ETIMEDOUT;
+                return (-1);
+        default:
+                if (FD_ISSET(fd, &rset) || FD_ISSET(fd, &wset))
+                        return (0);
+
+                if (!sch_pipe_child_died (data))
+                        errno = EINTR;
+
+                return (-1);
+        }
+}
+
+int sch_pipe_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+{
+        sch_pipedata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = (sch_pipedata_t *)desc->scheme_data;
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        return sch_pipe_select_fd (data, data->pfd, ev, timeout);
 }
@@ -26,6 +26,8 @@
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include "../../../common/util.h"
 
 OSCAP_HIDDEN_START;
@@ -33,9 +35,23 @@ OSCAP_HIDDEN_START;
 typedef struct {
         int   pfd;
         pid_t pid;
+        int   pidfd;  /* process descriptor of the child or -1 */
+        int   status; /* exit status, valid if reaped */
+        bool  reaped; /* set under reap_lock */
+        pthread_mutex_t reap_lock;
         char *execpath;
 } sch_pipedata_t;
 
+/*
+ * Process management shared with the schemes that talk to a spawned
+ * process (sch_memfd).
+ */
+int sch_pipe_spawn (sch_pipedata_t *data, const char *uri, uint32_t flags, const char *env, int keepfd, uint8_t *encoding);
+int sch_pipe_check_child (sch_pipedata_t *data, int waitf);
+bool sch_pipe_child_died (sch_pipedata_t *data);
+int sch_pipe_terminate (sch_pipedata_t *data);
+int sch_pipe_select_fd (sch_pipedata_t *data, int fd, int ev, uint16_t timeout);
+
 int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags);
 int sch_pipe_openfd (SEAP_desc_t *desc, int fd, uint32_t flags);
 int sch_pipe_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags);
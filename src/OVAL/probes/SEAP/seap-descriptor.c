@@ -69,6 +69,7 @@ int SEAP_desc_add (SEAP_desctable_t *sd_table, SEXP_pstate_t *pstate,
                 sd_dsc->pstate  = pstate;
                 sd_dsc->scheme  = scheme;
                 sd_dsc->scheme_data = scheme_data;
+                sd_dsc->encoding = SEAP_DESC_ENC_TEXT;
                 sd_dsc->ostate  = NULL;
                 sd_dsc->next_cid = 0;
                 sd_dsc->cmd_c_table = SEAP_cmdtbl_new ();
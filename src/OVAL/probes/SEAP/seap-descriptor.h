@@ -51,6 +51,7 @@ typedef struct {
         SEXP_pstate_t *pstate; /* Parser state */
         SEAP_scheme_t  scheme; /* Protocol/Scheme used for this descriptor */
         void          *scheme_data; /* Protocol/Scheme related data */
+        uint8_t        encoding; /* Transport encoding of sent S-exps */
 
         SEXP_t *msg_queue;
 	rbt_t  *err_queue;
@@ -70,6 +71,17 @@ typedef struct {
 #define SEAP_DESC_FDOUT 0x00000002
 #define SEAP_DESC_SELF  -1
 
+/*
+ * Transport encodings. Received data is accepted in both encodings,
+ * the encoding field selects the one used for sending. A process that
+ * spawns a peer offers the binary encoding to it using the environment
+ * variable below; set it to "text" to use the text encoding in both
+ * directions.
+ */
+#define SEAP_DESC_ENC_TEXT   0
+#define SEAP_DESC_ENC_BINARY 1
+#define SEAP_DESC_ENC_ENV    "OSCAP_SEAP_ENCODING"
+
 typedef struct {
         rbt_t       *tree;
         bitmap_t    *bmap;
@@ -31,6 +31,7 @@
 #include "generic/common.h"
 #include "public/sexp-manip.h"
 #include "_sexp-parser.h"
+#include "_sexp-binary.h"
 #include "_seap-packetq.h"
 #include "_seap-packet.h"
 #include "_seap-scheme.h"
@@ -171,7 +172,7 @@ static int SEAP_packet_sexp2msg (SEXP_t *sexp_msg, SEAP_msg_t *seap_msg)
 
                                 SEXP_free (attr_val);
                         } else {
-                                seap_msg->attrs[attr_i].name  = SEXP_string_subcstr (attr_name, 1, 0);
+                                seap_msg->attrs[attr_i].name  = SEXP_string_subcstr (attr_name, 1, SEXP_string_length (attr_name) - 1);
                                 seap_msg->attrs[attr_i].value = SEXP_list_nth (sexp_msg, msg_n + 1);
 
                                 if (seap_msg->attrs[attr_i].value == NULL) {
@@ -589,6 +590,99 @@ static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
         return (sexp);
 }
 
+/*
+ * Binary frames (see SEXP_sbprintf_b) are collected until the received
+ * data ends on a frame boundary, like the text parser does with S-exps.
+ */
+typedef struct {
+        uint8_t *mem;  /* incomplete frame */
+        size_t   len;
+        size_t   cap;
+        SEXP_t  *list; /* decoded frames */
+} SEAP_bframes_t;
+
+static void SEAP_bframes_free (SEAP_bframes_t *bf)
+{
+        if (bf->mem != NULL)
+                sm_free (bf->mem);
+        if (bf->list != NULL)
+                SEXP_free (bf->list);
+
+        bf->mem  = NULL;
+        bf->len  = 0;
+        bf->cap  = 0;
+        bf->list = NULL;
+}
+
+/*
+ * Decode the frames in the received data. Takes ownership of the data
+ * buffer. Returns 1 if all the data was decoded, 0 if there's an
+ * incomplete frame at the end and -1 on error.
+ */
+static int SEAP_bframes_add (SEAP_bframes_t *bf, void *data, size_t length)
+{
+        uint8_t *mem, *p;
+        size_t   len;
+        ssize_t  ret;
+        SEXP_t  *s_exp;
+
+        if (bf->len > 0) {
+                if (bf->cap - bf->len < length) {
+                        do {
+                                bf->cap <<= 1;
+                        } while (bf->cap - bf->len < length);
+
+                        bf->mem = sm_realloc (bf->mem, bf->cap);
+                }
+
+                memcpy (bf->mem + bf->len, data, length);
+                sm_free (data);
+
+                mem = bf->mem;
+                len = bf->len + length;
+        } else {
+                mem = data;
+                len = length;
+                bf->cap = length;
+        }
+
+        if (bf->list == NULL)
+                bf->list = SEXP_list_new (NULL);
+
+        for (p = mem; len > 0; p += ret, len -= ret) {
+                ret = SEXP_parse_b (p, len, &s_exp);
+
+                if (ret < 0) {
+                        bf->mem = mem;
+                        bf->len = 0;
+                        return (-1);
+                } else if (ret == 0)
+                        break;
+
+                SEXP_list_add (bf->list, s_exp);
+                SEXP_free (s_exp);
+        }
+
+        if (len > 0) {
+                /* keep the incomplete frame at the beginning of the buffer */
+                if (p != mem)
+                        memmove (mem, p, len);
+
+                bf->mem = mem;
+                bf->len = len;
+
+                return (0);
+        }
+
+        sm_free (mem);
+
+        bf->mem = NULL;
+        bf->len = 0;
+        bf->cap = 0;
+
+        return (1);
+}
+
 int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 {
         SEAP_desc_t *dsc;
@@ -600,6 +694,7 @@ int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 
         SEXP_psetup_t *psetup;
         SEXP_pstate_t *pstate;
+        SEAP_bframes_t bframes;
 
         SEXP_t     *psym_sexp;
         char        psym_cstr_b[16+1];
@@ -674,6 +769,11 @@ eloop_exit:
         pstate = NULL;
         psetup = SEXP_psetup_new ();
 
+        bframes.mem  = NULL;
+        bframes.len  = 0;
+        bframes.cap  = 0;
+        bframes.list = NULL;
+
         /*
          * All buffer passed to SEXP_parse will be freed by
          * SEXP_pstate_free (i.e. after successful parsing)
@@ -691,6 +791,7 @@ eloop_exit:
 
                                 sm_free (data_buffer);
                                 SEXP_psetup_free (psetup);
+                                SEAP_bframes_free (&bframes);
 
                                 if (pstate != NULL)
                                         SEXP_pstate_free (pstate);
@@ -701,6 +802,15 @@ eloop_exit:
                         sm_free (data_buffer);
                         SEXP_psetup_free (psetup);
 
+                        if (bframes.len > 0) {
+                                dI("FAIL: incomplete binary frame received\n");
+                                SEAP_bframes_free (&bframes);
+                                errno = ENETRESET;
+                                return (-1);
+                        }
+
+                        SEAP_bframes_free (&bframes);
+
                         if (pstate != NULL) {
                                 dI("FAIL: incomplete S-exp received\n");
                                 errno = ENETRESET;
@@ -718,6 +828,35 @@ eloop_exit:
 			data_buflen = data_length;
 		}
 
+                /*
+                 * A binary frame can only start where no S-exp is being
+                 * parsed, so the first octet of the message tells which
+                 * encoding the peer uses.
+                 */
+                if (pstate == NULL &&
+                    (bframes.len > 0 || *(uint8_t *)data_buffer == SEXP_BFRAME_MAGIC))
+                {
+                        sexp_buffer = NULL;
+
+                        switch (SEAP_bframes_add (&bframes, data_buffer, (size_t)data_length)) {
+                        case 1:
+                                sexp_buffer  = bframes.list;
+                                bframes.list = NULL;
+                                DESC_RUNLOCK(dsc);
+                                goto recv_done;
+                        case 0:
+                                goto recv_wait;
+                        default:
+                                dI("FAIL: invalid binary frame received\n");
+
+                                SEXP_psetup_free (psetup);
+                                SEAP_bframes_free (&bframes);
+
+                                errno = EILSEQ;
+                                return (-1);
+                        }
+                }
+
                 sexp_buffer = SEXP_parse (psetup, data_buffer, data_length, &pstate);
 
                 if (sexp_buffer != NULL) {
@@ -748,6 +887,7 @@ eloop_exit:
 			}
 		}
 
+        recv_wait:
                 if (SCH_SELECT(dsc->scheme, dsc, SEAP_IO_EVREAD, ctx->recv_timeout, 0) != 0) {
                         switch (errno) {
                         case ETIMEDOUT:
@@ -762,14 +902,17 @@ eloop_exit:
                                            dsc, errno, strerror (errno));
 
                                         SEXP_psetup_free (psetup);
-                                        SEXP_pstate_free (pstate);
+                                        SEAP_bframes_free (&bframes);
+
+                                        if (pstate != NULL)
+                                                SEXP_pstate_free (pstate);
                                 }
                                 SEXP_free(sexp_buffer);
                                 return (-1);
                         }
                 }
         }
-
+recv_done:
         SEXP_psetup_free (psetup);
 	SEXP_VALIDATE(sexp_buffer);
 	(*packet) = NULL;
@@ -30,7 +30,10 @@
 #include "generic/common.h"
 #include "_seap-scheme.h"
 
-/* KEEP THIS ARRAY SORTED! */
+/*
+ * The index of a scheme is its SCH_* number. Append new schemes at the
+ * end, SEAP_scheme_search() doesn't depend on the order.
+ */
 const SEAP_schemefn_t __schtbl[] = {
         { "cons",    /* This scheme is used from within probes */
           sch_cons_connect, sch_cons_openfd,
@@ -51,30 +54,24 @@ const SEAP_schemefn_t __schtbl[] = {
           sch_pipe_connect, sch_pipe_openfd,
           sch_pipe_openfd2, sch_pipe_recv,
           sch_pipe_send, sch_pipe_close,
-          sch_pipe_sendsexp, sch_pipe_select }
+          sch_pipe_sendsexp, sch_pipe_select },
+        { "memfd",   /* Like pipe, large messages are passed in shared memory */
+          sch_memfd_connect, sch_memfd_openfd,
+          sch_memfd_openfd2, sch_memfd_recv,
+          sch_memfd_send, sch_memfd_close,
+          sch_memfd_sendsexp, sch_memfd_select }
 };
 
 #define SCHTBLSIZE ((sizeof __schtbl)/sizeof (SEAP_schemefn_t))
 
 SEAP_scheme_t SEAP_scheme_search (const SEAP_schemefn_t fntable[SCHTBLSIZE], const char *sch, size_t schlen)
 {
-        SEAP_scheme_t w, s;
-        int cmp;
-
-        w = SCHTBLSIZE;
-        s = 0;
-
-        while (w > 0) {
-                cmp = strncmp (sch, fntable[s + w/2].schstr, schlen);
+        SEAP_scheme_t s;
 
-                if (cmp > 0) {
-                        s += w/2 + 1;
-                        w  = w - w/2 - 1;
-                } else if (cmp < 0) {
-                        w = w/2;
-                } else {
-                        return (s + w/2);
-                }
+        for (s = 0; s < SCHTBLSIZE; ++s) {
+                if (strncmp (sch, fntable[s].schstr, schlen) == 0 &&
+                    fntable[s].schstr[schlen] == '\0')
+                        return (s);
         }
 
         return (SCH_NONE);
@@ -151,10 +151,13 @@ int SEAP_openfd (SEAP_CTX_t *ctx, int fd, uint32_t flags)
 
 int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
 {
-        SEAP_desc_t *dsc;
+        SEAP_desc_t  *dsc;
+        SEAP_scheme_t scheme;
         int sd;
 
-        sd = SEAP_desc_add (ctx->sd_table, NULL, SCH_GENERIC, NULL);
+        /* A peer spawned by the memfd scheme has to use it too */
+        scheme = getenv (SEAP_MEMFD_ENV) != NULL ? SCH_MEMFD : SCH_GENERIC;
+        sd = SEAP_desc_add (ctx->sd_table, NULL, scheme, NULL);
 
         if (sd < 0) {
                 dI("Can't create/add new SEAP descriptor\n");
@@ -168,7 +171,7 @@ int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
                 return(-1);
         }
 
-        if (SCH_OPENFD2(SCH_GENERIC, dsc, ifd, ofd, flags) != 0) {
+        if (SCH_OPENFD2(scheme, dsc, ifd, ofd, flags) != 0) {
                 dI("FAIL: errno=%u, %s.\n", errno, strerror (errno));
                 return (-1);
         }
@@ -124,4 +124,54 @@ SEXP_ID_t SEXP_ID_v2(const SEXP_t *s)
         return (pair.hash);
 }
 
+/*
+ * Same as SEXP_ID_v_callback, but both parts are computed
+ * during a single traversal of the value.
+ */
+static int SEXP_ID_v128_callback(const SEXP_t *sexp, SEXP_ID_t *hash)
+{
+        SEXP_val_t v_dsc;
+
+        assume_d(sexp != NULL, -1);
+        assume_d(hash != NULL, -1);
+
+        SEXP_val_dsc(&v_dsc, sexp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        case SEXP_VALTYPE_STRING:
+                hash[0] = SEXP_ID_hash(v_dsc.mem, v_dsc.hdr->size, hash[0], 0);
+                hash[1] = SEXP_ID_hash(v_dsc.mem, v_dsc.hdr->size, hash[1], 1);
+                break;
+        case SEXP_VALTYPE_LIST:
+        {
+                SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                                     (int (*)(SEXP_t *, void *)) SEXP_ID_v128_callback,
+                                     (void *) hash,
+                                     SEXP_LCASTP(v_dsc.mem)->offset + 1);
+
+                hash[0] = SEXP_ID_hash(&hash[0], 1, hash[0] + SEXP_LCASTP(v_dsc.mem)->offset, 0);
+                hash[1] = SEXP_ID_hash(&hash[1], 1, hash[1] + SEXP_LCASTP(v_dsc.mem)->offset, 1);
+                break;
+        }
+        case SEXP_VALTYPE_EMPTY:
+                hash[0] = SEXP_ID_hash(&hash[0], 1, hash[0], 0);
+                hash[1] = SEXP_ID_hash(&hash[1], 1, hash[1], 1);
+                break;
+        default:
+                /* Unknown S-exp value type */
+                abort ();
+        }
+
+        return (0);
+}
+
+void SEXP_ID_v128(const SEXP_t *s, SEXP_ID_t id[2])
+{
+        id[0] = 0xAD30917100C0FFEE;
+        id[1] = 0xAD309171FFC0FFEE;
+
+        SEXP_ID_v128_callback(s, id);
+}
+
 /// @}
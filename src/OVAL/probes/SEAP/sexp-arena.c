@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "_sexp-atomic.h"
+#include "_sexp-arena.h"
+#include "public/sm_alloc.h"
+
+/*
+ * Chunks are aligned to their size so that the chunk of an object can be
+ * found by masking its address. Larger objects are always allocated from
+ * the heap.
+ */
+#define SEXP_ARENA_CHUNKSIZE (64 * 1024)
+#define SEXP_ARENA_HDRSIZE   64
+#define SEXP_ARENA_MAXOBJ    (SEXP_ARENA_CHUNKSIZE / 8)
+
+#define SEXP_ARENA_CHUNK(p) \
+        ((struct SEXP_arena_chunk *)((uintptr_t)(p) & ~((uintptr_t)SEXP_ARENA_CHUNKSIZE - 1)))
+
+struct SEXP_arena_chunk {
+        /*
+         * Number of objects allocated from the chunk and not freed yet,
+         * plus one while the chunk is the current chunk of an arena.
+         */
+        uint32_t live;
+};
+
+struct SEXP_arena {
+        SEXP_arena_mode_t        mode;
+        struct SEXP_arena_chunk *chunk; /* current chunk */
+        uintptr_t                cur;   /* first free octet of the current chunk */
+        uintptr_t                end;
+        SEXP_allocstats_t        stats;
+        SEXP_arena_t            *prev;  /* scope to restore when this one ends */
+};
+
+static __thread SEXP_arena_t *__SEXP_arena_cur = NULL;
+
+static void SEXP_arena_chunk_release (struct SEXP_arena_chunk *chunk)
+{
+        if (SEXP_atomic_dec_u32 (&chunk->live) == 0)
+                sm_free (chunk);
+}
+
+static void *SEXP_arena_chunk_alloc (SEXP_arena_t *arena, size_t align, size_t size)
+{
+        uintptr_t p;
+        void     *mem;
+
+        p = (arena->cur + (align - 1)) & ~((uintptr_t)align - 1);
+
+        if (arena->chunk == NULL || p + size > arena->end) {
+                if (sm_memalign (&mem, SEXP_ARENA_CHUNKSIZE, SEXP_ARENA_CHUNKSIZE) != 0)
+                        return (NULL);
+
+                if (arena->chunk != NULL)
+                        SEXP_arena_chunk_release (arena->chunk);
+
+                arena->chunk       = (struct SEXP_arena_chunk *)mem;
+                arena->chunk->live = 1;
+                arena->cur = (uintptr_t)mem + SEXP_ARENA_HDRSIZE;
+                arena->end = (uintptr_t)mem + SEXP_ARENA_CHUNKSIZE;
+                arena->stats.chunk_cnt++;
+
+                p = (arena->cur + (align - 1)) & ~((uintptr_t)align - 1);
+        }
+
+        arena->cur = p + size;
+        SEXP_atomic_inc_u32 (&arena->chunk->live);
+
+        return ((void *)p);
+}
+
+void *SEXP_mem_alloc (size_t align, size_t size, uint32_t *flags)
+{
+        SEXP_arena_t *arena;
+        void *mem;
+
+        arena  = __SEXP_arena_cur;
+        mem    = NULL;
+        *flags = 0;
+
+        if (arena != NULL && arena->mode == SEXP_ARENA_CHUNKS && size <= SEXP_ARENA_MAXOBJ) {
+                if ((mem = SEXP_arena_chunk_alloc (arena, align, size)) != NULL)
+                        *flags |= SEXP_MEMF_ARENA;
+        }
+
+        if (mem == NULL) {
+                if (sm_memalign (&mem, align, size) != 0)
+                        return (NULL);
+        }
+
+        if (arena != NULL) {
+                *flags |= SEXP_MEMF_COUNTED;
+
+                arena->stats.alloc_cnt++;
+                arena->stats.bytes += size;
+
+                if (arena->stats.bytes > arena->stats.peak_bytes)
+                        arena->stats.peak_bytes = arena->stats.bytes;
+        }
+
+        return (mem);
+}
+
+void SEXP_mem_free (void *ptr, size_t size, uint32_t flags)
+{
+        SEXP_arena_t *arena;
+
+        arena = __SEXP_arena_cur;
+
+        /*
+         * Only the frees done by the thread while it is in a scope are
+         * seen here; an object allocated in another scope makes the byte
+         * count approximate, never negative.
+         */
+        if (arena != NULL && (flags & SEXP_MEMF_COUNTED) != 0) {
+                arena->stats.free_cnt++;
+                arena->stats.bytes -= size < arena->stats.bytes ? size : arena->stats.bytes;
+        }
+
+        if (flags & SEXP_MEMF_ARENA)
+                SEXP_arena_chunk_release (SEXP_ARENA_CHUNK(ptr));
+        else
+                sm_free (ptr);
+}
+
+SEXP_arena_t *SEXP_arena_begin (SEXP_arena_mode_t mode)
+{
+        SEXP_arena_t *arena;
+
+        arena = sm_talloc (SEXP_arena_t);
+
+        if (arena == NULL)
+                return (NULL);
+
+        memset (arena, 0, sizeof (SEXP_arena_t));
+
+        arena->mode = mode;
+        arena->prev = __SEXP_arena_cur;
+        __SEXP_arena_cur = arena;
+
+        return (arena);
+}
+
+void SEXP_arena_end (SEXP_arena_t *arena, SEXP_allocstats_t *stats)
+{
+        if (arena == NULL)
+                return;
+
+        _A(__SEXP_arena_cur == arena);
+        __SEXP_arena_cur = arena->prev;
+
+        /* the chunks live on until everything allocated from them is freed */
+        if (arena->chunk != NULL)
+                SEXP_arena_chunk_release (arena->chunk);
+
+        if (stats != NULL)
+                memcpy (stats, &arena->stats, sizeof (SEXP_allocstats_t));
+
+        sm_free (arena);
+}
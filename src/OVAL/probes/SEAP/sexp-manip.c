@@ -846,7 +846,6 @@ char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len)
                 s_len = len;
 
         if (s_len > 0) {
-                s_len = v_dsc.hdr->size / sizeof (char);
                 s_str = sm_alloc (sizeof (char) * (s_len + 1));
 
                 memcpy (s_str, ((char *) v_dsc.mem) + beg, sizeof (char) * s_len);
@@ -1293,12 +1292,13 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                /* free the block after its last member was popped */
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
                         SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                }
         }
 
 #if !defined(NDEBUG)
@@ -1638,16 +1638,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1833,16 +1833,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -42,6 +42,7 @@
 #include "_sexp-value.h"
 #include "_sexp-datatype.h"
 #include "_sexp-rawptr.h"
+#include "_sexp-binary.h"
 
 #define SEXP_SBPRINTF_BUFSZ 1024
 
@@ -212,6 +213,172 @@ int SEXP_sbprintf_t (SEXP_t *s_exp, strbuf_t *sb)
         return (0);
 }
 
+struct SEXP_bbuf {
+        uint8_t *mem;
+        size_t   len;
+        size_t   cap;
+};
+
+static inline uint8_t *SEXP_bbuf_reserve (struct SEXP_bbuf *bb, size_t n)
+{
+        if (bb->cap - bb->len < n) {
+                do {
+                        bb->cap <<= 1;
+                } while (bb->cap - bb->len < n);
+
+                bb->mem = sm_realloc (bb->mem, bb->cap);
+        }
+
+        return (bb->mem + bb->len);
+}
+
+static inline void SEXP_bbuf_varint (struct SEXP_bbuf *bb, uint64_t n)
+{
+        uint8_t *p = SEXP_bbuf_reserve (bb, SEXP_BVARINT_MAX);
+
+        while (n >= 0x80) {
+                *p++ = (uint8_t)(n | 0x80);
+                n  >>= 7;
+        }
+
+        *p++ = (uint8_t)n;
+        bb->len = p - bb->mem;
+}
+
+static inline void SEXP_bbuf_tag (struct SEXP_bbuf *bb, uint8_t tag, uint64_t n)
+{
+        *SEXP_bbuf_reserve (bb, 1) = tag;
+        ++bb->len;
+        SEXP_bbuf_varint (bb, n);
+}
+
+static inline void SEXP_bbuf_octets (struct SEXP_bbuf *bb, const void *mem, size_t len)
+{
+        memcpy (SEXP_bbuf_reserve (bb, len), mem, len);
+        bb->len += len;
+}
+
+static int SEXP_sbprintf_b1 (SEXP_t *s_exp, struct SEXP_bbuf *bb)
+{
+        SEXP_val_t v_dsc;
+
+        if (SEXP_rawptr_mask(s_exp->s_type, SEXP_DATATYPEPTR_MASK) != NULL) {
+                const char *name;
+                size_t      nlen;
+
+                name = SEXP_datatype_name(s_exp->s_type);
+                nlen = strlen (name);
+
+                SEXP_bbuf_tag (bb, SEXP_BTAG_DTYPE, nlen);
+                SEXP_bbuf_octets (bb, name, nlen);
+        }
+
+        if (s_exp->s_valp == 0) {
+                errno = EINVAL;
+                return (-1);
+        }
+
+        SEXP_val_dsc (&v_dsc, s_exp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        {
+                int64_t  i;
+                uint64_t u;
+
+                switch (SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem)) {
+                case SEXP_NUM_BOOL:
+                        *SEXP_bbuf_reserve (bb, 1) = SEXP_NCASTP(b,v_dsc.mem)->n ? SEXP_BTAG_TRUE : SEXP_BTAG_FALSE;
+                        ++bb->len;
+                        return (0);
+                case SEXP_NUM_INT8:   i = SEXP_NCASTP(i8 ,v_dsc.mem)->n; break;
+                case SEXP_NUM_INT16:  i = SEXP_NCASTP(i16,v_dsc.mem)->n; break;
+                case SEXP_NUM_INT32:  i = SEXP_NCASTP(i32,v_dsc.mem)->n; break;
+                case SEXP_NUM_INT64:  i = SEXP_NCASTP(i64,v_dsc.mem)->n; break;
+                case SEXP_NUM_UINT8:  u = SEXP_NCASTP(u8 ,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT16: u = SEXP_NCASTP(u16,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT32: u = SEXP_NCASTP(u32,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_UINT64: u = SEXP_NCASTP(u64,v_dsc.mem)->n; goto unsigned_number;
+                case SEXP_NUM_DOUBLE:
+                {
+                        uint8_t *p;
+                        int      k;
+
+                        memcpy (&u, &SEXP_NCASTP(f,v_dsc.mem)->n, sizeof u);
+                        p    = SEXP_bbuf_reserve (bb, 1 + sizeof u);
+                        p[0] = SEXP_BTAG_DOUBLE;
+
+                        for (k = 1; k <= 8; ++k, u >>= 8)
+                                p[k] = (uint8_t)u;
+
+                        bb->len += 1 + sizeof u;
+                        return (0);
+                }
+                default:
+                        abort ();
+                }
+
+                if (i < 0) {
+                        SEXP_bbuf_tag (bb, SEXP_BTAG_NINT, ~(uint64_t)i);
+                        return (0);
+                }
+
+                u = (uint64_t)i;
+        unsigned_number:
+                SEXP_bbuf_tag (bb, SEXP_BTAG_UINT, u);
+                break;
+        }
+        case SEXP_VALTYPE_STRING:
+                SEXP_bbuf_tag (bb, SEXP_BTAG_STRING, v_dsc.hdr->size / sizeof (char));
+                SEXP_bbuf_octets (bb, v_dsc.mem, v_dsc.hdr->size / sizeof (char));
+                break;
+        case SEXP_VALTYPE_LIST:
+                SEXP_bbuf_tag (bb, SEXP_BTAG_LIST, SEXP_rawval_list_length (SEXP_LCASTP(v_dsc.mem)));
+
+                if (SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, (int (*)(SEXP_t *, void *)) SEXP_sbprintf_b1, (void *)bb,
+                                         SEXP_LCASTP(v_dsc.mem)->offset + 1) != 0)
+                        return (-1);
+                break;
+        default:
+                abort ();
+        }
+
+        return (0);
+}
+
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb)
+{
+        struct SEXP_bbuf bb;
+        size_t plen;
+        int    ret;
+
+        bb.cap = SEXP_SBPRINTF_BUFSZ;
+        bb.mem = sm_alloc (bb.cap);
+        bb.len = SEXP_BFRAME_HDRSZ;
+
+        ret  = SEXP_sbprintf_b1 (s_exp, &bb);
+        plen = bb.len - SEXP_BFRAME_HDRSZ;
+
+        if (ret == 0 && plen > UINT32_MAX) {
+                errno = EFBIG;
+                ret   = -1;
+        }
+
+        if (ret == 0) {
+                bb.mem[0] = SEXP_BFRAME_MAGIC;
+                bb.mem[1] = (uint8_t)(plen);
+                bb.mem[2] = (uint8_t)(plen >> 8);
+                bb.mem[3] = (uint8_t)(plen >> 16);
+                bb.mem[4] = (uint8_t)(plen >> 24);
+
+                ret = strbuf_add (sb, (const char *)bb.mem, bb.len);
+        }
+
+        sm_free (bb.mem);
+
+        return (ret);
+}
+
 typedef struct {
         size_t sz;
         FILE  *fp;
@@ -42,6 +42,7 @@
 #include "generic/xbase64.h"
 #include "generic/strto.h"
 #include "public/strbuf.h"
+#include "_sexp-binary.h"
 
 SEXP_pstate_t *SEXP_pstate_new (void)
 {
@@ -119,7 +120,7 @@ void SEXP_pstate_free (SEXP_pstate_t *pstate)
                                 SEXP_val_t v_dsc;
 
                                 SEXP_val_dsc (&v_dsc, pstate->v_bool[i]);
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                         }
                 }
         }
@@ -1970,3 +1971,260 @@ bool SEXP_pstate_errorp(SEXP_pstate_t *pstate)
 		return (true);
 	}
 }
+
+struct SEXP_bdec {
+        const uint8_t *p; /* current position */
+        const uint8_t *e; /* end of the payload */
+};
+
+static int SEXP_parse_b_varint (struct SEXP_bdec *d, uint64_t *n)
+{
+        uint64_t v = 0;
+        unsigned int s;
+
+        for (s = 0; d->p < d->e && s < 64; s += 7) {
+                uint8_t o = *d->p++;
+
+                v |= (uint64_t)(o & 0x7f) << s;
+
+                if ((o & 0x80) == 0) {
+                        *n = v;
+                        return (0);
+                }
+        }
+
+        return (-1);
+}
+
+static int SEXP_parse_b_number (SEXP_t *s_exp, SEXP_numtype_t t, uint64_t n)
+{
+        SEXP_val_t v_dsc;
+        size_t     size;
+
+        switch (t) {
+        case SEXP_NUM_INT8:   size = sizeof (struct SEXP_val_num_i8);  break;
+        case SEXP_NUM_UINT8:  size = sizeof (struct SEXP_val_num_u8);  break;
+        case SEXP_NUM_INT16:  size = sizeof (struct SEXP_val_num_i16); break;
+        case SEXP_NUM_UINT16: size = sizeof (struct SEXP_val_num_u16); break;
+        case SEXP_NUM_INT32:  size = sizeof (struct SEXP_val_num_i32); break;
+        case SEXP_NUM_UINT32: size = sizeof (struct SEXP_val_num_u32); break;
+        case SEXP_NUM_INT64:  size = sizeof (struct SEXP_val_num_i64); break;
+        case SEXP_NUM_UINT64: size = sizeof (struct SEXP_val_num_u64); break;
+        case SEXP_NUM_DOUBLE: size = sizeof (struct SEXP_val_num_f);   break;
+        default:
+                abort ();
+        }
+
+        if (SEXP_val_new (&v_dsc, size, SEXP_VALTYPE_NUMBER) != 0)
+                return (-1);
+
+        switch (t) {
+        case SEXP_NUM_INT8:   SEXP_NCASTP(i8 ,v_dsc.mem)->n = (int8_t)n;   break;
+        case SEXP_NUM_UINT8:  SEXP_NCASTP(u8 ,v_dsc.mem)->n = (uint8_t)n;  break;
+        case SEXP_NUM_INT16:  SEXP_NCASTP(i16,v_dsc.mem)->n = (int16_t)n;  break;
+        case SEXP_NUM_UINT16: SEXP_NCASTP(u16,v_dsc.mem)->n = (uint16_t)n; break;
+        case SEXP_NUM_INT32:  SEXP_NCASTP(i32,v_dsc.mem)->n = (int32_t)n;  break;
+        case SEXP_NUM_UINT32: SEXP_NCASTP(u32,v_dsc.mem)->n = (uint32_t)n; break;
+        case SEXP_NUM_INT64:  SEXP_NCASTP(i64,v_dsc.mem)->n = (int64_t)n;  break;
+        case SEXP_NUM_UINT64: SEXP_NCASTP(u64,v_dsc.mem)->n = n;           break;
+        case SEXP_NUM_DOUBLE: memcpy (&SEXP_NCASTP(f,v_dsc.mem)->n, &n, sizeof n); break;
+        }
+
+        SEXP_NTYPEP(size, v_dsc.mem) = t;
+        s_exp->s_valp = SEXP_val_ptr (&v_dsc);
+
+        return (0);
+}
+
+static SEXP_datatypePtr_t *SEXP_parse_b_datatype (struct SEXP_bdec *d)
+{
+        SEXP_datatypePtr_t *dt;
+        uint64_t n;
+        char    *name, name_static[128];
+
+        if (SEXP_parse_b_varint (d, &n) != 0 || n == 0 || n > (uint64_t)(d->e - d->p))
+                return (NULL);
+
+        if (n < sizeof name_static)
+                name = name_static;
+        else
+                name = sm_alloc (sizeof (char) * (n + 1));
+
+        memcpy (name, d->p, n);
+        name[n] = '\0';
+        d->p   += n;
+
+        dt = SEXP_datatype_get (&g_datatypes, name);
+
+        if (dt == NULL) {
+                if (name == name_static)
+                        name = strdup (name);
+
+                dt = SEXP_datatype_add (&g_datatypes, name, NULL, NULL);
+
+                if (dt == NULL)
+                        sm_free (name);
+        } else if (name != name_static)
+                sm_free (name);
+
+        return (dt);
+}
+
+static SEXP_t *SEXP_parse_b1 (struct SEXP_bdec *d, unsigned int depth)
+{
+        SEXP_datatypePtr_t *dt = NULL;
+        SEXP_t  *s_exp;
+        uint64_t n;
+        uint8_t  tag;
+
+        if (d->p >= d->e)
+                return (NULL);
+
+        tag = *d->p++;
+
+        if (tag == SEXP_BTAG_DTYPE) {
+                if ((dt = SEXP_parse_b_datatype (d)) == NULL || d->p >= d->e)
+                        return (NULL);
+
+                tag = *d->p++;
+        }
+
+        s_exp = SEXP_new ();
+
+        switch (tag) {
+        case SEXP_BTAG_FALSE:
+        case SEXP_BTAG_TRUE:
+                if (SEXP_number_newb_r (s_exp, tag == SEXP_BTAG_TRUE) == NULL)
+                        goto fail;
+                break;
+        case SEXP_BTAG_UINT:
+                if (SEXP_parse_b_varint (d, &n) != 0)
+                        goto fail;
+
+                /* same number types as the text parser chooses */
+                if (SEXP_parse_b_number (s_exp, n > UINT16_MAX ?
+                                         (n > UINT32_MAX ? SEXP_NUM_UINT64 : SEXP_NUM_UINT32) :
+                                         (n > UINT8_MAX  ? SEXP_NUM_UINT16 : SEXP_NUM_UINT8), n) != 0)
+                        goto fail;
+                break;
+        case SEXP_BTAG_NINT:
+        {
+                int64_t i;
+
+                if (SEXP_parse_b_varint (d, &n) != 0 || n > INT64_MAX)
+                        goto fail;
+
+                i = -(int64_t)n - 1;
+
+                if (SEXP_parse_b_number (s_exp, i < INT16_MIN ?
+                                         (i < INT32_MIN ? SEXP_NUM_INT64 : SEXP_NUM_INT32) :
+                                         (i < INT8_MIN  ? SEXP_NUM_INT16 : SEXP_NUM_INT8), (uint64_t)i) != 0)
+                        goto fail;
+                break;
+        }
+        case SEXP_BTAG_DOUBLE:
+        {
+                int k;
+
+                if (d->e - d->p < 8)
+                        goto fail;
+
+                for (n = 0, k = 7; k >= 0; --k)
+                        n = (n << 8) | d->p[k];
+
+                d->p += 8;
+
+                if (SEXP_parse_b_number (s_exp, SEXP_NUM_DOUBLE, n) != 0)
+                        goto fail;
+                break;
+        }
+        case SEXP_BTAG_STRING:
+                if (SEXP_parse_b_varint (d, &n) != 0 || n > (uint64_t)(d->e - d->p))
+                        goto fail;
+                if (SEXP_string_new_r (s_exp, d->p, (size_t)n) == NULL)
+                        goto fail;
+
+                d->p += n;
+                break;
+        case SEXP_BTAG_LIST:
+        {
+                SEXP_t   *memb;
+                uintptr_t last;
+
+                /* every member takes at least one octet */
+                if (SEXP_parse_b_varint (d, &n) != 0 || n > (uint64_t)(d->e - d->p))
+                        goto fail;
+                if (depth >= SEXP_BDEPTH_MAX)
+                        goto fail;
+                if (SEXP_list_new_r (s_exp, NULL) == NULL)
+                        goto fail;
+
+                for (last = 0; n > 0; --n) {
+                        if ((memb = SEXP_parse_b1 (d, depth + 1)) == NULL)
+                                goto fail;
+                        /*
+                         * The list is private, so the members can be appended
+                         * to the last block directly instead of walking the
+                         * block chain for every member in SEXP_list_add.
+                         */
+                        if (last == 0) {
+                                SEXP_val_t v_dsc;
+
+                                SEXP_list_add (s_exp, memb);
+                                SEXP_val_dsc (&v_dsc, s_exp->s_valp);
+                                last = (uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr;
+                        } else
+                                SEXP_rawval_lblk_add1 (last, memb);
+
+                        last = SEXP_rawval_lblk_last (last);
+                        SEXP_free (memb);
+                }
+                break;
+        }
+        default:
+                goto fail;
+        }
+
+        s_exp->s_type = dt;
+
+        return (s_exp);
+fail:
+        SEXP_free (s_exp);
+        return (NULL);
+}
+
+ssize_t SEXP_parse_b (const void *buffer, size_t buflen, SEXP_t **s_exp)
+{
+        const uint8_t   *b = (const uint8_t *)buffer;
+        struct SEXP_bdec d;
+        size_t           plen;
+
+        if (buffer == NULL || s_exp == NULL) {
+                errno = EFAULT;
+                return (-1);
+        }
+
+        if (buflen < SEXP_BFRAME_HDRSZ)
+                return (0);
+        if (b[0] != SEXP_BFRAME_MAGIC) {
+                errno = EILSEQ;
+                return (-1);
+        }
+
+        plen = (size_t)b[1] | ((size_t)b[2] << 8) | ((size_t)b[3] << 16) | ((size_t)b[4] << 24);
+
+        if (buflen - SEXP_BFRAME_HDRSZ < plen)
+                return (0);
+
+        d.p = b + SEXP_BFRAME_HDRSZ;
+        d.e = d.p + plen;
+
+        if ((*s_exp = SEXP_parse_b1 (&d, 0)) == NULL || d.p != d.e) {
+                SEXP_free (*s_exp);
+                *s_exp = NULL;
+                errno  = EILSEQ;
+                return (-1);
+        }
+
+        return (SEXP_BFRAME_HDRSZ + plen);
+}
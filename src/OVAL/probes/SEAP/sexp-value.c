@@ -28,22 +28,27 @@
 #include <string.h>
 
 #include "_sexp-atomic.h"
+#include "_sexp-arena.h"
 #include "_sexp-value.h"
 #include "public/sm_alloc.h"
 
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
-        void *s_val;
+        void    *s_val;
+        uint32_t flags;
 
-        if (sm_memalign (&s_val, SEXP_VALP_ALIGN,
-                         sizeof (SEXP_valhdr_t) + vmemsize) != 0)
-        {
+        if (vmemsize > SEXP_VALHDR_SIZEMAX)
+                return (-1);
+
+        s_val = SEXP_mem_alloc (SEXP_VALP_ALIGN, sizeof (SEXP_valhdr_t) + vmemsize, &flags);
+
+        if (s_val == NULL)
                 return (-1);
-        }
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
-        dst->hdr->refs = 1;
+        dst->hdr->refs  = 1;
+        dst->hdr->flags = flags;
         dst->hdr->size = vmemsize;
         dst->type      = type;
         dst->ptr       = SEXP_val_ptr (dst);
@@ -58,6 +63,11 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+        SEXP_mem_free (dsc->hdr, sizeof (SEXP_valhdr_t) + dsc->hdr->size, dsc->hdr->flags);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -115,19 +125,21 @@ size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 {
         struct SEXP_val_lblk *lblk;
+        uint32_t flags;
 
         _A(sz < 16);
 
-        if (sm_memalign ((void **)(void *)&lblk, SEXP_LBLK_ALIGN,
-                         sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + (sizeof (SEXP_t) * (1 << sz))) != 0) {
+        lblk = SEXP_mem_alloc (SEXP_LBLK_ALIGN, SEXP_LBLK_SIZE(sz), &flags);
+
+        if (lblk == NULL) {
                 /* TODO: handle this */
                 abort ();
                 return ((uintptr_t) NULL);
         }
 
-        lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
-        lblk->refs = 1;
-        lblk->real = 0;
+        lblk->nxsz  = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
+        lblk->refs  = 1 | (uint16_t)(flags << SEXP_LBLK_FLAGSHIFT);
+        lblk->real  = 0;
 
         return ((uintptr_t)lblk);
 }
@@ -148,7 +160,7 @@ uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
         for (;;) {
                 refs = lblk->refs;
 
-                if (refs < UINT16_MAX) {
+                if ((refs & SEXP_LBLK_REFSMAX) < SEXP_LBLK_REFSMAX) {
                         if (SEXP_atomic_cas_u16 (&lblk->refs, refs, refs + 1))
                                 break;
                 } else
@@ -160,7 +172,7 @@ uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
 
 int SEXP_rawval_lblk_decref (uintptr_t lblkp)
 {
-        return (SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) == 0);
+        return ((SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) & SEXP_LBLK_REFSMAX) == 0);
 }
 
 uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint16_t s_exp_count)
@@ -202,7 +214,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                 lb_prev = 0;
 
                 do {
-                        if (lblk->refs < 2) {
+                        if (SEXP_LBLK_REFS(lblk) < 2) {
                                 lb_prev = (uintptr_t)lblk;
                                 lblk    = SEXP_VALP_LBLK(lblk->nxsz);
                         } else {
@@ -335,7 +347,7 @@ uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n
         lb_prev = 0;
 
         while (n > lblk->real) {
-                if (lblk->refs < 2) {
+                if (SEXP_LBLK_REFS(lblk) < 2) {
                         n      -= lblk->real;
                         lb_prev = (uintptr_t)lblk;
                         lblk    = SEXP_VALP_LBLK(lblk->nxsz);
@@ -533,7 +545,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                SEXP_mem_free (lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK), SEXP_LBLK_FLAGS(lblk));
 
                 if (next != NULL)
                         SEXP_rawval_lblk_free ((uintptr_t)next, func);
@@ -554,7 +566,7 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                SEXP_mem_free (lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK), SEXP_LBLK_FLAGS(lblk));
         }
 
         return;
@@ -55,4 +55,26 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Size of the buffer used for reading the input of the multi-digest
+ * functions. The buffer is page aligned.
+ */
+#define CRAPI_MDIGEST_BUFSZ (128 * 1024)
+
+/**
+ * Digest request for crapi_mdigest_fdv().
+ */
+typedef struct {
+        crapi_alg_t alg;  /**< digest algorithm */
+        void       *dst;  /**< destination buffer */
+        size_t     *size; /**< in: size of `dst', out: digest length or 0 if the digest can't be computed */
+} crapi_mdigest_t;
+
+/**
+ * Compute `num' digests of the file content in a single pass, i.e. all
+ * digest contexts are updated from the same read loop.
+ * @return 0 on success, -1 on error
+ */
+int crapi_mdigest_fdv (int fd, crapi_mdigest_t *req, int num);
+
 #endif /* CRAPI_DIGEST_H */
@@ -103,16 +103,16 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx *ctx)
+static int filehash58_cb (const char *p, const char *f, const char *hash_types[], int hash_cnt, probe_ctx *ctx)
 {
 	SEXP_t *itm;
 
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
+	int fd, i;
 
-	if (f == NULL)
+	if (f == NULL || hash_cnt == 0)
 		return (0);
 
 	/*
@@ -140,61 +140,69 @@ static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx
 	fd = open (pbuf, O_RDONLY);
 
 	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
-
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		int errnum = errno;
+
+		for (i = 0; i < hash_cnt; ++i) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, hash_types[i],
+						NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", pbuf, errnum, strerror (errnum));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
+		}
 	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
+		uint8_t hash_dst[CRAPI_DIGEST_CNT][64];
+		size_t  hash_dstlen[CRAPI_DIGEST_CNT];
+		char    hash_str[129];
 
-		crapi_alg_t hash_type;
+		crapi_mdigest_t hash_req[CRAPI_DIGEST_CNT];
 
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
+		for (i = 0; i < hash_cnt; ++i) {
+			hash_dstlen[i]   = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, hash_types[i]);
+			hash_req[i].alg  = oscap_string_to_enum(CRAPI_ALG_MAP, hash_types[i]);
+			hash_req[i].dst  = hash_dst[i];
+			hash_req[i].size = &hash_dstlen[i];
+		}
 
 		/*
-		 * Compute hash value
+		 * Compute all requested hash values in a single pass
 		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
+		if (crapi_mdigest_fdv (fd, hash_req, hash_cnt) != 0) {
 			close (fd);
 			return (-1);
 		}
 
 		close (fd);
 
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
+		for (i = 0; i < hash_cnt; ++i) {
+			hash_str[0] = '\0';
+			mem2hex (hash_dst[i], hash_dstlen[i], hash_str, sizeof hash_str);
+
+			/*
+			 * Create and add the item
+			 */
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, hash_types[i],
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (hash_dstlen[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", hash_types[i], pbuf);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
 
-		/*
-		 * Create and add the item
-		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
-
-		if (hash_dstlen == 0) {
-			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
-			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
 		}
 	}
 
-	probe_item_collect(ctx, itm);
-
 	return (0);
 }
 
@@ -238,7 +246,9 @@ int probe_main(probe_ctx *ctx, void *mutex)
 	SEXP_t *probe_in;
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
-	int err = 0;
+	const char *hash_types[CRAPI_DIGEST_CNT];
+	const struct oscap_string_map *p;
+	int hash_cnt = 0, err = 0;
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
@@ -281,19 +291,19 @@ int probe_main(probe_ctx *ctx, void *mutex)
 		goto cleanup;
 	}
 
+	/* find hash types to compare with entity, think "not satisfy" */
+	for (p = CRAPI_ALG_MAP; p->value != CRAPI_INVALID; ++p) {
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
+
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE)
+			hash_types[hash_cnt++] = p->string;
+
+		SEXP_free(crapi_hash_type_sexp);
+	}
+
 	if ((ofts = oval_fts_open(path, filename, filepath, behaviors)) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
-			}
+			filehash58_cb(ofts_ent->path, ofts_ent->file, hash_types, hash_cnt, ctx);
 			oval_ftsent_free(ofts_ent);
 		}
 
@@ -36,10 +36,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
+#include <setjmp.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
@@ -63,8 +68,46 @@
 
 oval_schema_version_t over;
 
+#ifndef TFC54_MMAP_MINSIZE
+# define TFC54_MMAP_MINSIZE   (64 * 1024)        /* smaller files are read into a buffer */
+#endif
+#ifndef TFC54_STREAM_MINSIZE
+# define TFC54_STREAM_MINSIZE (64 * 1024 * 1024) /* larger files are matched in chunks (PCRE only) */
+#endif
+#ifndef TFC54_STREAM_CHUNK
+# define TFC54_STREAM_CHUNK   (1024 * 1024)      /* read size of the chunked matcher */
+#endif
+#ifndef TFC54_STREAM_CONTEXT
+# define TFC54_STREAM_CONTEXT 4096               /* bytes kept before the match offset */
+#endif
+
+#define TFC54_PARTIAL (-2) /* the match may continue past the end of the subject */
+
+#if defined USE_REGEX_PCRE && defined PCRE_PARTIAL_HARD
+# define TFC54_STREAM
+#endif
+#if defined USE_REGEX_PCRE || defined REG_STARTEND
+# define TFC54_MMAP
+#endif
+
+struct pfdata {
+	char *pattern;
+	int re_opts;
+	SEXP_t *instance_ent;
+	uint8_t *instance_res; /* cached results of the instance entity comparison */
+	size_t instance_cnt;
+	size_t context;        /* bytes kept before the match offset by the chunked matcher */
+	char **substrs;        /* substrings of a mapped file being reported, NULL terminated */
+        probe_ctx *ctx;
 #if defined USE_REGEX_PCRE
-static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
+	pcre *compiled_regex;
+#elif defined USE_REGEX_POSIX
+	regex_t *compiled_regex;
+#endif
+};
+
+#if defined USE_REGEX_PCRE
+static int get_substrings(struct pfdata *pfd, const char *str, int len, int *ofs, int opts, int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 	char **substrs;
@@ -75,11 +118,14 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		ovector[i] = -1;
 
 #if defined(__SVR4) && defined(__sun)
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
-#else
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	opts |= PCRE_NO_UTF8_CHECK;
 #endif
+	rc = pcre_exec(pfd->compiled_regex, NULL, str, len, *ofs, opts, ovector, ovector_len);
 
+#if defined(TFC54_STREAM)
+	if (rc == PCRE_ERROR_PARTIAL)
+		return TFC54_PARTIAL;
+#endif
 	if (rc < -1) {
 		return -1;
 	} else if (rc == -1) {
@@ -87,7 +133,16 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		return 0;
 	}
 
-	*ofs = (*ofs == ovector[1]) ? ovector[1] + 1 : ovector[1];
+	if (*ofs == ovector[1]) {
+		/* empty match, skip to the next character */
+		*ofs = ovector[1] + 1;
+
+		if (pfd->re_opts & PCRE_UTF8) {
+			while (*ofs < len && (str[*ofs] & 0xc0) == 0x80)
+				++(*ofs);
+		}
+	} else
+		*ofs = ovector[1];
 
 	if (!want_substrs) {
 		/* just report successful match */
@@ -101,39 +156,52 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		rc = ovector_len / 3;
 	}
 
-	substrs = oscap_alloc(rc * sizeof (char *));
+	/*
+	 * The array is handed over before the subject is read, so that the
+	 * substrings can be freed if reading a mapped subject faults.
+	 */
+	substrs = oscap_calloc(rc + 1, sizeof (char *));
+	*substrings = substrs;
+
 	for (i = 0; i < rc; ++i) {
-		int len;
+		int sublen;
 		char *buf;
 
 		if (ovector[2 * i] == -1)
 			continue;
-		len = ovector[2 * i + 1] - ovector[2 * i];
-		buf = oscap_alloc(len + 1);
-		memcpy(buf, str + ovector[2 * i], len);
-		buf[len] = '\0';
+		sublen = ovector[2 * i + 1] - ovector[2 * i];
+		buf = oscap_alloc(sublen + 1);
 		substrs[ret] = buf;
+		memcpy(buf, str + ovector[2 * i], sublen);
+		buf[sublen] = '\0';
 		++ret;
 	}
 
-	*substrings = substrs;
-
 	return ret;
 }
 #elif defined USE_REGEX_POSIX
-static int get_substrings(char *str, int *ofs, regex_t *re, int want_substrs, char ***substrings) {
-	int i, ret, rc;
+static int get_substrings(struct pfdata *pfd, const char *str, int len, int *ofs, int opts, int want_substrs, char ***substrings) {
+	int i, ret, rc, base;
 	regmatch_t pmatch[40];
 	int pmatch_len = sizeof (pmatch) / sizeof (pmatch[0]);
 	char **substrs;
 
-	rc = regexec(re, str + *ofs, pmatch_len, pmatch, 0);
+#if defined(REG_STARTEND)
+	/* the subject doesn't have to be NUL terminated, offsets are relative to `str' */
+	pmatch[0].rm_so = *ofs;
+	pmatch[0].rm_eo = len;
+	base = 0;
+	rc = regexec(pfd->compiled_regex, str, pmatch_len, pmatch, opts | REG_STARTEND);
+#else
+	base = *ofs;
+	rc = regexec(pfd->compiled_regex, str + base, pmatch_len, pmatch, opts);
+#endif
 	if (rc == REG_NOMATCH) {
 		/* no match */
 		return 0;
 	}
 
-	*ofs += (0 == pmatch[0].rm_eo) ? 1 : pmatch[0].rm_eo;
+	*ofs = (*ofs == base + pmatch[0].rm_eo) ? *ofs + 1 : base + pmatch[0].rm_eo;
 
 	if (!want_substrs) {
 		/* just report successful match */
@@ -141,23 +209,24 @@ static int get_substrings(char *str, int *ofs, regex_t *re, int want_substrs, ch
 	}
 
 	ret = 0;
-	substrs = oscap_alloc(pmatch_len * sizeof (char *));
+	/* see the PCRE variant */
+	substrs = oscap_calloc(pmatch_len + 1, sizeof (char *));
+	*substrings = substrs;
+
 	for (i = 0; i < pmatch_len; ++i) {
-		int len;
+		int sublen;
 		char *buf;
 
 		if (pmatch[i].rm_so == -1)
 			continue;
-		len = pmatch[i].rm_eo - pmatch[i].rm_so;
-		buf = oscap_alloc(len + 1);
-		memcpy(buf, str + pmatch[i].rm_so, len);
-		buf[len] = '\0';
+		sublen = pmatch[i].rm_eo - pmatch[i].rm_so;
+		buf = oscap_alloc(sublen + 1);
 		substrs[ret] = buf;
+		memcpy(buf, str + base + pmatch[i].rm_so, sublen);
+		buf[sublen] = '\0';
 		++ret;
 	}
 
-	*substrings = substrs;
-
 	return ret;
 }
 #endif
@@ -207,25 +276,381 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
 	return item;
 }
 
-struct pfdata {
-	char *pattern;
-	int re_opts;
-	SEXP_t *instance_ent;
-        probe_ctx *ctx;
+/*
+ * Compare the instance number with the instance entity of the object.
+ * The results are cached, the same instance numbers are checked for
+ * every match in every file.
+ */
+static int want_instance(struct pfdata *pfd, int instance)
+{
+	enum { INST_UNKNOWN = 0, INST_FALSE, INST_TRUE };
+
+	if (instance < 1)
+		return 0;
+
+	if ((size_t)instance > pfd->instance_cnt) {
+		size_t cnt = pfd->instance_cnt > 0 ? pfd->instance_cnt : 64;
+
+		while (cnt < (size_t)instance)
+			cnt *= 2;
+
+		pfd->instance_res = oscap_realloc(pfd->instance_res, cnt);
+		memset(pfd->instance_res + pfd->instance_cnt, INST_UNKNOWN, cnt - pfd->instance_cnt);
+		pfd->instance_cnt = cnt;
+	}
+
+	if (pfd->instance_res[instance - 1] == INST_UNKNOWN) {
+		SEXP_t *inst = SEXP_number_newi_32(instance);
+
+		if (probe_entobj_cmp(pfd->instance_ent, inst) == OVAL_RESULT_TRUE)
+			pfd->instance_res[instance - 1] = INST_TRUE;
+		else
+			pfd->instance_res[instance - 1] = INST_FALSE;
+
+		SEXP_free(inst);
+	}
+
+	return (pfd->instance_res[instance - 1] == INST_TRUE);
+}
+
+static void report_instance(struct pfdata *pfd, const char *path, const char *file,
+			    int instance, char **substrs, int substr_cnt)
+{
+	int k;
+	SEXP_t *item;
+
+	item = create_item(path, file, pfd->pattern,
+			   instance, substrs, substr_cnt);
+
+	probe_item_collect(pfd->ctx, item);
+
+	for (k = 0; k < substr_cnt; ++k)
+		oscap_free(substrs[k]);
+	oscap_free(substrs);
+}
+
+static void report_error(struct pfdata *pfd, SEXP_t *msg)
+{
+	probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+	SEXP_free(msg);
+	probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+}
+
+/*
+ * Match the pattern against the first `len' bytes of `buf'
+ * and collect the requested instances.
+ */
+static int process_buffer(struct pfdata *pfd, const char *path, const char *file, const char *buf, int len)
+{
+	int ofs = 0, opts = 0, cur_inst = 0, substr_cnt;
+
+	do {
+		int want;
+
+		want = want_instance(pfd, cur_inst + 1);
+		substr_cnt = get_substrings(pfd, buf, len, &ofs, opts, want, &pfd->substrs);
 #if defined USE_REGEX_PCRE
-	pcre *compiled_regex;
-#elif defined USE_REGEX_POSIX
-	regex_t *compiled_regex;
+		/* the subject was validated by the first pcre_exec() call */
+		opts |= PCRE_NO_UTF8_CHECK;
+#endif
+		if (substr_cnt > 0) {
+			++cur_inst;
+
+			if (want) {
+				report_instance(pfd, path, file, cur_inst, pfd->substrs, substr_cnt);
+				pfd->substrs = NULL;
+			}
+		}
+	} while (substr_cnt > 0 && ofs <= len);
+
+	return (substr_cnt < 0 ? -1 : 0);
+}
+
+#if defined(TFC54_MMAP)
+static __thread sigjmp_buf *tfc54_sigbus_env = NULL;
+static __thread const char *tfc54_sigbus_map = NULL;
+static __thread size_t tfc54_sigbus_map_size = 0;
+static struct sigaction tfc54_sigbus_oldact;
+
+/*
+ * Touching a page of a mapped file which was truncated after it was
+ * mapped raises SIGBUS. Jump out of the matcher if the fault happened
+ * while this thread was processing a mapping and the faulting address
+ * is inside of the mapping.
+ */
+static void tfc54_sigbus_handler(int sig, siginfo_t *info, void *uctx)
+{
+	if (tfc54_sigbus_env != NULL && info != NULL && info->si_code > 0 &&
+	    (const char *)info->si_addr >= tfc54_sigbus_map &&
+	    (const char *)info->si_addr < tfc54_sigbus_map + tfc54_sigbus_map_size)
+		siglongjmp(*tfc54_sigbus_env, 1);
+	/*
+	 * Not our fault. Pass the signal to the previous handler, the
+	 * disposition is shared by all threads and has to stay ours.
+	 */
+	if (tfc54_sigbus_oldact.sa_flags & SA_SIGINFO)
+		tfc54_sigbus_oldact.sa_sigaction(sig, info, uctx);
+	else if (tfc54_sigbus_oldact.sa_handler == SIG_DFL) {
+		/* the default action terminates the process */
+		signal(SIGBUS, SIG_DFL);
+		raise(SIGBUS);
+	} else if (tfc54_sigbus_oldact.sa_handler != SIG_IGN)
+		tfc54_sigbus_oldact.sa_handler(sig);
+}
+
+static int tfc54_sigbus_init(void)
+{
+	struct sigaction act;
+
+	memset(&act, 0, sizeof act);
+	sigemptyset(&act.sa_mask);
+	/*
+	 * SIGBUS must not be blocked in the handler, otherwise it would
+	 * stay blocked after siglongjmp().
+	 */
+	act.sa_flags     = SA_SIGINFO | SA_NODEFER;
+	act.sa_sigaction = tfc54_sigbus_handler;
+
+	return sigaction(SIGBUS, &act, &tfc54_sigbus_oldact);
+}
+
+/*
+ * Match the pattern against a mapping of the file. Returns 1 if the
+ * file can't be mapped and has to be read instead.
+ */
+static int process_mapping(struct pfdata *pfd, const char *path, const char *file,
+			   const char *whole_path, int fd, size_t size)
+{
+	sigjmp_buf env;
+	const char *map, *nul;
+	size_t pagesize = sysconf(_SC_PAGESIZE);
+	int ret;
+
+	map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (map == MAP_FAILED) {
+		dD("mmap(%s): %s\n", whole_path, strerror(errno));
+		return (1);
+	}
+#if defined(POSIX_MADV_SEQUENTIAL)
+	posix_madvise((void *)map, size, POSIX_MADV_SEQUENTIAL);
 #endif
+	if (sigsetjmp(env, 0) == 0) {
+		/* the last page of the mapping is mapped whole */
+		tfc54_sigbus_map      = map;
+		tfc54_sigbus_map_size = size + (pagesize - size % pagesize) % pagesize;
+		tfc54_sigbus_env      = &env;
+		/* The content ends at the first NUL byte, as if it was read into a C string */
+		nul = memchr(map, '\0', size);
+		ret = process_buffer(pfd, path, file, map, nul != NULL ? (int)(nul - map) : (int)size);
+	} else {
+		/* free the substrings being copied from the mapping */
+		if (pfd->substrs != NULL) {
+			char **substr;
+
+			for (substr = pfd->substrs; *substr != NULL; ++substr)
+				oscap_free(*substr);
+
+			oscap_free(pfd->substrs);
+			pfd->substrs = NULL;
+		}
+
+		report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+						   "'%s' was truncated while being read.", whole_path));
+		ret = -1;
+	}
+
+	tfc54_sigbus_env = NULL;
+	tfc54_sigbus_map = NULL;
+	munmap((void *)map, size);
+
+	return (ret);
+}
+#endif /* TFC54_MMAP */
+
+#if defined(TFC54_STREAM)
+struct tfc54_stream {
+	int     fd;
+	char   *buf;
+	size_t  size; /* allocated size of the buffer */
+	size_t  used; /* bytes of the file in the buffer */
+	bool    eof;
 };
 
+/*
+ * Drop the first `drop' bytes of the buffer and read up to `want'
+ * more bytes. The end of the file is at the first NUL byte.
+ */
+static int stream_fill(struct tfc54_stream *s, size_t drop, size_t want)
+{
+	ssize_t rd;
+	char   *nul;
+
+	if (drop > 0) {
+		memmove(s->buf, s->buf + drop, s->used - drop);
+		s->used -= drop;
+	}
+
+	if (s->used + want > INT_MAX) {
+		errno = EFBIG;
+		return (-1);
+	}
+
+	if (s->used + want > s->size) {
+		s->size = s->used + want;
+		s->buf  = oscap_realloc(s->buf, s->size);
+	}
+
+	while (want > 0 && !s->eof) {
+		rd = read(s->fd, s->buf + s->used, want);
+
+		if (rd < 0) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+
+		if (rd == 0) {
+			s->eof = true;
+			break;
+		}
+
+		if ((nul = memchr(s->buf + s->used, '\0', rd)) != NULL) {
+			s->used = nul - s->buf;
+			s->eof  = true;
+			break;
+		}
+
+		s->used += rd;
+		want    -= rd;
+	}
+
+	return (0);
+}
+
+/*
+ * Length of the buffer without a trailing incomplete UTF-8 sequence
+ */
+static size_t utf8_complete(const char *buf, size_t len)
+{
+	size_t i = len, n = 0, need;
+	unsigned char c;
+
+	while (i > 0 && n < 3 && (buf[i - 1] & 0xc0) == 0x80) {
+		--i;
+		++n;
+	}
+
+	if (i == 0)
+		return (len);
+
+	c = (unsigned char)buf[i - 1];
+	need = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+
+	return (need > n ? i - 1 : len);
+}
+
+/*
+ * Match the pattern against a file read in chunks. Only a window of the
+ * file is kept in memory. pcre_exec() is called with PCRE_PARTIAL_HARD
+ * on all but the last window, so that a match which may continue past
+ * the end of the window is reported as partial and retried once more
+ * data is read. Some bytes before the match offset are kept in the
+ * window for lookbehind assertions, \b and ^ in multiline mode.
+ */
+static int process_stream(struct pfdata *pfd, const char *path, const char *file,
+			  const char *whole_path, int fd)
+{
+	struct tfc54_stream s;
+	size_t keep, more = TFC54_STREAM_CHUNK;
+	int ofs = 0, opts = 0, avail = 0, cur_inst = 0, substr_cnt, ret = 0;
+	bool need_data = true;
+
+	memset(&s, 0, sizeof s);
+	s.fd = fd;
+
+	for (;;) {
+		char **substrs;
+		int want;
+
+		if (need_data) {
+			keep = (size_t)ofs > pfd->context ? ofs - pfd->context : 0;
+
+			if (stream_fill(&s, keep, more) != 0) {
+				report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+								   "read(): '%s' %s.", whole_path, strerror(errno)));
+				ret = -1;
+				break;
+			}
+
+			ofs  -= keep;
+			opts  = 0;
+			avail = s.eof ? (int)s.used : (int)utf8_complete(s.buf, s.used);
+			need_data = false;
+			/*
+			 * ^ doesn't match at the end of the subject even if it
+			 * follows a newline, so a window which isn't the last one
+			 * must not end with a newline.
+			 */
+			while (!s.eof && avail > 0 && (s.buf[avail - 1] == '\n' || s.buf[avail - 1] == '\r'))
+				--avail;
+		}
+
+		if (ofs > avail || (ofs == avail && !s.eof)) {
+			if (s.eof)
+				break;
+			need_data = true;
+			continue;
+		}
+
+		want = want_instance(pfd, cur_inst + 1);
+		substr_cnt = get_substrings(pfd, s.buf, avail, &ofs,
+					    opts | (s.eof ? 0 : PCRE_PARTIAL_HARD), want, &substrs);
+		/* the window was validated by the first pcre_exec() call */
+		opts = PCRE_NO_UTF8_CHECK;
+
+		if (substr_cnt == TFC54_PARTIAL) {
+			/* grow the window geometrically if the match doesn't fit */
+			more = s.used > TFC54_STREAM_CHUNK ? s.used : TFC54_STREAM_CHUNK;
+			need_data = true;
+			continue;
+		}
+
+		more = TFC54_STREAM_CHUNK;
+
+		if (substr_cnt < 0) {
+			ret = -1;
+			break;
+		}
+
+		if (substr_cnt == 0) {
+			if (s.eof)
+				break;
+			/* no match starts in the window */
+			ofs = avail;
+			need_data = true;
+			continue;
+		}
+
+		++cur_inst;
+
+		if (want)
+			report_instance(pfd, path, file, cur_inst, substrs, substr_cnt);
+	}
+
+	oscap_free(s.buf);
+
+	return (ret);
+}
+#endif /* TFC54_STREAM */
+
 static int process_file(const char *path, const char *file, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
+	int ret = 0, path_len, file_len, fd = -1;
+	size_t buf_size, buf_used = 0;
+	ssize_t rd;
 	char *whole_path = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
 	struct stat st;
 
 	if (file == NULL)
@@ -260,69 +685,71 @@ static int process_file(const char *path, const char *file, void *arg)
 
 	fd = open(whole_path, O_RDONLY);
 	if (fd == -1) {
-		SEXP_t *msg;
+		report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+						   "open(): '%s' %s.", whole_path, strerror(errno)));
+		ret = -1;
+		goto cleanup;
+	}
 
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno));
-		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-		SEXP_free(msg);
-		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+#if defined(TFC54_STREAM)
+	if (st.st_size >= TFC54_STREAM_MINSIZE) {
+		ret = process_stream(pfd, path, file, whole_path, fd);
+		goto cleanup;
+	}
+#endif
+	if (st.st_size >= INT_MAX) {
+		report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+						   "'%s' is too large.", whole_path));
 		ret = -1;
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = oscap_realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
-
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
+#if defined(TFC54_MMAP)
+	if (st.st_size >= TFC54_MMAP_MINSIZE) {
+		ret = process_mapping(pfd, path, file, whole_path, fd, st.st_size);
+		if (ret != 1)
 			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
-
-	do {
-		char **substrs;
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
+		ret = 0;
+	}
+#endif
+	/*
+	 * Read the whole file. The size reported by stat() is only
+	 * a hint, e.g. the files in /proc report 0.
+	 */
+	buf_size = st.st_size < 4096 ? 4096 : st.st_size + 1;
+	buf = oscap_alloc(buf_size);
 
-		SEXP_free(next_inst);
-		substr_cnt = get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
+	for (;;) {
+		rd = read(fd, buf + buf_used, buf_size - buf_used - 1);
 
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
+		if (rd == -1) {
+			if (errno == EINTR)
+				continue;
+			report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+							   "read(): '%s' %s.", whole_path, strerror(errno)));
+			ret = -2;
+			goto cleanup;
+		}
 
-				item = create_item(path, file, pfd->pattern,
-						   cur_inst, substrs, substr_cnt);
+		if (rd == 0)
+			break;
 
-                                probe_item_collect(pfd->ctx, item);
+		buf_used += rd;
 
-				for (k = 0; k < substr_cnt; ++k)
-					oscap_free(substrs[k]);
-				oscap_free(substrs);
+		if (buf_used == buf_size - 1) {
+			if (buf_size > INT_MAX / 2) {
+				report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+								   "'%s' is too large.", whole_path));
+				ret = -1;
+				goto cleanup;
 			}
+			buf_size *= 2;
+			buf = oscap_realloc(buf, buf_size);
 		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	}
+
+	buf[buf_used] = '\0';
+	ret = process_buffer(pfd, path, file, buf, strlen(buf));
 
  cleanup:
 	if (fd != -1)
@@ -337,6 +764,10 @@ static int process_file(const char *path, const char *file, void *arg)
 void *probe_init(void)
 {
   probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
+#if defined(TFC54_MMAP)
+  if (tfc54_sigbus_init() != 0)
+	  dW("Can't install the SIGBUS handler: %s\n", strerror(errno));
+#endif
   return NULL;
 }
 
@@ -353,7 +784,6 @@ int probe_main(probe_ctx *ctx, void *arg)
 	const char *error;
 #elif defined USE_REGEX_POSIX
 	regex_t _re;
-	pfd.compiled_regex = &_re;
 	int err;
 #endif
 	OVAL_FTS    *ofts;
@@ -362,6 +792,9 @@ int probe_main(probe_ctx *ctx, void *arg)
         (void)arg;
 
 	memset(&pfd, 0, sizeof(pfd));
+#if defined USE_REGEX_POSIX
+	pfd.compiled_regex = &_re;
+#endif
 
         probe_in = probe_ctx_getobject(ctx);
 
@@ -414,6 +847,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 	probe_tfc54behaviors_canonicalize(&bh_ent);
 
 	pfd.instance_ent = inst_ent;
+	pfd.context      = TFC54_STREAM_CONTEXT;
         pfd.ctx          = ctx;
 #if defined USE_REGEX_PCRE
 	pfd.re_opts = PCRE_UTF8;
@@ -450,6 +884,16 @@ int probe_main(probe_ctx *ctx, void *arg)
 		probe_cobj_set_flag(probe_ctx_getresult(pfd.ctx), SYSCHAR_FLAG_ERROR);
 		goto cleanup;
 	}
+#if defined(TFC54_STREAM) && defined(PCRE_INFO_MAXLOOKBEHIND)
+	{
+		int lookbehind = 0;
+
+		/* the lookbehind is in characters, a character takes up to 4 bytes in UTF-8 */
+		if (pcre_fullinfo(pfd.compiled_regex, NULL, PCRE_INFO_MAXLOOKBEHIND, &lookbehind) == 0
+		    && (size_t)lookbehind * 4 + 1 > pfd.context)
+			pfd.context = (size_t)lookbehind * 4 + 1;
+	}
+#endif
 #elif defined USE_REGEX_POSIX
 	pfd.re_opts = REG_EXTENDED | REG_NEWLINE;
 	r0 = probe_ent_getattrval(bh_ent, "ignore_case");
@@ -491,6 +935,7 @@ int probe_main(probe_ctx *ctx, void *arg)
         SEXP_free(filepath_ent);
 	if (pfd.pattern != NULL)
 		oscap_free(pfd.pattern);
+	oscap_free(pfd.instance_res);
 #if defined USE_REGEX_PCRE
 	if (pfd.compiled_regex != NULL)
 		pcre_free(pfd.compiled_regex);
@@ -70,9 +70,9 @@ static OVAL_FTS *OVAL_FTS_new()
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
 	if (ofts->ofts_match_path_fts != NULL)
-		fts_close(ofts->ofts_match_path_fts);
+		oval_ftsidx_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
-		fts_close(ofts->ofts_recurse_path_fts);
+		oval_ftsidx_close(ofts->ofts_recurse_path_fts);
 
 	oscap_free(ofts);
 	return;
@@ -93,7 +93,7 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, OVAL_FTSIDXENT *fts_ent)
 {
 	OVAL_FTSENT *ofts_ent;
 
@@ -369,19 +369,19 @@ static char *extract_fixed_path_prefix(char *path)
 
 static int badpartial_check_slash(const char *pattern)
 {
-	pcre *regex;
+	oval_regex_t *regex;
 	const char *errptr = NULL;
 	int errofs = 0, fb, ret;
 
-	regex = pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs, NULL);
+	regex = oval_regex_get(pattern + 1 /* skip '^' */, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error: '%s', error offset: %d, pattern: '%s'.\n",
 		   errofs, errptr, pattern);
 		return -1;
 	}
-	ret = pcre_fullinfo(regex, NULL, PCRE_INFO_FIRSTBYTE, &fb);
-	pcre_free(regex);
+	ret = pcre_fullinfo(regex->re, NULL, PCRE_INFO_FIRSTBYTE, &fb);
+	oval_regex_put(regex);
 	regex = NULL;
 	if (ret != 0) {
 		dE("Failed to validate the pattern: pcre_fullinfo(): "
@@ -401,7 +401,7 @@ static int badpartial_check_slash(const char *pattern)
 #define TEST_PATH1 "/"
 #define TEST_PATH2 "x"
 
-static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
+static int badpartial_transform_pattern(char *pattern, oval_regex_t **regex_out)
 {
 	/*
 	  PCREPARTIAL(3)
@@ -426,7 +426,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	const char *errptr = NULL;
 	char *s, *brkt_mark;
 	bool bracketed = false, found_regex = false;
-	pcre *regex;
+	oval_regex_t *regex;
 
 	/* The processing bellow builds upon the assumption that
 	   the pattern has been validated by pcre_compile() */
@@ -476,7 +476,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	else
 		*s = '\0';
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oval_regex_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, error: '%s', error offset: %d, "
@@ -484,10 +484,10 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 		return -1;
 	}
 
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oval_regex_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 	if (ret != PCRE_ERROR_PARTIAL && ret < 0) {
-		pcre_free(regex);
+		oval_regex_put(regex);
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, pcre_exec() return code: %d, pattern: "
 		   "'%s'.\n", ret, pattern);
@@ -503,14 +503,14 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 /* Verify that the path is usable and try to craft a regex to speed up
    the filesystem traversal. If the path to match is ill-designed, an
    ugly heuristic is employed to obtain something meaningfull. */
-static int process_pattern_match(const char *path, pcre **regex_out)
+static int process_pattern_match(const char *path, oval_regex_t **regex_out)
 {
 	int ret, errofs = 0;
 	char *pattern;
 	const char *test_path1 = TEST_PATH1;
 	//const char *test_path2 = TEST_PATH2;
 	const char *errptr = NULL;
-	pcre *regex;
+	oval_regex_t *regex;
 
 	if (path[0] != '^') {
 		/* Matching has to have a fixed starting point and thus
@@ -528,7 +528,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		pattern = strdup(path);
 	}
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oval_regex_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error offset: %d, error: '%s', pattern: '%s'.\n",
@@ -536,7 +536,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		free(pattern);
 		return -1;
 	}
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oval_regex_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 
 	switch (ret) {
@@ -552,14 +552,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 
 		dI("pcre_exec() returned PCRE_ERROR_PARTIAL for pattern '%s' "
 		   "and test path '%s'.\n", pattern, test_path1);
-		ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+		ret = oval_regex_exec(regex, test_path2, strlen(test_path2),
 			0, PCRE_PARTIAL, NULL, 0);
 		if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 			dE("Failed to validate the pattern: test path '%s' "
 			   "matched by pattern '%s' - the pattern is too "
 			   "general, i.e. inefficient. This could take a "
 			   "lifetime to complete.\n", test_path2, pattern);
-			pcre_free(regex);
+			oval_regex_put(regex);
 			free(pattern);
 			return -2;
 		}
@@ -569,7 +569,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dI("pcre_exec() returned PCRE_ERROR_BADPARTIAL for pattern "
 		   "'%s' and a test path '%s'. Falling back to "
 		   "pcre_fullinfo().\n", pattern, test_path1);
-		pcre_free(regex);
+		oval_regex_put(regex);
 		regex = NULL;
 
 		/* Fallback to first byte check to determin if
@@ -593,7 +593,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "PCRE_ERROR_NOMATCH for pattern '%s' and a test path '%s'. "
 		   "This indicates the pattern doesn't match a leading '/'.\n",
 		   pattern, test_path1);
-		pcre_free(regex);
+		oval_regex_put(regex);
 		free(pattern);
 		return -2;
 	default:
@@ -607,14 +607,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 			   their OVAL definitions that use ".*" as
 			   'path' and then uncomment this.
 
-			ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+			ret = oval_regex_exec(regex, test_path2, strlen(test_path2),
 					0, PCRE_PARTIAL, NULL, 0);
 			if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 				dE("Failed to validate the pattern: test path '%s' "
 				   "matched by pattern '%s' - the pattern is too "
 				   "general, i.e. inefficient. This could take a "
 				   "lifetime to complete.\n", test_path2, pattern);
-				pcre_free(regex);
+				oval_regex_put(regex);
 				free(pattern);
 				return -2;
 			}
@@ -625,7 +625,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dE("Failed to validate the pattern: pcre_exec() return "
 		   "code: %d, pattern '%s', test path '%s'.\n", ret,
 		   pattern, test_path1);
-		pcre_free(regex);
+		oval_regex_put(regex);
 		free(pattern);
 		return -1;
 	}
@@ -668,7 +668,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 	uint32_t path_op;
 	bool nilfilename = false;
-	pcre *regex = NULL;
+	oval_regex_t *regex = NULL;
 	struct stat st;
 
 	assume_d((path == NULL && filename == NULL && filepath != NULL)
@@ -823,29 +823,24 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 		return NULL;
 	}
 
-	dI("fts_open args: path: \"%s\", options: %d.\n", paths[0], mtc_fts_options);
+	dI("oval_ftsidx_open args: path: \"%s\", options: %d.\n", paths[0], mtc_fts_options);
 
 	ofts = OVAL_FTS_new();
-	/* reset errno as fts_open() doesn't do it itself. */
+	/* oval_ftsidx_open() reports an unreadable root only through errno, reset it. */
 	errno = 0;
-	ofts->ofts_match_path_fts = fts_open((char * const *) paths, mtc_fts_options, NULL);
+	ofts->ofts_match_path_fts = oval_ftsidx_open(paths[0], mtc_fts_options);
 	free((void *) paths[0]);
-	/* fts_open() doesn't return NULL for all errors (e.g. nonexistent paths),
-	   so check errno to detect it. Far from being perfect. */
+	/* Like fts_open(), oval_ftsidx_open() returns a walker even if the root
+	   can't be stat'ed (e.g. a nonexistent path) and leaves errno set. */
 	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
-		dE("fts_open() failed, errno: %d \"%s\".\n", errno, strerror(errno));
+		dE("oval_ftsidx_open() failed, errno: %d \"%s\".\n", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
 		return (NULL);
 	}
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
-		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
-	}
+	ofts->ofts_path_regex = regex;
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if   defined(__SVR4) && defined(__sun)
@@ -854,22 +849,18 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 		ofts->localdevs = fsdev_init(NULL, 0);
 		if (ofts->localdevs == NULL) {
 			dE("fsdev_init() failed.\n");
-			/* One dummy read to get rid of an uninitialized
-			 * value in the FTS data before calling
-			 * fts_close() on it. */
-			fts_read(ofts->ofts_match_path_fts);
 			oval_fts_close(ofts);
 			return (NULL);
 		}
 #endif
 	} else if (filesystem == OVAL_RECURSE_FS_DEFINED) {
 		/* store the device id for future comparison */
-		FTSENT *fts_ent;
+		OVAL_FTSIDXENT *fts_ent;
 
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = oval_ftsidx_read(ofts->ofts_match_path_fts);
 		if (fts_ent != NULL) {
 			ofts->ofts_recurse_path_devid = fts_ent->fts_statp->st_dev;
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
+			oval_ftsidx_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
 		}
 	}
 
@@ -896,7 +887,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, OVAL_FTSIDXENT *fts_ent) {
 # if defined (__SVR4) && defined(__sun)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
@@ -915,15 +906,15 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 }
 
 /* find the first matching path or filepath */
-static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
+static OVAL_FTSIDXENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent = NULL;
+	OVAL_FTSIDXENT *fts_ent = NULL;
 	SEXP_t *stmp;
 	oval_result_t ores;
 
 	/* iterate until a match is found or all elements have been traversed */
 	for (;;) {
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = oval_ftsidx_read(ofts->ofts_match_path_fts);
 		if (fts_ent == NULL)
 			return NULL;
 		switch (fts_ent->fts_info) {
@@ -931,7 +922,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			continue;
 		case FTS_DC:
 			dW("Filesystem tree cycle detected at '%s'.\n", fts_ent->fts_path);
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsidx_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -946,19 +937,19 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 #if defined(OSCAP_FTS_DEBUG)
 			dI("Only the target of a symlink gets reported, skipping '%s'.\n", fts_ent->fts_path, fts_ent->fts_name);
 #endif
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
+			oval_ftsidx_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
 		if (_oval_fts_is_local(ofts, fts_ent)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.\n", fts_ent->fts_path);
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 		/* don't recurse beyond the initial filesystem */
 		if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 		    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 		    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -966,14 +957,14 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
 			int ret, svec[3];
 
-			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
+			ret = oval_regex_exec(ofts->ofts_path_regex,
 					fts_ent->fts_path, fts_ent->fts_pathlen, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
 			if (ret < 0) {
 				switch (ret) {
 				case PCRE_ERROR_NOMATCH:
 					dI("Partial match optimization: PCRE_ERROR_NOMATCH, skipping.\n");
-					fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsidx_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				case PCRE_ERROR_PARTIAL:
 					dI("Partial match optimization: PCRE_ERROR_PARTIAL, continuing.\n");
@@ -1012,16 +1003,16 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 	    ofts->ofts_sfilename == NULL &&
 	    ofts->ofts_sfilepath == NULL)
 	{
-		fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+		oval_ftsidx_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 	}
 
 	return fts_ent;
 }
 
 /* find the first matching file or directory */
-static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
+static OVAL_FTSIDXENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 {
-	FTSENT *out_fts_ent = NULL;
+	OVAL_FTSIDXENT *out_fts_ent = NULL;
 	/* the condition below is correct because ofts_sfilepath is NULL here */
 	bool collect_dirs = (ofts->ofts_sfilename == NULL);
 
@@ -1042,25 +1033,25 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 			char * const paths[2] = { ofts->ofts_match_path_fts_ent->fts_path, NULL };
 
 #if defined(OSCAP_FTS_DEBUG)
-			dI("fts_open args: path: \"%s\", options: %d.\n",
+			dI("oval_ftsidx_open args: path: \"%s\", options: %d.\n",
 				paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
-			/* reset errno as fts_open() doesn't do it itself. */
+			/* oval_ftsidx_open() reports an unreadable root only through errno, reset it. */
 			errno = 0;
-			ofts->ofts_recurse_path_fts = fts_open(paths,
-				ofts->ofts_recurse_path_fts_opts, NULL);
-			/* fts_open() doesn't return NULL for all errors
-			   (e.g. nonexistent paths), so check errno to detect it.
-			   Far from being perfect. */
+			ofts->ofts_recurse_path_fts = oval_ftsidx_open(paths[0],
+				ofts->ofts_recurse_path_fts_opts);
+			/* Like fts_open(), oval_ftsidx_open() returns a walker
+			   even if the root can't be stat'ed (e.g. a nonexistent
+			   path) and leaves errno set. */
 			if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-				dE("fts_open() failed, errno: %d \"%s\".\n",
+				dE("oval_ftsidx_open() failed, errno: %d \"%s\".\n",
 					errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
-				dE("fts_open args: path: \"%s\", options: %d.\n",
+				dE("oval_ftsidx_open args: path: \"%s\", options: %d.\n",
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 				if (ofts->ofts_recurse_path_fts != NULL) {
-					fts_close(ofts->ofts_recurse_path_fts);
+					oval_ftsidx_close(ofts->ofts_recurse_path_fts);
 					ofts->ofts_recurse_path_fts = NULL;
 				}
 				return (NULL);
@@ -1069,11 +1060,11 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
-			FTSENT *fts_ent;
+			OVAL_FTSIDXENT *fts_ent;
 
-			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+			fts_ent = oval_ftsidx_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
-				fts_close(ofts->ofts_recurse_path_fts);
+				oval_ftsidx_close(ofts->ofts_recurse_path_fts);
 				ofts->ofts_recurse_path_fts = NULL;
 
 				return NULL;
@@ -1084,7 +1075,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				continue;
 			case FTS_DC:
 				dW("Filesystem tree cycle detected at '%s'.\n", fts_ent->fts_path);
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 
@@ -1115,7 +1106,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* limit recursion depth */
 				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
 				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				}
 
@@ -1123,30 +1114,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				switch (fts_ent->fts_info) {
 				case FTS_D:
 					if (!(ofts->recurse & OVAL_RECURSE_DIRS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
 					break;
 				case FTS_SL:
 					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 					break;
 				default:
 					continue;
 				}
 			}
 			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 			/* don't recurse beyond the initial filesystem */
 			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 		}
@@ -1165,25 +1156,25 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				char * const paths[2] = { ofts->ofts_recurse_path_curpth, NULL };
 
 #if defined(OSCAP_FTS_DEBUG)
-				dI("fts_open args: path: \"%s\", options: %d.\n",
+				dI("oval_ftsidx_open args: path: \"%s\", options: %d.\n",
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
-				/* reset errno as fts_open() doesn't do it itself. */
+				/* oval_ftsidx_open() reports an unreadable root only through errno, reset it. */
 				errno = 0;
-				/* fts_open() doesn't return NULL for all errors
-				   (e.g. nonexistent paths), so check errno to
-				   detect it. Far from being perfect. */
-				ofts->ofts_recurse_path_fts = fts_open(paths,
-					ofts->ofts_recurse_path_fts_opts, NULL);
+				/* Like fts_open(), oval_ftsidx_open() returns a walker
+				   even if the root can't be stat'ed (e.g. a nonexistent
+				   path) and leaves errno set. */
+				ofts->ofts_recurse_path_fts = oval_ftsidx_open(paths[0],
+					ofts->ofts_recurse_path_fts_opts);
 				if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-					dE("fts_open() failed, errno: %d \"%s\".\n",
+					dE("oval_ftsidx_open() failed, errno: %d \"%s\".\n",
 						errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
-					dE("fts_open args: path: \"%s\", options: %d.\n",
+					dE("oval_ftsidx_open args: path: \"%s\", options: %d.\n",
 						paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 					if (ofts->ofts_recurse_path_fts != NULL) {
-						fts_close(ofts->ofts_recurse_path_fts);
+						oval_ftsidx_close(ofts->ofts_recurse_path_fts);
 						ofts->ofts_recurse_path_fts = NULL;
 					}
 					return (NULL);
@@ -1192,9 +1183,9 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 			/* iterate until a match is found or all elements have been traversed */
 			while (out_fts_ent == NULL) {
-				FTSENT *fts_ent;
+				OVAL_FTSIDXENT *fts_ent;
 
-				fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+				fts_ent = oval_ftsidx_read(ofts->ofts_recurse_path_fts);
 				if (fts_ent == NULL)
 					break;
 
@@ -1228,7 +1219,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					/* only fts root is collected */
 					if (fts_ent->fts_level == 0 && fts_ent->fts_info == FTS_D) {
 						out_fts_ent = fts_ent;
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						break;
 					}
 				} else {
@@ -1243,16 +1234,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 
 				if (fts_ent->fts_info == FTS_SL)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 				/* limit recursion only to fts root */
 				else if (fts_ent->fts_level > 0)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsidx_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			}
 
 			if (out_fts_ent != NULL)
 				break;
 
-			fts_close(ofts->ofts_recurse_path_fts);
+			oval_ftsidx_close(ofts->ofts_recurse_path_fts);
 			ofts->ofts_recurse_path_fts = NULL;
 
 			if (!strcmp(ofts->ofts_recurse_path_curpth, "/"))
@@ -1275,7 +1266,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent;
+	OVAL_FTSIDXENT *fts_ent;
 
 #if defined(OSCAP_FTS_DEBUG)
 	dI("ofts: %p.\n", ofts);
@@ -1323,9 +1314,7 @@ int oval_fts_close(OVAL_FTS *ofts)
 		oscap_free(ofts->ofts_recurse_path_pthcpy);
 
 	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
+		oval_regex_put(ofts->ofts_path_regex);
 
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
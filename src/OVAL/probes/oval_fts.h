@@ -23,13 +23,10 @@
 #define OVAL_FTS_H
 
 #include <sexp.h>
-#if defined(__SVR4) && defined(__sun)
-#include "fts_sun.h"
-#else
-#include <fts.h>
-#endif
+#include "oval_fts_index.h"
 #include <pcre.h>
 #include "fsdev.h"
+#include "../results/oval_regex_cache_impl.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -66,18 +63,17 @@
 
 typedef struct {
 	/* oval_fts_read_match_path() state */
-	FTS *ofts_match_path_fts;
-	FTSENT *ofts_match_path_fts_ent;
+	OVAL_FTSIDX *ofts_match_path_fts;
+	OVAL_FTSIDXENT *ofts_match_path_fts_ent;
 	/* oval_fts_read_recurse_path() state */
-	FTS *ofts_recurse_path_fts;
+	OVAL_FTSIDX *ofts_recurse_path_fts;
 	int ofts_recurse_path_fts_opts;
 	int ofts_recurse_path_curdepth;
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
 
-	pcre       *ofts_path_regex;
-	pcre_extra *ofts_path_regex_extra;
+	oval_regex_t *ofts_path_regex;
 	uint32_t ofts_path_op;
 
 	SEXP_t *ofts_spath;
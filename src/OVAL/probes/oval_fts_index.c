@@ -0,0 +1,702 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "alloc.h"
+#include "debug_priv.h"
+#include "oval_fts_index.h"
+
+#define OVAL_FTSIDX_BLKSIZE  (256 * 1024) /* arena block size */
+#define OVAL_FTSIDX_HINITSZ  1024         /* initial number of hash buckets */
+#define OVAL_FTSIDX_ALIGN(n) (((n) + 15) & ~((size_t)15))
+
+/* Directory member */
+struct oval_ftsidx_rec {
+	ino_t    ino;
+	dev_t    dev;
+	mode_t   mode;
+	uint32_t name;    /* offset of the name in oval_ftsidx_dir.names */
+	uint16_t namelen;
+	uint8_t  statok;  /* lstat() succeeded */
+#if defined(__SVR4) && defined(__sun)
+	char     fstype[_ST_FSTYPSZ];
+#endif
+};
+
+/* Directory listing; allocated as one block followed by the member names */
+struct oval_ftsidx_dir {
+	dev_t    dev;
+	ino_t    ino;
+	uint32_t count;
+	struct oval_ftsidx_dir *next; /* hash chain */
+	char    *names;
+	struct oval_ftsidx_rec rec[];
+};
+
+struct oval_ftsidx_blk {
+	struct oval_ftsidx_blk *next;
+	size_t  size;
+	size_t  used;
+	uint8_t data[] __attribute__ ((aligned (16)));
+};
+
+struct oval_ftsidx_frame {
+	const struct oval_ftsidx_dir *dir;
+	struct oval_ftsidx_dir       *owned; /* listing not stored in the index */
+	uint32_t    next;    /* next member to visit */
+	size_t      pathlen; /* length of the directory path */
+	size_t      namepos; /* offset of the directory name in the path */
+	size_t      namelen;
+	int         level;
+	struct stat st;
+};
+
+struct oval_ftsidx {
+	int   options;
+	dev_t rootdev;
+	enum {
+		OVAL_FTSIDX_INIT,
+		OVAL_FTSIDX_WALK,
+		OVAL_FTSIDX_DONE
+	} state;
+
+	char  *path;     /* path of the current entry */
+	size_t path_max;
+
+	OVAL_FTSIDXENT cur;
+	struct stat    st;
+
+	struct oval_ftsidx_frame *stk; /* directories being visited */
+	uint32_t depth;
+	uint32_t stk_max;
+
+	/* listing buffers */
+	struct oval_ftsidx_rec *scr_rec;
+	uint32_t scr_cnt;
+	uint32_t scr_max;
+	char    *scr_names;
+	size_t   scr_nlen;
+	size_t   scr_nmax;
+};
+
+/*
+ * The index is shared by all walkers of the process. Stored listings
+ * are never modified, so they are used by the walkers without holding
+ * the lock; the lock protects the hash table, the arena and the stats.
+ * Arena blocks dropped by oval_ftsidx_free() while walkers are open are
+ * kept on the retired list until the last walker is closed.
+ */
+static pthread_mutex_t __ftsidx_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct oval_ftsidx_dir **__ftsidx_htbl = NULL;
+static uint32_t                 __ftsidx_hsize = 0;
+static struct oval_ftsidx_blk  *__ftsidx_arena = NULL;
+static struct oval_ftsidx_blk  *__ftsidx_retired = NULL;
+static uint32_t                 __ftsidx_walkers = 0;
+static struct oval_ftsidx_stats __ftsidx_stats = { 0, 0, 0, 0, 0, 0 };
+
+/*
+ * Probe workers run with asynchronous cancelation enabled; don't let
+ * them be canceled while holding the lock or modifying the index.
+ */
+static void oval_ftsidx_lock(int *cstate)
+{
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, cstate);
+
+	if (pthread_mutex_lock(&__ftsidx_lock) != 0) {
+		dE("Can't lock the fts index mutex\n");
+		abort();
+	}
+}
+
+static void oval_ftsidx_unlock(int cstate)
+{
+	pthread_mutex_unlock(&__ftsidx_lock);
+	pthread_setcancelstate(cstate, NULL);
+}
+
+static uint32_t oval_ftsidx_hash(dev_t dev, ino_t ino)
+{
+	uint64_t h;
+
+	h  = (uint64_t)ino * UINT64_C(0x9E3779B97F4A7C15);
+	h ^= (uint64_t)dev + (h >> 29);
+
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+static void *oval_ftsidx_arena_alloc(size_t size)
+{
+	struct oval_ftsidx_blk *blk = __ftsidx_arena;
+	void *ptr;
+
+	size = OVAL_FTSIDX_ALIGN(size);
+
+	if (blk == NULL || blk->size - blk->used < size) {
+		size_t blksize = size > OVAL_FTSIDX_BLKSIZE ? size : OVAL_FTSIDX_BLKSIZE;
+
+		blk = oscap_alloc(sizeof(struct oval_ftsidx_blk) + blksize);
+		blk->size = blksize;
+		blk->used = 0;
+		blk->next = __ftsidx_arena;
+
+		__ftsidx_arena = blk;
+		__ftsidx_stats.size += sizeof(struct oval_ftsidx_blk) + blksize;
+	}
+
+	ptr = blk->data + blk->used;
+	blk->used += size;
+
+	return (ptr);
+}
+
+static struct oval_ftsidx_dir *oval_ftsidx_lookup(dev_t dev, ino_t ino)
+{
+	struct oval_ftsidx_dir *dir;
+
+	if (__ftsidx_htbl == NULL)
+		return (NULL);
+
+	for (dir = __ftsidx_htbl[oval_ftsidx_hash(dev, ino) & (__ftsidx_hsize - 1)]; dir != NULL; dir = dir->next)
+		if (dir->ino == ino && dir->dev == dev)
+			return (dir);
+
+	return (NULL);
+}
+
+static void oval_ftsidx_link(struct oval_ftsidx_dir *dir)
+{
+	uint32_t i, h;
+
+	if (__ftsidx_htbl == NULL) {
+		__ftsidx_hsize = OVAL_FTSIDX_HINITSZ;
+		__ftsidx_htbl  = oscap_calloc(__ftsidx_hsize, sizeof(struct oval_ftsidx_dir *));
+	} else if (__ftsidx_stats.dirs >= __ftsidx_hsize * 2) {
+		struct oval_ftsidx_dir **htbl, *d, *n;
+
+		htbl = oscap_calloc(__ftsidx_hsize * 2, sizeof(struct oval_ftsidx_dir *));
+
+		for (i = 0; i < __ftsidx_hsize; ++i) {
+			for (d = __ftsidx_htbl[i]; d != NULL; d = n) {
+				n = d->next;
+				h = oval_ftsidx_hash(d->dev, d->ino) & (__ftsidx_hsize * 2 - 1);
+				d->next = htbl[h];
+				htbl[h] = d;
+			}
+		}
+
+		oscap_free(__ftsidx_htbl);
+		__ftsidx_htbl   = htbl;
+		__ftsidx_hsize *= 2;
+	}
+
+	h = oval_ftsidx_hash(dir->dev, dir->ino) & (__ftsidx_hsize - 1);
+	dir->next = __ftsidx_htbl[h];
+	__ftsidx_htbl[h] = dir;
+	++__ftsidx_stats.dirs;
+}
+
+static void oval_ftsidx_pathcap(OVAL_FTSIDX *walk, size_t len)
+{
+	if (len <= walk->path_max)
+		return;
+
+	while (walk->path_max < len)
+		walk->path_max *= 2;
+
+	walk->path = oscap_realloc(walk->path, walk->path_max);
+}
+
+/* Append `name' to the directory path of length `pathlen'; returns the new length */
+static size_t oval_ftsidx_pathcat(OVAL_FTSIDX *walk, size_t pathlen, const char *name, size_t namelen)
+{
+	size_t sep = (pathlen > 0 && walk->path[pathlen - 1] == '/') ? 0 : 1;
+
+	oval_ftsidx_pathcap(walk, pathlen + sep + namelen + 1);
+
+	if (sep)
+		walk->path[pathlen] = '/';
+
+	memcpy(walk->path + pathlen + sep, name, namelen);
+	walk->path[pathlen + sep + namelen] = '\0';
+
+	return (pathlen + sep + namelen);
+}
+
+/*
+ * Read the directory whose path is in the path buffer and lstat() all
+ * of its members. Returns a listing allocated using oscap_alloc().
+ */
+static struct oval_ftsidx_dir *oval_ftsidx_list(OVAL_FTSIDX *walk, size_t pathlen)
+{
+	struct oval_ftsidx_dir *dir;
+	struct oval_ftsidx_rec *rec;
+	struct dirent *dent;
+	struct stat    st;
+	DIR   *dirp;
+	size_t namelen, size;
+
+	if ((dirp = opendir(walk->path)) == NULL)
+		return (NULL);
+
+	walk->scr_cnt  = 0;
+	walk->scr_nlen = 0;
+
+	while ((dent = readdir(dirp)) != NULL) {
+		if (dent->d_name[0] == '.' &&
+		    (dent->d_name[1] == '\0' || (dent->d_name[1] == '.' && dent->d_name[2] == '\0')))
+			continue;
+
+		namelen = strlen(dent->d_name);
+
+		if (walk->scr_cnt == walk->scr_max) {
+			walk->scr_max = walk->scr_max > 0 ? walk->scr_max * 2 : 64;
+			walk->scr_rec = oscap_realloc(walk->scr_rec, sizeof(struct oval_ftsidx_rec) * walk->scr_max);
+		}
+
+		if (walk->scr_nlen + namelen + 1 > walk->scr_nmax) {
+			while (walk->scr_nlen + namelen + 1 > walk->scr_nmax)
+				walk->scr_nmax = walk->scr_nmax > 0 ? walk->scr_nmax * 2 : 1024;
+			walk->scr_names = oscap_realloc(walk->scr_names, walk->scr_nmax);
+		}
+
+		rec = walk->scr_rec + walk->scr_cnt++;
+		rec->name    = (uint32_t)walk->scr_nlen;
+		rec->namelen = (uint16_t)namelen;
+
+		memcpy(walk->scr_names + walk->scr_nlen, dent->d_name, namelen + 1);
+		walk->scr_nlen += namelen + 1;
+
+		oval_ftsidx_pathcat(walk, pathlen, dent->d_name, namelen);
+
+		if (lstat(walk->path, &st) == 0) {
+			rec->statok = 1;
+			rec->dev    = st.st_dev;
+			rec->ino    = st.st_ino;
+			rec->mode   = st.st_mode;
+#if defined(__SVR4) && defined(__sun)
+			memcpy(rec->fstype, st.st_fstype, sizeof rec->fstype);
+#endif
+		} else {
+			rec->statok = 0;
+			rec->dev    = 0;
+			rec->ino    = 0;
+			rec->mode   = 0;
+		}
+	}
+
+	closedir(dirp);
+	walk->path[pathlen] = '\0';
+
+	size = OVAL_FTSIDX_ALIGN(sizeof(struct oval_ftsidx_dir) + sizeof(struct oval_ftsidx_rec) * walk->scr_cnt);
+	dir  = oscap_alloc(size + walk->scr_nlen);
+
+	dir->dev   = walk->st.st_dev;
+	dir->ino   = walk->st.st_ino;
+	dir->count = walk->scr_cnt;
+	dir->next  = NULL;
+	dir->names = (char *)dir + size;
+
+	memcpy(dir->rec, walk->scr_rec, sizeof(struct oval_ftsidx_rec) * walk->scr_cnt);
+	memcpy(dir->names, walk->scr_names, walk->scr_nlen);
+
+	return (dir);
+}
+
+/*
+ * Get the listing of the current directory entry. `owned' is set if
+ * the listing isn't stored in the index and has to be freed by the caller.
+ */
+static const struct oval_ftsidx_dir *oval_ftsidx_getdir(OVAL_FTSIDX *walk, struct oval_ftsidx_dir **owned)
+{
+	struct oval_ftsidx_dir *dir, *cached;
+	size_t size;
+	int    cstate;
+
+	*owned = NULL;
+
+	oval_ftsidx_lock(&cstate);
+
+	++__ftsidx_stats.lookups;
+
+	if ((dir = oval_ftsidx_lookup(walk->st.st_dev, walk->st.st_ino)) != NULL) {
+		++__ftsidx_stats.hits;
+		__ftsidx_stats.stat_saved += dir->count;
+		oval_ftsidx_unlock(cstate);
+		return (dir);
+	}
+
+	oval_ftsidx_unlock(cstate);
+
+	/* Read the directory without holding the lock */
+	if ((dir = oval_ftsidx_list(walk, walk->cur.fts_pathlen)) == NULL)
+		return (NULL);
+
+	size = (size_t)(dir->names - (char *)dir) + walk->scr_nlen;
+
+	oval_ftsidx_lock(&cstate);
+
+	if ((cached = oval_ftsidx_lookup(dir->dev, dir->ino)) != NULL) {
+		/* stored by another thread in the meantime */
+		oval_ftsidx_unlock(cstate);
+		oscap_free(dir);
+		return (cached);
+	}
+
+	if (__ftsidx_stats.size + size <= OVAL_FTSIDX_MAXSIZE) {
+		cached = oval_ftsidx_arena_alloc(size);
+		memcpy(cached, dir, size);
+		cached->names = (char *)cached + (dir->names - (char *)dir);
+		oval_ftsidx_link(cached);
+		oval_ftsidx_unlock(cstate);
+		oscap_free(dir);
+		return (cached);
+	}
+
+	++__ftsidx_stats.uncached;
+	oval_ftsidx_unlock(cstate);
+
+	*owned = dir;
+	return (dir);
+}
+
+/*
+ * Same mapping of stat results to fts_info as fts_stat(). The "." and ".."
+ * entries are never listed, so FTS_DOT is returned only for such a root.
+ */
+static unsigned short oval_ftsidx_info(OVAL_FTSIDX *walk, const struct stat *st)
+{
+	uint32_t i;
+
+	if (S_ISDIR(st->st_mode)) {
+		const char *name = walk->cur.fts_name;
+
+		if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+			return (FTS_DOT);
+
+		for (i = 0; i < walk->depth; ++i)
+			if (walk->stk[i].st.st_ino == st->st_ino && walk->stk[i].st.st_dev == st->st_dev)
+				return (FTS_DC);
+
+		return (FTS_D);
+	}
+
+	if (S_ISLNK(st->st_mode))
+		return (FTS_SL);
+	if (S_ISREG(st->st_mode))
+		return (FTS_F);
+
+	return (FTS_DEFAULT);
+}
+
+static unsigned short oval_ftsidx_stat(OVAL_FTSIDX *walk, bool follow)
+{
+	if (follow) {
+		if (stat(walk->path, &walk->st) == 0)
+			return oval_ftsidx_info(walk, &walk->st);
+
+		if (errno == ENOENT && lstat(walk->path, &walk->st) == 0) {
+			errno = 0;
+			return (FTS_SLNONE);
+		}
+	} else if (lstat(walk->path, &walk->st) == 0)
+		return oval_ftsidx_info(walk, &walk->st);
+
+	memset(&walk->st, 0, sizeof walk->st);
+	return (FTS_NS);
+}
+
+OVAL_FTSIDX *oval_ftsidx_open(const char *path, int options)
+{
+	OVAL_FTSIDX *walk;
+	char  *name;
+	size_t len;
+	int    cstate;
+
+	if (path == NULL) {
+		errno = EINVAL;
+		return (NULL);
+	}
+
+	len  = strlen(path);
+	walk = oscap_talloc(OVAL_FTSIDX);
+	memset(walk, 0, sizeof(OVAL_FTSIDX));
+
+	walk->options  = options;
+	walk->state    = OVAL_FTSIDX_INIT;
+	walk->path_max = len + 1 > PATH_MAX ? len + 1 : PATH_MAX;
+	walk->path     = oscap_alloc(walk->path_max);
+	memcpy(walk->path, path, len + 1);
+
+	/* like fts, use the last path component as the name of the root */
+	name = strrchr(walk->path, '/');
+	name = (name == NULL || len == 1) ? walk->path : name + 1;
+
+	walk->cur.fts_path    = walk->path;
+	walk->cur.fts_pathlen = len;
+	walk->cur.fts_name    = name;
+	walk->cur.fts_namelen = len - (name - walk->path);
+	walk->cur.fts_level   = 0;
+	walk->cur.fts_statp   = &walk->st;
+	walk->cur.fts_instr   = 0;
+	walk->cur.fts_info    = oval_ftsidx_stat(walk, true);
+
+	if (walk->cur.fts_info == FTS_DOT)
+		walk->cur.fts_info = FTS_D;
+
+	walk->rootdev = walk->st.st_dev;
+
+	oval_ftsidx_lock(&cstate);
+	++__ftsidx_walkers;
+	oval_ftsidx_unlock(cstate);
+
+	return (walk);
+}
+
+/* Descend into the current directory entry */
+static int oval_ftsidx_push(OVAL_FTSIDX *walk)
+{
+	const struct oval_ftsidx_dir *dir;
+	struct oval_ftsidx_dir   *owned;
+	struct oval_ftsidx_frame *frame;
+	size_t namepos;
+
+	namepos = walk->cur.fts_name - walk->path;
+
+	if ((dir = oval_ftsidx_getdir(walk, &owned)) == NULL)
+		return (-1);
+
+	if (walk->depth == walk->stk_max) {
+		walk->stk_max = walk->stk_max > 0 ? walk->stk_max * 2 : 16;
+		walk->stk     = oscap_realloc(walk->stk, sizeof(struct oval_ftsidx_frame) * walk->stk_max);
+	}
+
+	frame = walk->stk + walk->depth++;
+	frame->dir     = dir;
+	frame->owned   = owned;
+	frame->next    = 0;
+	frame->pathlen = walk->cur.fts_pathlen;
+	frame->namepos = namepos;
+	frame->namelen = walk->cur.fts_namelen;
+	frame->level   = walk->cur.fts_level;
+	memcpy(&frame->st, &walk->st, sizeof(struct stat));
+
+	return (0);
+}
+
+/* Visit the next member of the current directory or the directory itself in post-order */
+static OVAL_FTSIDXENT *oval_ftsidx_next(OVAL_FTSIDX *walk)
+{
+	struct oval_ftsidx_frame     *frame;
+	const struct oval_ftsidx_rec *rec;
+
+	if (walk->depth == 0) {
+		walk->state = OVAL_FTSIDX_DONE;
+		return (NULL);
+	}
+
+	frame = walk->stk + walk->depth - 1;
+
+	if (frame->next < frame->dir->count) {
+		rec = frame->dir->rec + frame->next++;
+
+		walk->cur.fts_pathlen = oval_ftsidx_pathcat(walk, frame->pathlen,
+							    frame->dir->names + rec->name, rec->namelen);
+		walk->cur.fts_path    = walk->path;
+		walk->cur.fts_name    = walk->path + walk->cur.fts_pathlen - rec->namelen;
+		walk->cur.fts_namelen = rec->namelen;
+		walk->cur.fts_level   = frame->level + 1;
+
+		memset(&walk->st, 0, sizeof walk->st);
+
+		if (rec->statok) {
+			walk->st.st_dev  = rec->dev;
+			walk->st.st_ino  = rec->ino;
+			walk->st.st_mode = rec->mode;
+#if defined(__SVR4) && defined(__sun)
+			memcpy(walk->st.st_fstype, rec->fstype, sizeof rec->fstype);
+#endif
+			walk->cur.fts_info = oval_ftsidx_info(walk, &walk->st);
+		} else
+			walk->cur.fts_info = FTS_NS;
+
+		return (&walk->cur);
+	}
+
+	walk->path[frame->pathlen] = '\0';
+	walk->cur.fts_path    = walk->path;
+	walk->cur.fts_pathlen = frame->pathlen;
+	walk->cur.fts_name    = walk->path + frame->namepos;
+	walk->cur.fts_namelen = frame->namelen;
+	walk->cur.fts_level   = frame->level;
+	walk->cur.fts_info    = FTS_DP;
+	memcpy(&walk->st, &frame->st, sizeof(struct stat));
+
+	oscap_free(frame->owned);
+	--walk->depth;
+
+	return (&walk->cur);
+}
+
+OVAL_FTSIDXENT *oval_ftsidx_read(OVAL_FTSIDX *walk)
+{
+	int instr;
+
+	if (walk == NULL)
+		return (NULL);
+
+	switch (walk->state) {
+	case OVAL_FTSIDX_INIT:
+		walk->state = OVAL_FTSIDX_WALK;
+		return (&walk->cur);
+	case OVAL_FTSIDX_DONE:
+		return (NULL);
+	case OVAL_FTSIDX_WALK:
+		break;
+	}
+
+	instr = walk->cur.fts_instr;
+	walk->cur.fts_instr = 0;
+
+	if (instr == FTS_AGAIN) {
+		walk->cur.fts_info = oval_ftsidx_stat(walk, false);
+		return (&walk->cur);
+	}
+
+	if (instr == FTS_FOLLOW &&
+	    (walk->cur.fts_info == FTS_SL || walk->cur.fts_info == FTS_SLNONE)) {
+		walk->cur.fts_info = oval_ftsidx_stat(walk, true);
+		return (&walk->cur);
+	}
+
+	if (walk->cur.fts_info == FTS_D) {
+		/* skipped or crossed mount point: post-order visit right away */
+		if (instr == FTS_SKIP ||
+		    ((walk->options & FTS_XDEV) && walk->st.st_dev != walk->rootdev)) {
+			walk->cur.fts_info = FTS_DP;
+			return (&walk->cur);
+		}
+
+		if (oval_ftsidx_push(walk) != 0) {
+			walk->cur.fts_info = FTS_DNR;
+			return (&walk->cur);
+		}
+	}
+
+	return oval_ftsidx_next(walk);
+}
+
+int oval_ftsidx_set(OVAL_FTSIDX *walk, OVAL_FTSIDXENT *ent, int instr)
+{
+	if (ent == NULL ||
+	    (instr != 0 && instr != FTS_AGAIN && instr != FTS_FOLLOW && instr != FTS_SKIP)) {
+		errno = EINVAL;
+		return (1);
+	}
+
+	ent->fts_instr = instr;
+	return (0);
+}
+
+static void oval_ftsidx_blk_free(struct oval_ftsidx_blk *blk)
+{
+	struct oval_ftsidx_blk *next;
+
+	for (; blk != NULL; blk = next) {
+		next = blk->next;
+		oscap_free(blk);
+	}
+}
+
+int oval_ftsidx_close(OVAL_FTSIDX *walk)
+{
+	struct oval_ftsidx_blk *retired = NULL;
+	int cstate;
+
+	if (walk == NULL)
+		return (0);
+
+	oval_ftsidx_lock(&cstate);
+
+	if (--__ftsidx_walkers == 0) {
+		retired = __ftsidx_retired;
+		__ftsidx_retired = NULL;
+	}
+
+	oval_ftsidx_unlock(cstate);
+	oval_ftsidx_blk_free(retired);
+
+	while (walk->depth > 0)
+		oscap_free(walk->stk[--walk->depth].owned);
+
+	oscap_free(walk->stk);
+	oscap_free(walk->scr_rec);
+	oscap_free(walk->scr_names);
+	oscap_free(walk->path);
+	oscap_free(walk);
+
+	return (0);
+}
+
+void oval_ftsidx_stats(struct oval_ftsidx_stats *stats)
+{
+	pthread_mutex_lock(&__ftsidx_lock);
+	*stats = __ftsidx_stats;
+	pthread_mutex_unlock(&__ftsidx_lock);
+}
+
+void oval_ftsidx_free(void)
+{
+	struct oval_ftsidx_blk *blk;
+	int cstate;
+
+	oval_ftsidx_lock(&cstate);
+
+	if (__ftsidx_walkers > 0 && __ftsidx_arena != NULL) {
+		/* the open walkers may still use the listings */
+		for (blk = __ftsidx_arena; blk->next != NULL; blk = blk->next);
+		blk->next = __ftsidx_retired;
+		__ftsidx_retired = __ftsidx_arena;
+	} else
+		oval_ftsidx_blk_free(__ftsidx_arena);
+
+	oscap_free(__ftsidx_htbl);
+
+	__ftsidx_arena = NULL;
+	__ftsidx_htbl  = NULL;
+	__ftsidx_hsize = 0;
+	__ftsidx_stats.dirs = 0;
+	__ftsidx_stats.size = 0;
+
+	oval_ftsidx_unlock(cstate);
+}
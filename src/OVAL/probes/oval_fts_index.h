@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef OVAL_FTS_INDEX_H
+#define OVAL_FTS_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__SVR4) && defined(__sun)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+/*
+ * Filesystem traversal backed by a process wide directory index. Every
+ * probe process has its own index, shared by the objects it collects.
+ *
+ * The walker implements the subset of the fts(3) interface used by oval_fts
+ * (FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR, optionally FTS_XDEV) and
+ * returns the same entries in the same order. The content of every directory
+ * the walker descends into (names and lstat() results of the members) is
+ * stored in the index, keyed by the device and inode number of the directory.
+ * Later walks of the same directories, e.g. by other objects with overlapping
+ * paths, are served from the index without calling readdir() and lstat().
+ */
+
+#ifndef OVAL_FTSIDX_MAXSIZE
+# define OVAL_FTSIDX_MAXSIZE (64 * 1024 * 1024) /**< upper bound on the index size (bytes) */
+#endif
+
+/**
+ * Walker entry. The field names follow FTSENT. The entry is valid
+ * until the next call of oval_ftsidx_read() on the same walker.
+ */
+typedef struct {
+	char          *fts_path;    /**< path of the entry */
+	size_t         fts_pathlen;
+	char          *fts_name;    /**< file name */
+	size_t         fts_namelen;
+	int            fts_level;   /**< depth, 0 is the root */
+	unsigned short fts_info;    /**< FTS_D, FTS_F, FTS_SL, ... */
+	struct stat   *fts_statp;   /**< st_dev, st_ino and st_mode are always valid */
+	int            fts_instr;   /**< instruction set by oval_ftsidx_set() */
+} OVAL_FTSIDXENT;
+
+typedef struct oval_ftsidx OVAL_FTSIDX;
+
+struct oval_ftsidx_stats {
+	uint64_t lookups;    /**< directory listings requested by the walkers */
+	uint64_t hits;       /**< listings served from the index */
+	uint64_t stat_saved; /**< lstat() calls saved by the hits */
+	uint64_t uncached;   /**< listings not stored because the index was full */
+	uint32_t dirs;       /**< number of indexed directories */
+	size_t   size;       /**< memory used by the index (bytes) */
+};
+
+/**
+ * Start a traversal of the tree rooted at `path'. Like fts_open(), errno
+ * is left set if the root can't be stat'ed.
+ * @param path root of the traversal
+ * @param options fts_open() options; only FTS_XDEV changes the behavior
+ */
+OVAL_FTSIDX *oval_ftsidx_open(const char *path, int options);
+
+/**
+ * Get the next entry; see fts_read().
+ */
+OVAL_FTSIDXENT *oval_ftsidx_read(OVAL_FTSIDX *walk);
+
+/**
+ * Set an instruction (FTS_AGAIN, FTS_FOLLOW, FTS_SKIP) for the entry;
+ * see fts_set(). Only the entry is modified, `walk' may be NULL.
+ */
+int oval_ftsidx_set(OVAL_FTSIDX *walk, OVAL_FTSIDXENT *ent, int instr);
+
+/**
+ * Finish the traversal.
+ */
+int oval_ftsidx_close(OVAL_FTSIDX *walk);
+
+/**
+ * Get the index statistics.
+ */
+void oval_ftsidx_stats(struct oval_ftsidx_stats *stats);
+
+/**
+ * Free the index, e.g. when the probe is reset and the filesystem may have
+ * changed since the listings were stored. The next walker starts a new
+ * index. The listings used by walkers that are still open are freed when
+ * the last of them is closed.
+ */
+void oval_ftsidx_free(void);
+
+#endif /* OVAL_FTS_INDEX_H */
@@ -1402,8 +1402,10 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
         double  value_flt;
         bool    value_bool;
         bool    free_value = true;
+        bool    shared_value = false; /* value_sexp is a reference from the ncache */
         bool    multiplied;
         int     value_i, multiply;
+        size_t  value_len;
 
         subtype_name = oval_subtype_to_str(item_subtype);
 
@@ -1439,7 +1441,14 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                         if (value_str == NULL)
                                 goto skip;
 
-                        value_sexp = SEXP_string_new_r(&value_sexp_mem, value_str, strlen(value_str));
+                        /* short values are often repeated, share them */
+                        value_len  = strlen(value_str);
+                        value_sexp = probe_ncache_value(OSCAP_GSYM(ncache), value_str, value_len);
+
+                        if (value_sexp != NULL)
+                                shared_value = true;
+                        else
+                                value_sexp = SEXP_string_new_r(&value_sexp_mem, value_str, value_len);
                         break;
                 case OVAL_DATATYPE_STRING_M:
                         value_type = OVAL_DATATYPE_STRING;
@@ -1462,7 +1471,8 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                         break;
                 case OVAL_DATATYPE_BOOLEAN:
                         value_bool = (bool)va_arg(ap, int);
-                        value_sexp = SEXP_number_newb_r(&value_sexp_mem, value_bool);
+                        value_sexp = probe_ncache_bool(OSCAP_GSYM(ncache), value_bool);
+                        shared_value = true;
                         break;
                 case OVAL_DATATYPE_INTEGER:
                         value_int  = va_arg(ap, int64_t);
@@ -1518,7 +1528,9 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                                 SEXP_free(name_sexp);
                                 SEXP_free(item);
 
-                                if (free_value) {
+                                if (shared_value)
+                                        SEXP_free(value_sexp);
+                                else if (free_value) {
                                         while(value_i < multiply)
                                                 SEXP_free_r(value_sexp + value_i++);
                                         if (multiplied)
@@ -1536,7 +1548,9 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
                         SEXP_list_add(item, entity);
                         SEXP_free_r(&entity_mem);
 
-                        if (free_value)
+                        if (shared_value)
+                                SEXP_free(value_sexp);
+                        else if (free_value)
                                 SEXP_free_r(value_sexp + value_i);
                         ++value_i;
                 }
@@ -1548,6 +1562,7 @@ SEXP_t *probe_item_create(oval_subtype_t item_subtype, probe_elmatr_t *item_attr
         skip:
                 value_name = va_arg(ap, const char *);
 		free_value = true;
+		shared_value = false;
         }
 
 	va_end(ap);
@@ -0,0 +1,700 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, 
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software 
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sexp.h>
+#include <strbuf.h>
+
+#include "probe-api.h"
+#include "common/alloc.h"
+#include "common/assume.h"
+#include "common/debug_priv.h"
+
+#include "dcache.h"
+#include "rpmdb_files.h"
+
+#define PROBE_DCACHE_SBSIZE     (64 * 1024)
+#define PROBE_DCACHE_BOOT_ID    "/proc/sys/kernel/random/boot_id"
+#define PROBE_DCACHE_RPMDB_PATH "/var/lib/rpm"
+#define PROBE_DCACHE_NSSWITCH   "/etc/nsswitch.conf"
+
+typedef enum {
+        PROBE_DCACHE_OBJFILE, /**< the file selected by the filepath or path & filename entities */
+        PROBE_DCACHE_FILES,   /**< a fixed set of files */
+        PROBE_DCACHE_RPMDB    /**< files of the RPM database */
+} probe_dcache_kind_t;
+
+/*
+ * Probes whose collected objects depend only on the content and metadata
+ * of known files. Runtime state (processes, sockets, sysctls, ...) and the
+ * results of pattern matching or recursion over the filesystem can't be
+ * validated this way and are never cached. The password and shadow probes
+ * read the NSS databases, which are backed by the files only if nothing
+ * else (sss, ldap, systemd, ...) is configured in nsswitch.conf.
+ */
+static const struct {
+        const char          *name;
+        probe_dcache_kind_t  kind;
+        const char          *nss_db; /**< NSS database the probe reads */
+        bool                 atime;  /**< the access time is collected */
+        const char          *files[PROBE_RPMDB_FILE_COUNT + 1];
+} probe_dcache_probes[] = {
+        { "probe_file",                  PROBE_DCACHE_OBJFILE, NULL,     true,  { NULL } },
+        { "probe_fileextendedattribute", PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_filehash",              PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_filehash58",            PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_filemd5",               PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_textfilecontent",       PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_textfilecontent54",     PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_xmlfilecontent",        PROBE_DCACHE_OBJFILE, NULL,     false, { NULL } },
+        { "probe_password",              PROBE_DCACHE_FILES,   "passwd", false, { "/etc/passwd", NULL } },
+        { "probe_shadow",                PROBE_DCACHE_FILES,   "shadow", false, { "/etc/shadow", NULL } },
+        { "probe_dpkginfo",              PROBE_DCACHE_FILES,   NULL,     false, { "/var/lib/dpkg/status", NULL } },
+        { "probe_rpminfo",               PROBE_DCACHE_RPMDB,   NULL,     false, { PROBE_RPMDB_FILES, NULL } }
+};
+
+struct probe_dcache {
+        int                 dirfd;  /**< cache directory of the probe */
+        probe_dcache_kind_t kind;
+        const char *const  *files;
+        bool                atime;  /**< the access time is part of the file tokens */
+        char               *rpmdb;  /**< path of the RPM database */
+        SEXP_t             *scope;  /**< root directory & RPM database path, part of every key */
+        SEXP_t             *boot;   /**< boot ID token */
+        struct probe_dcache_stats stats;
+};
+
+static SEXP_t *probe_dcache_boot_token(void)
+{
+        char   buf[64];
+        FILE  *fp;
+        SEXP_t *r0, *r1, *token;
+
+        buf[0] = '\0';
+
+        if ((fp = fopen(PROBE_DCACHE_BOOT_ID, "r")) != NULL) {
+                if (fgets(buf, sizeof buf, fp) == NULL)
+                        buf[0] = '\0';
+                fclose(fp);
+        }
+
+        buf[strcspn(buf, "\n")] = '\0';
+
+        token = SEXP_list_new(r0 = SEXP_string_new("boot_id", 7),
+                              r1 = SEXP_string_newf("%s", buf), NULL);
+        SEXP_vfree(r0, r1, NULL);
+
+        return (token);
+}
+
+/*
+ * Check whether an NSS database is looked up only in the local files
+ */
+static bool probe_dcache_nss_files(const char *db)
+{
+        char   line[1024], *p, *tok, *save;
+        size_t len = strlen(db);
+        bool   files = false;
+        FILE  *fp;
+
+        if ((fp = fopen(PROBE_DCACHE_NSSWITCH, "r")) == NULL)
+                return (false);
+
+        while (fgets(line, sizeof line, fp) != NULL) {
+                line[strcspn(line, "#\n")] = '\0';
+                p = line + strspn(line, " \t");
+
+                if (strncmp(p, db, len) != 0)
+                        continue;
+
+                p += len;
+                p += strspn(p, " \t");
+
+                if (*p != ':')
+                        continue;
+
+                for (tok = strtok_r(p + 1, " \t", &save); tok != NULL; tok = strtok_r(NULL, " \t", &save)) {
+                        if (strcmp(tok, "files") != 0) {
+                                files = false;
+                                break;
+                        }
+                        files = true;
+                }
+                break;
+        }
+
+        fclose(fp);
+
+        return (files);
+}
+
+probe_dcache_t *probe_dcache_new(const char *dir, const char *probe_name)
+{
+        probe_dcache_t *cache;
+        const char *root, *rpmdb;
+        SEXP_t *r0, *r1, *r2, *r3;
+        struct stat st;
+        size_t i;
+        int fd;
+
+        for (i = 0; i < sizeof probe_dcache_probes / sizeof probe_dcache_probes[0]; ++i)
+                if (strcmp(probe_dcache_probes[i].name, probe_name) == 0)
+                        break;
+
+        if (i == sizeof probe_dcache_probes / sizeof probe_dcache_probes[0]) {
+                dI("%s: collected objects of this probe are not cached\n", probe_name);
+                errno = ENOTSUP;
+                return (NULL);
+        }
+
+        if (probe_dcache_probes[i].nss_db != NULL && !probe_dcache_nss_files(probe_dcache_probes[i].nss_db)) {
+                dI("%s: the %s database isn't backed only by files, collected objects are not cached\n",
+                   probe_name, probe_dcache_probes[i].nss_db);
+                errno = ENOTSUP;
+                return (NULL);
+        }
+
+        if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+                dW("Can't open the cache directory %s: %u, %s\n", dir, errno, strerror(errno));
+                return (NULL);
+        }
+
+        if (mkdirat(fd, probe_name, 0700) != 0 && errno != EEXIST) {
+                dW("Can't create the cache directory %s/%s: %u, %s\n", dir, probe_name, errno, strerror(errno));
+                close(fd);
+                return (NULL);
+        }
+
+        cache = oscap_talloc(probe_dcache_t);
+        cache->dirfd = openat(fd, probe_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        close(fd);
+
+        if (cache->dirfd == -1) {
+                dW("Can't open the cache directory %s/%s: %u, %s\n", dir, probe_name, errno, strerror(errno));
+                oscap_free(cache);
+                return (NULL);
+        }
+
+        /*
+         * The directory may have existed before. Entries written by someone
+         * else could make the probe report forged collected objects.
+         */
+        if (fstat(cache->dirfd, &st) != 0 || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+                dW("Refusing the cache directory %s/%s: not owned by uid %u or writable by others\n",
+                   dir, probe_name, (unsigned int)geteuid());
+                close(cache->dirfd);
+                oscap_free(cache);
+                errno = EPERM;
+                return (NULL);
+        }
+
+        if ((root = getenv("OSCAP_PROBE_ROOT")) == NULL)
+                root = "";
+        if ((rpmdb = getenv("OSCAP_PROBE_RPMDB_PATH")) == NULL)
+                rpmdb = PROBE_DCACHE_RPMDB_PATH;
+
+        cache->kind  = probe_dcache_probes[i].kind;
+        cache->files = probe_dcache_probes[i].files;
+        cache->atime = probe_dcache_probes[i].atime;
+        cache->rpmdb = strdup(rpmdb);
+        cache->scope = SEXP_list_new(r0 = SEXP_string_new("root", 4), r1 = SEXP_string_newf("%s", root),
+                                     r2 = SEXP_string_new("rpmdb", 5), r3 = SEXP_string_newf("%s", rpmdb), NULL);
+        cache->boot  = probe_dcache_boot_token();
+        memset(&cache->stats, 0, sizeof cache->stats);
+
+        SEXP_vfree(r0, r1, r2, r3, NULL);
+        dI("%s: caching collected objects in %s/%s\n", probe_name, dir, probe_name);
+
+        return (cache);
+}
+
+void probe_dcache_free(probe_dcache_t *cache)
+{
+        if (cache == NULL)
+                return;
+
+        close(cache->dirfd);
+        SEXP_vfree(cache->scope, cache->boot, NULL);
+        oscap_free(cache->rpmdb);
+        oscap_free(cache);
+}
+
+static size_t probe_dcache_stat_fmt(char *buf, size_t size, int ret, const struct stat *st, bool atime)
+{
+        size_t len;
+
+        if (ret != 0)
+                return (snprintf(buf, size, "e%d;", errno));
+
+        len = snprintf(buf, size, "%jx:%jx:%jx:%jd:%jd.%09ld:%jd.%09ld",
+                       (uintmax_t)st->st_dev, (uintmax_t)st->st_ino, (uintmax_t)st->st_mode,
+                       (intmax_t)st->st_size,
+                       (intmax_t)st->st_mtim.tv_sec, (long)st->st_mtim.tv_nsec,
+                       (intmax_t)st->st_ctim.tv_sec, (long)st->st_ctim.tv_nsec);
+
+        if (atime && len < size)
+                len += snprintf(buf + len, size - len, ":%jd.%09ld",
+                                (intmax_t)st->st_atim.tv_sec, (long)st->st_atim.tv_nsec);
+        if (len < size)
+                len += snprintf(buf + len, size - len, ";");
+
+        return (len);
+}
+
+/*
+ * The metadata of a file (or the reason why it can't be read). The change
+ * time covers changes of the owner and of the permissions; symlinks are
+ * followed, the metadata of both the link and the target are recorded.
+ * The access time is recorded only for probes which report it.
+ */
+static SEXP_t *probe_dcache_stat_token(const char *path, bool atime)
+{
+        struct stat st;
+        char   buf[256];
+        size_t len;
+        SEXP_t *r0, *r1, *r2, *token;
+        int    ret;
+
+        ret = lstat(path, &st);
+        len = probe_dcache_stat_fmt(buf, sizeof buf, ret, &st, atime);
+
+        if (ret == 0 && S_ISLNK(st.st_mode) && len < sizeof buf) {
+                ret = stat(path, &st);
+                probe_dcache_stat_fmt(buf + len, sizeof buf - len, ret, &st, atime);
+        }
+
+        token = SEXP_list_new(r0 = SEXP_string_new("stat", 4),
+                              r1 = SEXP_string_newf("%s", path),
+                              r2 = SEXP_string_newf("%s", buf), NULL);
+        SEXP_vfree(r0, r1, r2, NULL);
+
+        return (token);
+}
+
+/*
+ * Get the value of a string entity of an object
+ * @retval 0 on success
+ * @retval 1 if there's no such entity or its value is nil
+ * @retval -1 if the entity selects more than one value (operation other
+ *         than equals, variable reference) or the value doesn't fit
+ */
+static int probe_dcache_entval(const SEXP_t *obj, const char *name, char *buf, size_t size)
+{
+        SEXP_t *ent, *ent2, *op, *val;
+        int ret = -1;
+
+        if ((ent = probe_obj_getent(obj, name, 1)) == NULL)
+                return (1);
+
+        ent2 = probe_obj_getent(obj, name, 2);
+        op   = probe_ent_getattrval(ent, "operation");
+
+        if (ent2 == NULL && !probe_ent_attrexists(ent, "var_ref") &&
+            (op == NULL || SEXP_number_geti_32(op) == OVAL_OPERATION_EQUALS)) {
+                if ((val = probe_ent_getval(ent)) == NULL)
+                        ret = 1;
+                else if (SEXP_stringp(val) && SEXP_string_cstr_r(val, buf, size) != (size_t)-1)
+                        ret = 0;
+
+                SEXP_free(val);
+        }
+
+        SEXP_free(ent);
+        SEXP_free(ent2);
+        SEXP_free(op);
+
+        return (ret);
+}
+
+/*
+ * Find the one file examined by the probe for an object
+ */
+static int probe_dcache_objfile(const SEXP_t *obj, char *path, size_t size)
+{
+        char   filename[PATH_MAX];
+        SEXP_t *behaviors, *val;
+        bool   recurse;
+        size_t len;
+
+        if ((behaviors = probe_obj_getent(obj, "behaviors", 1)) != NULL) {
+                val = probe_ent_getattrval(behaviors, "recurse_direction");
+                recurse = val != NULL && SEXP_strcmp(val, "none") != 0;
+                SEXP_vfree(behaviors, val, NULL);
+
+                if (recurse)
+                        return (-1);
+        }
+
+        switch (probe_dcache_entval(obj, "filepath", path, size)) {
+        case 0:
+                return (0);
+        case -1:
+                return (-1);
+        }
+
+        if (probe_dcache_entval(obj, "path", path, size) != 0)
+                return (-1);
+
+        switch (probe_dcache_entval(obj, "filename", filename, sizeof filename)) {
+        case 0:
+                len = strlen(path);
+                if (snprintf(path + len, size - len, "/%s", filename) >= (int)(size - len))
+                        return (-1);
+                /* FALLTHROUGH */
+        case 1:
+                return (0);
+        }
+
+        return (-1);
+}
+
+/*
+ * Build the list of validation tokens of an object, or NULL if the object
+ * can't be cached
+ */
+static SEXP_t *probe_dcache_tokens(probe_dcache_t *cache, const SEXP_t *obj)
+{
+        char   path[PATH_MAX];
+        SEXP_t *tokens, *token;
+        size_t i;
+
+        /*
+         * Filters are sent as state IDs, the content of the states (and of
+         * the variables they reference) isn't part of the key
+         */
+        if ((token = probe_obj_getent(obj, "filter", 1)) != NULL) {
+                SEXP_free(token);
+                return (NULL);
+        }
+
+        tokens = SEXP_list_new(cache->boot, NULL);
+
+        switch (cache->kind) {
+        case PROBE_DCACHE_OBJFILE:
+                if (probe_dcache_objfile(obj, path, sizeof path) != 0) {
+                        SEXP_free(tokens);
+                        return (NULL);
+                }
+
+                SEXP_list_add(tokens, token = probe_dcache_stat_token(path, cache->atime));
+                SEXP_free(token);
+                break;
+        case PROBE_DCACHE_FILES:
+                for (i = 0; cache->files[i] != NULL; ++i) {
+                        SEXP_list_add(tokens, token = probe_dcache_stat_token(cache->files[i], cache->atime));
+                        SEXP_free(token);
+                }
+                break;
+        case PROBE_DCACHE_RPMDB:
+                for (i = 0; cache->files[i] != NULL; ++i) {
+                        snprintf(path, sizeof path, "%s/%s", cache->rpmdb, cache->files[i]);
+                        SEXP_list_add(tokens, token = probe_dcache_stat_token(path, cache->atime));
+                        SEXP_free(token);
+                }
+                break;
+        }
+
+        return (tokens);
+}
+
+/*
+ * The key of an object is the object without its id attribute together
+ * with the scope of the cache
+ */
+static SEXP_t *probe_dcache_key(probe_dcache_t *cache, const SEXP_t *obj)
+{
+        SEXP_t *name, *attrs, *attr, *rest, *r0, *key;
+        uint32_t i;
+
+        name = SEXP_list_first(obj);
+
+        if (SEXP_listp(name)) {
+                attrs = SEXP_list_new(NULL);
+
+                for (i = 1; (attr = SEXP_list_nth(name, i)) != NULL; ++i) {
+                        if (i > 1 && SEXP_stringp(attr) && SEXP_strcmp(attr, ":id") == 0)
+                                ++i; /* skip the value too */
+                        else
+                                SEXP_list_add(attrs, attr);
+
+                        SEXP_free(attr);
+                }
+        } else
+                attrs = SEXP_ref(name);
+
+        rest = SEXP_list_rest(obj);
+        r0   = SEXP_list_new(cache->scope, attrs, NULL);
+        key  = SEXP_list_join(r0, rest);
+
+        SEXP_vfree(name, attrs, rest, r0, NULL);
+
+        return (key);
+}
+
+static SEXP_t *probe_dcache_name(const SEXP_t *key)
+{
+        strbuf_t *sb;
+        char     *buf;
+        size_t    len, i;
+        uint64_t  h = UINT64_C(14695981039346656037);
+        SEXP_t   *name;
+
+        sb = strbuf_new(PROBE_DCACHE_SBSIZE);
+
+        if (SEXP_sbprintf_b((SEXP_t *)key, sb) != 0) {
+                strbuf_free(sb);
+                return (NULL);
+        }
+
+        len = strbuf_length(sb);
+        buf = oscap_alloc(len);
+        strbuf_copy(sb, buf, len);
+        strbuf_free(sb);
+
+        for (i = 0; i < len; ++i) {
+                h ^= (uint8_t)buf[i];
+                h *= UINT64_C(1099511628211);
+        }
+
+        oscap_free(buf);
+        name = SEXP_string_newf("%016"PRIx64, h);
+
+        return (name);
+}
+
+static SEXP_t *probe_dcache_read(probe_dcache_t *cache, const char *name)
+{
+        struct stat st;
+        uint8_t *buf;
+        size_t   len;
+        ssize_t  ret;
+        SEXP_t  *stored = NULL;
+        int      fd;
+
+        if ((fd = openat(cache->dirfd, name, O_RDONLY | O_CLOEXEC)) == -1)
+                return (NULL);
+
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                close(fd);
+                return (NULL);
+        }
+
+        buf = oscap_alloc((size_t)st.st_size);
+
+        for (len = 0; len < (size_t)st.st_size; len += (size_t)ret) {
+                ret = read(fd, buf + len, (size_t)st.st_size - len);
+
+                if (ret <= 0) {
+                        if (ret < 0 && errno == EINTR) {
+                                ret = 0;
+                                continue;
+                        }
+                        break;
+                }
+        }
+
+        close(fd);
+
+        if (len != (size_t)st.st_size || SEXP_parse_b(buf, len, &stored) != (ssize_t)len) {
+                dW("Ignoring invalid cache entry %s\n", name);
+                stored = NULL;
+        }
+
+        oscap_free(buf);
+
+        return (stored);
+}
+
+static bool probe_dcache_valid(const SEXP_t *stored, const SEXP_t *key, const SEXP_t *tokens)
+{
+        SEXP_t *r0;
+        bool valid;
+
+        if (SEXP_list_length(stored) != 4)
+                return (false);
+
+        r0 = SEXP_list_nth(stored, 1);
+        valid = SEXP_numberp(r0) && SEXP_number_getu_32(r0) == PROBE_DCACHE_VERSION;
+        SEXP_free(r0);
+
+        if (!valid)
+                return (false);
+
+        r0 = SEXP_list_nth(stored, 2);
+        valid = SEXP_deepcmp(r0, key);
+        SEXP_free(r0);
+
+        if (!valid)
+                return (false);
+
+        r0 = SEXP_list_nth(stored, 3);
+        valid = SEXP_deepcmp(r0, tokens);
+        SEXP_free(r0);
+
+        return (valid);
+}
+
+SEXP_t *probe_dcache_get(probe_dcache_t *cache, const SEXP_t *obj, SEXP_t **entry)
+{
+        char   name[32];
+        SEXP_t *tokens, *key, *s_name, *stored, *cobj = NULL;
+
+        assume_d(cache != NULL, NULL);
+        assume_d(obj   != NULL, NULL);
+        assume_d(entry != NULL, NULL);
+
+        *entry = NULL;
+        __sync_fetch_and_add(&cache->stats.lookups, 1);
+
+        /*
+         * Take the tokens before anything is collected; if the files change
+         * during the collection, the stored entry is invalid right away.
+         */
+        if ((tokens = probe_dcache_tokens(cache, obj)) == NULL) {
+                __sync_fetch_and_add(&cache->stats.uncachable, 1);
+                return (NULL);
+        }
+
+        key = probe_dcache_key(cache, obj);
+
+        if ((s_name = probe_dcache_name(key)) == NULL) {
+                SEXP_vfree(tokens, key, NULL);
+                return (NULL);
+        }
+
+        SEXP_string_cstr_r(s_name, name, sizeof name);
+
+        if ((stored = probe_dcache_read(cache, name)) != NULL) {
+                if (probe_dcache_valid(stored, key, tokens)) {
+                        cobj = SEXP_list_nth(stored, 4);
+                        __sync_fetch_and_add(&cache->stats.hits, 1);
+                } else {
+                        dD("Stale cache entry %s\n", name);
+                        __sync_fetch_and_add(&cache->stats.stale, 1);
+                }
+
+                SEXP_free(stored);
+        }
+
+        if (cobj == NULL)
+                *entry = SEXP_list_new(s_name, key, tokens, NULL);
+
+        SEXP_vfree(tokens, key, s_name, NULL);
+
+        return (cobj);
+}
+
+int probe_dcache_add(probe_dcache_t *cache, const SEXP_t *entry, SEXP_t *cobj)
+{
+        char      name[32], tmp[64];
+        strbuf_t *sb;
+        SEXP_t   *s_name, *key, *tokens, *version, *stored;
+        int       fd, ret;
+
+        assume_d(cache != NULL, -1);
+        assume_d(entry != NULL, -1);
+        assume_d(cobj  != NULL, -1);
+
+        /*
+         * Errors and incomplete results (e.g. due to the memory limits)
+         * are collected again the next time.
+         */
+        switch (probe_cobj_get_flag(cobj)) {
+        case SYSCHAR_FLAG_COMPLETE:
+        case SYSCHAR_FLAG_DOES_NOT_EXIST:
+                break;
+        default:
+                return (0);
+        }
+
+        s_name = SEXP_list_nth(entry, 1);
+        key    = SEXP_list_nth(entry, 2);
+        tokens = SEXP_list_nth(entry, 3);
+        SEXP_string_cstr_r(s_name, name, sizeof name);
+
+        version = SEXP_number_newu_32(PROBE_DCACHE_VERSION);
+        stored  = SEXP_list_new(version, key, tokens, cobj, NULL);
+        sb      = strbuf_new(PROBE_DCACHE_SBSIZE);
+        ret     = -1;
+
+        SEXP_vfree(s_name, key, tokens, version, NULL);
+
+        if (SEXP_sbprintf_b(stored, sb) != 0) {
+                dW("Can't encode the cache entry %s\n", name);
+                goto finish;
+        }
+
+        /*
+         * Write a temporary file and rename it, so that a concurrent reader
+         * (another scan) never sees a partial entry
+         */
+        snprintf(tmp, sizeof tmp, "%s.%ld.%lx", name, (long)getpid(), (unsigned long)pthread_self());
+
+        if ((fd = openat(cache->dirfd, tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600)) == -1) {
+                dW("Can't create the cache entry %s: %u, %s\n", tmp, errno, strerror(errno));
+                goto finish;
+        }
+
+        if (strbuf_write(sb, fd) != (ssize_t)strbuf_length(sb)) {
+                dW("Can't write the cache entry %s: %u, %s\n", tmp, errno, strerror(errno));
+                close(fd);
+                unlinkat(cache->dirfd, tmp, 0);
+                goto finish;
+        }
+
+        close(fd);
+
+        if (renameat(cache->dirfd, tmp, cache->dirfd, name) != 0) {
+                dW("Can't rename the cache entry %s: %u, %s\n", tmp, errno, strerror(errno));
+                unlinkat(cache->dirfd, tmp, 0);
+                goto finish;
+        }
+
+        __sync_fetch_and_add(&cache->stats.stores, 1);
+        ret = 0;
+finish:
+        strbuf_free(sb);
+        SEXP_free(stored);
+
+        return (ret);
+}
+
+void probe_dcache_stats(probe_dcache_t *cache, struct probe_dcache_stats *stats)
+{
+        assume_d(cache != NULL, /* void */);
+        assume_d(stats != NULL, /* void */);
+
+        __sync_synchronize();
+        memcpy(stats, &cache->stats, sizeof *stats);
+}
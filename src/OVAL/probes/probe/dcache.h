@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, 
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software 
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef PROBE_DCACHE_H
+#define PROBE_DCACHE_H
+
+#include <stdint.h>
+#include <sexp.h>
+
+/*
+ * Persistent cache of collected objects. Each entry is stored in its own
+ * file named after the hash of the object and holds
+ *
+ *  (<version> <object> <tokens> <collected object>)
+ *
+ * in the binary S-exp encoding. <object> is the object with its id
+ * removed, so equal objects of different definitions share an entry.
+ * <tokens> describe the state of the system the collected object depends
+ * on (boot ID, metadata of the examined files). They are taken before the
+ * collection and an entry is used only if they are still the same.
+ *
+ * Only objects of the probes listed in dcache.c, and only those with
+ * a known set of examined files, are cached.
+ */
+#define PROBE_DCACHE_ENV     "OSCAP_PROBE_CACHE_DIR"
+#define PROBE_DCACHE_VERSION 1
+
+struct probe_dcache_stats {
+        uint64_t lookups;    /**< objects looked up in the cache */
+        uint64_t hits;       /**< valid entries found */
+        uint64_t stale;      /**< entries found but not valid anymore */
+        uint64_t stores;     /**< entries written */
+        uint64_t uncachable; /**< objects which can't be cached */
+};
+
+typedef struct probe_dcache probe_dcache_t;
+
+/**
+ * Open the cache of a probe in a directory. A subdirectory named after the
+ * probe is created if it doesn't exist yet. An existing subdirectory is
+ * used only if it's owned by the effective user and not writable by the
+ * group or others. The cache has to be opened before the probe changes
+ * its root directory.
+ * @param dir cache directory
+ * @param probe_name name of the probe
+ * @return cache pointer or NULL if the probe isn't supported or on failure
+ */
+probe_dcache_t *probe_dcache_new(const char *dir, const char *probe_name);
+
+/**
+ * Close the cache.
+ * @param cache the cache to be closed
+ */
+void probe_dcache_free(probe_dcache_t *cache);
+
+/**
+ * Look up the collected object of an object.
+ * @param cache the cache
+ * @param obj the object
+ * @param entry where to store the key and the validation tokens of the
+ *              object (set to NULL if the object can't be cached); the
+ *              S-exp is used to store the collected object on a miss
+ * @return the cached collected object or NULL
+ */
+SEXP_t *probe_dcache_get(probe_dcache_t *cache, const SEXP_t *obj, SEXP_t **entry);
+
+/**
+ * Store a collected object.
+ * @param cache the cache
+ * @param entry entry returned by probe_dcache_get
+ * @param cobj the collected object
+ * @retval 0 on success or if the collected object isn't worth caching
+ * @retval -1 on failure
+ */
+int probe_dcache_add(probe_dcache_t *cache, const SEXP_t *entry, SEXP_t *cobj);
+
+/**
+ * Get the usage counters of the cache.
+ */
+void probe_dcache_stats(probe_dcache_t *cache, struct probe_dcache_stats *stats);
+
+#endif /* PROBE_DCACHE_H */
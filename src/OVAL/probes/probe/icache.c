@@ -29,8 +29,9 @@
 #include <errno.h>
 #include <string.h>
 #include <inttypes.h>
+#include <time.h>
+#include <sys/time.h>
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
 #include "common/memusage.h"
@@ -84,181 +85,206 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static void *probe_icache_worker(void *arg)
+/*
+ * Compare two items ignoring the first element (name and attributes,
+ * including the item ID). The lists are compared in place.
+ */
+static bool probe_icache_itemcmp(const SEXP_t *a, const SEXP_t *b)
 {
-        probe_icache_t *cache = (probe_icache_t *)(arg);
-        probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
-
-        assume_d(cache != NULL, NULL);
+        SEXP_list_it *it_a, *it_b;
+        SEXP_t       *ia, *ib;
+        bool          ret;
 
-	pthread_setname_np(pthread_self(), "icache_worker");
+        it_a = SEXP_list_it_new(a);
+        it_b = SEXP_list_it_new(b);
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                return (NULL);
+        if (it_a == NULL || it_b == NULL) {
+                ret = false;
+                goto out;
         }
 
-	pair = &pair_mem;
-        dD("icache worker ready\n");
+        SEXP_list_it_next(it_a);
+        SEXP_list_it_next(it_b);
+
+        do {
+                ia = SEXP_list_it_next(it_a);
+                ib = SEXP_list_it_next(it_b);
+                ret = SEXP_deepcmp(ia, ib);
+        } while (ret && ia != NULL && ib != NULL);
+out:
+        if (it_a != NULL)
+                SEXP_list_it_free(it_a);
+        if (it_b != NULL)
+                SEXP_list_it_free(it_b);
+
+        return (ret);
+}
 
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.\n",
-	           errno, strerror(errno));
-	        pthread_mutex_unlock(&cache->queue_mutex);
-	        return (NULL);
+static void probe_icache_index_grow(probe_icache_t *cache)
+{
+        probe_citem_t *index;
+        size_t         size, i, j;
+
+        size  = cache->index_size * 2;
+        index = oscap_alloc(sizeof(probe_citem_t) * size);
+        memset(index, 0, sizeof(probe_citem_t) * size);
+
+        for (i = 0; i < cache->index_size; ++i) {
+                if (cache->index[i].item == NULL)
+                        continue;
+
+                for (j = cache->index[i].id[0] & (size - 1); index[j].item != NULL; j = (j + 1) & (size - 1));
+
+                index[j] = cache->index[i];
         }
 
-        while(pthread_cond_wait(&cache->queue_notempty, &cache->queue_mutex) == 0) {
-                assume_d(cache->queue_cnt > 0, NULL);
-        next:
-                dD("Extracting item from the cache queue: cnt=%"PRIu16", beg=%"PRIu16"\n", cache->queue_cnt, cache->queue_beg);
-                /*
-                 * Extract an item from the queue and update queue beg, end & cnt
-                 */
-                pair_mem = cache->queue[cache->queue_beg];
-#ifndef NDEBUG
-		memset(cache->queue + cache->queue_beg, 0, sizeof(probe_iqpair_t));
-#endif
-                --cache->queue_cnt;
-		++cache->queue_beg;
+        oscap_free(cache->index);
+        cache->index      = index;
+        cache->index_size = size;
+}
 
-		if (cache->queue_beg == cache->queue_max)
-			cache->queue_beg = 0;
+static void probe_icache_handle(probe_icache_t *cache, probe_iqpair_t *pair)
+{
+        probe_citem_t *slot;
+        SEXP_ID_t      id[2];
+        size_t         i, mask;
 
-		assume_d(cache->queue_cnt == 0 ?
-			 cache->queue_end == cache->queue_beg :
-			 cache->queue_end != cache->queue_beg, NULL);
+        dD("Handling cache request\n");
 
-                /*
-                 * Release the mutex
-                 */
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
-                }
+        /*
+         * Compute the item hash. Items with the same hash are
+         * considered to be equal if the rest of the items
+         * (everything except the ID) is equal.
+         */
+        SEXP_ID_v128(pair->p.item, id);
+        dD("item ID=%"PRIx64"%016"PRIx64"\n", id[0], id[1]);
 
-                dD("Signaling `notfull'\n");
+        /* Keep the load factor below 0.75 */
+        if ((cache->index_count + 1) * 4 > cache->index_size * 3)
+                probe_icache_index_grow(cache);
 
-                if (pthread_cond_signal(&cache->queue_notfull) != 0) {
-                        dE("An error ocured while signaling the `notfull' condition: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
-                }
+        mask = cache->index_size - 1;
+
+        for (i = id[0] & mask; cache->index[i].item != NULL; i = (i + 1) & mask) {
+                slot = cache->index + i;
 
-                if (pair->cobj == NULL) {
+                if (slot->id[0] == id[0] && slot->id[1] == id[1] &&
+                    probe_icache_itemcmp(pair->p.item, slot->item))
+                {
                         /*
-                         * Handle NOP case (synchronization)
+                         * Cache HIT
                          */
-                        assume_d(pair->p.cond != NULL, NULL);
+                        dD("cache HIT\n");
+                        SEXP_free(pair->p.item);
+                        pair->p.item = slot->item;
 
-                        dD("Handling NOP\n");
+                        goto add;
+                }
+        }
 
-                        if (pthread_cond_signal(pair->p.cond) != 0) {
-                                dE("An error ocured while signaling NOP condition: %u, %s\n",
-                                   errno, strerror(errno));
-                                abort();
-                        }
-                } else {
-                        probe_citem_t *cached = NULL;
+        /*
+         * Cache MISS
+         */
+        dD("cache MISS\n");
+        slot = cache->index + i;
+        slot->id[0] = id[0];
+        slot->id[1] = id[1];
+        slot->item  = pair->p.item;
+        ++cache->index_count;
+
+        /* Assign an unique item ID */
+        probe_icache_item_setID(pair->p.item, id[0]);
+add:
+        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
+                dW("An error ocured while adding the item to the collected object\n");
+        }
+}
 
-                        dD("Handling cache request\n");
+/*
+ * Drop all items from the index. The items stay referenced by the
+ * collected objects they were added to.
+ */
+static void probe_icache_clear(probe_icache_t *cache)
+{
+        size_t i;
 
-                        /*
-                         * Compute item ID
-                         */
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dD("item ID=%"PRIu64"\n", item_ID);
+        for (i = 0; i < cache->index_size; ++i) {
+                if (cache->index[i].item != NULL)
+                        SEXP_free(cache->index[i].item);
+        }
 
-                        /*
-                         * Perform cache lookup
-                         */
-                        if (rbt_i64_get(cache->tree, (int64_t)item_ID, (void *)&cached) == 0) {
-                                register uint16_t i;
-				SEXP_t   rest1, rest2;
-                                /*
-                                 * Maybe a cache HIT
-                                 */
-                                dD("cache HIT #1\n");
-
-                                for (i = 0; i < cached->count; ++i) {
-                                        if (SEXP_deepcmp(SEXP_list_rest_r(&rest1, pair->p.item),
-							 SEXP_list_rest_r(&rest2, cached->item[i])))
-					{
-						SEXP_free_r(&rest1);
-						SEXP_free_r(&rest2);
-                                                break;
-					}
-
-					SEXP_free_r(&rest1);
-					SEXP_free_r(&rest2);
-                                }
+        memset(cache->index, 0, sizeof(probe_citem_t) * cache->index_size);
+        cache->index_count = 0;
+}
 
-                                if (i == cached->count) {
-                                        /*
-                                         * Cache MISS
-                                         */
-                                        dD("cache MISS\n");
-
-                                        cached->item = oscap_realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-                                        cached->item[cached->count - 1] = pair->p.item;
-
-                                        /* Assign an unique item ID */
-                                        probe_icache_item_setID(pair->p.item, item_ID);
-                                } else {
-                                        /*
-                                         * Cache HIT
-                                         */
-                                        dD("cache HIT #2 -> real HIT\n");
-                                        SEXP_free(pair->p.item);
-                                        pair->p.item = cached->item[i];
-                                }
-                        } else {
+static void *probe_icache_worker(void *arg)
+{
+        probe_icache_t *cache = (probe_icache_t *)(arg);
+        probe_iqpair_t  pairs[PROBE_IQUEUE_BATCH];
+        uint32_t        count, i;
+
+        assume_d(cache != NULL, NULL);
+
+	pthread_setname_np(pthread_self(), "icache_worker");
+        dD("icache worker ready\n");
+
+        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
+        {
+        case 0:
+        case PTHREAD_BARRIER_SERIAL_THREAD:
+	        break;
+        default:
+	        dE("pthread_barrier_wait: %d, %s.\n",
+	           errno, strerror(errno));
+	        return (NULL);
+        }
+
+        /*
+         * Drain the queue in batches. mpscq_pop() blocks (and is
+         * a cancellation point) while the queue is empty.
+         */
+        while ((count = mpscq_pop(cache->queue, pairs, PROBE_IQUEUE_BATCH)) > 0) {
+                dD("Extracted %"PRIu32" pairs from the cache queue\n", count);
+
+                for (i = 0; i < count; ++i) {
+                        if (pairs[i].cobj == NULL) {
                                 /*
-                                 * Cache MISS
+                                 * Handle NOP case (synchronization)
                                  */
-                                dD("cache MISS\n");
-                                cached = oscap_talloc(probe_citem_t);
-                                cached->item = oscap_talloc(SEXP_t *);
-                                cached->item[0] = pair->p.item;
-                                cached->count = 1;
+                                assume_d(pairs[i].p.done != NULL, NULL);
 
-                                /* Assign an unique item ID */
-                                probe_icache_item_setID(pair->p.item, item_ID);
+                                dD("Handling NOP\n");
 
-                                if (rbt_i64_add(cache->tree, (int64_t)item_ID, (void *)cached, NULL) != 0) {
-                                        dE("Can't add item (k=%"PRIi64" to the cache (%p)\n", (int64_t)item_ID, cache->tree);
-
-                                        oscap_free(cached->item);
-                                        oscap_free(cached);
+                                if (__sync_bool_compare_and_swap(&cache->flush, 1, 0)) {
+                                        dD("Flushing %zu items\n", cache->index_count);
+                                        probe_icache_clear(cache);
+                                }
 
-                                        /* now what? */
+                                if (pthread_mutex_lock(&cache->nop_mutex) != 0) {
+                                        dE("An error ocured while locking the NOP mutex: %u, %s\n",
+                                           errno, strerror(errno));
                                         abort();
                                 }
-                        }
 
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object\n");
-                        }
-                }
+                                *pairs[i].p.done = 1;
 
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while re-locking the queue mutex: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
-                }
+                                if (pthread_cond_broadcast(&cache->nop_cond) != 0) {
+                                        dE("An error ocured while signaling NOP condition: %u, %s\n",
+                                           errno, strerror(errno));
+                                        abort();
+                                }
 
-                if (cache->queue_cnt > 0)
-                        goto next;
+                                if (pthread_mutex_unlock(&cache->nop_mutex) != 0) {
+                                        dE("An error ocured while unlocking the NOP mutex: %u, %s\n",
+                                           errno, strerror(errno));
+                                        abort();
+                                }
+                        } else
+                                probe_icache_handle(cache, pairs + i);
+                }
         }
 
+        dE("An error ocured while reading the cache queue\n");
         return (NULL);
 }
 
@@ -267,26 +293,25 @@ probe_icache_t *probe_icache_new(void)
         probe_icache_t *cache;
 
         cache = oscap_talloc(probe_icache_t);
-        cache->tree = rbt_i64_new();
-
-        if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
-                dE("Can't initialize icache mutex: %u, %s\n", errno, strerror(errno));
+        cache->index_size  = PROBE_ICACHE_INITSIZE;
+        cache->index_count = 0;
+        cache->flush       = 0;
+        cache->index = oscap_alloc(sizeof(probe_citem_t) * cache->index_size);
+        memset(cache->index, 0, sizeof(probe_citem_t) * cache->index_size);
+        cache->queue = mpscq_new(PROBE_IQUEUE_CAPACITY, sizeof(probe_iqpair_t));
+
+        if (cache->queue == NULL) {
+                dE("Can't create the icache queue: %u, %s\n", errno, strerror(errno));
                 goto fail;
         }
 
-        cache->queue_beg = 0;
-        cache->queue_end = 0;
-        cache->queue_cnt = 0;
-        cache->queue_max = PROBE_IQUEUE_CAPACITY;
-
-        if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notempty): %u, %s\n",
-                   errno, strerror(errno));
+        if (pthread_mutex_init(&cache->nop_mutex, NULL) != 0) {
+                dE("Can't initialize icache mutex: %u, %s\n", errno, strerror(errno));
                 goto fail;
         }
 
-        if (pthread_cond_init(&cache->queue_notfull, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notfull): %u, %s\n",
+        if (pthread_cond_init(&cache->nop_cond, NULL) != 0) {
+                dE("Can't initialize icache NOP condition variable: %u, %s\n",
                    errno, strerror(errno));
                 goto fail;
         }
@@ -300,80 +325,51 @@ probe_icache_t *probe_icache_new(void)
 
         return (cache);
 fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
-
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
+        oscap_free(cache->index);
+        mpscq_free(cache->queue);
+        pthread_mutex_destroy(&cache->nop_mutex);
+        pthread_cond_destroy(&cache->nop_cond);
         oscap_free(cache);
 
         return (NULL);
 }
 
-static int __probe_icache_add_nolock(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item, pthread_cond_t *cond)
+int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        assume_d((cond == NULL) ^ (item == NULL), -1);
-retry:
-        if (cache->queue_cnt < cache->queue_max) {
-                cache->queue[cache->queue_end].cobj = cobj;
-
-                if (item != NULL) {
-			assume_d(cobj != NULL, -1);
-                        cache->queue[cache->queue_end].p.item = item;
-                } else {
-			assume_d(item == NULL && cobj == NULL, -1);
-                        cache->queue[cache->queue_end].p.cond = cond;
-		}
-
-                ++cache->queue_cnt;
-		++cache->queue_end;
-
-                if (cache->queue_end == cache->queue_max)
-                        cache->queue_end = 0;
-        } else {
-                /*
-                 * The queue is full, we have to wait
-                 */
-                if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
-                        goto retry;
-                else {
-                        dE("An error ocured while waiting for the `notfull' queue condition: %u, %s\n",
-                           errno, strerror(errno));
-                        return (-1);
-                }
-        }
-
-        return (0);
+        return probe_icache_add_batch(cache, cobj, &item, 1);
 }
 
-int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
+/*
+ * Enqueue several items of one collected object at once. The items
+ * are handed over to the icache worker in a single queue operation.
+ */
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count)
 {
-        int ret;
+        probe_iqpair_t pairs[PROBE_IQUEUE_BATCH];
+        size_t i, n;
 
-        if (cache == NULL || cobj == NULL || item == NULL)
+        if (cache == NULL || cobj == NULL || items == NULL)
                 return (-1); /* XXX: EFAULT */
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+        while (count > 0) {
+                n = count < PROBE_IQUEUE_BATCH ? count : PROBE_IQUEUE_BATCH;
 
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
+                for (i = 0; i < n; ++i) {
+                        if (items[i] == NULL)
+                                return (-1);
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                abort();
-        }
+                        pairs[i].cobj   = cobj;
+                        pairs[i].p.item = items[i];
+                }
 
-        if (ret != 0)
-                return (-1);
+                if (mpscq_push(cache->queue, pairs, (uint32_t)n) != 0) {
+                        dE("An error ocured while adding items to the cache queue: %u, %s\n",
+                           errno, strerror(errno));
+                        return (-1);
+                }
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
+                items += n;
+                count -= n;
         }
 
         return (0);
@@ -381,103 +377,130 @@ int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 
 int probe_icache_nop(probe_icache_t *cache)
 {
-        pthread_cond_t cond;
+        probe_iqpair_t pair;
+        volatile int   done = 0;
 
         dD("NOP\n");
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
+        pair.cobj   = NULL;
+        pair.p.done = &done;
+
+        if (mpscq_push(cache->queue, &pair, 1) != 0) {
+                dE("An error ocured while adding NOP to the cache queue: %u, %s\n",
                    errno, strerror(errno));
                 return (-1);
         }
 
-        if (pthread_cond_init(&cond, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (NOP): %u, %s\n",
+        dD("Waiting for icache worker to handle the NOP\n");
+
+        if (pthread_mutex_lock(&cache->nop_mutex) != 0) {
+                dE("An error ocured while locking the NOP mutex: %u, %s\n",
                    errno, strerror(errno));
-                return (-1);
+                abort();
         }
 
-        if (__probe_icache_add_nolock(cache, NULL, NULL, &cond) != 0) {
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s\n",
+        while (!done) {
+                if (pthread_cond_wait(&cache->nop_cond, &cache->nop_mutex) != 0) {
+                        dE("An error ocured while waiting for the `NOP' queue condition: %u, %s\n",
                            errno, strerror(errno));
-                        abort();
+                        pthread_mutex_unlock(&cache->nop_mutex);
+                        return (-1);
                 }
-
-                pthread_cond_destroy(&cond);
-                return (-1);
         }
 
-        dD("Signaling `notempty'\n");
+        dD("Sync\n");
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
+        if (pthread_mutex_unlock(&cache->nop_mutex) != 0) {
+                dE("An error ocured while unlocking the NOP mutex: %u, %s\n",
                    errno, strerror(errno));
-
-                pthread_cond_destroy(&cond);
-                return (-1);
+                abort();
         }
 
-        dD("Waiting for icache worker to handle the NOP\n");
+        return (0);
+}
 
-        if (pthread_cond_wait(&cond, &cache->queue_mutex) != 0) {
-                dE("An error ocured while waiting for the `NOP' queue condition: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+/*
+ * Drop the cached items, e.g. when the probe is reset. Items enqueued
+ * before the call are handled first.
+ */
+int probe_icache_flush(probe_icache_t *cache)
+{
+        __sync_lock_test_and_set(&cache->flush, 1);
 
-        dD("Sync\n");
+        return probe_icache_nop(cache);
+}
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                abort();
-        }
+static uint64_t probe_memcheck_msec(void)
+{
+        struct timeval tv;
+#if defined(HAVE_CLOCK_GETTIME)
+        struct timespec ts;
 
-        pthread_cond_destroy(&cond);
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+                return ((uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000);
+#endif
+        gettimeofday(&tv, NULL);
 
-        return (0);
+        return ((uint64_t)tv.tv_sec * 1000 + (uint64_t)tv.tv_usec / 1000);
 }
 
-#define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
-#define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
-#define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
-
 /**
  * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
  * In case of an error, -1 is returned.
+ *
+ * Reading the memory usage means parsing two files in /proc, so it's
+ * sampled only once per `interval' items or `period' milliseconds,
+ * whichever comes first. The result of the last sample is returned
+ * in between.
  */
-static int probe_cobj_memcheck(size_t item_cnt)
+static int probe_cobj_memcheck(struct probe_ctx *ctx)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
+	const probe_memlimits_t *limits = ctx->memlimits;
+	struct proc_memusage mu_proc;
+	struct sys_memusage  mu_sys;
+	double   c_ratio;
+	uint64_t now;
+
+	if (limits == NULL || ctx->item_cnt <= limits->threshold)
+		return (0);
+
+	now = probe_memcheck_msec();
+
+	if (ctx->mc_cnt != 0 &&
+	    ctx->item_cnt - ctx->mc_cnt < limits->interval &&
+	    now - ctx->mc_time < limits->period)
+	{
+		if (ctx->mc_result != 0)
+			errno = ENOMEM;
+		return (ctx->mc_result);
+	}
 
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
+	ctx->mc_cnt  = ctx->item_cnt;
+	ctx->mc_time = now;
 
-		if (oscap_sys_memusage (&mu_sys) != 0)
-			return (-1);
+	if (oscap_proc_memusage (&mu_proc) != 0)
+		return (ctx->mc_result = -1);
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+	if (oscap_sys_memusage (&mu_sys) != 0)
+		return (ctx->mc_result = -1);
 
-		if (c_ratio > PROBE_RESULT_MEMCHECK_MAXRATIO) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f\n",
-			   PROBE_RESULT_MEMCHECK_MAXRATIO, c_ratio);
-			errno = ENOMEM;
-			return (1);
-		}
+	c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
 
-		if ((mu_sys.mu_realfree / 1024) < PROBE_RESULT_MEMCHECK_MINFREEMEM) {
-			dW("Minimum free memory limit reached! limit=%zu, current=%zu\n",
-			   PROBE_RESULT_MEMCHECK_MINFREEMEM, mu_sys.mu_realfree / 1024);
-			errno = ENOMEM;
-			return (1);
-		}
+	if (c_ratio > limits->max_ratio) {
+		dW("Memory usage ratio limit reached! limit=%f, current=%f\n",
+		   limits->max_ratio, c_ratio);
+		errno = ENOMEM;
+		return (ctx->mc_result = 1);
+	}
+
+	if ((mu_sys.mu_realfree / 1024) < limits->min_free) {
+		dW("Minimum free memory limit reached! limit=%zu, current=%zu\n",
+		   limits->min_free, mu_sys.mu_realfree / 1024);
+		errno = ENOMEM;
+		return (ctx->mc_result = 1);
 	}
 
-	return (0);
+	return (ctx->mc_result = 0);
 }
 
 /**
@@ -497,18 +520,11 @@ static int probe_cobj_memcheck(size_t item_cnt)
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
-	SEXP_t *cobj_content;
-	size_t  cobj_itemcnt;
-
 	assume_d(ctx != NULL, -1);
 	assume_d(ctx->probe_out != NULL, -1);
 	assume_d(item != NULL, -1);
 
-	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
-	cobj_itemcnt = SEXP_list_length(cobj_content);
-	SEXP_free(cobj_content);
-
-	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
+	if (probe_cobj_memcheck(ctx) != 0) {
 
 		/*
 		 * Don't set the message again if the collected object is
@@ -520,8 +536,10 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 			 * Sync with the icache thread before modifying the
 			 * collected object.
 			 */
-			if (probe_icache_nop(ctx->icache) != 0)
+			if (probe_icache_nop(ctx->icache) != 0) {
+				SEXP_free(item);
 				return -1;
+			}
 
 			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
 			                      "Object is incomplete due to memory constraints.");
@@ -532,6 +550,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 			SEXP_free(msg);
 		}
 
+		SEXP_free(item);
 		return 2;
 	}
 
@@ -546,34 +565,23 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
                 return (-1);
         }
 
-        return (0);
-}
-
-static void probe_icache_free_node(struct rbt_i64_node *n)
-{
-        probe_citem_t *ci = (probe_citem_t *)n->data;
-
-        while (ci->count > 0) {
-                SEXP_free(ci->item[ci->count - 1]);
-                --ci->count;
-        }
+        ++ctx->item_cnt;
 
-        oscap_free(ci->item);
-        oscap_free(ci);
-        return;
+        return (0);
 }
 
 void probe_icache_free(probe_icache_t *cache)
 {
-        void *ret = NULL;
+        void  *ret = NULL;
 
         pthread_cancel(cache->thid);
         pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+        mpscq_free(cache->queue);
+        pthread_mutex_destroy(&cache->nop_mutex);
+        pthread_cond_destroy(&cache->nop_cond);
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
+        probe_icache_clear(cache);
+        oscap_free(cache->index);
         oscap_free(cache);
         return;
 }
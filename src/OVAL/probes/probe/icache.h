@@ -24,43 +24,51 @@
 
 #include <stddef.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
+#include "../SEAP/generic/mpscq.h"
 
 #ifndef PROBE_IQUEUE_CAPACITY
 #define PROBE_IQUEUE_CAPACITY 1024
 #endif
 
+#ifndef PROBE_ICACHE_INITSIZE
+#define PROBE_ICACHE_INITSIZE 1024 /* initial number of item index slots; power of 2 */
+#endif
+
+#ifndef PROBE_IQUEUE_BATCH
+#define PROBE_IQUEUE_BATCH 64 /* max. number of pairs handled per queue drain */
+#endif
+
 typedef struct {
         SEXP_t *cobj;
         union {
-                SEXP_t         *item;
-                pthread_cond_t *cond;
+                SEXP_t       *item;
+                volatile int *done; /* NOP: set when handled */
         } p;
 } probe_iqpair_t;
 
+/* Item index slot; the slot is empty if item == NULL */
 typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
+        SEXP_ID_t id[2]; /* 128-bit structural hash of the item */
+        SEXP_t   *item;
+} probe_citem_t;
 
-        pthread_mutex_t queue_mutex;
-        pthread_cond_t  queue_notempty;
-        pthread_cond_t  queue_notfull;
+typedef struct {
+        probe_citem_t *index;       /* open addressing (linear probing) hash index */
+        size_t         index_size;  /* number of slots; power of 2 */
+        size_t         index_count; /* number of stored items */
+        pthread_t      thid;
 
-        probe_iqpair_t  queue[PROBE_IQUEUE_CAPACITY];
-        uint16_t        queue_beg;
-        uint16_t        queue_end;
-        uint16_t        queue_cnt;
-        uint16_t        queue_max;
+        mpscq_t        *queue;    /* lock-free MPSC ring of probe_iqpair_t */
+        pthread_mutex_t nop_mutex;
+        pthread_cond_t  nop_cond; /* signaled when a NOP is handled */
+        volatile int    flush;    /* drop the index when handling the next NOP */
 } probe_icache_t;
 
-typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
-
 probe_icache_t *probe_icache_new(void);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count);
 int probe_icache_nop(probe_icache_t *cache);
+int probe_icache_flush(probe_icache_t *cache);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
@@ -32,17 +32,23 @@
 #include <pthread.h>
 #include <errno.h>
 #include <libgen.h>
+#include <stdlib.h>
+#include <inttypes.h>
 #include <seap.h>
 #include "common/bfind.h"
+#include "common/debug_priv.h"
 #include "probe.h"
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
 #include "worker.h"
+#include "wpool.h"
 #include "signal_handler.h"
 #include "input_handler.h"
 #include "probe-api.h"
 #include "option.h"
+#include "OVAL/results/oval_regex_cache_impl.h"
+#include "OVAL/probes/oval_fts_index.h"
 #include <oscap_debug.h>
 
 static int fail(int err, const char *who, int line)
@@ -68,21 +74,109 @@ static int probe_optecmp(char **a, char **b)
 	return strcmp(*a, *b);
 }
 
+/*
+ * Reset command handler. If the argument is a list of object and state ids,
+ * only the cached results of those are dropped. Otherwise the whole result
+ * cache and the item cache are flushed, the directory index is dropped and
+ * the probe drops the state it keeps between objects (probe_flush). The
+ * name cache doesn't depend on the evaluated content and it's shared by
+ * the worker threads (OSCAP_GSYM(ncache)) so it's kept. The persistent
+ * cache validates its entries on every lookup and is kept as well.
+ *
+ * The state is torn down only while no worker runs; requests received in
+ * the meantime wait in the queue of the worker pool. The library receives
+ * the replies to all its requests before it sends the reset, so no worker
+ * waits for the library (nested objects, state fetches) at this point.
+ */
 static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
 {
         probe_t *probe = (probe_t *)arg1;
-        /*
-         * FIXME: implement main loop locking & worker waiting
-         */
-	probe_rcache_free(probe->rcache);
-        probe_ncache_free(probe->ncache);
 
+        if (arg0 != NULL && SEXP_listp(arg0)) {
+                SEXP_t *id;
+                uint32_t n = 0;
+
+                SEXP_list_foreach(id, arg0) {
+                        if (probe_rcache_sexp_del(probe->rcache, id) == 0)
+                                ++n;
+                }
+
+                dI("%s: reset: dropped %u cached result(s)\n", probe->name, n);
+                return(NULL);
+        }
+
+        probe_wpool_quiesce(probe->wpool);
+
+	probe_rcache_free(probe->rcache);
         probe->rcache = probe_rcache_new();
-        probe->ncache = probe_ncache_new();
+
+        /* items of the previous scan aren't shared with the next one */
+        probe_icache_flush(probe->icache);
+
+        /* directory listings may be outdated in the next scan */
+        oval_ftsidx_free();
+
+        /* state the probe keeps between objects, e.g. the process table */
+        probe_flush(probe->probe_arg);
+
+        probe_wpool_resume(probe->wpool);
 
         return(NULL);
 }
 
+/*
+ * Cache statistics command handler. Replies with the usage counters of the
+ * persistent cache as (lookups hits stale stores uncachable), all zero if
+ * the cache isn't used.
+ */
+static SEXP_t *probe_cache_stats(SEXP_t *arg0, void *arg1)
+{
+        probe_t *probe = (probe_t *)arg1;
+        struct probe_dcache_stats ds;
+        SEXP_t *r0, *r1, *r2, *r3, *r4, *res;
+
+        memset(&ds, 0, sizeof ds);
+
+        if (probe->dcache != NULL)
+                probe_dcache_stats(probe->dcache, &ds);
+
+        res = SEXP_list_new(r0 = SEXP_number_newu_64(ds.lookups),
+                            r1 = SEXP_number_newu_64(ds.hits),
+                            r2 = SEXP_number_newu_64(ds.stale),
+                            r3 = SEXP_number_newu_64(ds.stores),
+                            r4 = SEXP_number_newu_64(ds.uncachable), NULL);
+        SEXP_vfree(r0, r1, r2, r3, r4, NULL);
+
+        return(res);
+}
+
+/*
+ * Worker pool statistics command handler. Replies with the current state
+ * and the counters of the worker pool as (threads threads_max threads_limit
+ * blocked queued queue_peak jobs refused utilisation).
+ */
+static SEXP_t *probe_pool_stats(SEXP_t *arg0, void *arg1)
+{
+        probe_t *probe = (probe_t *)arg1;
+        struct probe_wpool_stats wps;
+        SEXP_t *r0, *r1, *r2, *r3, *r4, *r5, *r6, *r7, *r8, *res;
+
+        probe_wpool_stats(probe->wpool, &wps);
+
+        res = SEXP_list_new(r0 = SEXP_number_newu_32(wps.threads),
+                            r1 = SEXP_number_newu_32(wps.threads_max),
+                            r2 = SEXP_number_newu_32(wps.threads_limit),
+                            r3 = SEXP_number_newu_32(wps.blocked),
+                            r4 = SEXP_number_newu_32(wps.queue_cnt),
+                            r5 = SEXP_number_newu_32(wps.queue_peak),
+                            r6 = SEXP_number_newu_64(wps.jobs),
+                            r7 = SEXP_number_newu_64(wps.refused),
+                            r8 = SEXP_number_newf(wps.utilisation), NULL);
+        SEXP_vfree(r0, r1, r2, r3, r4, r5, r6, r7, r8, NULL);
+
+        return(res);
+}
+
 static int probe_opthandler_varref(int option, int op, va_list args)
 {
 	bool  o_switch;
@@ -122,6 +216,79 @@ static int probe_opthandler_rcache(int option, int op, va_list args)
 	return (0);
 }
 
+static probe_t *probe_self = NULL;
+
+static int probe_opthandler_maxthreads(int option, int op, va_list args)
+{
+	if (op == PROBE_OPTION_SET) {
+		int o_max_threads = va_arg(args, int);
+
+		if (o_max_threads < 1)
+			return (-1);
+		/*
+		 * The option is supposed to be set from probe_init(), i.e.
+		 * before the worker pool is created.
+		 */
+		probe_self->max_threads = (uint32_t)o_max_threads;
+	} else if (op == PROBE_OPTION_GET) {
+		int *max_threads = va_arg(args, int *);
+
+		if (max_threads != NULL)
+			*max_threads = (int)probe_self->max_threads;
+	}
+	return (0);
+}
+
+static int probe_opthandler_collectthreads(int option, int op, va_list args)
+{
+	if (op == PROBE_OPTION_SET) {
+		int o_threads = va_arg(args, int);
+
+		if (o_threads < 1)
+			return (-1);
+
+		probe_self->collect_threads = (uint32_t)o_threads;
+	} else if (op == PROBE_OPTION_GET) {
+		int *threads = va_arg(args, int *);
+
+		if (threads != NULL)
+			*threads = (int)probe_self->collect_threads;
+	}
+	return (0);
+}
+
+static int probe_opthandler_memlimits(int option, int op, va_list args)
+{
+	if (op == PROBE_OPTION_SET) {
+		double o_max_ratio = va_arg(args, double);
+		int    o_min_free  = va_arg(args, int);
+
+		if (o_max_ratio <= 0.0 || o_max_ratio > 1.0 || o_min_free < 0)
+			return (-1);
+
+		probe_self->memlimits.max_ratio = o_max_ratio;
+		probe_self->memlimits.min_free  = (size_t)o_min_free;
+	} else if (op == PROBE_OPTION_GET) {
+		double *max_ratio = va_arg(args, double *);
+		int    *min_free  = va_arg(args, int *);
+
+		if (max_ratio != NULL)
+			*max_ratio = probe_self->memlimits.max_ratio;
+		if (min_free != NULL)
+			*min_free = (int)probe_self->memlimits.min_free;
+	}
+	return (0);
+}
+
+static void probe_pwpair_free(void *arg)
+{
+	/*
+	 * The message and the worker structure are referenced from
+	 * the probe->workers tree and freed by the signal handler.
+	 */
+	oscap_free(arg);
+}
+
 static int probe_opthandler_offlinemode(int option, int op, va_list args)
 {
 	if (op == PROBE_OPTION_SET) {
@@ -167,6 +334,8 @@ int main(int argc, char *argv[])
 	sigset_t       sigmask;
 	probe_t        probe;
 	char *rootdir = NULL;
+	char *max_threads = NULL;
+	char *env_value = NULL;
 
 	/* Turn on verbose mode */
 	char *verbosity_level = getenv("OSCAP_PROBE_VERBOSITY_LEVEL");
@@ -202,6 +371,16 @@ int main(int argc, char *argv[])
 	probe.pid   = getpid();
 	probe.name  = basename(argv[0]);
         probe.probe_exitcode = 0;
+	probe.max_threads = PROBE_WORKER_DEFAULT_MAX_THREADS;
+	probe.collect_threads = PROBE_WORKER_DEFAULT_COLLECT_THREADS;
+	probe.memlimits.max_ratio = PROBE_RESULT_MEMCHECK_MAXRATIO;
+	probe.memlimits.min_free  = PROBE_RESULT_MEMCHECK_MINFREEMEM;
+	probe.memlimits.threshold = PROBE_RESULT_MEMCHECK_CTRESHOLD;
+	probe.memlimits.interval  = PROBE_RESULT_MEMCHECK_INTERVAL;
+	probe.memlimits.period    = PROBE_RESULT_MEMCHECK_PERIOD;
+	probe.sexp_arena = SEXP_ARENA_HEAP;
+
+	probe_self = &probe;
 
 	/*
 	 * Initialize SEAP stuff
@@ -212,7 +391,13 @@ int main(int argc, char *argv[])
 	if (probe.sd < 0)
 		fail(errno, "SEAP_openfd2", __LINE__ - 3);
 
-	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, 0, &probe_reset) != 0)
+	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, SEAP_CMDREG_USEARG, &probe_reset, &probe) != 0)
+		fail(errno, "SEAP_cmd_register", __LINE__ - 1);
+
+	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_CACHE_STATS, SEAP_CMDREG_USEARG, &probe_cache_stats, &probe) != 0)
+		fail(errno, "SEAP_cmd_register", __LINE__ - 1);
+
+	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_POOL_STATS, SEAP_CMDREG_USEARG, &probe_pool_stats, &probe) != 0)
 		fail(errno, "SEAP_cmd_register", __LINE__ - 1);
 
 	/*
@@ -221,13 +406,14 @@ int main(int argc, char *argv[])
 	probe.rcache = probe_rcache_new();
 	probe.ncache = probe_ncache_new();
         probe.icache = probe_icache_new();
+        probe.regex_cache = oval_regex_cache_new(OVAL_REGEX_CACHE_MAX);
 
         OSCAP_GSYM(ncache) = probe.ncache;
 
 	/*
 	 * Initialize probe option handlers
 	 */
-#define PROBE_OPTION_INITCOUNT 3
+#define PROBE_OPTION_INITCOUNT 6
 
 	probe.option = oscap_alloc(sizeof(probe_option_t) * PROBE_OPTION_INITCOUNT);
 	probe.optcnt = PROBE_OPTION_INITCOUNT;
@@ -238,6 +424,12 @@ int main(int argc, char *argv[])
 	probe.option[1].handler = &probe_opthandler_rcache;
 	probe.option[2].option  = PROBEOPT_OFFLINE_MODE_SUPPORTED;
 	probe.option[2].handler = &probe_opthandler_offlinemode;
+	probe.option[3].option  = PROBEOPT_MAX_THREADS;
+	probe.option[3].handler = &probe_opthandler_maxthreads;
+	probe.option[4].option  = PROBEOPT_MEMORY_LIMITS;
+	probe.option[4].handler = &probe_opthandler_memlimits;
+	probe.option[5].option  = PROBEOPT_COLLECT_THREADS;
+	probe.option[5].handler = &probe_opthandler_collectthreads;
 
 	OSCAP_GSYM(probe_optdef) = probe.option;
 	OSCAP_GSYM(probe_optdef_count) = probe.optcnt;
@@ -255,6 +447,15 @@ int main(int argc, char *argv[])
 
 	pthread_attr_destroy(&th_attr);
 
+	/*
+	 * Open the persistent cache of collected objects while the cache
+	 * directory is still reachable
+	 */
+	if ((env_value = getenv(PROBE_DCACHE_ENV)) != NULL && env_value[0] != '\0')
+		probe.dcache = probe_dcache_new(env_value, probe.name);
+	else
+		probe.dcache = NULL;
+
 	/*
 	 * Setup offline mode(s)
 	 */
@@ -286,6 +487,63 @@ int main(int argc, char *argv[])
         probe.workers   = rbt_i32_new();
         probe.probe_arg = probe_init();
 
+	/*
+	 * The environment overrides the probe specific worker thread limit
+	 */
+	if ((max_threads = getenv("OSCAP_PROBE_MAX_THREADS")) != NULL) {
+		long l = strtol(max_threads, NULL, 10);
+
+		if (l > 0)
+			probe.max_threads = (uint32_t)l;
+		else
+			dW("Ignoring invalid OSCAP_PROBE_MAX_THREADS value: %s\n", max_threads);
+	}
+
+	/*
+	 * ...the number of threads used to collect a single object...
+	 */
+	if ((env_value = getenv("OSCAP_PROBE_COLLECT_THREADS")) != NULL) {
+		long l = strtol(env_value, NULL, 10);
+
+		if (l > 0)
+			probe.collect_threads = (uint32_t)l;
+		else
+			dW("Ignoring invalid OSCAP_PROBE_COLLECT_THREADS value: %s\n", env_value);
+	}
+
+	/*
+	 * ...and the memory constraints of the collected objects
+	 */
+	if ((env_value = getenv("OSCAP_PROBE_MEMORY_USAGE_RATIO")) != NULL) {
+		double d = strtod(env_value, NULL);
+
+		if (d > 0.0 && d <= 1.0)
+			probe.memlimits.max_ratio = d;
+		else
+			dW("Ignoring invalid OSCAP_PROBE_MEMORY_USAGE_RATIO value: %s\n", env_value);
+	}
+
+	if ((env_value = getenv("OSCAP_PROBE_MINIMUM_FREE_MEMORY")) != NULL) {
+		char *end = NULL;
+		long  l = strtol(env_value, &end, 10);
+
+		if (end != env_value && l >= 0)
+			probe.memlimits.min_free = (size_t)l;
+		else
+			dW("Ignoring invalid OSCAP_PROBE_MINIMUM_FREE_MEMORY value: %s\n", env_value);
+	}
+
+	/*
+	 * Allocate the S-exps of each request from chunks
+	 */
+	if ((env_value = getenv("OSCAP_PROBE_SEXP_ARENA")) != NULL)
+		probe.sexp_arena = strcmp(env_value, "0") != 0 ? SEXP_ARENA_CHUNKS : SEXP_ARENA_HEAP;
+
+	probe.wpool = probe_wpool_new(probe.max_threads, &probe_worker_runfn, &probe_pwpair_free);
+
+	if (probe.wpool == NULL)
+		fail(errno, "probe_wpool_new", __LINE__ - 3);
+
 	pthread_attr_init(&th_attr);
 
 	if (pthread_create(&probe.th_input, &th_attr, &probe_input_handler, &probe))
@@ -321,13 +579,52 @@ int main(int argc, char *argv[])
 	/*
 	 * Cleanup
 	 */
+	{
+		struct probe_wpool_stats wps;
+
+		probe_wpool_stats(probe.wpool, &wps);
+		dI("%s: worker pool: threads=%"PRIu32"/%"PRIu32" (limit %"PRIu32", refused %"PRIu64"), jobs=%"PRIu64", "
+		   "queue depth: peak=%"PRIu32", avg=%.2f, utilisation=%.1f%%\n",
+		   probe.name, wps.threads, wps.threads_max, wps.threads_limit, wps.refused, wps.jobs,
+		   wps.queue_peak, wps.queue_avg, wps.utilisation * 100.0);
+	}
+	{
+		struct oval_regex_stats rs;
+
+		oval_regex_cache_stats(probe.regex_cache, &rs);
+		dI("%s: regex cache: entries=%"PRIu32", hits=%"PRIu64", misses=%"PRIu64", uncached=%"PRIu64"\n",
+		   probe.name, rs.entries, rs.hits, rs.misses, rs.uncached);
+	}
+	{
+		struct oval_ftsidx_stats fs;
+
+		oval_ftsidx_stats(&fs);
+		dI("%s: fts index: dirs=%"PRIu32", size=%zu, lookups=%"PRIu64", hits=%"PRIu64", "
+		   "lstat saved=%"PRIu64", uncached=%"PRIu64"\n",
+		   probe.name, fs.dirs, fs.size, fs.lookups, fs.hits, fs.stat_saved, fs.uncached);
+	}
+
+	if (probe.dcache != NULL) {
+		struct probe_dcache_stats ds;
+
+		probe_dcache_stats(probe.dcache, &ds);
+		dI("%s: persistent cache: lookups=%"PRIu64", hits=%"PRIu64", stale=%"PRIu64", "
+		   "stored=%"PRIu64", uncachable=%"PRIu64", hit rate=%.1f%%\n",
+		   probe.name, ds.lookups, ds.hits, ds.stale, ds.stores, ds.uncachable,
+		   ds.lookups > 0 ? 100.0 * (double)ds.hits / (double)ds.lookups : 0.0);
+	}
+
         probe_fini(probe.probe_arg);
 
 	probe_ncache_free(probe.ncache);
 	probe_rcache_free(probe.rcache);
+	probe_dcache_free(probe.dcache);
         probe_icache_free(probe.icache);
 
+        probe_wpool_free(probe.wpool);
         rbt_i32_free(probe.workers);
+        oval_regex_cache_free(probe.regex_cache);
+        oval_ftsidx_free();
 
         if (probe.sd != -1)
                 SEAP_close(probe.SEAP_ctx, probe.sd);
@@ -31,165 +31,255 @@
 #include <sexp.h>
 
 #include "common/alloc.h"
-#include "common/bfind.h"
 #include "common/assume.h"
 
 #include "ncache.h"
 
-/**
- * Lock cache for reading.
- * @param c element name cache
- * @param r return value on failure
+/*
+ * An entry or a table is written completely before a pointer to it is
+ * stored where lookups can see it.
  */
-#define PROBE_NCACHE_RLOCK(c,r)                                      \
-        do {                                                    \
-                if (pthread_rwlock_rdlock (&(c)->lock) != 0)    \
-                        return (r);                             \
+#if defined(HAVE_ATOMIC_BUILTINS)
+# define probe_ncache_barrier() __sync_synchronize ()
+#else
+static pthread_mutex_t __probe_ncache_barrier_mtx = PTHREAD_MUTEX_INITIALIZER;
+# define probe_ncache_barrier()                                         \
+        do {                                                            \
+                pthread_mutex_lock (&__probe_ncache_barrier_mtx);       \
+                pthread_mutex_unlock (&__probe_ncache_barrier_mtx);     \
         } while (0)
+#endif
 
-/**
- * Unlock cache which was previously locked for reading.
- * @param c element name cache
- * @return this function calls abort(3) if it is unable to
- *         unlock the cache so as to prevent a deadlock.
- */
-#define PROBE_NCACHE_RUNLOCK(c)                                      \
-        do {                                                    \
-                if (pthread_rwlock_unlock (&(c)->lock) != 0)    \
-                        abort ();                               \
-        } while (0)
+#define probe_ncache_load(p) (*(__typeof__(p) volatile *)&(p))
 
-/**
- * Lock cache for writing.
- * @param c element name cache
- * @param r return value on failure
- */
-#define PROBE_NCACHE_WLOCK(c,r)                                      \
-        do {                                                    \
-                if (pthread_rwlock_wrlock (&(c)->lock) != 0)    \
-                        return (r);                             \
-        } while (0)
+static probe_ncache_table_t *probe_ncache_table_new (size_t size)
+{
+        probe_ncache_table_t *table;
 
-/**
- * Unlock cache which was previously locked for writing.
- * @param c element name cache
- * @return this function calls abort(3) if it is unable to
- *         unlock the cache so as to prevent a deadlock.
- */
-#define PROBE_NCACHE_WUNLOCK(c) PROBE_NCACHE_RUNLOCK(c)
+        table = oscap_alloc (sizeof (probe_ncache_table_t) + sizeof (probe_ncache_entry_t *) * size);
+        table->size = size;
+        table->prev = NULL;
+        memset (table->slot, 0, sizeof (probe_ncache_entry_t *) * size);
+
+        return (table);
+}
 
 probe_ncache_t *probe_ncache_new (void)
 {
         probe_ncache_t *cache;
         cache = oscap_talloc (probe_ncache_t);
 
-        if (pthread_rwlock_init (&cache->lock, NULL) != 0) {
+        if (pthread_mutex_init (&cache->lock, NULL) != 0) {
                 oscap_free (cache);
                 return (NULL);
         }
 
-        cache->name = oscap_calloc (PROBE_NCACHE_INIT_SIZE, sizeof (SEXP_t *));
-        cache->size = PROBE_NCACHE_INIT_SIZE;
-        cache->real = 0;
+        cache->table = probe_ncache_table_new (PROBE_NCACHE_INIT_SIZE);
+        cache->real  = 0;
+        cache->vcnt  = 0;
+        cache->bool_sexp[0] = SEXP_number_newb (false);
+        cache->bool_sexp[1] = SEXP_number_newb (true);
 
         return (cache);
 }
 
 void probe_ncache_free (probe_ncache_t *cache)
 {
+        probe_ncache_table_t *table, *prev;
         size_t i;
 
         assume_d (cache != NULL, /* void */);
 
-        for (i = 0; i < cache->real; ++i)
-                if (cache->name[i] != NULL)
-                        SEXP_free (cache->name[i]);
+        table = cache->table;
+
+        for (i = 0; i < table->size; ++i) {
+                if (table->slot[i] != NULL) {
+                        SEXP_free (table->slot[i]->sexp);
+                        oscap_free (table->slot[i]);
+                }
+        }
+
+        while (table != NULL) {
+                prev = table->prev;
+                oscap_free (table);
+                table = prev;
+        }
 
-        oscap_free (cache->name);
-        pthread_rwlock_destroy (&cache->lock);
+        SEXP_free (cache->bool_sexp[0]);
+        SEXP_free (cache->bool_sexp[1]);
+        pthread_mutex_destroy (&cache->lock);
         oscap_free (cache);
 
         return;
 }
 
-static int probe_ncache_cmp1 (const char *name, const SEXP_t **sexp)
+static uint32_t probe_ncache_hash (const char *str, size_t len)
 {
-        return ((-1) * SEXP_strcmp (*sexp, name));
+        uint32_t h = 2166136261U; /* FNV-1a */
+
+        while (len-- > 0) {
+                h ^= (uint8_t)*str++;
+                h *= 16777619U;
+        }
+
+        return (h);
 }
 
-static int probe_ncache_cmp2 (const SEXP_t **a, const SEXP_t **b)
+static probe_ncache_entry_t *probe_ncache_find (probe_ncache_table_t *table, const char *str, size_t len, uint32_t hash)
 {
-        return SEXP_string_cmp (*a, *b);
+        probe_ncache_entry_t *entry;
+        size_t i, mask;
+
+        mask = table->size - 1;
+
+        for (i = hash & mask; ; i = (i + 1) & mask) {
+                entry = probe_ncache_load (table->slot[i]);
+
+                if (entry == NULL)
+                        return (NULL);
+                if (entry->hash == hash && entry->len == len && memcmp (entry->str, str, len) == 0)
+                        return (entry);
+        }
+        /* NOTREACHED */
+        return (NULL);
 }
 
-SEXP_t *probe_ncache_add (probe_ncache_t *cache, const char *name)
+static void probe_ncache_put (probe_ncache_table_t *table, probe_ncache_entry_t *entry)
 {
-        SEXP_t *ref;
+        size_t i, mask;
 
-        assume_d (cache != NULL, NULL);
-        assume_d (name  != NULL, NULL);
+        mask = table->size - 1;
+
+        for (i = entry->hash & mask; table->slot[i] != NULL; i = (i + 1) & mask);
+
+        table->slot[i] = entry;
+}
+
+/*
+ * Replace the table with one twice as big. Lookups that already loaded
+ * the old table continue to use it, so it can't be freed here.
+ */
+static void probe_ncache_grow (probe_ncache_t *cache)
+{
+        probe_ncache_table_t *table;
+        size_t i;
+
+        table = probe_ncache_table_new (cache->table->size * 2);
 
-        ref = SEXP_string_new (name, strlen (name));
+        for (i = 0; i < cache->table->size; ++i)
+                if (cache->table->slot[i] != NULL)
+                        probe_ncache_put (table, cache->table->slot[i]);
 
-        if (ref == NULL)
+        table->prev = cache->table;
+
+        probe_ncache_barrier ();
+        cache->table = table;
+}
+
+/*
+ * Find or insert a string. Returns NULL if an entity value should be
+ * inserted but the limit of cached values was reached.
+ */
+static SEXP_t *probe_ncache_intern (probe_ncache_t *cache, const char *str, size_t len, bool value)
+{
+        probe_ncache_entry_t *entry;
+        uint32_t hash;
+
+        hash  = probe_ncache_hash (str, len);
+        entry = probe_ncache_find (probe_ncache_load (cache->table), str, len, hash);
+
+        if (entry != NULL)
+                return SEXP_ref (entry->sexp);
+
+        /*
+         * The number of cached values never decreases. Once the limit is
+         * reached, values that aren't cached are refused without taking
+         * the lock; a stale count is checked again under the lock.
+         */
+        if (value && probe_ncache_load (cache->vcnt) >= PROBE_NCACHE_VALUE_MAXCNT)
                 return (NULL);
 
-        PROBE_NCACHE_WLOCK(cache, NULL);
+        if (pthread_mutex_lock (&cache->lock) != 0)
+                return (NULL);
 
-        if (cache->size <= cache->real) {
-                cache->size += PROBE_NCACHE_ADD_SIZE;
-                cache->name  = oscap_realloc (cache->name, sizeof (SEXP_t *) * cache->size);
-        }
+        entry = probe_ncache_find (cache->table, str, len, hash);
+
+        if (entry == NULL) {
+                if (value && cache->vcnt >= PROBE_NCACHE_VALUE_MAXCNT)
+                        goto unlock;
+
+                if ((cache->real + 1) * 2 > cache->table->size)
+                        probe_ncache_grow (cache);
 
-        assume_d (cache->name != NULL, NULL);
-        assume_d (cache->size > cache->real, NULL);
+                entry = oscap_alloc (sizeof (probe_ncache_entry_t) + len + 1);
+                entry->hash = hash;
+                entry->len  = (uint32_t)len;
+                entry->sexp = SEXP_string_new (str, len);
+                memcpy (entry->str, str, len);
+                entry->str[len] = '\0';
 
-        cache->name[cache->real] = ref;
-        ++cache->real;
+                probe_ncache_barrier ();
+                probe_ncache_put (cache->table, entry);
 
-        ref = SEXP_ref (ref);
-        qsort (cache->name, cache->real, sizeof (SEXP_t *), (int (*)(const void *, const void *)) &probe_ncache_cmp2);
+                ++cache->real;
 
-        PROBE_NCACHE_WUNLOCK(cache);
+                if (value)
+                        ++cache->vcnt;
+        }
+unlock:
+        if (pthread_mutex_unlock (&cache->lock) != 0)
+                abort ();
 
-        return (ref);
+        return (entry != NULL ? SEXP_ref (entry->sexp) : NULL);
 }
 
-SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name)
+SEXP_t *probe_ncache_add (probe_ncache_t *cache, const char *name)
 {
-        SEXP_t **ref = NULL;
-
         assume_d (cache != NULL, NULL);
         assume_d (name  != NULL, NULL);
 
-        PROBE_NCACHE_RLOCK(cache, NULL);
+        return probe_ncache_intern (cache, name, strlen (name), false);
+}
 
-        if (cache->real > 0) {
-                ref = (SEXP_t **)oscap_bfind (cache->name, cache->real, sizeof (SEXP_t *),
-                                              (void *)name, (int (*)(void *, void *))&probe_ncache_cmp1);
+SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name)
+{
+        probe_ncache_entry_t *entry;
+        size_t len;
 
-                if (ref != NULL)
-                        ref = (SEXP_t **)SEXP_ref (*ref);
-        }
+        assume_d (cache != NULL, NULL);
+        assume_d (name  != NULL, NULL);
 
-        PROBE_NCACHE_RUNLOCK(cache);
+        len   = strlen (name);
+        entry = probe_ncache_find (probe_ncache_load (cache->table), name, len,
+                                   probe_ncache_hash (name, len));
 
-        return ((SEXP_t *)(ref));
+        return (entry != NULL ? SEXP_ref (entry->sexp) : NULL);
 }
 
 SEXP_t *probe_ncache_ref (probe_ncache_t *cache, const char *name)
 {
-        SEXP_t *ref;
-
         assume_d (name  != NULL, NULL);
 
         if (cache == NULL)
                 return SEXP_string_new (name, strlen (name));
 
-        ref = probe_ncache_get (cache, name);
+        return probe_ncache_intern (cache, name, strlen (name), false);
+}
+
+SEXP_t *probe_ncache_value (probe_ncache_t *cache, const char *value, size_t len)
+{
+        assume_d (value != NULL, NULL);
+
+        if (cache == NULL || len > PROBE_NCACHE_VALUE_MAXLEN)
+                return (NULL);
+
+        return probe_ncache_intern (cache, value, len, true);
+}
 
-        if (ref == NULL)
-                ref = probe_ncache_add (cache, name);
+SEXP_t *probe_ncache_bool (probe_ncache_t *cache, bool value)
+{
+        if (cache == NULL)
+                return SEXP_number_newb (value);
 
-        return (ref);
+        return SEXP_ref (cache->bool_sexp[value ? 1 : 0]);
 }
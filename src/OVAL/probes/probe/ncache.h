@@ -23,21 +23,42 @@
 #define PROBE_NCACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <pthread.h>
 #include <sexp.h>
 
-#define PROBE_NCACHE_INIT_SIZE 24
-#define PROBE_NCACHE_ADD_SIZE  8
+#define PROBE_NCACHE_INIT_SIZE    64   /* initial number of hash table slots, a power of 2 */
+#define PROBE_NCACHE_VALUE_MAXLEN 32   /* longer entity values are not interned */
+#define PROBE_NCACHE_VALUE_MAXCNT 4096 /* max. number of interned entity values */
+
+typedef struct {
+        uint32_t hash;
+        uint32_t len;
+        SEXP_t  *sexp;  /**< cached string S-exp */
+        char     str[]; /**< copy of the string for comparison */
+} probe_ncache_entry_t;
+
+typedef struct probe_ncache_table {
+        size_t size;                     /**< number of slots, a power of 2 */
+        struct probe_ncache_table *prev; /**< smaller table replaced by this one */
+        probe_ncache_entry_t *slot[];    /**< open addressing, linear probing */
+} probe_ncache_table_t;
 
 /**
- * Element name cache structure. This structure contains an array
- * of cached string S-exps representing the names of elements.
+ * String interning cache. It holds one string S-exp for each element
+ * name and for each short, frequently repeated entity value, so that
+ * equal strings in items share the same value. Lookups don't lock: the
+ * entries are never removed and a table that is replaced by a bigger
+ * one is kept until the cache is freed. Insertions are serialized by
+ * a mutex.
  */
 typedef struct {
-        pthread_rwlock_t lock; /**< pthread read-write lock */
-        SEXP_t **name; /**< array of S-exp refs */
-        size_t   real; /**< number of cached names */
-        size_t   size; /**< pre-allocated size */
+        pthread_mutex_t       lock;  /**< writer lock */
+        probe_ncache_table_t *table; /**< current hash table */
+        size_t   real;               /**< number of cached strings */
+        size_t   vcnt;               /**< number of cached entity values */
+        SEXP_t  *bool_sexp[2];       /**< boolean values */
 } probe_ncache_t;
 
 /**
@@ -60,7 +81,8 @@ void probe_ncache_free (probe_ncache_t *cache);
  * Add a name to the cache. This will create a new S-exp
  * object and return a reference to it. Reference count
  * of such object will be 2 because the cache hold it's
- * own reference to the object.
+ * own reference to the object. If the name is already
+ * cached, a reference to the cached object is returned.
  * @param cache element name cache
  * @param name name string
  * @return S-exp reference to the name string
@@ -87,4 +109,22 @@ SEXP_t *probe_ncache_get (probe_ncache_t *cache, const char *name);
  */
 SEXP_t *probe_ncache_ref (probe_ncache_t *cache, const char *name);
 
+/**
+ * Get a reference to a cached string S-exp for an entity value.
+ * Only values up to PROBE_NCACHE_VALUE_MAXLEN characters are cached
+ * and at most PROBE_NCACHE_VALUE_MAXCNT of them.
+ * @param cache element name cache
+ * @param value value string
+ * @param len length of the value string
+ * @return S-exp reference to the value or NULL if the value isn't cached
+ */
+SEXP_t *probe_ncache_value (probe_ncache_t *cache, const char *value, size_t len);
+
+/**
+ * Get a reference to a boolean S-exp
+ * @param cache element name cache (may be NULL)
+ * @param value the value
+ */
+SEXP_t *probe_ncache_bool (probe_ncache_t *cache, bool value);
+
 #endif /* PROBE_NCACHE_H */
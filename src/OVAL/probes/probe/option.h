@@ -4,6 +4,9 @@
 #define PROBEOPT_VARREF_HANDLING 0
 #define PROBEOPT_RESULT_CACHING  1
 #define PROBEOPT_OFFLINE_MODE_SUPPORTED 2
+#define PROBEOPT_MAX_THREADS 3
+#define PROBEOPT_MEMORY_LIMITS 4
+#define PROBEOPT_COLLECT_THREADS 5
 
 #define PROBE_OPTION_SET 0
 #define PROBE_OPTION_GET 1
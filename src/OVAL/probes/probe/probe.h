@@ -31,11 +31,30 @@
 #include <seap.h>
 #include "ncache.h"
 #include "rcache.h"
+#include "dcache.h"
 #include "icache.h"
+#include "wpool.h"
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
 
+#define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
+#define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
+#define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8    /* max. memory usage ratio - used/total */
+#define PROBE_RESULT_MEMCHECK_INTERVAL   1024   /* items between two memory usage samples */
+#define PROBE_RESULT_MEMCHECK_PERIOD     1000   /* max. time between two memory usage samples (ms) */
+
+/**
+ * Memory constraints of the collected objects
+ */
+typedef struct {
+        double   max_ratio; /**< max. memory usage ratio (process RSS/total memory) */
+        size_t   min_free;  /**< min. free memory (MiB) */
+        size_t   threshold; /**< item count from which the memory usage is checked */
+        size_t   interval;  /**< number of items between two memory usage samples */
+        uint32_t period;    /**< max. time between two memory usage samples (ms) */
+} probe_memlimits_t;
+
 typedef struct {
 	pthread_rwlock_t rwlock;
 	uint32_t         flags;
@@ -52,13 +71,19 @@ typedef struct {
 	pthread_t th_input;
 	pthread_t th_signal;
 
-        rbt_t    *workers;
-        uint32_t  max_threads;
-        uint32_t  max_chdepth;
+        rbt_t         *workers;     /**< requests being handled, indexed by the SEAP message ID */
+        probe_wpool_t *wpool;       /**< worker thread pool */
+        uint32_t       max_threads; /**< maximal number of worker threads */
+        uint32_t       collect_threads; /**< maximal number of threads used to collect a single object */
+
+        probe_memlimits_t memlimits; /**< memory constraints of the collected objects */
+        SEXP_arena_mode_t sexp_arena; /**< allocation mode of the S-exps built by a worker */
 
 	probe_rcache_t *rcache; /**< probe result cache */
+	probe_dcache_t *dcache; /**< persistent cache of collected objects, or NULL */
 	probe_ncache_t *ncache; /**< probe name cache */
         probe_icache_t *icache; /**< probe item cache */
+        struct oval_regex_cache *regex_cache; /**< patterns compiled by the workers */
 
 	probe_option_t *option; /**< probe option handlers */
 	size_t          optcnt; /**< number of defined options */
@@ -69,6 +94,12 @@ struct probe_ctx {
         SEXP_t         *probe_out; /**< collected object */
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
+
+        const probe_memlimits_t *memlimits; /**< memory constraints */
+        size_t          item_cnt;  /**< number of items added to the collected object */
+        size_t          mc_cnt;    /**< item count at the last memory usage sample */
+        uint64_t        mc_time;   /**< time of the last memory usage sample (ms) */
+        int             mc_result; /**< result of the last memory usage sample */
 };
 
 typedef enum {
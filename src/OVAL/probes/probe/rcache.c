@@ -84,12 +84,45 @@ int probe_rcache_cstr_add(probe_rcache_t *cache, const char *id, SEXP_t * item)
 
 int probe_rcache_sexp_del(probe_rcache_t *cache, const SEXP_t * id)
 {
-	return (-1);
+        char b[128], *k = b;
+        int  r;
+
+        if (SEXP_string_cstr_r(id, k, sizeof b) == ((size_t)-1))
+                k = SEXP_string_cstr(id);
+
+        if (k == NULL)
+                return (-1);
+
+        r = probe_rcache_cstr_del(cache, k);
+
+        if (k != b)
+                oscap_free(k);
+
+        return (r);
 }
 
 int probe_rcache_cstr_del(probe_rcache_t *cache, const char *id)
 {
-	return (-1);
+        struct rbt_str_node *n = NULL;
+        SEXP_t *r = NULL;
+        char   *k;
+
+        /*
+         * rbt_str_del() returns only the data pointer of the removed
+         * node; remember the key so that it can be freed too.
+         */
+        if (rbt_str_getnode(cache->tree, id, &n) != 0)
+                return (1);
+
+        k = n->key;
+
+        if (rbt_str_del(cache->tree, id, (void *)&r) != 0)
+                return (-1);
+
+        oscap_free(k);
+        SEXP_free(r);
+
+	return (0);
 }
 
 SEXP_t *probe_rcache_sexp_get(probe_rcache_t *cache, const SEXP_t * id)
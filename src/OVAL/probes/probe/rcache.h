@@ -70,8 +70,8 @@ int probe_rcache_cstr_add(probe_rcache_t *cache, const char *id, SEXP_t *item);
  * Delete an S-exp from the cache identified by an S-exp string.
  * @param cache probe cache
  * @param id S-exp string object containing the id
- * @param item the S-exp (item) to be stored in the cache
  * @retval 0 on success
+ * @retval 1 if there's no such item in the cache
  * @retval -1 on failure
  */
 int probe_rcache_sexp_del(probe_rcache_t *cache, const SEXP_t *id);
@@ -81,8 +81,8 @@ int probe_rcache_sexp_del(probe_rcache_t *cache, const SEXP_t *id);
  * Delete an S-exp from the cache identified by a C string.
  * @param cache probe cache
  * @param id C string containing the id
- * @param item the S-exp (item) to be stored in the cache
  * @retval 0 on success
+ * @retval 1 if there's no such item in the cache
  * @retval -1 on failure
  */
 int probe_rcache_cstr_del(probe_rcache_t *cache, const char *id);
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, 
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software 
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef PROBE_RPMDB_FILES_H
+#define PROBE_RPMDB_FILES_H
+
+/*
+ * Files whose metadata identify the state of the RPM database, relative
+ * to its directory. Any rpm transaction updates at least one of them.
+ * The ndb backend updates its files in place, so the mtime of the
+ * directory doesn't change then.
+ */
+#define PROBE_RPMDB_FILES                                    \
+        "",             /* the database directory itself */ \
+        "Packages",     /* Berkeley DB backend */            \
+        "Packages.db",  /* ndb backend */                    \
+        "Index.db",                                          \
+        "rpmdb.sqlite"  /* sqlite backend */
+
+#define PROBE_RPMDB_FILE_COUNT 5
+
+#endif /* PROBE_RPMDB_FILES_H */
@@ -27,12 +27,14 @@
 #include <seap.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <errno.h>
 
 #include "probe-api.h"
 #include "common/debug_priv.h"
 #include "common/assume.h"
+#include "OVAL/results/oval_regex_cache_impl.h"
 #include "entcmp.h"
 
 #include "worker.h"
@@ -40,15 +42,41 @@
 extern bool  OSCAP_GSYM(varref_handling);
 extern void *OSCAP_GSYM(probe_arg);
 
+/*
+ * End the S-exp allocation scope of a request and log its statistics
+ */
+static void probe_worker_arena_end(SEXP_arena_t *arena, SEAP_msgid_t sid)
+{
+	SEXP_allocstats_t stats;
+
+	if (arena == NULL)
+		return;
+
+	SEXP_arena_end(arena, &stats);
+
+	dI("S-exp allocations of request %u: count=%"PRIu64", freed=%"PRIu64", peak=%zu bytes, chunks=%zu\n",
+	   sid, stats.alloc_cnt, stats.free_cnt, stats.peak_bytes, stats.chunk_cnt);
+}
+
 void *probe_worker_runfn(void *arg)
 {
 	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
 
 	SEXP_t *probe_res, *obj, *oid;
 	int     probe_ret;
+	SEXP_arena_t *arena;
+	SEAP_msgid_t  sid;
 
 	pthread_setname_np(pthread_self(), "probe_worker");
-	dD("handling SEAP message ID %u\n", pair->pth->sid);
+	oval_regex_cache_set(pair->probe->regex_cache);
+	pair->pth->tid = pthread_self();
+	sid = pair->pth->sid;
+	dD("handling SEAP message ID %u\n", sid);
+	/*
+	 * Everything built while handling the request is allocated in its
+	 * own scope. Items that outlive it (in the caches) are fine.
+	 */
+	arena = SEXP_arena_begin(pair->probe->sexp_arena);
 	//
 	probe_ret = -1;
 	probe_res = pair->pth->msg_handler(pair->probe, pair->pth->msg, &probe_ret);
@@ -68,6 +96,8 @@ void *probe_worker_runfn(void *arg)
                 SEXP_free(probe_res);
                 oscap_free(pair);
 
+                probe_worker_arena_end(arena, sid);
+
                 return (NULL);
 	} else {
                 SEXP_t *items;
@@ -130,7 +160,8 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         oscap_free(pair->pth);
 	oscap_free(pair);
-	pthread_detach(pthread_self());
+
+	probe_worker_arena_end(arena, sid);
 
 	return (NULL);
 }
@@ -366,7 +397,17 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	/*
+	 * The object is evaluated by an other worker of this probe; don't
+	 * hold a slot of the pool while waiting for it.
+	 */
+	if (probe_wpool_block_begin(probe->wpool) != 0) {
+		dE("Can't evaluate the nested object: all the worker threads are waiting.\n");
+		return (NULL);
+	}
+
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_wpool_block_end(probe->wpool);
 
 	rid = SEXP_list_first(res);
 	assume_r(SEXP_string_cmp(id, rid) == 0, NULL);
@@ -887,6 +928,57 @@ static SEXP_t *probe_set_eval(probe_t *probe, SEXP_t *set, size_t depth)
 	return result;
 }
 
+/*
+ * Assign a new input and collected object to the probe context and
+ * reset the item counter and the memory usage sampling state.
+ */
+static void probe_ctx_setobj(struct probe_ctx *pctx, SEXP_t *probe_in, SEXP_t *probe_out)
+{
+        pctx->probe_in  = probe_in;
+        pctx->probe_out = probe_out;
+        pctx->item_cnt  = 0;
+        pctx->mc_cnt    = 0;
+        pctx->mc_time   = 0;
+        pctx->mc_result = 0;
+}
+
+/*
+ * Rebuild a collected object loaded from the persistent cache. The stored
+ * items carry the IDs assigned by the process which collected them, so the
+ * IDs are cleared and the items are sent through the item cache again to
+ * get IDs which are unique in this run.
+ */
+static SEXP_t *probe_dcache_reload(probe_t *probe, SEXP_t *cached)
+{
+        SEXP_t *cobj, *msgs, *mask, *items, *item, *name_ref, *prev_id, sid;
+        uint32_t i;
+
+        msgs  = probe_cobj_get_msgs(cached);
+        mask  = probe_cobj_get_mask(cached);
+        items = probe_cobj_get_items(cached);
+        cobj  = probe_cobj_new(probe_cobj_get_flag(cached), msgs, NULL, mask);
+
+        SEXP_string_new_r(&sid, "", 0);
+
+        for (i = 1; (item = SEXP_list_nth(items, i)) != NULL; ++i) {
+                name_ref = SEXP_listref_first(item);
+                prev_id  = SEXP_list_replace(name_ref, 3, &sid);
+                SEXP_vfree(prev_id, name_ref, NULL);
+
+                if (probe_icache_add(probe->icache, cobj, item) != 0) {
+                        dE("Can't add item (%p) to the item cache (%p)\n", item, probe->icache);
+                        SEXP_free(item);
+                }
+        }
+
+        probe_icache_nop(probe->icache);
+
+        SEXP_free_r(&sid);
+        SEXP_vfree(msgs, mask, items, cached, NULL);
+
+        return (cobj);
+}
+
 /**
  * Worker thread function. This functions handles the evalution of objects and sets.
  * @param msg_in SEAP message with the request which contains the object to be evaluated
@@ -923,6 +1015,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 		/* simple object */
                 pctx.icache  = probe->icache;
+                pctx.memlimits = &probe->memlimits;
 		pctx.filters = probe_prepare_filters(probe, probe_in);
                 mask = probe_obj_getmask(probe_in);
 
@@ -932,14 +1025,31 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                         varrefs = NULL;
 
 		if (varrefs == NULL || !OSCAP_GSYM(varref_handling)) {
+			SEXP_t *dentry = NULL;
+
+			/*
+			 * A collected object from a previous run, if the files
+			 * it depends on haven't changed since
+			 */
+			if (probe->dcache != NULL &&
+			    (probe_out = probe_dcache_get(probe->dcache, probe_in, &dentry)) != NULL)
+			{
+				dD("collected object found in the persistent cache\n");
+				SEXP_free(mask);
+				SEXP_free(pctx.filters);
+				SEXP_free(probe_in);
+				*ret = 0;
+
+				return (probe_dcache_reload(probe, probe_out));
+			}
+
                         /*
                          * Prepare the collected object
                          */
 			probe_out = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, mask);
 			SEXP_free(mask);
 			
-                        pctx.probe_in  = probe_in;
-                        pctx.probe_out = probe_out;
+                        probe_ctx_setobj(&pctx, probe_in, probe_out);
 
                         /*
                          * Run the main function of the probe implementation. Set thread
@@ -957,6 +1067,12 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                         probe_icache_nop(probe->icache);
 
 			probe_cobj_compute_flag(probe_out);
+
+			if (dentry != NULL) {
+				if (*ret == 0)
+					probe_dcache_add(probe->dcache, dentry, probe_out);
+				SEXP_free(dentry);
+			}
 		} else {
 			/*
 			 * there are variable references in the object.
@@ -981,8 +1097,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                                  */
 				cobj = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, mask);
 
-                                pctx.probe_in  = ctx->pi2;
-                                pctx.probe_out = cobj;
+                                probe_ctx_setobj(&pctx, ctx->pi2, cobj);
                                 /*
                                  * Run the main function of the probe implementation
                                  */
@@ -28,11 +28,11 @@
 #include "probe.h"
 
 #ifndef PROBE_WORKER_DEFAULT_MAX_THREADS
-# define PROBE_WORKER_DEFAULT_MAX_THREADS 64 /**< maximum number of worker threads that will be created */
+# define PROBE_WORKER_DEFAULT_MAX_THREADS 64 /**< maximum number of workers running a request at the same time */
 #endif
 
-#ifndef PROBE_WORKER_DEFAULT_MAX_CHDEPTH
-# define PROBE_WORKER_DEFAULT_MAX_CHDEPTH 8 /**< maximum depth of a worker thread chain */
+#ifndef PROBE_WORKER_DEFAULT_COLLECT_THREADS
+# define PROBE_WORKER_DEFAULT_COLLECT_THREADS 1 /**< number of threads used to collect a single object */
 #endif
 
 typedef struct {
@@ -0,0 +1,543 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "common/debug_priv.h"
+#include "common/alloc.h"
+#include "common/assume.h"
+
+#include "wpool.h"
+
+static uint64_t probe_wpool_usec(void)
+{
+        struct timeval tv;
+#if defined(HAVE_CLOCK_GETTIME)
+        struct timespec ts;
+
+        if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+                return ((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+#endif
+        gettimeofday(&tv, NULL);
+
+        return ((uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec);
+}
+
+static void probe_wpool_unlock(void *arg)
+{
+        pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+/*
+ * Check whether a worker may take a job from the queue. Must be called
+ * with the pool mutex locked.
+ */
+static bool __probe_wpool_runnable_nolock(probe_wpool_t *pool)
+{
+        return (pool->queue_cnt > 0 && !pool->paused &&
+                pool->run_cnt - pool->block_cnt < pool->thread_max);
+}
+
+static void *probe_wpool_worker(void *arg);
+
+/*
+ * Start a new worker thread. Must be called with the pool mutex locked.
+ */
+static int __probe_wpool_spawn_nolock(probe_wpool_t *pool)
+{
+        if (pool->thread_cnt >= pool->thread_limit) {
+                if (pool->stat_refused++ == 0)
+                        dW("worker pool: reached the limit of %u threads\n", pool->thread_limit);
+                errno = EAGAIN;
+                return (-1);
+        }
+
+        if (pool->thread_cnt == pool->thread_size) {
+                pool->thread_size *= 2;
+                pool->thread = oscap_realloc(pool->thread, sizeof(pthread_t) * pool->thread_size);
+        }
+
+        if ((errno = pthread_create(pool->thread + pool->thread_cnt, NULL,
+                                    &probe_wpool_worker, pool)) != 0)
+        {
+                dE("Can't start a new worker thread: %d, %s.\n", errno, strerror(errno));
+                return (-1);
+        }
+
+        ++pool->thread_cnt;
+        dD("worker pool: started thread #%u\n", pool->thread_cnt);
+
+        return (0);
+}
+
+static void *probe_wpool_worker(void *arg)
+{
+        probe_wpool_t *pool = (probe_wpool_t *)arg;
+        void          *job;
+        uint64_t       t_beg;
+
+        assume_d(pool != NULL, NULL);
+
+        for (;;) {
+                if (pthread_mutex_lock(&pool->mutex) != 0) {
+                        dE("An error ocured while locking the pool mutex: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+
+                /*
+                 * pthread_cond_wait is a cancellation point; make sure
+                 * the mutex isn't left locked if we get canceled there.
+                 */
+                pthread_cleanup_push(&probe_wpool_unlock, &pool->mutex);
+
+                ++pool->idle_cnt;
+
+                while (!__probe_wpool_runnable_nolock(pool)) {
+                        if (pthread_cond_wait(&pool->notempty, &pool->mutex) != 0) {
+                                dE("An error ocured while waiting for the `notempty' pool condition: %u, %s\n",
+                                   errno, strerror(errno));
+                                abort();
+                        }
+                }
+
+                --pool->idle_cnt;
+                ++pool->run_cnt;
+
+                job = pool->queue[pool->queue_beg];
+#ifndef NDEBUG
+                pool->queue[pool->queue_beg] = NULL;
+#endif
+                pool->queue_beg = (pool->queue_beg + 1) % pool->queue_max;
+                --pool->queue_cnt;
+
+                pthread_cleanup_pop(1);
+
+                t_beg = probe_wpool_usec();
+                pool->runfn(job);
+
+                if (pthread_mutex_lock(&pool->mutex) != 0) {
+                        dE("An error ocured while locking the pool mutex: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+
+                pool->stat_busy += probe_wpool_usec() - t_beg;
+                ++pool->stat_jobs;
+                --pool->run_cnt;
+
+                if (pool->queue_cnt > 0 && pthread_cond_signal(&pool->notempty) != 0) {
+                        dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+
+                if (pool->run_cnt == 0 && pthread_cond_broadcast(&pool->idle) != 0) {
+                        dE("An error ocured while signaling the `idle' condition: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+
+                if (pthread_mutex_unlock(&pool->mutex) != 0) {
+                        dE("An error ocured while unlocking the pool mutex: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+        }
+
+        return (NULL);
+}
+
+probe_wpool_t *probe_wpool_new(uint32_t thread_max, void *(*runfn)(void *), void (*argfree)(void *))
+{
+        probe_wpool_t *pool;
+
+        if (runfn == NULL)
+                return (NULL);
+
+        pool = oscap_talloc(probe_wpool_t);
+
+        if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+                dE("Can't initialize pool mutex: %u, %s\n", errno, strerror(errno));
+                oscap_free(pool);
+                return (NULL);
+        }
+
+        if (pthread_cond_init(&pool->notempty, NULL) != 0) {
+                dE("Can't initialize pool condition variable (notempty): %u, %s\n",
+                   errno, strerror(errno));
+                pthread_mutex_destroy(&pool->mutex);
+                oscap_free(pool);
+                return (NULL);
+        }
+
+        if (pthread_cond_init(&pool->idle, NULL) != 0) {
+                dE("Can't initialize pool condition variable (idle): %u, %s\n",
+                   errno, strerror(errno));
+                pthread_cond_destroy(&pool->notempty);
+                pthread_mutex_destroy(&pool->mutex);
+                oscap_free(pool);
+                return (NULL);
+        }
+
+        pool->thread_max  = thread_max > 0 ? thread_max : 1;
+        pool->thread_limit = pool->thread_max + PROBE_WPOOL_BLOCKED_MAX;
+        pool->thread_size = pool->thread_max;
+        pool->thread      = oscap_alloc(sizeof(pthread_t) * pool->thread_size);
+        pool->thread_cnt  = 0;
+        pool->idle_cnt    = 0;
+        pool->run_cnt     = 0;
+        pool->block_cnt   = 0;
+
+        pool->runfn   = runfn;
+        pool->argfree = argfree;
+
+        pool->queue_max = PROBE_WPOOL_QUEUE_INITSIZE;
+        pool->queue     = oscap_alloc(sizeof(void *) * pool->queue_max);
+        pool->queue_beg = 0;
+        pool->queue_cnt = 0;
+
+        pool->stat_qpeak   = 0;
+        pool->stat_qsum    = 0;
+        pool->stat_submits = 0;
+        pool->stat_jobs    = 0;
+        pool->stat_refused = 0;
+        pool->stat_busy    = 0;
+        pool->stat_tstart  = probe_wpool_usec();
+        pool->stat_tstop   = 0;
+        pool->canceled     = false;
+        pool->paused       = false;
+
+        return (pool);
+}
+
+/*
+ * Double the queue capacity while preserving the order of the pending jobs.
+ * Must be called with the pool mutex locked.
+ */
+static void __probe_wpool_grow_nolock(probe_wpool_t *pool)
+{
+        void   **queue;
+        uint32_t i;
+
+        queue = oscap_alloc(sizeof(void *) * pool->queue_max * 2);
+
+        for (i = 0; i < pool->queue_cnt; ++i)
+                queue[i] = pool->queue[(pool->queue_beg + i) % pool->queue_max];
+
+        oscap_free(pool->queue);
+
+        pool->queue      = queue;
+        pool->queue_beg  = 0;
+        pool->queue_max *= 2;
+}
+
+int probe_wpool_submit(probe_wpool_t *pool, void *arg)
+{
+        int ret = 0;
+
+        if (pool == NULL)
+                return (-1);
+
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                return (-1);
+        }
+
+        if (pool->canceled) {
+                ret = -1;
+                goto unlock;
+        }
+
+        /*
+         * Start a new worker thread if all of the existing ones are busy.
+         * Threads blocked waiting for the library to evaluate a nested
+         * object (set objects), which will be sent to us as a new job,
+         * don't count.
+         */
+        if (pool->idle_cnt <= pool->queue_cnt &&
+            pool->thread_cnt - pool->block_cnt < pool->thread_max)
+        {
+                if (__probe_wpool_spawn_nolock(pool) != 0 && pool->thread_cnt == pool->block_cnt) {
+                        /* There's no one to handle the job */
+                        ret = -1;
+                        goto unlock;
+                }
+        }
+
+        if (pool->queue_cnt == pool->queue_max)
+                __probe_wpool_grow_nolock(pool);
+
+        pool->queue[(pool->queue_beg + pool->queue_cnt) % pool->queue_max] = arg;
+        ++pool->queue_cnt;
+
+        pool->stat_qsum += pool->queue_cnt;
+        ++pool->stat_submits;
+
+        if (pool->queue_cnt > pool->stat_qpeak)
+                pool->stat_qpeak = pool->queue_cnt;
+
+        if (pthread_cond_signal(&pool->notempty) != 0) {
+                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+unlock:
+        if (pthread_mutex_unlock(&pool->mutex) != 0) {
+                dE("An error ocured while unlocking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        return (ret);
+}
+
+int probe_wpool_block_begin(probe_wpool_t *pool)
+{
+        int ret = 0;
+
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        ++pool->block_cnt;
+
+        /*
+         * The worker's slot is free now; hand it over to a pending job,
+         * starting a new thread if there's no idle one.
+         */
+        if (!pool->canceled && __probe_wpool_runnable_nolock(pool)) {
+                if (pool->idle_cnt > 0) {
+                        if (pthread_cond_signal(&pool->notempty) != 0) {
+                                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
+                                   errno, strerror(errno));
+                                abort();
+                        }
+                } else
+                        __probe_wpool_spawn_nolock(pool);
+        }
+
+        /*
+         * At the thread limit, the last thread which isn't blocked must not
+         * block. The queued jobs, including the one it waits for, would
+         * never run.
+         */
+        if (pool->block_cnt == pool->thread_cnt && pool->thread_cnt >= pool->thread_limit) {
+                --pool->block_cnt;
+                ret = -1;
+        }
+
+        if (pthread_mutex_unlock(&pool->mutex) != 0) {
+                dE("An error ocured while unlocking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        return (ret);
+}
+
+void probe_wpool_block_end(probe_wpool_t *pool)
+{
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        --pool->block_cnt;
+
+        if (pthread_mutex_unlock(&pool->mutex) != 0) {
+                dE("An error ocured while unlocking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+}
+
+void probe_wpool_quiesce(probe_wpool_t *pool)
+{
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        pool->paused = true;
+
+        while (pool->run_cnt > 0) {
+                if (pthread_cond_wait(&pool->idle, &pool->mutex) != 0) {
+                        dE("An error ocured while waiting for the `idle' pool condition: %u, %s\n",
+                           errno, strerror(errno));
+                        abort();
+                }
+        }
+
+        if (pthread_mutex_unlock(&pool->mutex) != 0) {
+                dE("An error ocured while unlocking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+}
+
+void probe_wpool_resume(probe_wpool_t *pool)
+{
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        pool->paused = false;
+
+        if (pool->queue_cnt > 0 && pthread_cond_broadcast(&pool->notempty) != 0) {
+                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
+                   errno, strerror(errno));
+                abort();
+        }
+
+        pthread_mutex_unlock(&pool->mutex);
+}
+
+void probe_wpool_cancel(probe_wpool_t *pool)
+{
+        pthread_t *thread;
+        uint32_t   thread_cnt, i;
+
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                return;
+        }
+
+        if (pool->canceled) {
+                pthread_mutex_unlock(&pool->mutex);
+                return;
+        }
+
+        thread     = pool->thread;
+        thread_cnt = pool->thread_cnt;
+
+        /* Prevent new threads from being started */
+        pool->canceled   = true;
+        pool->stat_tstop = probe_wpool_usec();
+
+        for (i = 0; i < thread_cnt; ++i)
+                pthread_cancel(thread[i]);
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        /*
+         * Wait till all threads are canceled (they may temporarily disable
+         * cancelability), but at most 60 seconds per thread.
+         */
+        for (i = 0; i < thread_cnt; ++i) {
+#if defined(HAVE_PTHREAD_TIMEDJOIN_NP) && defined(HAVE_CLOCK_GETTIME)
+                struct timespec j_tm;
+
+                if (clock_gettime(CLOCK_REALTIME, &j_tm) == -1) {
+                        dE("clock_gettime(CLOCK_REALTIME): %d, %s.\n", errno, strerror(errno));
+                        continue;
+                }
+
+                j_tm.tv_sec += 60;
+
+                if ((errno = pthread_timedjoin_np(thread[i], NULL, &j_tm)) != 0) {
+                        dE("pthread_timedjoin_np: %d, %s.\n", errno, strerror(errno));
+                        continue;
+                }
+#else
+                if ((errno = pthread_join(thread[i], NULL)) != 0) {
+                        dE("pthread_join: %d, %s.\n", errno, strerror(errno));
+                        continue;
+                }
+#endif
+        }
+
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                return;
+        }
+
+        while (pool->queue_cnt > 0) {
+                if (pool->argfree != NULL)
+                        pool->argfree(pool->queue[pool->queue_beg]);
+
+                pool->queue_beg = (pool->queue_beg + 1) % pool->queue_max;
+                --pool->queue_cnt;
+        }
+
+        pthread_mutex_unlock(&pool->mutex);
+}
+
+void probe_wpool_stats(probe_wpool_t *pool, struct probe_wpool_stats *stats)
+{
+        uint64_t t_life;
+
+        if (pthread_mutex_lock(&pool->mutex) != 0) {
+                dE("An error ocured while locking the pool mutex: %u, %s\n",
+                   errno, strerror(errno));
+                memset(stats, 0, sizeof(struct probe_wpool_stats));
+                return;
+        }
+
+        t_life = (pool->canceled ? pool->stat_tstop : probe_wpool_usec()) - pool->stat_tstart;
+
+        stats->threads     = pool->thread_cnt;
+        stats->threads_max = pool->thread_max;
+        stats->threads_limit = pool->thread_limit;
+        stats->blocked     = pool->block_cnt;
+        stats->refused     = pool->stat_refused;
+        stats->queue_cnt   = pool->queue_cnt;
+        stats->queue_peak  = pool->stat_qpeak;
+        stats->queue_avg   = pool->stat_submits > 0 ? (double)pool->stat_qsum / (double)pool->stat_submits : 0.0;
+        stats->jobs        = pool->stat_jobs;
+        stats->utilisation = (pool->thread_cnt > 0 && t_life > 0) ?
+                (double)pool->stat_busy / ((double)t_life * pool->thread_cnt) : 0.0;
+
+        pthread_mutex_unlock(&pool->mutex);
+}
+
+void probe_wpool_free(probe_wpool_t *pool)
+{
+        if (pool == NULL)
+                return;
+
+        probe_wpool_cancel(pool);
+
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_cond_destroy(&pool->notempty);
+        pthread_cond_destroy(&pool->idle);
+
+        oscap_free(pool->thread);
+        oscap_free(pool->queue);
+        oscap_free(pool);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef WPOOL_H
+#define WPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef PROBE_WPOOL_QUEUE_INITSIZE
+#define PROBE_WPOOL_QUEUE_INITSIZE 32
+#endif
+
+#ifndef PROBE_WPOOL_BLOCKED_MAX
+#define PROBE_WPOOL_BLOCKED_MAX 32 /**< number of threads started on top of `thread_max' for blocked workers */
+#endif
+
+/**
+ * Worker pool statistics.
+ */
+struct probe_wpool_stats {
+        uint32_t threads;     /**< number of started worker threads */
+        uint32_t threads_max; /**< upper bound on the number of workers running a job */
+        uint32_t threads_limit; /**< upper bound on the number of started threads */
+        uint32_t blocked;     /**< number of workers blocked on a nested job */
+        uint64_t refused;     /**< number of threads not started because of `threads_limit' */
+        uint32_t queue_cnt;   /**< current queue depth */
+        uint32_t queue_peak;  /**< maximal observed queue depth */
+        double   queue_avg;   /**< average queue depth observed by submitted jobs */
+        uint64_t jobs;        /**< number of finished jobs */
+        double   utilisation; /**< busy time / (threads * lifetime), 0.0 - 1.0 */
+};
+
+/**
+ * Worker pool.
+ * A bounded set of worker threads serving jobs from a shared FIFO queue.
+ * There's a single producer (the input handler), so the pool doesn't use
+ * per-worker work-stealing deques. Threads are started on demand, i.e.
+ * only when a job is submitted and there's no idle thread available, and
+ * are kept alive and reused for later jobs.
+ *
+ * At most `thread_max' workers run jobs at the same time. A worker that
+ * waits for a job submitted to the same pool (see probe_wpool_block_begin)
+ * doesn't count, so an additional thread may be started for the time the
+ * worker is blocked. The total number of threads is capped by
+ * `thread_limit' (thread_max + PROBE_WPOOL_BLOCKED_MAX). At the cap, a
+ * worker may block only if another thread is left to run the queued jobs.
+ */
+typedef struct {
+        pthread_mutex_t mutex;
+        pthread_cond_t  notempty;
+        pthread_cond_t  idle;   /**< signaled when the last running worker finishes its job */
+
+        pthread_t *thread;      /**< started worker threads */
+        uint32_t   thread_cnt;  /**< number of started worker threads */
+        uint32_t   thread_size; /**< allocated size of the thread array */
+        uint32_t   thread_max;  /**< maximal number of workers running a job */
+        uint32_t   thread_limit; /**< maximal number of started threads */
+        uint32_t   idle_cnt;    /**< number of threads waiting for a job */
+        uint32_t   run_cnt;     /**< number of threads running a job */
+        uint32_t   block_cnt;   /**< number of running threads blocked on a nested job */
+        bool       canceled;   /**< the threads were canceled, no new jobs are accepted */
+        bool       paused;     /**< queued jobs aren't started (see probe_wpool_quiesce) */
+
+        void    *(*runfn)(void *); /**< job handler */
+        void     (*argfree)(void *); /**< destructor for jobs that never ran */
+
+        void   **queue;     /**< circular queue of pending jobs */
+        uint32_t queue_beg;
+        uint32_t queue_cnt;
+        uint32_t queue_max; /**< current capacity; the queue grows on demand */
+
+        uint32_t stat_qpeak;   /**< maximal queue depth */
+        uint64_t stat_qsum;    /**< sum of queue depths seen by submitted jobs */
+        uint64_t stat_submits; /**< number of submitted jobs */
+        uint64_t stat_jobs;    /**< number of finished jobs */
+        uint64_t stat_refused; /**< number of threads not started because of `thread_limit' */
+        uint64_t stat_busy;    /**< time spent in job handlers (usec) */
+        uint64_t stat_tstart;  /**< pool creation time (usec) */
+        uint64_t stat_tstop;   /**< pool cancelation time (usec) */
+} probe_wpool_t;
+
+/**
+ * Create a new worker pool.
+ * @param thread_max maximal number of worker threads (0 is treated as 1)
+ * @param runfn job handler; called with the argument passed to probe_wpool_submit
+ * @param argfree function used to free jobs which were not handled (may be NULL)
+ * @return worker pool pointer or NULL on failure
+ */
+probe_wpool_t *probe_wpool_new(uint32_t thread_max, void *(*runfn)(void *), void (*argfree)(void *));
+
+/**
+ * Submit a job to the pool. This function never blocks on a full queue.
+ * @param pool worker pool
+ * @param arg job argument
+ * @retval 0 on success
+ * @retval -1 on failure (no thread could be started to handle the job)
+ */
+int probe_wpool_submit(probe_wpool_t *pool, void *arg);
+
+/**
+ * Called by a worker before it blocks waiting for the result of a job
+ * it caused to be submitted to the same pool (nested object evaluation).
+ * The worker doesn't count against `thread_max' until the matching call
+ * of probe_wpool_block_end; a new thread is started if the pending jobs
+ * would otherwise wait for it.
+ * @param pool worker pool
+ * @retval 0 on success
+ * @retval -1 if the worker must not block because no other thread would be
+ *            left to run the jobs and no thread can be started
+ */
+int probe_wpool_block_begin(probe_wpool_t *pool);
+
+/**
+ * Called by a worker after a successful probe_wpool_block_begin, when the
+ * wait is over.
+ * @param pool worker pool
+ */
+void probe_wpool_block_end(probe_wpool_t *pool);
+
+/**
+ * Stop starting queued jobs and wait until no worker runs a job, including
+ * workers blocked on a nested job. Jobs submitted in the meantime are
+ * queued and started after probe_wpool_resume. Must not be called by a
+ * worker of the pool.
+ * @param pool worker pool
+ */
+void probe_wpool_quiesce(probe_wpool_t *pool);
+
+/**
+ * Start the queued jobs again after probe_wpool_quiesce.
+ * @param pool worker pool
+ */
+void probe_wpool_resume(probe_wpool_t *pool);
+
+/**
+ * Cancel and join all the worker threads. Jobs that are still waiting
+ * in the queue are freed using the `argfree' callback. The pool doesn't
+ * accept new jobs after this call but the statistics remain available.
+ * @param pool worker pool
+ */
+void probe_wpool_cancel(probe_wpool_t *pool);
+
+/**
+ * Get a snapshot of the pool statistics.
+ * @param pool worker pool
+ * @param stats statistics output buffer
+ */
+void probe_wpool_stats(probe_wpool_t *pool, struct probe_wpool_stats *stats);
+
+/**
+ * Free the worker pool. The worker threads are canceled if needed.
+ * @param pool worker pool
+ */
+void probe_wpool_free(probe_wpool_t *pool);
+
+#endif /* WPOOL_H */
@@ -467,9 +467,12 @@ void probe_tfc54behaviors_canonicalize(SEXP_t **behaviors);
 #define PROBECMD_STE_FETCH 1 /**< State fetch command code */
 #define PROBECMD_OBJ_EVAL  2 /**< Object eval command code */
 #define PROBECMD_RESET     3 /**< Reset command code */
+#define PROBECMD_CACHE_STATS 4 /**< Persistent cache statistics command code */
+#define PROBECMD_POOL_STATS  5 /**< Worker pool statistics command code */
 
 void *probe_init(void) __attribute__ ((unused));
 void probe_fini(void *) __attribute__ ((unused));
+void probe_flush(void *) __attribute__ ((unused)); /**< drop the state cached in the probe argument on reset */
 
 typedef struct probe_ctx probe_ctx;
 
@@ -53,6 +53,8 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <regex.h>
+#include <sys/socket.h>
+#include <linux/packet_diag.h>
 
 #include "seap.h"
 #include "probe-api.h"
@@ -60,6 +62,8 @@
 #include "alloc.h"
 #include "util.h"
 #include "common/debug_priv.h"
+#include "../procsnap.h"
+#include "sockdiag.h"
 
 #include "iflisteners-proto.h"
 
@@ -72,246 +76,25 @@ struct result_info {
 	const char *hw_address;
 };
 
-/* This structure is used to store information from scanning all runnning
- * processes. It will be used later to augment server info */
-typedef struct _lnode {
-  pid_t pid;            // process ID
-  uid_t uid;            // effective user ID
-  char *cmd;            // command run by user
-  unsigned long inode;  // inode of socket
-  struct _lnode* next;  // Next node pointer
-} lnode;
-
-/* This is the linked list head. Only data elements go here. */
-typedef struct {
-  lnode *head;          // List head
-  lnode *cur;           // Pointer to current node
-} llist;
-
 struct interface_t {
   char interface_name[255];
   char hw_address[255];
 };
 
-/* Local data */
-static int perm_warn = 0;
-
-/* Function prototypes */
-static inline lnode *list_get_cur(llist *l) { return l->cur; }
-static void list_create(llist *l);
-static void list_append(llist *l, lnode *node);
-static void list_clear(llist* l);
-static lnode *list_find_inode(llist *l, unsigned long i);
-
-
-static void list_create(llist *l)
-{
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static void list_append(llist *l, lnode *node)
-{
-	lnode* newnode;
-
-	if (node == NULL || l == NULL)
-		return;
-
-	newnode = malloc(sizeof(lnode));
-	if (newnode == NULL)
-		return;
-
-	newnode->pid = node->pid;
-	newnode->uid = node->uid;
-	newnode->inode = node->inode;
-	// Take custody of the memory
-	newnode->cmd = node->cmd;
-	newnode->next = NULL;
-
-	// if we are at top, fix this up
-	if (l->head == NULL)
-		l->head = newnode;
-	else	// Otherwise add pointer to newnode
-		l->cur->next = newnode;
-
-	// make newnode current
-	l->cur = newnode;
-}
-
-static void list_clear(llist* l)
-{
-	lnode* nextnode;
-	register lnode* cur;
-
-	cur = l->head;
-	while (cur) {
-		nextnode=cur->next;
-		free(cur->cmd);
-		free(cur);
-		cur=nextnode;
-	}
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static lnode *list_find_inode(llist *l, unsigned long i)
-{
-        register lnode* cur;
-
-	cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur->inode == i) {
-			l->cur = cur;
-			return cur;
-		} else
-			cur = cur->next;
-	}
-	return NULL;
-}
-
-static int collect_process_info(llist *l)
-{
-	DIR *d, *f;
-	struct dirent *ent;
-
-	d = opendir("/proc");
-	if (d == NULL)
-		return 1;
-
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
-		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
-
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
-
-		// Skip kthreads
-		if (pid == 2 || ppid == 2)
-			continue;
-
-		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
-
-		// Now lets get the inodes each process has open
-		snprintf(buf, 32, "/proc/%d/fd", pid);
-		f = opendir(buf);
-		if (f == NULL) {
-			if (errno == EACCES && perm_warn == 0) {
-				/* Need DAC_OVERRIDE permission */
-				perm_warn = 1;
-			}
-			// Process might have ended or something - ignore it
-			free(text);
-			continue;
-		}
-		// For each file in the fd dir...
-		while (( ent = readdir(f) )) {
-			char line[256], ln[256], *s, *e;
-			unsigned long inode;
-			lnode node;
-			int lnlen;
-
-			if (ent->d_name[0] == '.')
-				continue;
-			snprintf(ln, 256, "%s/%s", buf, ent->d_name);
-			if ((lnlen = readlink(ln, line, sizeof(line)-1)) < 0)
-				continue;
-			line[lnlen] = 0;
-
-			// Only look at the socket entries
-			if (memcmp(line, "socket:", 7) == 0) {
-				// Type 1 sockets
-				s = strchr(line+7, '[');
-				if (s == NULL)
-					continue;
-				s++;
-				e = strchr(s, ']');
-				if (e == NULL)
-					continue;
-				*e = 0;
-			} else if (memcmp(line, "[0000]:", 7) == 0) {
-				// Type 2 sockets
-				s = line + 8;
-			} else
-				continue;
-			errno = 0;
-			inode = strtoul(s, NULL, 10);
-			if (errno)
-				continue;
-			node.pid = pid;
-			node.uid = euid;
-			node.cmd = strdup(cmd);
-			node.inode = inode;
-			// We make one entry for each socket inode
-			list_append(l, &node);
-		}
-		closedir(f);
-		free(text);
-	}
-	closedir(d);
-	return 0;
-}
-
-static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx, oval_schema_version_t over)
+static void report_finding(struct result_info *res, procsnap_proc_t *n, probe_ctx *ctx, oval_schema_version_t over)
 {
         SEXP_t *item, *user_id;
-	lnode *n = list_get_cur(l);
 
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
-		user_id = SEXP_string_newf("%d", n->uid);
+		user_id = SEXP_string_newf("%d", n->euid);
 	else
-		user_id = SEXP_number_newi_64((int64_t)n->uid);
+		user_id = SEXP_number_newi_64((int64_t)n->euid);
 
 	item = probe_item_create(OVAL_LINUX_IFLISTENERS, NULL,
                                  "interface_name",       OVAL_DATATYPE_STRING,  res->interface_name,
                                  "protocol",             OVAL_DATATYPE_STRING,  res->protocol,
                                  "hw_address",           OVAL_DATATYPE_STRING,  res->hw_address,
-                                 "program_name",         OVAL_DATATYPE_STRING,  n->cmd,
+                                 "program_name",         OVAL_DATATYPE_STRING,  n->comm,
                                  "pid",                  OVAL_DATATYPE_INTEGER, (int64_t)n->pid,
 				 "user_id",              OVAL_DATATYPE_SEXP, user_id,
                                  NULL);
@@ -370,7 +153,34 @@ static int get_interface(const int ent_ifindex, struct interface_t *interface) {
 	return 0;
 }
 
-static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over)
+static void report_socket(int ifindex, unsigned proto_num, unsigned long inode,
+	procsnap_t *snap, probe_ctx *ctx, oval_schema_version_t over)
+{
+	struct interface_t interface;
+	procsnap_proc_t *n;
+
+	n = procsnap_find_socket(snap, inode);
+	if (n != NULL && get_interface(ifindex, &interface)) {
+		struct result_info r;
+		SEXP_t *r0;
+		dI("Have interface_name: %s, hw_address: %s\n",
+				interface.interface_name, interface.hw_address);
+
+		r0 = SEXP_string_newf("%s", interface.interface_name);
+		if (probe_entobj_cmp(interface_name_ent, r0) != OVAL_RESULT_TRUE) {
+			SEXP_free(r0);
+			return;
+		}
+		SEXP_free(r0);
+
+		r.interface_name = interface.interface_name;
+		r.protocol = oscap_enum_to_string(ProtocolType, proto_num);
+		r.hw_address = interface.hw_address;
+		report_finding(&r, n, ctx, over);
+	}
+}
+
+static int read_packet(procsnap_t *snap, probe_ctx *ctx, oval_schema_version_t over)
 {
 	int line = 0;
 	FILE *f;
@@ -380,7 +190,6 @@ static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over)
 	int refcnt, sk_type, ifindex, running;
 	unsigned long inode;
 	unsigned rmem, uid, proto_num;
-	struct interface_t interface;
 
 
 	f = fopen("/proc/net/packet", "rt");
@@ -401,34 +210,105 @@ static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over)
 			"%p %d %d %04x %d %d %u %u %lu\n",
 			&s, &refcnt, &sk_type, &proto_num, &ifindex, &running, &rmem, &uid, &inode
 		);
-		if (list_find_inode(l, inode) && get_interface(ifindex, &interface)) {
-			struct result_info r;
-			SEXP_t *r0;
-			dI("Have interface_name: %s, hw_address: %s\n",
-					interface.interface_name, interface.hw_address);
-
-			r0 = SEXP_string_newf("%s", interface.interface_name);
-			if (probe_entobj_cmp(interface_name_ent, r0) != OVAL_RESULT_TRUE) {
-				SEXP_free(r0);
-				continue;
-			}
-			SEXP_free(r0);
-
-			r.interface_name = interface.interface_name;
-			r.protocol = oscap_enum_to_string(ProtocolType, proto_num);
-			r.hw_address = interface.hw_address;
-			report_finding(&r, l, ctx, over);
-		}
+		report_socket(ifindex, proto_num, inode, snap, ctx, over);
 	}
 	fclose(f);
 	return 0;
 }
 
+/* A packet socket from a sock_diag dump */
+struct diag_socket {
+	int ifindex;
+	unsigned proto_num;
+	unsigned long inode;
+};
+
+struct diag_state {
+	struct diag_socket *socks;
+	size_t count;
+	size_t size;
+};
+
+static int read_diag_cb(const struct nlmsghdr *nlh, void *arg)
+{
+	struct diag_state *st = arg;
+	const struct packet_diag_msg *m = NLMSG_DATA(nlh);
+	const struct packet_diag_info *info;
+	struct diag_socket *ds;
+	size_t len;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct packet_diag_msg)))
+		return 0;
+
+	info = sockdiag_attr(nlh, sizeof(struct packet_diag_msg), PACKET_DIAG_INFO, &len);
+	if (info == NULL || len < sizeof(struct packet_diag_info)) {
+		errno = EPROTO;
+		return 1;
+	}
+
+	if (st->count == st->size) {
+		st->size  = st->size > 0 ? st->size * 2 : 16;
+		st->socks = oscap_realloc(st->socks, sizeof(struct diag_socket) * st->size);
+	}
+
+	ds = st->socks + st->count++;
+	ds->ifindex   = info->pdi_index;
+	ds->proto_num = m->pdiag_num; /* already in host byte order */
+	ds->inode     = m->pdiag_ino;
+
+	return 0;
+}
+
+/*
+ * List the packet sockets using NETLINK_SOCK_DIAG. Returns -1 if the
+ * kernel doesn't support packet_diag; the caller reads /proc/net/packet
+ * instead.
+ */
+static int read_diag(procsnap_t *snap, probe_ctx *ctx, oval_schema_version_t over)
+{
+	struct packet_diag_req dreq;
+	struct diag_state st;
+	size_t i;
+	int ret;
+
+	memset(&dreq, 0, sizeof dreq);
+	dreq.sdiag_family = AF_PACKET;
+	dreq.pdiag_show   = PACKET_SHOW_INFO;
+
+	memset(&st, 0, sizeof st);
+
+	ret = sockdiag_dump(&dreq, sizeof dreq, read_diag_cb, &st);
+
+	if (ret == 0) {
+		for (i = 0; i < st.count; ++i)
+			report_socket(st.socks[i].ifindex, st.socks[i].proto_num, st.socks[i].inode, snap, ctx, over);
+	}
+
+	oscap_free(st.socks);
+
+	return ret;
+}
+
+void *probe_init(void)
+{
+	return procsnap_new();
+}
+
+void probe_fini(void *arg)
+{
+	procsnap_free(arg);
+}
+
+void probe_flush(void *arg)
+{
+	procsnap_reset(arg);
+}
+
 int probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
 	int err;
-	llist ll;
+	procsnap_t *snap = arg;
 	oval_schema_version_t over;
 
         object = probe_ctx_getobject(ctx);
@@ -441,8 +321,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now start collecting the info
-	list_create(&ll);
-	if (collect_process_info(&ll) || perm_warn) {
+	if (procsnap_load(snap) || procsnap_sockets_denied(snap) > 0) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Permission error.");
@@ -454,9 +333,8 @@ int probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
-	read_packet(&ll, ctx, over);
-
-	list_clear(&ll);
+	if (read_diag(snap, ctx, over) != 0)
+		read_packet(snap, ctx, over);
 
 	err = 0;
  cleanup:
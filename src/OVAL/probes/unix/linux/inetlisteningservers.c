@@ -59,12 +59,16 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <regex.h>
+#include <netinet/in.h>
+#include <linux/inet_diag.h>
 
 #include "seap.h"
 #include "probe-api.h"
 #include "probe/entcmp.h"
 #include "alloc.h"
 #include "common/debug_priv.h"
+#include "../procsnap.h"
+#include "sockdiag.h"
 
 /* This structure contains the information OVAL is asking or requesting */
 struct server_info {
@@ -82,222 +86,9 @@ struct result_info {
 	unsigned rport;
 };
 
-/* This structure is used to store information from scanning all runnning
- * processes. It will be used later to augment server info */
-typedef struct _lnode {
-  pid_t pid;            // process ID
-  uid_t uid;            // effective user ID
-  char *cmd;            // command run by user
-  unsigned long inode;  // inode of socket
-  struct _lnode* next;  // Next node pointer
-} lnode;
-
-/* This is the linked list head. Only data elements go here. */
-typedef struct {
-  lnode *head;          // List head
-  lnode *cur;           // Pointer to current node
-} llist;
-
 /* Local data */
 static struct server_info req;
 
-/* Function prototypes */
-static inline lnode *list_get_cur(llist *l) { return l->cur; }
-static void list_create(llist *l);
-static void list_append(llist *l, lnode *node);
-static void list_clear(llist* l);
-static lnode *list_find_inode(llist *l, unsigned long i);
-
-
-static void list_create(llist *l)
-{
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static void list_append(llist *l, lnode *node)
-{
-	lnode* newnode;
-
-	if (node == NULL || l == NULL)
-		return;
-
-	newnode = malloc(sizeof(lnode));
-	if (newnode == NULL)
-		return;
-
-	newnode->pid = node->pid;
-	newnode->uid = node->uid;
-	newnode->inode = node->inode;
-	// Take custody of the memory
-	newnode->cmd = node->cmd;
-	newnode->next = NULL;
-
-	// if we are at top, fix this up
-	if (l->head == NULL)
-		l->head = newnode;
-	else	// Otherwise add pointer to newnode
-		l->cur->next = newnode;
-
-	// make newnode current
-	l->cur = newnode;
-}
-
-static void list_clear(llist* l)
-{
-	lnode* nextnode;
-	register lnode* cur;
-
-	cur = l->head;
-	while (cur) {
-		nextnode=cur->next;
-		free(cur->cmd);
-		free(cur);
-		cur=nextnode;
-	}
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static lnode *list_find_inode(llist *l, unsigned long i)
-{
-        register lnode* cur;
-
-       	cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur->inode == i) {
-			l->cur = cur;
-			return cur;
-		} else
-			cur = cur->next;
-	}
-	return NULL;
-}
-
-static int collect_process_info(llist *l)
-{
-	DIR *d, *f;
-	struct dirent *ent;
-
-	d = opendir("/proc");
-	if (d == NULL)
-		return 1;
-
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
-		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
-
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
-
-		// Skip kthreads
-		if (pid == 2 || ppid == 2)
-			continue;
-
-		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
-
-		// Now lets get the inodes each process has open
-		snprintf(buf, 32, "/proc/%d/fd", pid);
-		f = opendir(buf);
-		if (f == NULL) {
-			// Process might have ended or we don;t have access - ignore it
-			free(text);
-			continue;
-		}
-		// For each file in the fd dir...
-		while (( ent = readdir(f) )) {
-			char line[256], ln[256], *s, *e;
-			unsigned long inode;
-			lnode node;
-			int lnlen;
-
-			if (ent->d_name[0] == '.')
-				continue;
-			snprintf(ln, 256, "%s/%s", buf, ent->d_name);
-			if ((lnlen = readlink(ln, line, sizeof(line)-1)) < 0)
-				continue;
-			line[lnlen] = 0;
-
-			// Only look at the socket entries
-			if (memcmp(line, "socket:", 7) == 0) {
-				// Type 1 sockets
-				s = strchr(line+7, '[');
-				if (s == NULL)
-					continue;
-				s++;
-				e = strchr(s, ']');
-				if (e == NULL)
-					continue;
-				*e = 0;
-			} else if (memcmp(line, "[0000]:", 7) == 0) {
-				// Type 2 sockets
-				s = line + 8;
-			} else
-				continue;
-			errno = 0;
-			inode = strtoul(s, NULL, 10);
-			if (errno)
-				continue;
-			node.pid = pid;
-			node.uid = euid;
-			node.cmd = strdup(cmd);
-			node.inode = inode;
-			// We make one entry for each socket inode
-			list_append(l, &node);
-		}
-		closedir(f);
-		free(text);
-	}
-	closedir(d);
-	return 0;
-}
-
 static int eval_data(const char *type, const char *local_address,
 	unsigned int local_port)
 {
@@ -327,15 +118,10 @@ static int eval_data(const char *type, const char *local_address,
 	return 1;
 }
 
-static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
+static void report_finding(struct result_info *res, procsnap_proc_t *n, probe_ctx *ctx)
 {
         SEXP_t *item;
         SEXP_t se_lport_mem, se_rport_mem, se_lfull_mem, se_ffull_mem, *se_uid_mem = NULL;
-	lnode *n = NULL;
-
-	if (l) {
-		n = list_get_cur(l);
-	}
 
 	if (n) {
                 item = probe_item_create(OVAL_LINUX_INET_LISTENING_SERVER, NULL,
@@ -344,13 +130,13 @@ static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
 				 "local_port",           OVAL_DATATYPE_SEXP, SEXP_number_newu_64_r(&se_lport_mem, res->lport),
                                  "local_full_address",   OVAL_DATATYPE_SEXP,    SEXP_string_newf_r(&se_lfull_mem,
                                                                                                    "%s:%u", res->laddr, res->lport),
-                                 "program_name",         OVAL_DATATYPE_STRING,  n->cmd,
+                                 "program_name",         OVAL_DATATYPE_STRING,  n->comm,
                                  "foreign_address",      OVAL_DATATYPE_STRING,  res->raddr,
 				 "foreign_port",         OVAL_DATATYPE_SEXP, SEXP_number_newu_64_r(&se_rport_mem, res->rport),
                                  "foreign_full_address", OVAL_DATATYPE_SEXP,    SEXP_string_newf_r(&se_ffull_mem,
                                                                                                    "%s:%u", res->raddr, res->rport),
                                  "pid",                  OVAL_DATATYPE_INTEGER, (int64_t)n->pid,
-				 "user_id",              OVAL_DATATYPE_SEXP, se_uid_mem = SEXP_number_newu_64(n->uid),
+				 "user_id",              OVAL_DATATYPE_SEXP, se_uid_mem = SEXP_number_newu_64((uid_t)n->euid),
                                  NULL);
 	} else {
                 item = probe_item_create(OVAL_LINUX_INET_LISTENING_SERVER, NULL,
@@ -375,6 +161,22 @@ static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
         SEXP_free(se_uid_mem);
 }
 
+static void report_socket(const char *type, const char *src, unsigned local_port,
+	const char *dest, unsigned rem_port, unsigned long inode, procsnap_t *snap, probe_ctx *ctx)
+{
+	struct result_info r;
+
+	if (!eval_data(type, src, local_port))
+		return;
+
+	r.proto = type;
+	r.laddr = src;
+	r.lport = local_port;
+	r.raddr = dest;
+	r.rport = rem_port;
+	report_finding(&r, procsnap_find_socket(snap, inode), ctx);
+}
+
 static void addr_convert(const char *src, char *dest, int size)
 {
 	if (strlen(src) > 8) {
@@ -391,7 +193,7 @@ static void addr_convert(const char *src, char *dest, int size)
 }
 
 
-static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+static int read_tcp(const char *proc, const char *type, procsnap_t *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -425,25 +227,13 @@ static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have tcp port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
-			struct result_info r;
-			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
-		}
+		report_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+static int read_udp(const char *proc, const char *type, procsnap_t *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -476,25 +266,13 @@ static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have udp port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
-			struct result_info r;
-			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
-		}
+		report_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+static int read_raw(const char *proc, const char *type, procsnap_t *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -527,29 +305,120 @@ static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have raw port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
+		report_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
+	}
+	fclose(f);
+	return 0;
+}
+
+/* A socket from a sock_diag dump that matches the object */
+struct diag_socket {
+	char laddr[INET6_ADDRSTRLEN];
+	char raddr[INET6_ADDRSTRLEN];
+	unsigned lport;
+	unsigned rport;
+	unsigned long inode;
+};
+
+struct diag_state {
+	const char *type;
+	struct diag_socket *socks;
+	size_t count;
+	size_t size;
+};
+
+static int read_diag_cb(const struct nlmsghdr *nlh, void *arg)
+{
+	struct diag_state *st = arg;
+	const struct inet_diag_msg *m = NLMSG_DATA(nlh);
+	struct diag_socket *ds;
+	char src[INET6_ADDRSTRLEN];
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct inet_diag_msg)))
+		return 0;
+
+	inet_ntop(m->idiag_family, m->id.idiag_src, src, sizeof src);
+	dI("Have %s port: %s:%u\n", st->type, src, ntohs(m->id.idiag_sport));
+
+	if (!eval_data(st->type, src, ntohs(m->id.idiag_sport)))
+		return 0;
+
+	if (st->count == st->size) {
+		st->size  = st->size > 0 ? st->size * 2 : 16;
+		st->socks = oscap_realloc(st->socks, sizeof(struct diag_socket) * st->size);
+	}
+
+	ds = st->socks + st->count++;
+	strcpy(ds->laddr, src);
+	inet_ntop(m->idiag_family, m->id.idiag_dst, ds->raddr, sizeof ds->raddr);
+	ds->lport = ntohs(m->id.idiag_sport);
+	ds->rport = ntohs(m->id.idiag_dport);
+	ds->inode = m->idiag_inode;
+
+	return 0;
+}
+
+/*
+ * List the sockets of one family and protocol using NETLINK_SOCK_DIAG.
+ * Sockets in all states are dumped, like /proc/net/<proto> shows them.
+ * The matching sockets are reported only after the whole dump succeeded;
+ * returns -1 otherwise and the caller reads /proc instead.
+ */
+static int read_diag(int family, int protocol, const char *type, procsnap_t *snap, probe_ctx *ctx)
+{
+	struct inet_diag_req_v2 dreq;
+	struct diag_state st;
+	size_t i;
+	int ret;
+
+	memset(&dreq, 0, sizeof dreq);
+	dreq.sdiag_family   = family;
+	dreq.sdiag_protocol = protocol;
+	dreq.idiag_states   = ~0U;
+
+	memset(&st, 0, sizeof st);
+	st.type = type;
+
+	ret = sockdiag_dump(&dreq, sizeof dreq, read_diag_cb, &st);
+
+	if (ret == 0) {
+		for (i = 0; i < st.count; ++i) {
 			struct result_info r;
+
 			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
+			r.laddr = st.socks[i].laddr;
+			r.lport = st.socks[i].lport;
+			r.raddr = st.socks[i].raddr;
+			r.rport = st.socks[i].rport;
+			report_finding(&r, procsnap_find_socket(snap, st.socks[i].inode), ctx);
 		}
 	}
-	fclose(f);
-	return 0;
+
+	oscap_free(st.socks);
+
+	return ret;
+}
+
+void *probe_init(void)
+{
+	return procsnap_new();
+}
+
+void probe_fini(void *arg)
+{
+	procsnap_free(arg);
+}
+
+void probe_flush(void *arg)
+{
+	procsnap_reset(arg);
 }
 
 int probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
 	int err;
-	llist ll;
+	procsnap_t *snap = arg;
 
         object = probe_ctx_getobject(ctx);
 
@@ -572,8 +441,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now start collecting the info
-	list_create(&ll);
-	if (collect_process_info(&ll)) {
+	if (procsnap_load(snap)) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Permission error.");
@@ -586,19 +454,21 @@ int probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now we check the tcp socket list...
-	read_tcp("/proc/net/tcp", "tcp", &ll, ctx);
-	read_tcp("/proc/net/tcp6", "tcp", &ll, ctx);
+	if (read_diag(AF_INET, IPPROTO_TCP, "tcp", snap, ctx) != 0)
+		read_tcp("/proc/net/tcp", "tcp", snap, ctx);
+	if (read_diag(AF_INET6, IPPROTO_TCP, "tcp", snap, ctx) != 0)
+		read_tcp("/proc/net/tcp6", "tcp", snap, ctx);
 
 	// Next udp sockets...
-	read_udp("/proc/net/udp", "udp", &ll, ctx);
-	read_udp("/proc/net/udp6", "udp", &ll, ctx);
+	if (read_diag(AF_INET, IPPROTO_UDP, "udp", snap, ctx) != 0)
+		read_udp("/proc/net/udp", "udp", snap, ctx);
+	if (read_diag(AF_INET6, IPPROTO_UDP, "udp", snap, ctx) != 0)
+		read_udp("/proc/net/udp6", "udp", snap, ctx);
 
 	// Next, raw sockets...not exactly part of standard yet. They
 	// can be used to send datagrams, so we will pretend they are udp
-	read_raw("/proc/net/raw", "udp", &ll, ctx);
-	read_raw("/proc/net/raw6", "udp", &ll, ctx);
-
-	list_clear(&ll);
+	read_raw("/proc/net/raw", "udp", snap, ctx);
+	read_raw("/proc/net/raw6", "udp", snap, ctx);
 
 	err = 0;
  cleanup:
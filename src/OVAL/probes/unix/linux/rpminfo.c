@@ -58,6 +58,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <regex.h>
+#include <limits.h>
+#include <stdlib.h>
 
 /* RPM headers */
 #include <rpm/rpmdb.h>
@@ -85,6 +87,7 @@
 #include <probe-api.h>
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/rpmdb_files.h>
 #include "probe/entcmp.h"
 #include <alloc.h>
 #include <common/assume.h>
@@ -104,12 +107,48 @@ struct rpminfo_rep {
         char *version;
         char *evr;
         char *signature_keyid;
-	char extended_name[1024];
+	char *extended_name;
+};
+
+/*
+ * Files whose metadata identify the state of the rpmdb. Any rpm transaction
+ * touches at least one of them, so the package index is rebuilt only when
+ * their stat() output changes.
+ */
+static const char *g_rpmdb_files[] = { PROBE_RPMDB_FILES };
+
+#define RPMINFO_DBFILE_COUNT (sizeof g_rpmdb_files / sizeof g_rpmdb_files[0])
+
+struct rpminfo_dbstamp {
+	struct {
+		dev_t  dev;
+		ino_t  ino;
+		off_t  size;
+		time_t mtime;
+		long   mtime_ns;
+		time_t ctime;
+		long   ctime_ns;
+	} file[RPMINFO_DBFILE_COUNT];
+};
+
+/*
+ * Package index: the headers of all installed packages, converted once and
+ * sorted by name. Queries hold a reference to the index they were answered
+ * from, so that the index can be replaced while items are still being built
+ * from the previous one.
+ */
+struct rpminfo_index {
+	struct rpminfo_rep    *pkgs;
+	size_t                 count;
+	struct rpminfo_dbstamp stamp;
+	unsigned int           refs;
 };
 
 struct rpminfo_global {
         rpmts           rpmts;
         pthread_mutex_t mutex;
+	char                 *dbpath;
+	struct rpminfo_index *index;
 };
 
 #define RPMINFO_LOCK	  \
@@ -145,6 +184,7 @@ static void __rpminfo_rep_free (struct rpminfo_rep *ptr)
         oscap_free (ptr->version);
         oscap_free (ptr->evr);
         oscap_free (ptr->signature_keyid);
+        oscap_free (ptr->extended_name);
 }
 
 static void pkgh2rep (Header h, struct rpminfo_rep *r)
@@ -152,6 +192,7 @@ static void pkgh2rep (Header h, struct rpminfo_rep *r)
         errmsg_t rpmerr;
         char *str, *sid;
 	char *epoch_override = NULL;
+	char extended_name[1024];
         size_t len;
 	regmatch_t keyid_match[1];
 
@@ -164,7 +205,8 @@ static void pkgh2rep (Header h, struct rpminfo_rep *r)
         r->release = headerFormat (h, "%{RELEASE}", &rpmerr);
         r->version = headerFormat (h, "%{VERSION}", &rpmerr);
 	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
-	snprintf(r->extended_name, 1024, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
+	snprintf(extended_name, sizeof extended_name, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
+	r->extended_name = strdup(extended_name);
 
 	len = (strlen(epoch_override) +
                strlen (r->release) +
@@ -201,103 +243,255 @@ static void pkgh2rep (Header h, struct rpminfo_rep *r)
         oscap_free (str);
 }
 
+static void rpminfo_dbstamp_get (struct rpminfo_dbstamp *stamp)
+{
+	char path[PATH_MAX];
+	struct stat st;
+	size_t i;
+
+	memset (stamp, 0, sizeof (struct rpminfo_dbstamp));
+
+	for (i = 0; i < RPMINFO_DBFILE_COUNT; ++i) {
+		snprintf (path, sizeof path, "%s/%s", g_rpm.dbpath, g_rpmdb_files[i]);
+
+		if (stat (path, &st) != 0)
+			continue;
+
+		stamp->file[i].dev      = st.st_dev;
+		stamp->file[i].ino      = st.st_ino;
+		stamp->file[i].size     = st.st_size;
+		stamp->file[i].mtime    = st.st_mtim.tv_sec;
+		stamp->file[i].mtime_ns = st.st_mtim.tv_nsec;
+		stamp->file[i].ctime    = st.st_ctim.tv_sec;
+		stamp->file[i].ctime_ns = st.st_ctim.tv_nsec;
+	}
+}
+
+static int rpminfo_rep_cmp (const void *a, const void *b)
+{
+	const struct rpminfo_rep *ra = a, *rb = b;
+	int cmp;
+
+	cmp = strcmp (ra->name, rb->name);
+
+	if (cmp != 0)
+		return (cmp);
+
+	return strcmp (ra->extended_name, rb->extended_name);
+}
+
+static void rpminfo_index_free (struct rpminfo_index *idx)
+{
+	size_t i;
+
+	for (i = 0; i < idx->count; ++i)
+		__rpminfo_rep_free (idx->pkgs + i);
+
+	oscap_free (idx->pkgs);
+	oscap_free (idx);
+}
+
+/*
+ * Reads all package headers from the rpmdb. Must be called with
+ * g_rpm.mutex locked.
+ */
+static struct rpminfo_index *rpminfo_index_build (const struct rpminfo_dbstamp *stamp)
+{
+	struct rpminfo_index *idx;
+	rpmdbMatchIterator match;
+	Header pkgh;
+	size_t size;
+
+	idx = oscap_talloc (struct rpminfo_index);
+	idx->pkgs  = NULL;
+	idx->count = 0;
+	idx->stamp = *stamp;
+	idx->refs  = 1;
+
+	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+
+	if (match == NULL)
+		return (idx);
+
+	size = rpmdbGetIteratorCount (match);
+
+	if (size < 64)
+		size = 64;
+
+	idx->pkgs = oscap_alloc (sizeof (struct rpminfo_rep) * size);
+
+	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+		if (idx->count == size) {
+			size *= 2;
+			idx->pkgs = oscap_realloc (idx->pkgs, sizeof (struct rpminfo_rep) * size);
+		}
+
+		pkgh2rep (pkgh, idx->pkgs + idx->count);
+		++idx->count;
+	}
+
+	match = rpmdbFreeIterator (match);
+
+	if (idx->count > 0) {
+		idx->pkgs = oscap_realloc (idx->pkgs, sizeof (struct rpminfo_rep) * idx->count);
+		qsort (idx->pkgs, idx->count, sizeof (struct rpminfo_rep), rpminfo_rep_cmp);
+	}
+
+	dI("rpminfo: indexed %zu packages\n", idx->count);
+
+	return (idx);
+}
+
+/*
+ * Returns a new reference to the package index, rebuilding it first if
+ * the rpmdb changed since it was built. Must be called with g_rpm.mutex
+ * locked.
+ */
+static struct rpminfo_index *rpminfo_index_get (void)
+{
+	struct rpminfo_dbstamp stamp;
+
+	rpminfo_dbstamp_get (&stamp);
+
+	if (g_rpm.index != NULL &&
+	    memcmp (&g_rpm.index->stamp, &stamp, sizeof stamp) != 0)
+	{
+		dI("rpminfo: rpmdb changed, rebuilding the package index\n");
+
+		if (--g_rpm.index->refs == 0)
+			rpminfo_index_free (g_rpm.index);
+
+		g_rpm.index = NULL;
+	}
+
+	if (g_rpm.index == NULL)
+		g_rpm.index = rpminfo_index_build (&stamp);
+
+	++g_rpm.index->refs;
+
+	return (g_rpm.index);
+}
+
+static void rpminfo_index_release (struct rpminfo_index *idx)
+{
+	if (pthread_mutex_lock (&g_rpm.mutex) != 0) {
+		dE("Can't lock mutex\n");
+		return;
+	}
+
+	if (--idx->refs == 0)
+		rpminfo_index_free (idx);
+
+	if (pthread_mutex_unlock (&g_rpm.mutex) != 0) {
+		dE("Can't unlock mutex. Aborting...\n");
+		abort ();
+	}
+}
+
 /*
  * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
+ * idx - A reference to the package index the result was
+ *       taken from will be stored here. It has to be
+ *       released using rpminfo_index_release.
+ * rep - An array of pointers to the matching index entries
+ *       will be allocated here.
  *
  * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
+ * entries in *rep is returned.
  */
-static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_rep **rep)
+static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_index **idx,
+                        const struct rpminfo_rep ***rep)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
+	struct rpminfo_index *index;
+	const char *prev_name;
+	regex_t re;
+	size_t lo, hi, mid, i;
+	int ret, prev_match;
+
+	*idx = NULL;
+	*rep = NULL;
 
         RPMINFO_LOCK;
+	index = rpminfo_index_get ();
+        RPMINFO_UNLOCK;
 
-        ret = -1;
+	ret = 0;
 
         switch (req->op) {
         case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)req->name, 0);
+		/* lower bound of the name range */
+		lo = 0;
+		hi = index->count;
 
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+
+			if (strcmp (index->pkgs[mid].name, req->name) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
 
-                ret = rpmdbGetIteratorCount (match);
+		for (i = lo; i < index->count && strcmp (index->pkgs[i].name, req->name) == 0; ++i)
+			;
+
+		if (i > lo) {
+			*rep = oscap_alloc (sizeof (struct rpminfo_rep *) * (i - lo));
+
+			for (; lo < i; ++lo)
+				(*rep)[ret++] = index->pkgs + lo;
+		}
 
                 break;
 	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
+		/* the names are filtered by the caller */
+		if (index->count > 0) {
+			*rep = oscap_alloc (sizeof (struct rpminfo_rep *) * index->count);
 
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
+			for (i = 0; i < index->count; ++i)
+				(*rep)[ret++] = index->pkgs + i;
+		}
 
                 break;
         case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+		/* the same flags rpmdbSetIteratorRE uses for RPMMIRE_REGEX */
+		if (regcomp (&re, req->name, REG_EXTENDED | REG_NOSUB) != 0) {
+			dI("Invalid regular expression: %s\n", req->name);
+			ret = -1;
+			break;
+		}
 
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
+		if (index->count > 0)
+			*rep = oscap_alloc (sizeof (struct rpminfo_rep *) * index->count);
 
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
+		/* the index is sorted by name, match each name once */
+		prev_name  = NULL;
+		prev_match = 0;
+
+		for (i = 0; i < index->count; ++i) {
+			if (prev_name == NULL || strcmp (prev_name, index->pkgs[i].name) != 0) {
+				prev_name  = index->pkgs[i].name;
+				prev_match = regexec (&re, prev_name, 0, NULL, 0) == 0;
+			}
 
+			if (prev_match)
+				(*rep)[ret++] = index->pkgs + i;
+		}
+
+		regfree (&re);
                 break;
         default:
                 /* not supported */
                 ret = -1;
-                goto ret;
         }
 
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-                                pkgh2rep (pkgh, (*rep) + i);
-                        else {
-                                /* XXX: emit warning */
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
+	if (ret <= 0) {
+		oscap_free (*rep);
+		*rep = NULL;
+		rpminfo_index_release (index);
+	} else
+		*idx = index;
 
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        assume_r (*rep != NULL, -1);
-                        pkgh2rep (pkgh, (*rep) + (ret - 1));
-                }
-        }
-
-	match = rpmdbFreeIterator (match);
-ret:
-        RPMINFO_UNLOCK;
         return (ret);
 }
 
@@ -316,6 +510,8 @@ void *probe_init (void)
         }
 
         g_rpm.rpmts = rpmtsCreate();
+        g_rpm.dbpath = rpmExpand("%{_dbpath}", NULL);
+        g_rpm.index = NULL;
         pthread_mutex_init (&(g_rpm.mutex), NULL);
 
 	if (regcomp(&g_keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
@@ -332,6 +528,10 @@ void probe_fini (void *ptr)
 {
         struct rpminfo_global *r = (struct rpminfo_global *)ptr;
 
+        if (r->index != NULL && --r->index->refs == 0)
+                rpminfo_index_free(r->index);
+
+        oscap_free(r->dbpath);
         rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
         rpmFreeRpmrc();
@@ -351,8 +551,11 @@ static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
 	int i, ret = 0;
 
+	RPMINFO_LOCK;
+
 	ts = rpmtsInitIterator(g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
 	if (ts == NULL) {
+		RPMINFO_UNLOCK;
 		return -1;
 	}
 
@@ -403,6 +606,7 @@ static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
 	}
 cleanup:
 	ts = rpmdbFreeIterator(ts);
+	RPMINFO_UNLOCK;
 	return ret;
 }
 
@@ -413,7 +617,8 @@ int probe_main (probe_ctx *ctx, void *arg)
 	int rpmret, i;
 
         struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
+        const struct rpminfo_rep **reply_st;
+        struct rpminfo_index *index;
 
 	probe_in = probe_ctx_getobject(ctx);
 	if (probe_in == NULL)
@@ -476,10 +681,8 @@ int probe_main (probe_ctx *ctx, void *arg)
                 }
         }
 
-        reply_st  = NULL;
-
-        /* get info from RPM db */
-        switch (rpmret = get_rpminfo (&request_st, &reply_st)) {
+        /* get info from the package index */
+        switch (rpmret = get_rpminfo (&request_st, &index, &reply_st)) {
         case 0: /* Not found */
                 dI("Package \"%s\" not found.\n", request_st.name);
                 break;
@@ -500,7 +703,7 @@ int probe_main (probe_ctx *ctx, void *arg)
                         SEXP_t *name;
 
                         for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
+				name = SEXP_string_newf("%s", reply_st[i]->name);
 
 				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
 					SEXP_free(name);
@@ -509,12 +712,12 @@ int probe_main (probe_ctx *ctx, void *arg)
 
                                 item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
                                                          "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
+                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i]->arch,
+                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i]->epoch,
+                                                         "release", OVAL_DATATYPE_STRING, reply_st[i]->release,
+                                                         "version", OVAL_DATATYPE_STRING, reply_st[i]->version,
+                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i]->evr,
+                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i]->signature_keyid,
                                                          NULL);
 
 				/* OVAL 5.10 added extended_name and filepaths behavior */
@@ -522,8 +725,8 @@ int probe_main (probe_ctx *ctx, void *arg)
 					SEXP_t *value, *bh_value;
 					value = probe_entval_from_cstr(
 							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
+							reply_st[i]->extended_name,
+							strlen(reply_st[i]->extended_name)
 					);
 					probe_item_ent_add(item, "extended_name", NULL, value);
 					SEXP_free(value);
@@ -537,7 +740,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 						if (bh_value != NULL) {
 							if (SEXP_strcmp(bh_value, "true") == 0) {
 								/* collect package files */
-								collect_rpm_files(item, &reply_st[i]);
+								collect_rpm_files(item, reply_st[i]);
 
 							}
 							SEXP_free(bh_value);
@@ -549,15 +752,18 @@ int probe_main (probe_ctx *ctx, void *arg)
 
 
 				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
 
 				if (probe_item_collect(ctx, item)) {
+					oscap_free (reply_st);
+					rpminfo_index_release (index);
 					SEXP_vfree(ent, NULL);
+					oscap_free(request_st.name);
 					return 1;
 				}
                         }
 
                         oscap_free (reply_st);
+                        rpminfo_index_release (index);
                 }
         }
 
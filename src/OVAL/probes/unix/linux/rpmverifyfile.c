@@ -42,6 +42,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <pcre.h>
+#include <pthread.h>
+#include <unistd.h>
 
 /* RPM headers */
 #include <rpm/rpmdb.h>
@@ -68,6 +70,7 @@
 
 /* SEAP */
 #include <probe-api.h>
+#include <probe/option.h>
 #include <alloc.h>
 #include <common/assume.h>
 #include "debug_priv.h"
@@ -75,11 +78,11 @@
 
 struct rpmverify_res {
 	char *name;  /**< package name */
-	const char *epoch;
-	const char *version;
-	const char *release;
-	const char *arch;
-	const char *file;  /**< filepath */
+	char *epoch;
+	char *version;
+	char *release;
+	char *arch;
+	char *file;  /**< filepath */
 	char extended_name[1024];
 	rpmVerifyAttrs vflags; /**< rpm verify flags */
 	rpmVerifyAttrs oflags; /**< rpm verify omit flags */
@@ -146,6 +149,396 @@ static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_ta
 	return ret;
 }
 
+/*
+ * Parallel verification
+ *
+ * The packages matching the object are selected under the rpm mutex as
+ * before, in batches of at most RPMVERIFY_BATCH headers: a batch is
+ * verified before the database iterator moves on, so the memory used
+ * doesn't grow with the number of matching packages. The files of a batch
+ * are verified by a pool of threads, each with its own transaction set,
+ * one package at a time. The results are handed over to the callback in
+ * the order of the packages and of their files, i.e. the items are the
+ * same as if the packages were verified serially. Workers verify at most
+ * RPMVERIFY_WINDOW_PER_THREAD packages per thread ahead of the last
+ * package handed over to the callback.
+ */
+#define RPMVERIFY_DEFAULT_THREADS   4
+#define RPMVERIFY_WINDOW_PER_THREAD 4
+#define RPMVERIFY_BATCH             64
+
+struct rpmverify_query {
+	const char      *file;
+	oval_operation_t file_op;
+	pcre            *re;
+	uint64_t         flags;
+};
+
+struct rpmverify_fres {
+	char          *file;
+	rpmVerifyAttrs vflags;
+	rpmfileAttrs   fflags;
+};
+
+struct rpmverify_pkg {
+	Header                 pkgh;
+	struct rpmverify_res   res;   /**< package part of the results */
+	struct rpmverify_fres *files; /**< verified files */
+	size_t                 count;
+	size_t                 size;
+	int                    ret;   /**< 0 or -1 if the verification failed */
+	int                    done;  /**< files verified */
+};
+
+struct rpmverify_pool {
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	struct rpmverify_pkg *pkgs;
+	size_t          count;
+	size_t          next;     /**< next package to verify */
+	size_t          consumed; /**< number of packages handed over to the callback */
+	size_t          window;
+	int             stop;
+	const struct rpmverify_query *query;
+	pthread_mutex_t ug_mutex; /**< serializes the owner checks */
+};
+
+struct rpmverify_worker {
+	pthread_t              tid;
+	rpmts                  rpmts;
+	struct rpmverify_pool *pool;
+};
+
+static void rpmverify_pkg_free(struct rpmverify_pkg *pkg)
+{
+	size_t i;
+
+	for (i = 0; i < pkg->count; ++i)
+		oscap_free(pkg->files[i].file);
+
+	oscap_free(pkg->files);
+	pkg->files = NULL;
+	pkg->count = pkg->size = 0;
+}
+
+static void rpmverify_pkg_release(struct rpmverify_pkg *pkg)
+{
+	rpmverify_pkg_free(pkg);
+	free(pkg->res.name);
+	free(pkg->res.epoch);
+	free(pkg->res.version);
+	free(pkg->res.release);
+	free(pkg->res.arch);
+	headerFree(pkg->pkgh);
+}
+
+/*
+ * Verifies the files of a package matching the query. The USER and GROUP
+ * checks of rpmVerifyFile() look the owners up using rpmugUname() and
+ * rpmugGname(), which keep static caches and call getpwuid() and
+ * getgrgid(). When `ug_mutex' isn't NULL, the other threads verify files
+ * too: the owners are then checked by a separate rpmVerifyFile() call
+ * made under the mutex, which omits all the other attributes.
+ */
+static int rpmverify_pkg_files(rpmts ts, const struct rpmverify_query *q, struct rpmverify_pkg *pkg,
+			       pthread_mutex_t *ug_mutex)
+{
+	rpmVerifyAttrs omit = (rpmVerifyAttrs)(q->flags & RPMVERIFY_RPMATTRMASK);
+	rpmVerifyAttrs ug_check = 0, ug_vflags;
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	struct rpmverify_fres *fres;
+	const char *file;
+	rpmfi fi;
+	int i, ret = 0;
+
+	if (ug_mutex != NULL) {
+		ug_check = (RPMVERIFY_USER | RPMVERIFY_GROUP) & ~omit;
+		omit |= ug_check;
+	}
+
+	for (i = 0; i < 2 && ret == 0; ++i) {
+		fi = rpmfiNew(ts, pkg->pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			rpmfileAttrs fflags = rpmfiFFlags(fi);
+
+			if (((fflags & RPMFILE_CONFIG) && (q->flags & RPMVERIFY_SKIP_CONFIG)) ||
+			    ((fflags & RPMFILE_GHOST)  && (q->flags & RPMVERIFY_SKIP_GHOST)))
+				continue;
+
+			file = rpmfiFN(fi);
+
+			switch(q->file_op) {
+			case OVAL_OPERATION_EQUALS:
+				if (strcmp(file, q->file) != 0)
+					continue;
+				break;
+			case OVAL_OPERATION_NOT_EQUAL:
+				if (strcmp(file, q->file) == 0)
+					continue;
+				break;
+			case OVAL_OPERATION_PATTERN_MATCH:
+				switch(pcre_exec(q->re, NULL, file, strlen(file), 0, 0, NULL, 0)) {
+				case 0: /* match */
+					break;
+				case -1: /* mismatch */
+					continue;
+				default:
+					dE("pcre_exec() failed!\n");
+					ret = -1;
+				}
+				break;
+			default:
+				/* unsupported operation */
+				dE("Operation \"%d\" on `filepath' not supported\n", q->file_op);
+				ret = -1;
+			}
+
+			if (ret != 0)
+				break;
+
+			if (pkg->count == pkg->size) {
+				pkg->size  = pkg->size > 0 ? pkg->size * 2 : 16;
+				pkg->files = oscap_realloc(pkg->files, sizeof(struct rpmverify_fres) * pkg->size);
+			}
+
+			fres = pkg->files + pkg->count++;
+			fres->file   = oscap_strdup(file);
+			fres->fflags = fflags;
+
+			if (rpmVerifyFile(ts, fi, &fres->vflags, omit) != 0) {
+				fres->vflags = RPMVERIFY_FAILURES;
+				continue;
+			}
+
+			if (ug_check != 0) {
+				pthread_mutex_lock(ug_mutex);
+
+				if (rpmVerifyFile(ts, fi, &ug_vflags, RPMVERIFY_ALL & ~ug_check) != 0)
+					fres->vflags = RPMVERIFY_FAILURES;
+				else
+					fres->vflags |= ug_vflags;
+
+				pthread_mutex_unlock(ug_mutex);
+			}
+		}
+
+		rpmfiFree(fi);
+	}
+
+	return (ret);
+}
+
+/*
+ * Hands over the verified files of a package to the callback. Returns 1
+ * if the callback doesn't want any more results.
+ */
+static int rpmverify_pkg_emit(probe_ctx *ctx, const struct rpmverify_query *q, struct rpmverify_pkg *pkg,
+			      int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	size_t i;
+
+	for (i = 0; i < pkg->count; ++i) {
+		pkg->res.file   = pkg->files[i].file;
+		pkg->res.vflags = pkg->files[i].vflags;
+		pkg->res.fflags = pkg->files[i].fflags;
+		pkg->res.oflags = (rpmVerifyAttrs)(q->flags & RPMVERIFY_RPMATTRMASK);
+
+		if (callback(ctx, &pkg->res) != 0)
+			return (1);
+	}
+
+	return (0);
+}
+
+static void *rpmverify_worker_run(void *arg)
+{
+	struct rpmverify_worker *worker = (struct rpmverify_worker *)arg;
+	struct rpmverify_pool   *pool   = worker->pool;
+	size_t i;
+	int ret;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	for (;;) {
+		while (!pool->stop && pool->next < pool->count &&
+		       pool->next >= pool->consumed + pool->window)
+			pthread_cond_wait(&pool->cond, &pool->mutex);
+
+		if (pool->stop || pool->next >= pool->count)
+			break;
+
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->mutex);
+
+		ret = rpmverify_pkg_files(worker->rpmts, pool->query, pool->pkgs + i, &pool->ug_mutex);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->pkgs[i].ret  = ret;
+		pool->pkgs[i].done = 1;
+		pthread_cond_broadcast(&pool->cond);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return (NULL);
+}
+
+/*
+ * The verification functions return 0 when all packages were handed over
+ * to the callback, 1 if the callback didn't want any more results and -1
+ * on failure.
+ */
+static int rpmverify_verify_serial(probe_ctx *ctx, const struct rpmverify_query *q,
+				   struct rpmverify_pkg *pkgs, size_t count,
+				   int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		if (rpmverify_pkg_files(g_rpm.rpmts, q, pkgs + i, NULL) != 0)
+			return (-1);
+
+		if (rpmverify_pkg_emit(ctx, q, pkgs + i, callback) != 0)
+			return (1);
+
+		rpmverify_pkg_free(pkgs + i);
+	}
+
+	return (0);
+}
+
+static int rpmverify_verify_parallel(probe_ctx *ctx, const struct rpmverify_query *q,
+				     struct rpmverify_pkg *pkgs, size_t count, unsigned int threads,
+				     int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	struct rpmverify_pool    pool;
+	struct rpmverify_worker *workers;
+	unsigned int started, t;
+	size_t i;
+	int ret = 0;
+
+	pool.pkgs     = pkgs;
+	pool.count    = count;
+	pool.next     = 0;
+	pool.consumed = 0;
+	pool.window   = (size_t)threads * RPMVERIFY_WINDOW_PER_THREAD;
+	pool.stop     = 0;
+	pool.query    = q;
+
+	pthread_mutex_init(&pool.mutex, NULL);
+	pthread_mutex_init(&pool.ug_mutex, NULL);
+	pthread_cond_init(&pool.cond, NULL);
+
+	workers = oscap_alloc(sizeof(struct rpmverify_worker) * threads);
+
+	for (started = 0; started < threads; ++started) {
+		workers[started].pool  = &pool;
+		workers[started].rpmts = rpmtsCreate();
+
+		if (pthread_create(&workers[started].tid, NULL, &rpmverify_worker_run, workers + started) != 0) {
+			dW("Can't start a verification thread: %u, %s\n", errno, strerror(errno));
+			rpmtsFree(workers[started].rpmts);
+			break;
+		}
+	}
+
+	dI("Verifying %zu packages using %u threads\n", count, started);
+
+	if (started == 0) {
+		oscap_free(workers);
+		pthread_cond_destroy(&pool.cond);
+		pthread_mutex_destroy(&pool.ug_mutex);
+		pthread_mutex_destroy(&pool.mutex);
+
+		return rpmverify_verify_serial(ctx, q, pkgs, count, callback);
+	}
+
+	for (i = 0; i < count; ++i) {
+		pthread_mutex_lock(&pool.mutex);
+
+		while (!pkgs[i].done)
+			pthread_cond_wait(&pool.cond, &pool.mutex);
+
+		pthread_mutex_unlock(&pool.mutex);
+
+		if (pkgs[i].ret != 0) {
+			ret = -1;
+			break;
+		}
+
+		if (rpmverify_pkg_emit(ctx, q, pkgs + i, callback) != 0) {
+			ret = 1;
+			break;
+		}
+
+		rpmverify_pkg_free(pkgs + i);
+
+		pthread_mutex_lock(&pool.mutex);
+		pool.consumed = i + 1;
+		pthread_cond_broadcast(&pool.cond);
+		pthread_mutex_unlock(&pool.mutex);
+	}
+
+	pthread_mutex_lock(&pool.mutex);
+	pool.stop = 1;
+	pthread_cond_broadcast(&pool.cond);
+	pthread_mutex_unlock(&pool.mutex);
+
+	for (t = 0; t < started; ++t) {
+		pthread_join(workers[t].tid, NULL);
+		rpmtsFree(workers[t].rpmts);
+	}
+
+	oscap_free(workers);
+	pthread_cond_destroy(&pool.cond);
+	pthread_mutex_destroy(&pool.ug_mutex);
+	pthread_mutex_destroy(&pool.mutex);
+
+	return (ret);
+}
+
+/* check whether the value of a package header matches the object entity */
+static bool rpmverify_ent_match(SEXP_t *obj_ent, const char *value)
+{
+	SEXP_t *ent;
+	bool match = true;
+
+	if (obj_ent == NULL)
+		return (true);
+
+	ent = probe_entval_from_cstr(probe_ent_getdatatype(obj_ent), value, strlen(value));
+
+	if (ent != NULL) {
+		match = probe_entobj_cmp(obj_ent, ent) == OVAL_RESULT_TRUE;
+		SEXP_free(ent);
+	}
+
+	return (match);
+}
+
+/* verify a batch of packages and release their headers */
+static int rpmverify_verify_batch(probe_ctx *ctx, const struct rpmverify_query *q,
+				  struct rpmverify_pkg *pkgs, size_t count, int threads,
+				  int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	size_t i;
+	int ret;
+
+	if ((size_t)threads > count)
+		threads = (int)count;
+
+	if (threads > 1)
+		ret = rpmverify_verify_parallel(ctx, q, pkgs, count, (unsigned int)threads, callback);
+	else
+		ret = rpmverify_verify_serial(ctx, q, pkgs, count, callback);
+
+	for (i = 0; i < count; ++i)
+		rpmverify_pkg_release(pkgs + i);
+
+	return (ret);
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
 			     const char *file, oval_operation_t file_op,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
@@ -153,24 +546,34 @@ static int rpmverify_collect(probe_ctx *ctx,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
 	rpmdbMatchIterator match;
-	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
-	pcre *re = NULL;
+	struct rpmverify_query query;
+	struct rpmverify_pkg *pkgs = NULL;
+	size_t count = 0;
+	int threads = 1;
 	int  ret = -1;
 
+	query.file    = file;
+	query.file_op = file_op;
+	query.re      = NULL;
+	query.flags   = flags;
+
 	/* pre-compile regex if needed */
 	if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
 		const char *errmsg;
 		int erroff;
 
-		re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
+		query.re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
 
-		if (re == NULL) {
+		if (query.re == NULL) {
 			/* TODO */
 			return (-1);
 		}
 	}
 
+	if (probe_getoption(PROBEOPT_COLLECT_THREADS, &threads) != 0 || threads < 1)
+		threads = 1;
+
 	RPMVERIFY_LOCK;
 
 	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
@@ -203,122 +606,67 @@ static int rpmverify_collect(probe_ctx *ctx,
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
+	pkgs = oscap_alloc(sizeof(struct rpmverify_pkg) * RPMVERIFY_BATCH);
+
+	/*
+	 * Select the packages to verify and inspect their files &
+	 * directories batch by batch
+	 */
 	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
-		rpmfi  fi;
-		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-		struct rpmverify_res res;
+		struct rpmverify_res *res;
 		errmsg_t rpmerr;
-		int i;
-
-		/*
-+SEXP_t *probe_ent_from_cstr(const char *name, oval_datatype_t type,
-+                            const char *value, size_t vallen)
-		 */
-
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
+
+		memset(pkgs + count, 0, sizeof(struct rpmverify_pkg));
+		res = &pkgs[count].res;
+
+		res->name    = headerFormat(pkgh, "%{NAME}", &rpmerr);
+		res->epoch   = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
+		res->version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
+		res->release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
+		res->arch    = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+
+		if (!rpmverify_ent_match(name_ent, res->name) ||
+		    !rpmverify_ent_match(epoch_ent, res->epoch) ||
+		    !rpmverify_ent_match(version_ent, res->version) ||
+		    !rpmverify_ent_match(release_ent, res->release) ||
+		    !rpmverify_ent_match(arch_ent, res->arch))
+		{
+			free(res->name);
+			free(res->epoch);
+			free(res->version);
+			free(res->release);
+			free(res->arch);
+			continue;
 		}
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
-
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
-
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-		  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-		  while (rpmfiNext(fi) != -1) {
-				res.file = oscap_strdup(rpmfiFN(fi));
-		    res.fflags = rpmfiFFlags(fi);
-		    res.oflags = omit;
-
-		    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-					((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
-					oscap_free(res.file);
-					continue;
-				}
+		snprintf(res->extended_name, 1024, "%s-%s:%s-%s.%s", res->name,
+			oscap_streq(res->epoch, "(none)") ? "0" : res->epoch,
+			res->version, res->release, res->arch);
 
-		    switch(file_op) {
-		    case OVAL_OPERATION_EQUALS:
-					if (strcmp(res.file, file) != 0) {
-						oscap_free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_NOT_EQUAL:
-					if (strcmp(res.file, file) == 0) {
-						oscap_free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_PATTERN_MATCH:
-		      ret = pcre_exec(re, NULL, res.file, strlen(res.file), 0, 0, NULL, 0);
-
-		      switch(ret) {
-		      case 0: /* match */
-			break;
-		      case -1:
-			/* mismatch */
-			oscap_free(res.file);
-			continue;
-		      default:
-			dE("pcre_exec() failed!\n");
-			ret = -1;
-			oscap_free(res.file);
-			goto ret;
-		      }
-		      break;
-		    default:
-		      /* unsupported operation */
-		      dE("Operation \"%d\" on `filepath' not supported\n", file_op);
-		      ret = -1;
-					oscap_free(res.file);
-		      goto ret;
-		    }
-
-		    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
-		      res.vflags = RPMVERIFY_FAILURES;
-
-		    if (callback(ctx, &res) != 0) {
-			    ret = 0;
-					oscap_free(res.file);
-			    goto ret;
-		    }
-			oscap_free(res.file);
-		  }
-
-		  rpmfiFree(fi);
+		pkgs[count++].pkgh = headerLink(pkgh);
+
+		if (count == RPMVERIFY_BATCH) {
+			ret   = rpmverify_verify_batch(ctx, &query, pkgs, count, threads, callback);
+			count = 0;
+
+			if (ret != 0)
+				break;
 		}
 	}
 
 	match = rpmdbFreeIterator (match);
-	ret   = 0;
+
+	if (ret == 0 && count > 0)
+		ret = rpmverify_verify_batch(ctx, &query, pkgs, count, threads, callback);
+
+	/* the callback didn't want any more results */
+	if (ret == 1)
+		ret = 0;
+
+	oscap_free(pkgs);
 ret:
-	if (re != NULL)
-		pcre_free(re);
+	if (query.re != NULL)
+		pcre_free(query.re);
 
 	RPMVERIFY_UNLOCK;
 	return (ret);
@@ -326,6 +674,8 @@ ret:
 
 void *probe_init (void)
 {
+	long threads;
+
 	if (rpmReadConfigFiles ((const char *)NULL, (const char *)NULL) != 0) {
 		dI("rpmReadConfigFiles failed: %u, %s.\n", errno, strerror (errno));
 		return (NULL);
@@ -335,6 +685,20 @@ void *probe_init (void)
 
 	pthread_mutex_init(&(g_rpm.mutex), NULL);
 
+	/*
+	 * Verify the files using one thread per online CPU, up to
+	 * RPMVERIFY_DEFAULT_THREADS; OSCAP_PROBE_COLLECT_THREADS overrides
+	 * the limit
+	 */
+	threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (threads > RPMVERIFY_DEFAULT_THREADS)
+		threads = RPMVERIFY_DEFAULT_THREADS;
+	if (threads < 1)
+		threads = 1;
+
+	probe_setoption(PROBEOPT_COLLECT_THREADS, (int)threads);
+
 	return ((void *)&g_rpm);
 }
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+
+#include "alloc.h"
+#include "common/debug_priv.h"
+#include "sockdiag.h"
+
+/* large enough for the biggest dump skb the kernel sends in one go */
+#define SOCKDIAG_BUFSIZE 32768
+
+int sockdiag_dump(const void *req, size_t reqlen, sockdiag_cb_t cb, void *arg)
+{
+	struct sockaddr_nl nladdr;
+	struct nlmsghdr nlh, *h;
+	struct iovec iov[2];
+	struct msghdr msg;
+	void *buf;
+	ssize_t len;
+	int fd, err = 0, done = 0;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+
+	if (fd < 0) {
+		dI("Can't open a NETLINK_SOCK_DIAG socket: %u, %s\n", errno, strerror(errno));
+		return (-1);
+	}
+
+	memset(&nladdr, 0, sizeof nladdr);
+	nladdr.nl_family = AF_NETLINK;
+
+	memset(&nlh, 0, sizeof nlh);
+	nlh.nlmsg_len   = NLMSG_LENGTH(reqlen);
+	nlh.nlmsg_type  = SOCK_DIAG_BY_FAMILY;
+	nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	nlh.nlmsg_seq   = 1;
+
+	iov[0].iov_base = &nlh;
+	iov[0].iov_len  = sizeof nlh;
+	iov[1].iov_base = (void *)req;
+	iov[1].iov_len  = reqlen;
+
+	memset(&msg, 0, sizeof msg);
+	msg.msg_name    = &nladdr;
+	msg.msg_namelen = sizeof nladdr;
+	msg.msg_iov     = iov;
+	msg.msg_iovlen  = 2;
+
+	if (sendmsg(fd, &msg, 0) < 0) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return (-1);
+	}
+
+	buf = oscap_alloc(SOCKDIAG_BUFSIZE);
+
+	while (!done) {
+		iov[0].iov_base = buf;
+		iov[0].iov_len  = SOCKDIAG_BUFSIZE;
+
+		memset(&msg, 0, sizeof msg);
+		msg.msg_name    = &nladdr;
+		msg.msg_namelen = sizeof nladdr;
+		msg.msg_iov     = iov;
+		msg.msg_iovlen  = 1;
+
+		len = recvmsg(fd, &msg, 0);
+
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			err = errno;
+			break;
+		}
+
+		if (len == 0 || (msg.msg_flags & MSG_TRUNC)) {
+			err = EMSGSIZE;
+			break;
+		}
+
+		for (h = buf; NLMSG_OK(h, (size_t)len); h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_type == NLMSG_DONE) {
+				done = 1;
+				break;
+			}
+
+			if (h->nlmsg_type == NLMSG_ERROR) {
+				const struct nlmsgerr *e = NLMSG_DATA(h);
+
+				if (h->nlmsg_len >= NLMSG_LENGTH(sizeof(struct nlmsgerr)) && e->error < 0)
+					err = -e->error;
+				else
+					err = EPROTO;
+				break;
+			}
+
+			if (h->nlmsg_type != SOCK_DIAG_BY_FAMILY)
+				continue;
+
+			errno = 0;
+
+			if (cb(h, arg) != 0) {
+				err = errno != 0 ? errno : ECANCELED;
+				break;
+			}
+		}
+
+		if (err != 0)
+			break;
+	}
+
+	oscap_free(buf);
+	close(fd);
+
+	if (err != 0) {
+		dI("sock_diag dump failed: %u, %s\n", err, strerror(err));
+		errno = err;
+		return (-1);
+	}
+
+	return (0);
+}
+
+const void *sockdiag_attr(const struct nlmsghdr *nlh, size_t hdrlen, unsigned short type, size_t *len)
+{
+	const struct rtattr *rta;
+	int rtalen;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(NLMSG_ALIGN(hdrlen)))
+		return (NULL);
+
+	rta    = (const struct rtattr *)((const char *)NLMSG_DATA(nlh) + NLMSG_ALIGN(hdrlen));
+	rtalen = nlh->nlmsg_len - NLMSG_LENGTH(NLMSG_ALIGN(hdrlen));
+
+	for (; RTA_OK(rta, rtalen); rta = RTA_NEXT(rta, rtalen)) {
+		if (rta->rta_type == type) {
+			*len = RTA_PAYLOAD(rta);
+			return (RTA_DATA(rta));
+		}
+	}
+
+	return (NULL);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SOCKDIAG_H
+#define SOCKDIAG_H
+
+#include <stddef.h>
+#include <linux/netlink.h>
+
+/*
+ * Minimal NETLINK_SOCK_DIAG client used by the inetlisteningservers and
+ * iflisteners probes to list sockets without parsing /proc/net/<proto>.
+ */
+
+/**
+ * Called for every SOCK_DIAG_BY_FAMILY message of a dump. A non-zero
+ * return value stops the dump, sockdiag_dump() then fails with errno
+ * set by the callback (or ECANCELED).
+ */
+typedef int (*sockdiag_cb_t)(const struct nlmsghdr *nlh, void *arg);
+
+/**
+ * Send a SOCK_DIAG_BY_FAMILY dump request with the given payload (e.g.
+ * a struct inet_diag_req_v2) and pass each reply to the callback.
+ * Returns 0 on success and -1 with errno set if the netlink socket
+ * can't be used or the kernel doesn't support the request, so that the
+ * caller can fall back to /proc.
+ */
+int sockdiag_dump(const void *req, size_t reqlen, sockdiag_cb_t cb, void *arg);
+
+/**
+ * Find the first attribute of the given type in a reply whose fixed
+ * part (e.g. struct inet_diag_msg) is hdrlen bytes long.
+ * Returns the attribute payload and its length, or NULL.
+ */
+const void *sockdiag_attr(const struct nlmsghdr *nlh, size_t hdrlen, unsigned short type, size_t *len);
+
+#endif /* SOCKDIAG_H */
@@ -103,7 +103,7 @@ extern char const *_cap_names[];
 #include "alloc.h"
 #include "common/debug_priv.h"
 #include <ctype.h>
-#include "common/oscap_buffer.h"
+#include "procsnap.h"
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -153,71 +153,6 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 unsigned long ticks, boot;
 
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-	r->loginuid = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	snprintf(buf, sizeof(buf), "/proc/%d/loginuid", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		if (fscanf(sf, "%u", &r->loginuid) < 1) {
-			dW("fscanf failed from %s\n", buf);
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
-
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
 	unsigned d,h,m,s;
@@ -236,21 +171,23 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 	return tbuf;
 }
 
-static char *get_selinux_label(int pid) {
+static char *get_selinux_label(procsnap_proc_t *p) {
 #ifdef HAVE_SELINUX_SELINUX_H
 	char *selinux_label;
-	security_context_t pid_context;
 	context_t context;
 
-	if (getpidcon(pid, &pid_context) == -1) {
+	if (p->label == NULL) {
 		/* error getting pid selinux context */
-		dW("Can't get selinux context for process %d\n", pid);
+		dW("Can't get selinux context for process %d\n", p->pid);
+		return NULL;
+	}
+	context = context_new(p->label);
+	if (context == NULL) {
+		dW("Can't parse selinux context of process %d: %s\n", p->pid, p->label);
 		return NULL;
 	}
-	context = context_new(pid_context);
 	selinux_label = strdup(context_type_get(context));
 	context_free(context);
-	freecon(pid_context);
 	return selinux_label;
 
 #else
@@ -258,37 +195,19 @@ static char *get_selinux_label(int pid) {
 #endif /* HAVE_SELINUX_SELINUX_H */
 }
 
-static char **get_posix_capability(int pid, int max_cap_id) {
+static char **get_posix_capability(procsnap_proc_t *p, int max_cap_id) {
 #ifdef HAVE_SYS_CAPABILITY_H
-	cap_t pid_caps;
 	char *cap_name, **ret = NULL;
 	unsigned cap_value, ret_index = 0;
-	cap_flag_value_t cap_flag;
 	int cap_id;
 
-#if LIBCAP_VERSION == 1
-	pid_caps = cap_init();
-	if (capgetp(pid, pid_caps) == -1) {
-		dW("Can't get capabilities for process %d\n", pid);
-		cap_free(pid_caps);
-		return NULL;
-	}
-#elif LIBCAP_VERSION == 2
-	pid_caps = cap_get_pid(pid);
-#else
-	dW("Can't detect libcap version\n");
-	return NULL;
-#endif
-
-	if (pid_caps == NULL) {
-		dW("Can't get capabilities for process %d\n", pid);
+	if (!p->cap_valid) {
+		dW("Can't get capabilities for process %d\n", p->pid);
 		return NULL;
 	}
 
 	for (cap_value = 0; cap_value < CAP_LAST_CAP; cap_value++) {
-		if (cap_get_flag(pid_caps, cap_value, CAP_EFFECTIVE, &cap_flag) == -1)
-			continue;
-		if (cap_flag == CAP_SET) {
+		if (p->cap_eff & ((uint64_t)1 << cap_value)) {
 #if LIBCAP_VERSION == 2
 			cap_name = cap_to_name(cap_value);
 #else
@@ -314,7 +233,6 @@ static char **get_posix_capability(int pid, int max_cap_id) {
 	ret = realloc(ret, (ret_index + 1) * sizeof(char *));
 	ret[ret_index] = NULL;
 
-	cap_free(pid_caps);
 	return ret;
 #else
 	return NULL;
@@ -356,98 +274,18 @@ static int get_exec_shield_status(int pid) {
 	return ret;
 }
 
-/**
- * Parse /proc/%d/cmdline file
- * @param filepath Path to file ~ use preallocated buffer for the path
- * @param buffer output buffer with non-zero size
- * @return ps-like command info or NULL
- */
-static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
-
-	int fd = open(filepath, O_RDONLY, 0);
-
-	if (fd < 0) {
-		return false;
-	}
-
-	oscap_buffer_clear(buffer);
-
-
-
-	for(;;) {
-		static const int chunk_size = 1024;
-		char chunk[chunk_size];
-		// Read data, store to buffer
-		ssize_t read_size = read(fd, chunk, chunk_size );
-		if (read_size < 0) {
-			close(fd);
-			return false;
-		}
-		oscap_buffer_append_binary_data(buffer, chunk, read_size);
-
-		// If reach end of file, then end the loop
-		if (chunk_size != read_size) {
-			break;
-		}
-	}
-
-	close(fd);
-
-	int length = oscap_buffer_get_length(buffer);
-	char* buffer_mem = oscap_buffer_get_raw(buffer);
-
-	if ( length == 0 ) { // empty file
-		return false;
-	} else {
-
-		// Skip multiple trailing zeros
-		int i = length - 1;
-		while ( (i > 0) && (buffer_mem[i] == '\0') ) {
-			--i;
-		}
-
-		// Program and args are separated by '\0'
-		// Replace them with spaces ' '
-		while( i >= 0 ){
-			char chr = buffer_mem[i];
-			if ( ( chr == '\0') || ( chr == '\n' ) ) {
-				buffer_mem[i] = ' ';
-			} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
-				buffer_mem[i] = '.';
-			}
-			--i;
-		}
-	}
-	return true;
-}
-
-/**
- * Make "[%s] <defunct>" from cmd string - inplace
- * @param cmd_buffer @see read_process() > cmd_buffer
- * @return pointer to start of string
- */
-static inline char *make_defunc_str(char* const cmd_buffer){
-	static const char DEFUNC_STR[] = "] <defunct>";
-
-	size_t len = strlen(cmd_buffer);
-	memcpy(cmd_buffer + len, DEFUNC_STR, sizeof(DEFUNC_STR));
-	return cmd_buffer;
-}
-
-static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
+static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx, procsnap_t *snap)
 {
 	int err = 1, max_cap_id;
-	DIR *d;
-	struct dirent *ent;
+	size_t i;
 	oval_schema_version_t oval_version;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	if (procsnap_load(snap) != 0)
 		return err;
 
 	// Get the time tick hertz
 	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	boot = procsnap_boot_time(snap);
 
 	oval_version = probe_obj_get_platform_schema_version(probe_ctx_getobject(ctx));
 	if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11)) < 0) {
@@ -456,71 +294,26 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		max_cap_id = OVAL_5_11_MAX_CAP_ID;
 	}
 
-	struct oscap_buffer *cmdline_buffer = oscap_buffer_new();
-	
 	char cmd_buffer[1 + 15 + 11 + 1]; // Format:" [ cmd:15 ] <defunc>"
-	cmd_buffer[0] = '[';
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	// Scan the snapshot of the process table
+	for (i = 0; i < procsnap_count(snap); ++i) {
+		procsnap_proc_t *p = procsnap_get(snap, i);
+		char tty_dev[128];
+		int pid = p->pid, ppid = p->ppid;
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd_buffer + 1, 0, sizeof(cmd_buffer)-1); // clear cmd after starting '['
-		sscanf(buf, "%d (%15c", &ppid, cmd_buffer + 1);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
-
 		const char* cmd;
-		if (state == 'Z') { // zombie
-			cmd = make_defunc_str(cmd_buffer);
+		if (p->state == 'Z') { // zombie
+			snprintf(cmd_buffer, sizeof(cmd_buffer), "[%s] <defunct>", p->comm);
+			cmd = cmd_buffer;
 		} else {
-			snprintf(buf, 32, "/proc/%d/cmdline", pid);
-			if (get_process_cmdline(buf, cmdline_buffer)) {
-				cmd = oscap_buffer_get_raw(cmdline_buffer); // use full cmdline
+			procsnap_attach(snap, p, PROCSNAP_CMDLINE);
+			if (p->cmdline != NULL) {
+				cmd = p->cmdline; // use full cmdline
 			} else {
-				cmd = cmd_buffer + 1;
+				cmd = p->comm;
 			}
 		}
 
@@ -533,7 +326,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		    (pid_sexp == NULL || probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE)
 		) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = p->utime/ticks + p->stime/ticks;
 			char tbuf[32], sbuf[32], *selinux_domain_label, **posix_capabilities;
 			int tday,tyear;
 			time_t s_time;
@@ -570,7 +363,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = boot + (p->start_time / ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -590,23 +383,27 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
 			r.pid = pid;
 			r.ppid = ppid;
-			r.priority = priority;
+			r.priority = p->priority;
 			r.start_time = sbuf;
 
-			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) p->tty_nr, pid, ABBREV_DEV);
 			r.tty = tty_dev;
 
 			r.exec_shield = (get_exec_shield_status(pid) > 0);
 
-			selinux_domain_label = get_selinux_label(pid);
+			procsnap_attach(snap, p, PROCSNAP_UIDS | PROCSNAP_LABEL);
+
+			selinux_domain_label = get_selinux_label(p);
 			r.selinux_domain_label = selinux_domain_label;
 
-			posix_capabilities = get_posix_capability(pid, max_cap_id);
+			posix_capabilities = get_posix_capability(p, max_cap_id);
 			r.posix_capability = posix_capabilities;
 
-			r.session_id = session;
+			r.session_id = p->session;
 
-			get_uids(pid, &r);
+			r.ruid = p->ruid;
+			r.user_id = p->euid;
+			r.loginuid = p->loginuid;
 			report_finding(&r, ctx);
 
 			if (selinux_domain_label != NULL)
@@ -622,11 +419,24 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
 	}
-        closedir(d);
-	oscap_buffer_free(cmdline_buffer);
 	return err;
 }
 
+void *probe_init(void)
+{
+	return procsnap_new();
+}
+
+void probe_fini(void *arg)
+{
+	procsnap_free(arg);
+}
+
+void probe_flush(void *arg)
+{
+	procsnap_reset(arg);
+}
+
 int probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *command_line_ent, *pid_ent;
@@ -637,7 +447,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 		return PROBE_ENOVAL;
 	}
 
-	if (read_process(command_line_ent, pid_ent, ctx)) {
+	if (read_process(command_line_ent, pid_ent, ctx, arg)) {
 		SEXP_free(command_line_ent);
 		SEXP_free(pid_ent);
 		return PROBE_EACCESS;
@@ -0,0 +1,638 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "alloc.h"
+#include "common/debug_priv.h"
+#include "procsnap.h"
+
+#ifndef PROCSNAP_PROCDIR
+#define PROCSNAP_PROCDIR "/proc"
+#endif
+
+/*
+ * Slot of the socket index, an open-addressing hash table keyed by the
+ * socket inode. proc is the index of the process plus one; 0 marks an
+ * empty slot.
+ */
+struct procsnap_sock {
+	unsigned long inode;
+	size_t        proc;
+};
+
+struct procsnap {
+	pthread_mutex_t  mutex;
+	int              loaded;
+	int              procfd;    /**< /proc */
+	unsigned long    boot_time; /**< btime from /proc/stat */
+
+	procsnap_proc_t *procs;     /**< in the order of the /proc entries */
+	size_t           count;
+
+	struct procsnap_sock *socks; /**< socket index, sock_mask + 1 slots */
+	size_t           sock_mask;
+	int              sock_indexed;
+	size_t           sock_denied;
+};
+
+procsnap_t *procsnap_new(void)
+{
+	procsnap_t *snap;
+
+	snap = oscap_talloc(procsnap_t);
+	memset(snap, 0, sizeof(procsnap_t));
+	snap->procfd = -1;
+	pthread_mutex_init(&snap->mutex, NULL);
+
+	return (snap);
+}
+
+static void procsnap_clear(procsnap_t *snap)
+{
+	size_t i;
+
+	for (i = 0; i < snap->count; ++i) {
+		oscap_free(snap->procs[i].cmdline);
+		oscap_free(snap->procs[i].label);
+		oscap_free(snap->procs[i].sockets);
+	}
+
+	if (snap->procfd != -1)
+		close(snap->procfd);
+
+	oscap_free(snap->procs);
+	oscap_free(snap->socks);
+
+	snap->loaded       = 0;
+	snap->procfd       = -1;
+	snap->boot_time    = 0;
+	snap->procs        = NULL;
+	snap->count        = 0;
+	snap->socks        = NULL;
+	snap->sock_mask    = 0;
+	snap->sock_indexed = 0;
+	snap->sock_denied  = 0;
+}
+
+void procsnap_free(procsnap_t *snap)
+{
+	if (snap == NULL)
+		return;
+
+	procsnap_clear(snap);
+	pthread_mutex_destroy(&snap->mutex);
+	oscap_free(snap);
+}
+
+void procsnap_reset(procsnap_t *snap)
+{
+	if (snap == NULL)
+		return;
+
+	pthread_mutex_lock(&snap->mutex);
+	procsnap_clear(snap);
+	pthread_mutex_unlock(&snap->mutex);
+}
+
+/*
+ * Read at most size - 1 bytes of a file relative to a directory (/proc or
+ * /proc/<pid>) and terminate them with a NUL byte. Returns the number of
+ * bytes read or -1.
+ */
+static ssize_t procsnap_read(int dirfd, const char *path, char *buf, size_t size)
+{
+	ssize_t len, ret = 0;
+	int fd;
+
+	fd = openat(dirfd, path, O_RDONLY);
+
+	if (fd < 0)
+		return (-1);
+
+	while ((size_t)ret < size - 1) {
+		len = read(fd, buf + ret, size - 1 - ret);
+
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			close(fd);
+			return (-1);
+		}
+		if (len == 0)
+			break;
+
+		ret += len;
+	}
+
+	close(fd);
+	buf[ret] = '\0';
+
+	return (ret);
+}
+
+/*
+ * Read a whole file relative to a directory into *buf (of *size bytes),
+ * growing the buffer as needed, and terminate it with a NUL byte. Returns
+ * the number of bytes read or -1.
+ */
+static ssize_t procsnap_read_all(int dirfd, const char *path, char **buf, size_t *size)
+{
+	ssize_t len;
+
+	/* the size of files in /proc isn't known, retry with a larger buffer */
+	while ((len = procsnap_read(dirfd, path, *buf, *size)) == (ssize_t)*size - 1) {
+		*size *= 2;
+		*buf = oscap_realloc(*buf, *size);
+	}
+
+	return (len);
+}
+
+static void procsnap_read_boot_time(procsnap_t *snap)
+{
+	char buf[4096], *btime;
+
+	if (procsnap_read(snap->procfd, "stat", buf, sizeof buf) < 0)
+		return;
+
+	btime = strstr(buf, "\nbtime ");
+
+	if (btime != NULL)
+		sscanf(btime, "\nbtime %lu", &snap->boot_time);
+}
+
+/*
+ * Parse the stat file of a process; path is relative to dirfd
+ */
+static int procsnap_parse_stat(int dirfd, const char *path, int pid, procsnap_proc_t *p)
+{
+	char buf[1024], *comm, *tmp;
+	unsigned flags;
+	int tpgid;
+	unsigned long minflt, cminflt, majflt, cmajflt;
+	long cutime, cstime, cnice, nthreads, itrealvalue;
+	size_t len;
+
+	if (procsnap_read(dirfd, path, buf, sizeof buf) < 40)
+		return (-1);
+
+	comm = strchr(buf, '(');
+	tmp  = strrchr(buf, ')');
+
+	if (comm == NULL || tmp == NULL || tmp < comm)
+		return (-1);
+
+	*tmp = '\0';
+	++comm;
+	len = strlen(comm);
+
+	if (len > sizeof p->comm - 1)
+		len = sizeof p->comm - 1;
+
+	memset(p, 0, sizeof(procsnap_proc_t));
+	memcpy(p->comm, comm, len);
+
+	p->pid = pid;
+
+	if (sscanf(tmp + 2, "%c %d %d %d %d %d "
+	                    "%u %lu %lu %lu %lu "
+	                    "%lu %lu %ld %ld %ld "
+	                    "%ld %ld %ld %llu",
+	           &p->state, &p->ppid, &p->pgrp, &p->session, &p->tty_nr, &tpgid,
+	           &flags, &minflt, &cminflt, &majflt, &cmajflt,
+	           &p->utime, &p->stime, &cutime, &cstime, &p->priority,
+	           &cnice, &nthreads, &itrealvalue, &p->start_time) < 2)
+		return (-1);
+
+	p->ruid     = -1;
+	p->euid     = -1;
+	p->loginuid = (unsigned)-1;
+
+	return (0);
+}
+
+int procsnap_load(procsnap_t *snap)
+{
+	DIR *d;
+	struct dirent *ent;
+	procsnap_proc_t proc;
+	char path[32];
+	size_t size = 0;
+	int pid, fd, ret = 0;
+
+	pthread_mutex_lock(&snap->mutex);
+
+	if (snap->loaded)
+		goto out;
+
+	snap->procfd = open(PROCSNAP_PROCDIR, O_RDONLY | O_DIRECTORY);
+
+	if (snap->procfd < 0) {
+		dE("Can't open " PROCSNAP_PROCDIR ": %u, %s\n", errno, strerror(errno));
+		ret = -1;
+		goto out;
+	}
+
+	fd = dup(snap->procfd);
+	d  = fd < 0 ? NULL : fdopendir(fd);
+
+	if (d == NULL) {
+		dE("Can't read " PROCSNAP_PROCDIR ": %u, %s\n", errno, strerror(errno));
+
+		if (fd >= 0)
+			close(fd);
+
+		close(snap->procfd);
+		snap->procfd = -1;
+		ret = -1;
+		goto out;
+	}
+
+	procsnap_read_boot_time(snap);
+
+	while ((ent = readdir(d)) != NULL) {
+		// Skip non-process dir entries
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, NULL, 10);
+		if (errno || pid == 2) // skip err & kthreads
+			continue;
+
+		snprintf(path, sizeof path, "%d/stat", pid);
+
+		if (procsnap_parse_stat(snap->procfd, path, pid, &proc) != 0)
+			continue;
+
+		// Skip kthreads
+		if (proc.ppid == 2)
+			continue;
+
+		if (snap->count == size) {
+			size = size > 0 ? size * 2 : 256;
+			snap->procs = oscap_realloc(snap->procs, sizeof(procsnap_proc_t) * size);
+		}
+
+		snap->procs[snap->count++] = proc;
+	}
+
+	closedir(d);
+
+	dI("Process table snapshot: %zu processes\n", snap->count);
+	snap->loaded = 1;
+out:
+	pthread_mutex_unlock(&snap->mutex);
+	return (ret);
+}
+
+size_t procsnap_count(const procsnap_t *snap)
+{
+	return (snap->count);
+}
+
+procsnap_proc_t *procsnap_get(procsnap_t *snap, size_t i)
+{
+	return (i < snap->count ? snap->procs + i : NULL);
+}
+
+unsigned long procsnap_boot_time(const procsnap_t *snap)
+{
+	return (snap->boot_time);
+}
+
+/*
+ * Parse the Uid and CapEff lines of a NUL terminated status file. The file
+ * is larger than a page on processes with many supplementary groups, so it
+ * has to be read whole.
+ */
+static void procsnap_parse_status(const char *buf, procsnap_proc_t *p)
+{
+	const char *line;
+
+	for (line = buf; *line != '\0'; ) {
+		if (strncmp(line, "Uid:", 4) == 0)
+			sscanf(line, "Uid: %d %d", &p->ruid, &p->euid);
+		else if (strncmp(line, "CapEff:", 7) == 0)
+			p->cap_valid = sscanf(line, "CapEff: %" SCNx64, &p->cap_eff) == 1;
+
+		if ((line = strchr(line, '\n')) == NULL)
+			break;
+		++line;
+	}
+}
+
+static void procsnap_attach_uids(int pidfd, procsnap_proc_t *p)
+{
+	char *buf;
+	size_t size = 4096;
+
+	buf = oscap_alloc(size);
+
+	if (procsnap_read_all(pidfd, "status", &buf, &size) > 0)
+		procsnap_parse_status(buf, p);
+
+	if (procsnap_read(pidfd, "loginuid", buf, size) > 0) {
+		if (sscanf(buf, "%u", &p->loginuid) < 1)
+			dW("sscanf failed from %d/loginuid\n", p->pid);
+	}
+
+	oscap_free(buf);
+}
+
+static void procsnap_attach_cmdline(int pidfd, procsnap_proc_t *p)
+{
+	char *buf;
+	size_t size = 1024;
+	ssize_t len, i;
+
+	buf = oscap_alloc(size);
+	len = procsnap_read_all(pidfd, "cmdline", &buf, &size);
+
+	if (len <= 0) {
+		oscap_free(buf);
+		return;
+	}
+
+	// Skip multiple trailing zeros
+	i = len - 1;
+	while (i > 0 && buf[i] == '\0')
+		--i;
+	buf[i + 1] = '\0';
+
+	// Program and args are separated by '\0'
+	// Replace them with spaces ' '
+	for (; i >= 0; --i) {
+		if (buf[i] == '\0' || buf[i] == '\n')
+			buf[i] = ' ';
+		else if (!isprint((unsigned char)buf[i])) // "ps" replace non-printable characters with '.' (LC_ALL=C)
+			buf[i] = '.';
+	}
+
+	p->cmdline = buf;
+}
+
+static void procsnap_attach_label(int pidfd, procsnap_proc_t *p)
+{
+	char buf[1024];
+	ssize_t len;
+
+	len = procsnap_read(pidfd, "attr/current", buf, sizeof buf);
+
+	while (len > 0 && (buf[len - 1] == '\0' || buf[len - 1] == '\n'))
+		buf[--len] = '\0';
+
+	if (len > 0)
+		p->label = strdup(buf);
+}
+
+static void procsnap_attach_sockets(int pidfd, procsnap_proc_t *p)
+{
+	char line[256], *s, *e;
+	DIR *d;
+	struct dirent *ent;
+	unsigned long inode;
+	size_t size = 0;
+	int fd, len;
+
+	fd = openat(pidfd, "fd", O_RDONLY | O_DIRECTORY);
+	d  = fd < 0 ? NULL : fdopendir(fd);
+
+	if (d == NULL) {
+		// Process might have ended or we don't have access
+		p->fd_errno = errno;
+
+		if (fd >= 0)
+			close(fd);
+
+		return;
+	}
+
+	// For each file in the fd dir...
+	while ((ent = readdir(d)) != NULL) {
+		if (ent->d_name[0] == '.')
+			continue;
+		if ((len = readlinkat(fd, ent->d_name, line, sizeof(line) - 1)) < 0)
+			continue;
+		line[len] = 0;
+
+		// Only look at the socket entries
+		if (strncmp(line, "socket:", 7) == 0) {
+			// Type 1 sockets
+			s = strchr(line + 7, '[');
+			if (s == NULL)
+				continue;
+			s++;
+			e = strchr(s, ']');
+			if (e == NULL)
+				continue;
+			*e = 0;
+		} else if (strncmp(line, "[0000]:", 7) == 0) {
+			// Type 2 sockets
+			s = line + 8;
+		} else
+			continue;
+		errno = 0;
+		inode = strtoul(s, NULL, 10);
+		if (errno)
+			continue;
+
+		if (p->socket_count == size) {
+			size = size > 0 ? size * 2 : 8;
+			p->sockets = oscap_realloc(p->sockets, sizeof(unsigned long) * size);
+		}
+
+		p->sockets[p->socket_count++] = inode;
+	}
+
+	closedir(d);
+}
+
+/*
+ * The files are read relative to /proc/<pid>, which stays bound to the
+ * process it was opened for. If the start time in its stat file differs
+ * from the snapshot, the process has exited and the pid was reused; the
+ * information is then left at the defaults.
+ */
+static void procsnap_attach_locked(procsnap_t *snap, procsnap_proc_t *p, uint32_t what)
+{
+	procsnap_proc_t cur;
+	char path[16];
+	int pidfd;
+
+	what &= ~p->attached;
+
+	if (what == 0)
+		return;
+
+	p->attached |= what;
+	snprintf(path, sizeof path, "%d", p->pid);
+
+	if ((pidfd = openat(snap->procfd, path, O_RDONLY | O_DIRECTORY)) < 0) {
+		if (what & PROCSNAP_SOCKETS)
+			p->fd_errno = errno;
+		return;
+	}
+
+	if (procsnap_parse_stat(pidfd, "stat", p->pid, &cur) != 0 || cur.start_time != p->start_time) {
+		dD("Process %d has exited, not reading its information\n", p->pid);
+
+		if (what & PROCSNAP_SOCKETS)
+			p->fd_errno = ESRCH;
+
+		close(pidfd);
+		return;
+	}
+
+	if (what & PROCSNAP_UIDS)
+		procsnap_attach_uids(pidfd, p);
+	if (what & PROCSNAP_CMDLINE)
+		procsnap_attach_cmdline(pidfd, p);
+	if (what & PROCSNAP_LABEL)
+		procsnap_attach_label(pidfd, p);
+	if (what & PROCSNAP_SOCKETS)
+		procsnap_attach_sockets(pidfd, p);
+
+	close(pidfd);
+}
+
+void procsnap_attach(procsnap_t *snap, procsnap_proc_t *proc, uint32_t what)
+{
+	pthread_mutex_lock(&snap->mutex);
+	procsnap_attach_locked(snap, proc, what);
+	pthread_mutex_unlock(&snap->mutex);
+}
+
+static size_t procsnap_sock_hash(unsigned long inode)
+{
+	uint64_t h = inode;
+
+	/* inodes are mostly sequential, spread them over the table */
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+
+	return ((size_t)h);
+}
+
+/*
+ * Read the descriptors of all processes and index their sockets. A
+ * socket shared by several processes keeps the first one, i.e. the one
+ * with the lowest /proc position.
+ */
+static void procsnap_index_sockets(procsnap_t *snap)
+{
+	size_t i, j, h, n = 0, size = 16;
+	procsnap_proc_t *p;
+
+	for (i = 0; i < snap->count; ++i) {
+		procsnap_attach_locked(snap, snap->procs + i, PROCSNAP_SOCKETS | PROCSNAP_UIDS);
+
+		if (snap->procs[i].fd_errno == EACCES)
+			++snap->sock_denied;
+
+		n += snap->procs[i].socket_count;
+	}
+
+	/* keep the load factor at or below 1/2 */
+	while (size < 2 * n)
+		size <<= 1;
+
+	snap->socks = oscap_alloc(sizeof(struct procsnap_sock) * size);
+	snap->sock_mask = size - 1;
+	memset(snap->socks, 0, sizeof(struct procsnap_sock) * size);
+
+	for (i = 0; i < snap->count; ++i) {
+		p = snap->procs + i;
+
+		for (j = 0; j < p->socket_count; ++j) {
+			h = procsnap_sock_hash(p->sockets[j]) & snap->sock_mask;
+
+			while (snap->socks[h].proc != 0 && snap->socks[h].inode != p->sockets[j])
+				h = (h + 1) & snap->sock_mask;
+
+			if (snap->socks[h].proc == 0) {
+				snap->socks[h].inode = p->sockets[j];
+				snap->socks[h].proc  = i + 1;
+			}
+		}
+	}
+
+	snap->sock_indexed = 1;
+}
+
+procsnap_proc_t *procsnap_find_socket(procsnap_t *snap, unsigned long inode)
+{
+	size_t h;
+	procsnap_proc_t *p = NULL;
+
+	pthread_mutex_lock(&snap->mutex);
+
+	if (!snap->sock_indexed)
+		procsnap_index_sockets(snap);
+
+	h = procsnap_sock_hash(inode) & snap->sock_mask;
+
+	while (snap->socks[h].proc != 0) {
+		if (snap->socks[h].inode == inode) {
+			p = snap->procs + snap->socks[h].proc - 1;
+			break;
+		}
+
+		h = (h + 1) & snap->sock_mask;
+	}
+
+	pthread_mutex_unlock(&snap->mutex);
+
+	return (p);
+}
+
+size_t procsnap_sockets_denied(procsnap_t *snap)
+{
+	size_t denied;
+
+	pthread_mutex_lock(&snap->mutex);
+
+	if (!snap->sock_indexed)
+		procsnap_index_sockets(snap);
+
+	denied = snap->sock_denied;
+	pthread_mutex_unlock(&snap->mutex);
+
+	return (denied);
+}
+
+#endif /* __linux__ */
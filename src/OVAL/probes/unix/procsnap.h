@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef PROCSNAP_H
+#define PROCSNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Snapshot of the process table shared by the probes that inspect
+ * running processes (process, process58, inetlisteningservers and
+ * iflisteners).
+ *
+ * /proc is walked once per scan, on the first call of procsnap_load()
+ * after the snapshot was created or reset; each /proc/<pid>/stat is
+ * parsed at that time. Further per-process information is read only when a probe
+ * asks for it using procsnap_attach() and is kept for the other objects;
+ * it's not read if the pid now belongs to another process.
+ * All files are opened relative to a /proc directory descriptor.
+ *
+ * Kernel threads (pid 2 and its children) are not part of the snapshot.
+ */
+#define PROCSNAP_UIDS    0x01 /**< uids, loginuid and effective capabilities */
+#define PROCSNAP_CMDLINE 0x02 /**< command line */
+#define PROCSNAP_LABEL   0x04 /**< SELinux context */
+#define PROCSNAP_SOCKETS 0x08 /**< inodes of the open sockets */
+
+typedef struct {
+	/* /proc/<pid>/stat */
+	int      pid;
+	int      ppid;
+	int      pgrp;
+	int      session;
+	int      tty_nr;
+	char     state;
+	char     comm[16];
+	unsigned long      utime;
+	unsigned long      stime;
+	long               priority;
+	unsigned long long start_time; /**< clock ticks after boot */
+
+	uint32_t attached; /**< PROCSNAP_* flags of the information read so far */
+
+	/* PROCSNAP_UIDS */
+	int      ruid;       /**< real uid or -1 */
+	int      euid;       /**< effective uid or -1 */
+	unsigned loginuid;   /**< (unsigned)-1 if unknown */
+	uint64_t cap_eff;    /**< effective capability set */
+	int      cap_valid;  /**< cap_eff was read */
+
+	/* PROCSNAP_CMDLINE */
+	char    *cmdline;    /**< arguments separated by spaces, as shown by ps; NULL if empty */
+
+	/* PROCSNAP_LABEL */
+	char    *label;      /**< security context or NULL */
+
+	/* PROCSNAP_SOCKETS */
+	unsigned long *sockets;
+	size_t   socket_count;
+	int      fd_errno;   /**< errno of opening /proc/<pid>/fd or 0 */
+} procsnap_proc_t;
+
+typedef struct procsnap procsnap_t;
+
+procsnap_t *procsnap_new(void);
+void procsnap_free(procsnap_t *snap);
+
+/**
+ * Drop the snapshot; the next procsnap_load() walks /proc again. Processes
+ * returned by procsnap_get() and procsnap_find_socket() must not be used
+ * anymore. Called from probe_flush(); the probe reset waits for the workers
+ * before that, so no object is being collected.
+ */
+void procsnap_reset(procsnap_t *snap);
+
+/**
+ * Walk /proc unless already done. Returns 0 on success, -1 if /proc
+ * can't be read.
+ */
+int procsnap_load(procsnap_t *snap);
+
+size_t procsnap_count(const procsnap_t *snap);
+procsnap_proc_t *procsnap_get(procsnap_t *snap, size_t i);
+unsigned long procsnap_boot_time(const procsnap_t *snap);
+
+/**
+ * Read the requested information of a process unless already done.
+ * Information that can't be read is left at the defaults described above.
+ */
+void procsnap_attach(procsnap_t *snap, procsnap_proc_t *proc, uint32_t what);
+
+/**
+ * Find the first process in the snapshot that has the socket open.
+ * Attaches PROCSNAP_SOCKETS and PROCSNAP_UIDS to all processes and builds
+ * an inode hash table on the first call.
+ */
+procsnap_proc_t *procsnap_find_socket(procsnap_t *snap, unsigned long inode);
+
+/**
+ * Number of processes whose descriptors couldn't be listed because of
+ * missing permissions.
+ */
+size_t procsnap_sockets_denied(procsnap_t *snap);
+
+#endif /* PROCSNAP_H */
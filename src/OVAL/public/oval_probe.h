@@ -85,5 +85,14 @@ int oval_probe_query_variable(oval_probe_session_t *sess, struct oval_variable *
 void oval_probe_meta_list(FILE *output, int flags);
 
 const char *oval_probe_ext_getdir(void);
+
+/**
+ * Get the usage counters of the persistent probe cache, summed over all
+ * probes closed so far. The cache is used by the probes if the
+ * OSCAP_PROBE_CACHE_DIR environment variable names its directory.
+ * @param lookups where to store the number of objects looked up in the cache
+ * @param hits where to store the number of objects found in the cache
+ */
+void oval_probe_cache_stats(uint64_t *lookups, uint64_t *hits);
 #endif				/* OVAL_PROBE_H */
 /// @}
@@ -39,7 +39,9 @@ typedef struct oval_ph    oval_ph_t;
  * Type of the handler function. This function takes care of handling
  * all the actions defined bellow, that is: initialization, freeing,
  * opening, evaluating, reseting and closing (whatever that means in
- * your particular case).
+ * your particular case). The PROBE_HANDLER_ACT_RESET action takes one
+ * additional argument: a list of object and state ids whose cached results
+ * should be dropped or NULL to drop everything.
  */
 typedef int (oval_probe_handler_t)(oval_subtype_t, void *, int, ...);
 
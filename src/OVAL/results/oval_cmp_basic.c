@@ -29,6 +29,7 @@
 #include <string.h>
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
+#include "oval_regex_cache_impl.h"
 #elif defined USE_REGEX_POSIX
 #include <regex.h>
 #endif
@@ -129,18 +130,18 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 	int ret;
 	oval_result_t result = OVAL_RESULT_ERROR;
 #if defined USE_REGEX_PCRE
-	pcre *re;
+	oval_regex_t *re;
 	const char *err;
 	int errofs;
 
-	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+	re = oval_regex_get(pattern, PCRE_UTF8, &err, &errofs);
 	if (re == NULL) {
 		oscap_dlprintf(DBG_E, "Unable to compile regex pattern, "
 			       "pcre_compile() returned error (offset: %d): '%s'.\n", errofs, err);
 		return OVAL_RESULT_ERROR;
 	}
 
-	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
+	ret = oval_regex_exec(re, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == -1) {
@@ -151,7 +152,7 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		result = OVAL_RESULT_ERROR;
 	}
 
-	pcre_free(re);
+	oval_regex_put(re);
 #elif defined USE_REGEX_POSIX
 	regex_t re;
 
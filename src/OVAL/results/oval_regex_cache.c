@@ -0,0 +1,229 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <pcre.h>
+
+#include "common/alloc.h"
+#include "common/debug_priv.h"
+#include "oval_regex_cache_impl.h"
+
+#define OVAL_REGEX_CACHE_HSIZE 256
+
+/*
+ * A cache is owned by an evaluation session and shared by all threads
+ * working for it (probe workers compare entities concurrently). Cached
+ * entries are never modified after they are inserted, so they can be
+ * used without holding the lock; pcre_exec() doesn't modify the compiled
+ * pattern.
+ */
+struct oval_regex_cache {
+	pthread_mutex_t         lock;
+	uint32_t                max_entries;
+	struct oval_regex_stats stats;
+	oval_regex_t           *table[OVAL_REGEX_CACHE_HSIZE];
+};
+
+/* cache used by oval_regex_get() in the calling thread */
+static __thread oval_regex_cache_t *__regex_cache_cur = NULL;
+
+static uint32_t oval_regex_hash(const char *pattern, int options)
+{
+	uint32_t h = 2166136261U; /* FNV-1a */
+
+	while (*pattern != '\0') {
+		h ^= (uint8_t)*pattern++;
+		h *= 16777619U;
+	}
+
+	return (h ^ (uint32_t)options);
+}
+
+static oval_regex_t *oval_regex_lookup(oval_regex_cache_t *cache, const char *pattern, int options, uint32_t hash)
+{
+	oval_regex_t *r;
+
+	for (r = cache->table[hash % OVAL_REGEX_CACHE_HSIZE]; r != NULL; r = r->next) {
+		if (r->hash == hash && r->options == options && strcmp(r->pattern, pattern) == 0)
+			return (r);
+	}
+
+	return (NULL);
+}
+
+static void oval_regex_free(oval_regex_t *regex)
+{
+	if (regex->extra != NULL) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study(regex->extra);
+#else
+		pcre_free(regex->extra);
+#endif
+	}
+
+	pcre_free(regex->re);
+	oscap_free(regex->pattern);
+	oscap_free(regex);
+}
+
+oval_regex_t *oval_regex_get(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	oval_regex_cache_t *cache = __regex_cache_cur;
+	oval_regex_t *regex, *cached;
+	const char   *err = NULL;
+	int           errofs = -1;
+	uint32_t      hash;
+	pcre         *re;
+
+	hash = oval_regex_hash(pattern, options);
+
+	if (cache != NULL) {
+		pthread_mutex_lock(&cache->lock);
+
+		if ((regex = oval_regex_lookup(cache, pattern, options, hash)) != NULL) {
+			++cache->stats.hits;
+			pthread_mutex_unlock(&cache->lock);
+			return (regex);
+		}
+
+		++cache->stats.misses;
+		pthread_mutex_unlock(&cache->lock);
+	}
+
+	/*
+	 * Compile without holding the lock. If another thread compiles
+	 * the same pattern in the meantime, its version is used.
+	 */
+	re = pcre_compile(pattern, options, &err, &errofs, NULL);
+
+	if (re == NULL) {
+		if (errptr != NULL)
+			*errptr = err;
+		if (erroffset != NULL)
+			*erroffset = errofs;
+		return (NULL);
+	}
+
+	regex = oscap_talloc(oval_regex_t);
+	regex->re      = re;
+#ifdef PCRE_STUDY_JIT_COMPILE
+	regex->extra   = pcre_study(re, PCRE_STUDY_JIT_COMPILE, &err);
+#else
+	regex->extra   = pcre_study(re, 0, &err);
+#endif
+	regex->options = options;
+	regex->pattern = oscap_strdup(pattern);
+	regex->hash    = hash;
+	regex->cached  = 0;
+	regex->next    = NULL;
+
+	if (cache == NULL)
+		return (regex);
+
+	pthread_mutex_lock(&cache->lock);
+
+	if ((cached = oval_regex_lookup(cache, pattern, options, hash)) != NULL) {
+		pthread_mutex_unlock(&cache->lock);
+		oval_regex_free(regex);
+		return (cached);
+	}
+
+	if (cache->stats.entries < cache->max_entries) {
+		regex->cached = 1;
+		regex->next   = cache->table[hash % OVAL_REGEX_CACHE_HSIZE];
+		cache->table[hash % OVAL_REGEX_CACHE_HSIZE] = regex;
+		++cache->stats.entries;
+	} else
+		++cache->stats.uncached;
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return (regex);
+}
+
+int oval_regex_exec(const oval_regex_t *regex, const char *subject, size_t length,
+		    int start, int options, int *ovector, int ovecsize)
+{
+	return pcre_exec(regex->re, regex->extra, subject, (int)length,
+			 start, options, ovector, ovecsize);
+}
+
+void oval_regex_put(oval_regex_t *regex)
+{
+	if (regex != NULL && !regex->cached)
+		oval_regex_free(regex);
+}
+
+oval_regex_cache_t *oval_regex_cache_new(uint32_t max_entries)
+{
+	oval_regex_cache_t *cache;
+
+	cache = oscap_calloc(1, sizeof(oval_regex_cache_t));
+
+	if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+		oscap_free(cache);
+		return (NULL);
+	}
+
+	cache->max_entries = max_entries;
+
+	return (cache);
+}
+
+oval_regex_cache_t *oval_regex_cache_set(oval_regex_cache_t *cache)
+{
+	oval_regex_cache_t *prev = __regex_cache_cur;
+
+	__regex_cache_cur = cache;
+
+	return (prev);
+}
+
+void oval_regex_cache_stats(oval_regex_cache_t *cache, struct oval_regex_stats *stats)
+{
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+void oval_regex_cache_free(oval_regex_cache_t *cache)
+{
+	oval_regex_t *r, *n;
+	size_t i;
+
+	if (cache == NULL)
+		return;
+
+	for (i = 0; i < OVAL_REGEX_CACHE_HSIZE; ++i) {
+		for (r = cache->table[i]; r != NULL; r = n) {
+			n = r->next;
+			oval_regex_free(r);
+		}
+	}
+
+	pthread_mutex_destroy(&cache->lock);
+	oscap_free(cache);
+}
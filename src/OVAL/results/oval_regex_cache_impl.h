@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef OSCAP_OVAL_REGEX_CACHE_IMPL_H_
+#define OSCAP_OVAL_REGEX_CACHE_IMPL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pcre.h>
+#include "../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+#ifndef OVAL_REGEX_CACHE_MAX
+# define OVAL_REGEX_CACHE_MAX 1024 /**< default maximal number of patterns cached by a session */
+#endif
+
+/**
+ * Compiled pattern. The pcre and pcre_extra pointers can be passed
+ * directly to pcre_exec() and pcre_fullinfo().
+ */
+typedef struct oval_regex {
+	pcre       *re;
+	pcre_extra *extra;   /**< result of pcre_study(); may be NULL */
+	int         options; /**< compile options */
+	char       *pattern;
+	uint32_t    hash;
+	int         cached;  /**< owned by the cache; don't free on put */
+	struct oval_regex *next;
+} oval_regex_t;
+
+typedef struct oval_regex_cache oval_regex_cache_t;
+
+struct oval_regex_stats {
+	uint64_t hits;     /**< lookups served from the cache */
+	uint64_t misses;   /**< lookups which required a compilation */
+	uint64_t uncached; /**< compiled patterns not stored because the cache was full */
+	uint32_t entries;  /**< number of cached patterns */
+};
+
+/**
+ * Get a compiled pattern. The pattern is compiled and studied (using the JIT
+ * compiler if available) on the first use and shared by all later callers
+ * using the same cache. Without a cache set in the calling thread (see
+ * oval_regex_cache_set()), the pattern is compiled for this caller only.
+ * The returned pattern must be released using oval_regex_put().
+ * @param pattern regular expression
+ * @param options pcre_compile() options
+ * @param errptr where to store the pcre_compile() error message (may be NULL)
+ * @param erroffset where to store the pcre_compile() error offset (may be NULL)
+ * @return compiled pattern or NULL if the pattern can't be compiled
+ */
+oval_regex_t *oval_regex_get(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/**
+ * Execute a compiled pattern. Same as pcre_exec() with the study data
+ * of the pattern.
+ */
+int oval_regex_exec(const oval_regex_t *regex, const char *subject, size_t length,
+		    int start, int options, int *ovector, int ovecsize);
+
+/**
+ * Release a pattern obtained using oval_regex_get().
+ */
+void oval_regex_put(oval_regex_t *regex);
+
+/**
+ * Create a cache of compiled patterns.
+ * @param max_entries maximal number of cached patterns; patterns beyond
+ *        the limit are compiled for each caller
+ */
+oval_regex_cache_t *oval_regex_cache_new(uint32_t max_entries);
+
+/**
+ * Set the cache used by oval_regex_get() in the calling thread.
+ * @param cache cache to use, NULL for none
+ * @return the previously set cache, to be restored by the caller
+ */
+oval_regex_cache_t *oval_regex_cache_set(oval_regex_cache_t *cache);
+
+/**
+ * Get the cache statistics.
+ */
+void oval_regex_cache_stats(oval_regex_cache_t *cache, struct oval_regex_stats *stats);
+
+/**
+ * Free the cache and all cached patterns. Must not be called while
+ * a pattern obtained from the cache is in use or while the cache is
+ * set in any thread.
+ */
+void oval_regex_cache_free(oval_regex_cache_t *cache);
+
+OSCAP_HIDDEN_END;
+
+#endif
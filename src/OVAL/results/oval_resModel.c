@@ -219,11 +219,12 @@ int oval_results_model_eval(struct oval_results_model *res_model)
 	return 0;
 }
 
-static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
-				    struct oval_directives_model *directives_model, 
-				    xmlDocPtr doc, xmlNode * parent)
+static int oval_results_to_dom(struct oval_results_model *results_model,
+			       struct oval_directives_model *directives_model, 
+			       xmlDocPtr doc, xmlNode * parent, xmlTextWriterPtr writer)
 {
 	xmlNode *root_node;
+	int ret = 0;
 	struct oval_result_directives * dirs;
 	struct oval_directives_model * dirs_model;
 
@@ -240,59 +241,97 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 
 	xmlSetNs(root_node, ns_common);
 	xmlSetNs(root_node, ns_results);
+	if (oscap_xml_writer_start_node(writer, root_node) != 0)
+		ret = -1;
 
 	/* Report generator */
-	oval_generator_to_dom(results_model->generator, doc, root_node);
+	if (ret == 0 && oscap_xml_writer_flush_node(writer, oval_generator_to_dom(results_model->generator, doc, root_node)) != 0)
+		ret = -1;
 
 	/* Report default directives and class directives from internal or external
 	 * directives model(if provided) */
 	dirs_model = (directives_model) ? directives_model : results_model->directives_model;
 	oval_directives_model_to_dom(dirs_model, doc, root_node);
+	if (writer != NULL) {
+		/* directives and class_directives are added straight to the root */
+		while (root_node->children != NULL) {
+			if (oscap_xml_writer_flush_node(writer, root_node->children) != 0)
+				ret = -1;
+		}
+	}
 
 	dirs = oval_directives_model_get_defdirs(dirs_model);
 
 	/* Report definitions */
-	if(oval_result_directives_get_included(dirs)) {
+	if (ret == 0 && oval_result_directives_get_included(dirs)) {
 		struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
-		oval_definition_model_to_dom(definition_model, doc, root_node);
+		if (oval_definition_model_to_dom(definition_model, doc, root_node, writer) != 0)
+			ret = -1;
 	}
 
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
+	if (ret == 0 && oscap_xml_writer_start_node(writer, results_node) != 0)
+		ret = -1;
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
-	while (oval_result_system_iterator_has_more(systems)) {
+	while (ret == 0 && oval_result_system_iterator_has_more(systems)) {
 		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
-		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node);
+		if (oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node, writer) != 0)
+			ret = -1;
 	}
 	oval_result_system_iterator_free(systems);
 
-	return root_node;
+	if (oscap_xml_writer_end_node(writer, results_node) != 0)
+		ret = -1;
+	if (oscap_xml_writer_end_node(writer, root_node) != 0)
+		ret = -1;
+
+	return ret;
 }
 
-struct oscap_source *oval_results_model_export_source(struct oval_results_model *results_model, struct oval_directives_model *directives_model, const char *name)
+struct oval_results_export {
+	struct oval_results_model *results_model;
+	struct oval_directives_model *directives_model;
+};
+
+static int oval_results_write(xmlTextWriterPtr writer, void *arg)
 {
-	__attribute__nonnull__(results_model);
+	struct oval_results_export *exp = arg;
 
+	/* The document holds only the elements being written, i.e. a single
+	 * definition, test or item at a time, next to their ancestors. */
 	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
 	if (doc == NULL) {
 		oscap_setxmlerr(xmlGetLastError());
-		return NULL;
+		return -1;
 	}
 
-	oval_results_to_dom(results_model, directives_model, doc, NULL);
-	return oscap_source_new_from_xmlDoc(doc, name);
+	int ret = oval_results_to_dom(exp->results_model, exp->directives_model, doc, NULL, writer);
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+struct oscap_source *oval_results_model_export_source(struct oval_results_model *results_model, struct oval_directives_model *directives_model, const char *name)
+{
+	__attribute__nonnull__(results_model);
+
+	struct oval_results_export exp = { results_model, directives_model };
+	char *buffer;
+	size_t size;
+
+	if (oscap_xml_save_writer_memory(&buffer, &size, oval_results_write, &exp) != 0)
+		return NULL;
+
+	return oscap_source_new_take_memory(buffer, size, name);
 }
 
 int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
-		return -1;
-	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
-	return ret;
+	__attribute__nonnull__(results_model);
+
+	struct oval_results_export exp = { results_model, directives_model };
+	return oscap_xml_save_writer(file, oval_results_write, &exp) == 1 ? 0 : -1;
 }
 
 int oval_results_model_parse(xmlTextReaderPtr reader, struct oval_parser_context *context) {
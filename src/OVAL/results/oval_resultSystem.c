@@ -50,6 +50,7 @@
 #include "common/debug_priv.h"
 #include "common/_error.h"
 #include "common/util.h"
+#include "common/elements.h"
 
 typedef struct oval_result_system {
 	struct oval_results_model *model;
@@ -383,17 +384,19 @@ int oval_result_system_eval_definition(struct oval_result_system *sys, const cha
 	return 0;
 }
 
-static void _oval_result_definition_to_dom_based_on_directives(struct oval_result_definition *rslt_definition,
+static int _oval_result_definition_to_dom_based_on_directives(struct oval_result_definition *rslt_definition,
 						   struct oval_result_directives * directives,
 						   xmlDocPtr doc,
 						   xmlNode *definitions_node,
-						   struct oval_smc *tstmap)
+						   struct oval_smc *tstmap,
+						   xmlTextWriterPtr writer)
 {
 	oval_result_t result = oval_result_definition_get_result(rslt_definition);
 	if (oval_result_directives_get_reported(directives, result)) {
 		oval_result_directive_content_t content = oval_result_directives_get_content(directives, result);
 		/* report definition according to directives settings */
-		oval_result_definition_to_dom(rslt_definition, content, doc, definitions_node);
+		if (oscap_xml_writer_flush_node(writer, oval_result_definition_to_dom(rslt_definition, content, doc, definitions_node)) != 0)
+			return -1;
 		if (content == OVAL_DIRECTIVE_CONTENT_FULL) {
 			struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(rslt_definition);
 			/* collect the tests that are referenced from reported definitions */
@@ -401,12 +404,13 @@ static void _oval_result_definition_to_dom_based_on_directives(struct oval_resul
 				_oval_result_system_scan_criteria_for_references(criteria, tstmap);
 		}
 	}
+	return 0;
 }
 
-xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
-				   struct oval_results_model * results_model,
-				   struct oval_directives_model * directives_model, 
-				   xmlDocPtr doc, xmlNode * parent) {
+int oval_result_system_to_dom(struct oval_result_system * sys,
+			      struct oval_results_model * results_model,
+			      struct oval_directives_model * directives_model, 
+			      xmlDocPtr doc, xmlNode * parent, xmlTextWriterPtr writer) {
 
 	struct oval_result_directives * directives;
 	struct oval_result_directives * class_dirs;
@@ -414,13 +418,18 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 
 	xmlNs *ns_results = xmlSearchNsByHref(doc, parent, OVAL_RESULTS_NAMESPACE);
 	xmlNode *system_node = xmlNewTextChild(parent, ns_results, BAD_CAST "system", NULL);
+	int ret = 0;
+	if (oscap_xml_writer_start_node(writer, system_node) != 0)
+		ret = -1;
 
 	struct oval_smc *tstmap = oval_smc_new();
 
 	xmlNode *definitions_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "definitions", NULL);
+	if (ret == 0 && oscap_xml_writer_start_node(writer, definitions_node) != 0)
+		ret = -1;
 	struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
 	struct oval_definition_iterator *oval_definitions = oval_definition_model_get_definitions(definition_model);
-	while(oval_definition_iterator_has_more(oval_definitions)) {
+	while (ret == 0 && oval_definition_iterator_has_more(oval_definitions)) {
 		struct oval_definition *oval_definition = oval_definition_iterator_next(oval_definitions);
 
 		oval_definition_class_t def_class = oval_definition_get_class(oval_definition);
@@ -430,9 +439,10 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 		bool exported = false;
 		struct oval_iterator *rslt_definitions_it = oval_smc_get_all_it(sys->definitions, oval_definition_get_id(oval_definition));
 		if (rslt_definitions_it != NULL) {
-			while (oval_collection_iterator_has_more(rslt_definitions_it)) {
+			while (ret == 0 && oval_collection_iterator_has_more(rslt_definitions_it)) {
 				struct oval_result_definition *rslt_definition = oval_collection_iterator_next(rslt_definitions_it);
-				_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
+				if (_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap, writer) != 0)
+					ret = -1;
 				exported = true;
 			}
 			oval_collection_iterator_free(rslt_definitions_it);
@@ -440,11 +450,14 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 		if (!exported) {
 			struct oval_result_definition *rslt_definition = oval_result_system_get_new_definition(sys, oval_definition, 1);
 			if (rslt_definition) {
-				_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
+				if (_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap, writer) != 0)
+					ret = -1;
 			}
 		}
 	}
 	oval_definition_iterator_free(oval_definitions);
+	if (oscap_xml_writer_end_node(writer, definitions_node) != 0)
+		ret = -1;
 
 	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
 	struct oval_string_map *sysmap = oval_string_map_new();
@@ -453,13 +466,16 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	struct oval_string_map *varmap = oval_string_map_new();
 
 	struct oval_smc_iterator *result_tests = oval_smc_iterator_new(tstmap);
-	if (oval_smc_iterator_has_more(result_tests)) {
+	if (ret == 0 && oval_smc_iterator_has_more(result_tests)) {
 		xmlNode *tests_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "tests", NULL);
-		while (oval_smc_iterator_has_more(result_tests)) {
+		if (oscap_xml_writer_start_node(writer, tests_node) != 0)
+			ret = -1;
+		while (ret == 0 && oval_smc_iterator_has_more(result_tests)) {
 			struct oval_state_iterator *ste_itr;
 			struct oval_result_test *result_test = oval_smc_iterator_next(result_tests);
 			/* report the test */
-			oval_result_test_to_dom(result_test, doc, tests_node);
+			if (oscap_xml_writer_flush_node(writer, oval_result_test_to_dom(result_test, doc, tests_node)) != 0)
+				ret = -1;
 			struct oval_test *oval_test = oval_result_test_get_test(result_test);
 			/* collect the objects that are referenced from reported test */
 			/* look for objects in path: test->object ...  */
@@ -494,11 +510,14 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 			}
 			oval_state_iterator_free(ste_itr);
 		}
+		if (oscap_xml_writer_end_node(writer, tests_node) != 0)
+			ret = -1;
 	}
 	oval_smc_iterator_free(result_tests);
 
-	oval_syschar_model_to_dom(syschar_model, doc, system_node, 
-				  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap);
+	if (ret == 0 && oval_syschar_model_to_dom(syschar_model, doc, system_node,
+						  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap, writer) != 0)
+		ret = -1;
 
 	oval_string_map_free(sysmap, NULL);
 	oval_string_map_free(objmap, NULL);
@@ -506,7 +525,10 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	oval_string_map_free(varmap, NULL);
 	oval_smc_free0(tstmap);
 
-	return system_node;
+	if (oscap_xml_writer_end_node(writer, system_node) != 0)
+		ret = -1;
+
+	return ret;
 }
 
 
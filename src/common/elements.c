@@ -28,6 +28,7 @@
 #include <config.h>
 #endif
 
+#include <limits.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -265,3 +266,283 @@ xmlNs *lookup_xsi_ns(xmlDoc *doc)
 	}
 	return ns_xsi;
 }
+
+static int _oscap_xml_write_document(xmlOutputBufferPtr buff, oscap_xml_writer_func func, void *arg)
+{
+	xmlTextWriterPtr writer = xmlNewTextWriter(buff);
+	if (writer == NULL) {
+		xmlOutputBufferClose(buff);
+		oscap_setxmlerr(xmlGetLastError());
+		return -1;
+	}
+
+	/* Indentation is done by oscap_xml_writer_*_node(), see below. */
+	int ret = -1;
+	if (xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL) >= 0
+	    && func(writer, arg) == 0
+	    && xmlTextWriterEndDocument(writer) >= 0
+	    && xmlTextWriterFlush(writer) >= 0)
+		ret = 0;
+
+	if (ret != 0) {
+		if (xmlGetLastError() != NULL)
+			oscap_setxmlerr(xmlGetLastError());
+		else if (!oscap_err())
+			oscap_seterr(OSCAP_EFAMILY_XML, "Could not write the XML document.");
+	}
+
+	xmlFreeTextWriter(writer); // closes the output buffer
+	return ret;
+}
+
+int oscap_xml_save_writer(const char *filename, oscap_xml_writer_func func, void *arg)
+{
+	xmlOutputBufferPtr buff;
+	int fd, ret;
+
+	if (strcmp(filename, "-") == 0) {
+		fd = STDOUT_FILENO;
+	} else {
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			return -1;
+		}
+	}
+
+	buff = xmlOutputBufferCreateFd(fd, NULL);
+	if (buff == NULL) {
+		if (fd != STDOUT_FILENO)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		oscap_dlprintf(DBG_W, "xmlOutputBufferCreateFd() failed.\n");
+		return -1;
+	}
+
+	ret = _oscap_xml_write_document(buff, func, arg);
+	if (fd != STDOUT_FILENO)
+		close(fd);
+
+	if (ret != 0)
+		oscap_dlprintf(DBG_W, "Streaming the document to '%s' failed.\n", filename);
+
+	return (ret == 0) ? 1 : -1;
+}
+
+struct oscap_xml_membuf {
+	char *data;
+	size_t size;
+	size_t alloc;
+};
+
+static int _oscap_xml_membuf_write(void *context, const char *buffer, int len)
+{
+	struct oscap_xml_membuf *mb = context;
+
+	if (mb->size + len > mb->alloc) {
+		do
+			mb->alloc = mb->alloc > 0 ? mb->alloc * 2 : 64 * 1024;
+		while (mb->size + len > mb->alloc);
+
+		mb->data = oscap_realloc(mb->data, mb->alloc);
+	}
+
+	memcpy(mb->data + mb->size, buffer, len);
+	mb->size += len;
+	return len;
+}
+
+int oscap_xml_save_writer_memory(char **buffer, size_t *size, oscap_xml_writer_func func, void *arg)
+{
+	struct oscap_xml_membuf mb = { NULL, 0, 0 };
+	xmlOutputBufferPtr buff;
+
+	buff = xmlOutputBufferCreateIO(_oscap_xml_membuf_write, NULL, &mb, NULL);
+	if (buff == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		return -1;
+	}
+
+	if (_oscap_xml_write_document(buff, func, arg) != 0) {
+		oscap_free(mb.data);
+		return -1;
+	}
+
+	*buffer = mb.data;
+	*size = mb.size;
+	return 0;
+}
+
+/*
+ * The writer doesn't indent elements mixed with raw content, so the
+ * functions below indent the output like xmlSaveFormatFileEnc() does.
+ *
+ * The _private member of a started skeleton node remembers what has been
+ * written: an element gets its end tag on a separate line if anything was
+ * written into it, and namespaces declared on the node after its start
+ * tag was written (e.g. by lookup_xsi_ns()) have to be declared again in
+ * the subtrees which use them.
+ */
+struct oscap_xml_writer_state {
+	xmlNsPtr last_ns;  ///< last namespace declared in the start tag
+	bool has_content;
+};
+
+static int _oscap_xml_node_level(xmlNodePtr node)
+{
+	int level = 0;
+	for (xmlNodePtr p = node->parent; p != NULL && p->type == XML_ELEMENT_NODE; p = p->parent)
+		++level;
+	return level;
+}
+
+static int _oscap_xml_writer_indent(xmlTextWriterPtr writer, int level)
+{
+	if (xmlTextWriterWriteRawLen(writer, BAD_CAST "\n", 1) < 0)
+		return -1;
+	for (int i = 0; i < level; ++i) {
+		if (xmlTextWriterWriteRawLen(writer, BAD_CAST "  ", 2) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* indent a child node which is about to be written */
+static int _oscap_xml_writer_indent_child(xmlTextWriterPtr writer, xmlNodePtr node)
+{
+	int level = _oscap_xml_node_level(node);
+	if (level == 0)
+		return 0;
+
+	struct oscap_xml_writer_state *state = node->parent->_private;
+	if (state == NULL)
+		return -1; /* the parent wasn't started */
+	state->has_content = true;
+	return _oscap_xml_writer_indent(writer, level) < 0 ? -1 : level;
+}
+
+int oscap_xml_writer_start_node(xmlTextWriterPtr writer, xmlNodePtr node)
+{
+	if (writer == NULL)
+		return 0;
+
+	if (_oscap_xml_writer_indent_child(writer, node) < 0)
+		return -1;
+
+	const xmlChar *prefix = node->ns != NULL ? node->ns->prefix : NULL;
+	if (xmlTextWriterStartElementNS(writer, prefix, node->name, NULL) < 0)
+		return -1;
+
+	struct oscap_xml_writer_state *state = oscap_calloc(1, sizeof(struct oscap_xml_writer_state));
+	node->_private = state;
+
+	for (xmlNsPtr ns = node->nsDef; ns != NULL; ns = ns->next) {
+		int ret;
+		state->last_ns = ns;
+		if (ns->prefix != NULL)
+			ret = xmlTextWriterWriteAttributeNS(writer, BAD_CAST "xmlns", ns->prefix, NULL, ns->href);
+		else
+			ret = xmlTextWriterWriteAttribute(writer, BAD_CAST "xmlns", ns->href);
+		if (ret < 0)
+			return -1;
+	}
+
+	for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+		xmlChar *value = xmlNodeGetContent((xmlNodePtr) attr);
+		const xmlChar *attr_prefix = attr->ns != NULL ? attr->ns->prefix : NULL;
+		int ret = xmlTextWriterWriteAttributeNS(writer, attr_prefix, attr->name, NULL,
+				value != NULL ? value : BAD_CAST "");
+		xmlFree(value);
+		if (ret < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+int oscap_xml_writer_end_node(xmlTextWriterPtr writer, xmlNodePtr node)
+{
+	if (writer == NULL)
+		return 0;
+
+	/* the start tag of a node without a state wasn't written */
+	struct oscap_xml_writer_state *state = node->_private;
+	int ret = state != NULL ? 0 : -1;
+	if (state != NULL && state->has_content)
+		ret = _oscap_xml_writer_indent(writer, _oscap_xml_node_level(node));
+	if (ret >= 0)
+		ret = xmlTextWriterEndElement(writer);
+
+	oscap_free(state);
+	node->_private = NULL;
+	xmlUnlinkNode(node);
+	xmlFreeNode(node);
+	return ret < 0 ? -1 : 0;
+}
+
+int oscap_xml_writer_flush_node(xmlTextWriterPtr writer, xmlNodePtr node)
+{
+	if (writer == NULL || node == NULL)
+		return 0;
+
+	/* Namespaces added to the started ancestors too late */
+	for (xmlNodePtr p = node->parent; p != NULL && p->type == XML_ELEMENT_NODE; p = p->parent) {
+		struct oscap_xml_writer_state *state = p->_private;
+		if (state == NULL) {
+			/* the ancestor wasn't started, its start has failed */
+			xmlUnlinkNode(node);
+			xmlFreeNode(node);
+			return -1;
+		}
+		xmlNsPtr ns = state->last_ns != NULL ? state->last_ns->next : p->nsDef;
+		for (; ns != NULL; ns = ns->next) {
+			if (xmlSearchNs(node->doc, node, ns->prefix) == ns)
+				xmlNewNs(node, ns->href, ns->prefix);
+		}
+	}
+
+	/* Serialize the subtree the way xmlSaveFormatFileEnc() would and
+	 * pass it to the writer as raw (already escaped) content. */
+	xmlBufferPtr buf = xmlBufferCreate();
+	xmlOutputBufferPtr out = xmlOutputBufferCreateBuffer(buf, NULL);
+	int ret = -1;
+
+	if (out != NULL) {
+		int level = _oscap_xml_writer_indent_child(writer, node);
+		if (level >= 0) {
+			xmlNodeDumpOutput(out, node->doc, node, level, 1, "UTF-8");
+			if (xmlOutputBufferClose(out) >= 0)
+				ret = xmlTextWriterWriteRawLen(writer, xmlBufferContent(buf), xmlBufferLength(buf));
+		} else
+			xmlOutputBufferClose(out);
+	}
+
+	xmlBufferFree(buf);
+	xmlUnlinkNode(node);
+	xmlFreeNode(node);
+	return ret < 0 ? -1 : 0;
+}
+
+int oscap_xml_writer_write_raw(xmlTextWriterPtr writer, xmlNodePtr parent, const char *data, size_t size)
+{
+	if (writer == NULL)
+		return 0;
+
+	struct oscap_xml_writer_state *state = parent->_private;
+	if (state == NULL)
+		return -1;
+	state->has_content = true;
+	if (_oscap_xml_writer_indent(writer, _oscap_xml_node_level(parent) + 1) < 0)
+		return -1;
+
+	/* xmlTextWriterWriteRawLen() takes an int */
+	while (size > 0) {
+		int len = size > INT_MAX ? INT_MAX : (int) size;
+		if (xmlTextWriterWriteRawLen(writer, BAD_CAST data, len) < 0)
+			return -1;
+		data += len;
+		size -= len;
+	}
+	return 0;
+}
@@ -78,4 +78,46 @@ int oscap_xml_save_filename_free(const char *filename, xmlDocPtr doc);
 
 xmlNs *lookup_xsi_ns(xmlDoc *doc);
 
+/**
+ * Callback producing the content of a streamed XML document.
+ * @param writer writer positioned after the XML declaration
+ * @param arg user argument
+ * @return 0 on success, -1 on failure
+ */
+typedef int (*oscap_xml_writer_func) (xmlTextWriterPtr writer, void *arg);
+
+/**
+ * Stream an XML document to the file of the given filename. Unlike
+ * oscap_xml_save_filename() the document doesn't have to be available
+ * as a whole, it is written by the callback while it is being produced.
+ * @param filename path to the file, "-" stands for the standard output
+ * @return 1 on success, -1 on failure (oscap_seterr is set appropriatly).
+ */
+int oscap_xml_save_writer(const char *filename, oscap_xml_writer_func func, void *arg);
+
+/**
+ * Stream an XML document to a newly allocated memory buffer.
+ * @param buffer the document, to be freed by the caller
+ * @param size size of the document
+ * @return 0 on success, -1 on failure (oscap_seterr is set appropriatly).
+ */
+int oscap_xml_save_writer_memory(char **buffer, size_t *size, oscap_xml_writer_func func, void *arg);
+
+/*
+ * The functions below let the code which builds a DOM tree top-down send
+ * it to a writer piece by piece. The tree is then a skeleton holding only
+ * the elements that are being written, so that namespace look-ups made by
+ * the *_to_dom() functions keep working. All of them do nothing if the
+ * writer is NULL, i.e. when a complete DOM is being built.
+ */
+
+/// write the start tag of the node, including its namespace declarations and attributes
+int oscap_xml_writer_start_node(xmlTextWriterPtr writer, xmlNodePtr node);
+/// write the end tag of a node started by oscap_xml_writer_start_node() and free the node
+int oscap_xml_writer_end_node(xmlTextWriterPtr writer, xmlNodePtr node);
+/// write the node including its subtree and free it
+int oscap_xml_writer_flush_node(xmlTextWriterPtr writer, xmlNodePtr node);
+/// write already serialized XML content (e.g. a whole document without its XML declaration) into the started parent node
+int oscap_xml_writer_write_raw(xmlTextWriterPtr writer, xmlNodePtr parent, const char *data, size_t size);
+
 #endif
@@ -28,6 +28,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "list.h"
 static inline bool _oscap_iterator_has_more_internal(const struct oscap_iterator *it);
@@ -372,28 +373,46 @@ OSCAP_ITERATOR_REMOVE(oscap_stringlist, oscap_stringlist_free)
     /*OSCAP_ITERATOR_RESET(oscap_string)*/
 
 
-#define OSCAP_DEFAULT_HSIZE 389
-static inline unsigned int oscap_htable_hash(const char *str, size_t htable_size)
+#define OSCAP_DEFAULT_HSIZE 32
+
+/*
+ * 64-bit FNV-1a followed by the finalizer of MurmurHash3 so that the low
+ * bits, which select the bucket, depend on all of the key.
+ */
+static inline size_t oscap_htable_hash(const char *str)
 {
-	unsigned h = 0;
-	unsigned char *p;
-	for (p = (unsigned char *)str; *p != '\0'; p++)
-		h = (97 * h) + *p;
-	return h % htable_size;
+	uint64_t h = UINT64_C(14695981039346656037);
+	const unsigned char *p;
+
+	for (p = (const unsigned char *)str; *p != '\0'; p++) {
+		h ^= *p;
+		h *= UINT64_C(1099511628211);
+	}
+
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+
+	return (size_t)h;
 }
 
+#define oscap_htable_bucket(htable, hash) ((hash) & ((htable)->hsize - 1))
+
 struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
 {
 	struct oscap_htable *t;
-    
-    assert(hsize > 0);
+	size_t size;
+
+	assert(hsize > 0);
+
+	for (size = 1; size < hsize; size <<= 1);
 
 	t = oscap_alloc(sizeof(struct oscap_htable));
 	if (t == NULL)
 		return NULL;
-	t->hsize = hsize;
+	t->hsize = size;
 	t->itemcount = 0;
-	t->table = oscap_calloc(hsize, sizeof(struct oscap_list_item *));
+	t->table = oscap_calloc(size, sizeof(struct oscap_htable_item *));
 	if (t->table == NULL) {
 		free(t);
 		return NULL;
@@ -433,44 +452,71 @@ struct oscap_htable *oscap_htable_new(void)
 	return oscap_htable_new1(oscap_htable_cmp, OSCAP_DEFAULT_HSIZE);
 }
 
-static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
+static struct oscap_htable_item *oscap_htable_lookup1(struct oscap_htable *htable, const char *key, size_t hash)
 {
-	__attribute__nonnull__(htable);
-	if (key == NULL)
-		return NULL;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	struct oscap_htable_item *htitem = htable->table[hashcode];
+	struct oscap_htable_item *htitem = htable->table[oscap_htable_bucket(htable, hash)];
 	while (htitem != NULL) {
-		if (htable->cmp(htitem->key, key) == 0)
+		if (htitem->hash == hash && htable->cmp(htitem->key, key) == 0)
 			return htitem;
 		htitem = htitem->next;
 	}
 	return NULL;
 }
 
+static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
+{
+	__attribute__nonnull__(htable);
+	if (key == NULL)
+		return NULL;
+	return oscap_htable_lookup1(htable, key, oscap_htable_hash(key));
+}
+
+/*
+ * Double the number of buckets. As after any insertion, iterators over
+ * the table must not be used afterwards.
+ */
+static void oscap_htable_grow(struct oscap_htable *htable)
+{
+	struct oscap_htable_item **table, *htitem, *next;
+	size_t i, hsize, bucket;
+
+	hsize = htable->hsize * 2;
+	table = oscap_calloc(hsize, sizeof(struct oscap_htable_item *));
+	if (table == NULL)
+		return;
+
+	for (i = 0; i < htable->hsize; ++i) {
+		for (htitem = htable->table[i]; htitem != NULL; htitem = next) {
+			next = htitem->next;
+			bucket = htitem->hash & (hsize - 1);
+			htitem->next = table[bucket];
+			table[bucket] = htitem;
+		}
+	}
+
+	free(htable->table);
+	htable->table = table;
+	htable->hsize = hsize;
+}
+
 bool oscap_htable_add(struct oscap_htable * htable, const char *key, void *item)
 {
 	__attribute__nonnull__(htable);
-	/*
-	   unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	   struct oscap_htable_item* htitem = htable->table[hashcode];
-	   while(htitem != NULL)
-	   {
-	   if( (*(htable->cmp))(htitem->key, key) == 0) return false;
-	   if(htitem->next == NULL) break;
-	   htitem = htitem->next;
-	   }
-	   // htitem points to the last item
-	 */
-	if (oscap_htable_lookup(htable, key) != NULL)
+	if (key == NULL)
+		return false;
+	size_t hash = oscap_htable_hash(key);
+	if (oscap_htable_lookup1(htable, key, hash) != NULL)
 		return false;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
+	if (htable->itemcount >= htable->hsize)
+		oscap_htable_grow(htable);
+	size_t bucket = oscap_htable_bucket(htable, hash);
 	struct oscap_htable_item *newhtitem;
 	newhtitem = oscap_alloc(sizeof(struct oscap_htable_item));
+	newhtitem->hash = hash;
 	newhtitem->key = strdup(key);
 	newhtitem->value = item;
-	newhtitem->next = htable->table[hashcode];
-	htable->table[hashcode] = newhtitem;
+	newhtitem->next = htable->table[bucket];
+	htable->table[bucket] = newhtitem;
 	htable->itemcount++;
 	return true;
 }
@@ -175,13 +175,14 @@ typedef int (*oscap_compare_func) (const char *, const char *);
 // Hash table item.
 struct oscap_htable_item {
 	struct oscap_htable_item *next;	// Next item.
+	size_t hash;		// Hash of the key.
 	char *key;		// Item key.
 	void *value;		// Item value.
 };
 
 // Hash table.
 struct oscap_htable {
-	size_t hsize;		// Size of the hash table.
+	size_t hsize;		// Size of the hash table, a power of 2.
 	size_t itemcount;	// Number of elements in the hash table.
 	struct oscap_htable_item **table;	// The table itself.
 	oscap_compare_func cmp;	// Funcion used to compare keys (e.g. strcmp).
@@ -189,8 +190,11 @@ struct oscap_htable {
 
 /*
  * Create a new hash table.
+ * The table doubles its size whenever the number of items exceeds the
+ * number of buckets. Keys that compare equal must be equal strings,
+ * they are hashed as such.
  * @param cmp Pointer to a function used as the key comparator.
- * @hsize Size of the hash table.
+ * @hsize Initial size of the hash table, rounded up to a power of 2.
  * @internal
  * @return new hash table
  */
@@ -199,7 +203,7 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize);
 /*
  * Create a new hash table.
  *
- * The table will use strcmp() as the comparison function and will have default table size.
+ * The table will use strcmp() as the comparison function and will have default initial size.
  * @see oscap_htable_new1()
  * @return new hash table
  */
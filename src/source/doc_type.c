@@ -24,6 +24,7 @@
 #endif
 
 #include <libxml/xmlreader.h>
+#include <limits.h>
 #include <string.h>
 
 #include "common/debug_priv.h"
@@ -31,22 +32,10 @@
 #include "common/public/oscap.h"
 #include "doc_type_priv.h"
 
-int oscap_determine_document_type_reader(xmlTextReader *reader, oscap_document_type_t *doc_type)
+/* identify document type by the local name of its root element */
+static int oscap_determine_document_type_root(const char *elm_name, oscap_document_type_t *doc_type)
 {
-        const char* elm_name = NULL;
-        *doc_type = 0;
-
-        /* find root element */
-        while (xmlTextReaderRead(reader) == 1
-               && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
-
-        /* identify document type */
-        elm_name = (const char *) xmlTextReaderConstLocalName(reader);
-        if (!elm_name) {
-                oscap_setxmlerr(xmlGetLastError());
-                return -1;
-        }
-        else if (!strcmp("oval_definitions", elm_name)) {
+        if (!strcmp("oval_definitions", elm_name)) {
                 *doc_type = OSCAP_DOCUMENT_OVAL_DEFINITIONS;
         }
         else if (!strcmp("oval_directives", elm_name)) {
@@ -93,3 +82,45 @@ int oscap_determine_document_type_reader(xmlTextReader *reader, oscap_document_t
 
         return 0;
 }
+
+int oscap_determine_document_type_reader(xmlTextReader *reader, oscap_document_type_t *doc_type)
+{
+        const char* elm_name = NULL;
+        *doc_type = 0;
+
+        /* find root element */
+        while (xmlTextReaderRead(reader) == 1
+               && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
+
+        /* identify document type */
+        elm_name = (const char *) xmlTextReaderConstLocalName(reader);
+        if (!elm_name) {
+                oscap_setxmlerr(xmlGetLastError());
+                return -1;
+        }
+
+        return oscap_determine_document_type_root(elm_name, doc_type);
+}
+
+int oscap_determine_document_type_memory(const char *buffer, size_t size, oscap_document_type_t *doc_type)
+{
+        xmlTextReader *reader;
+        int ret = -1;
+        *doc_type = 0;
+
+        if (size > INT_MAX)
+                return -1;
+        reader = xmlReaderForMemory(buffer, size, NULL, NULL, 0);
+        if (reader == NULL)
+                return -1;
+
+        /* the buffer may end anywhere past the root element */
+        while (xmlTextReaderRead(reader) == 1
+               && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
+
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+                ret = oscap_determine_document_type_root((const char *) xmlTextReaderConstLocalName(reader), doc_type);
+
+        xmlFreeTextReader(reader);
+        return ret;
+}
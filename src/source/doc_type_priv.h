@@ -41,5 +41,16 @@ OSCAP_HIDDEN_START;
  */
 int oscap_determine_document_type_reader(xmlTextReader *reader, oscap_document_type_t *doc_type);
 
+/**
+ * Determines the SCAP type of a serialized document. Only the beginning of the
+ * document up to the root element is needed. No error is reported, a document
+ * which can't be read is left to the callers to parse and report.
+ * @param buffer the serialized document or its beginning
+ * @param size size of the buffer
+ * @param doc_type determined document type (output parameter)
+ * @returns -1 if the type can't be determined, 0 otherwise
+ */
+int oscap_determine_document_type_memory(const char *buffer, size_t size, oscap_document_type_t *doc_type);
+
 OSCAP_HIDDEN_END;
 #endif
@@ -25,8 +25,11 @@
 #endif
 
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlerror.h>
@@ -56,6 +59,7 @@ typedef enum oscap_source_type {
 	OSCAP_SRC_FROM_USER_XML_FILE = 1,               ///< The source originated from XML file supplied by user
 	OSCAP_SRC_FROM_USER_MEMORY,                     ///< The source originated from memory supplied by user
 	OSCAP_SRC_FROM_XML_DOM,                         ///< The source originated from XML DOM (most often from DataStream).
+	OSCAP_SRC_FROM_MEMORY_CHUNKS,                   ///< The source is a part of another document (most often a DataStream component).
 	// TODO: downloaded from an http address (XCCDF can refer to remote sources)
 } oscap_source_type_t;
 
@@ -67,6 +71,10 @@ struct oscap_source {
 		char *filepath;                         ///< Filepath (if originated from file)
 		char *memory;                           ///< Memory buffer (if originated from memory)
 		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory)
+		struct oscap_source_chunk *chunks;      ///< Pieces of the document (if originated from memory chunks)
+		size_t chunk_count;                     ///< Number of the pieces
+		char *content;                          ///< Content of the file (if read to memory)
+		size_t content_size;                    ///< Size of the file content
 	} origin;                                       ///
 	struct {
 		xmlDoc *doc;                            /// DOM
@@ -114,6 +122,17 @@ struct oscap_source *oscap_source_new_take_memory(char *buffer, size_t size, con
 	return source;
 }
 
+struct oscap_source *oscap_source_new_from_chunks(const struct oscap_source_chunk *chunks, size_t count, const char *filepath)
+{
+	struct oscap_source *source = (struct oscap_source *) oscap_calloc(1, sizeof(struct oscap_source));
+	source->origin.type = OSCAP_SRC_FROM_MEMORY_CHUNKS;
+	source->origin.filepath = oscap_strdup(filepath ? filepath : "NONEXISTENT");
+	source->origin.chunks = oscap_alloc(count * sizeof(struct oscap_source_chunk));
+	memcpy(source->origin.chunks, chunks, count * sizeof(struct oscap_source_chunk));
+	source->origin.chunk_count = count;
+	return source;
+}
+
 struct oscap_source *oscap_source_new_from_xmlDoc(xmlDoc *doc, const char *filepath)
 {
 	struct oscap_source *source = (struct oscap_source *) oscap_calloc(1, sizeof(struct oscap_source));
@@ -128,6 +147,8 @@ void oscap_source_free(struct oscap_source *source)
 	if (source != NULL) {
 		oscap_free(source->origin.filepath);
 		oscap_free(source->origin.memory);
+		oscap_free(source->origin.chunks);
+		free(source->origin.content);
 		if (source->xml.doc != NULL) {
 			xmlFreeDoc(source->xml.doc);
 		}
@@ -160,9 +181,89 @@ xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
 	return reader;
 }
 
+static void xmlErrorCb(struct oscap_string *buffer, const char * format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+
+	char* error_msg = oscap_vsprintf(format, ap);
+	oscap_string_append_string(buffer, error_msg);
+	oscap_free(error_msg);
+
+	va_end(ap);
+}
+
+#define OSCAP_SOURCE_TYPE_PREFIX (64 * 1024)
+
+static int _oscap_source_read_prefix(const struct oscap_source *source, char **buffer, size_t *size)
+{
+	int fd = open(source->origin.filepath, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	char *data = malloc(OSCAP_SOURCE_TYPE_PREFIX);
+	size_t done = 0;
+	while (done < OSCAP_SOURCE_TYPE_PREFIX) {
+		ssize_t ret = read(fd, data + done, OSCAP_SOURCE_TYPE_PREFIX - done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			break;
+		done += ret;
+	}
+	close(fd);
+
+	*buffer = data;
+	*size = done;
+	return 0;
+}
+
+/*
+ * Looks the root element up in the serialized document, or in the beginning
+ * of the file if it hasn't been read. Neither the DOM is built nor the file
+ * kept just to tell the type. The errors are dropped, the DOM parser reports
+ * them when the type can't be told here.
+ */
+static void _oscap_source_scan_type(struct oscap_source *source)
+{
+	char *prefix = NULL;
+	const char *buffer;
+	size_t size;
+
+	if (source->origin.memory != NULL || source->origin.content != NULL) {
+		if (oscap_source_get_serialized_memory(source, &buffer, &size) != 0)
+			return;
+	}
+	else if (source->origin.type == OSCAP_SRC_FROM_USER_XML_FILE) {
+		if (_oscap_source_read_prefix(source, &prefix, &size) != 0)
+			return;
+		buffer = prefix;
+	}
+	else {
+		return;
+	}
+
+	struct oscap_string *xml_error_string = oscap_string_new();
+	xmlSetGenericErrorFunc(xml_error_string, (xmlGenericErrorFunc)xmlErrorCb);
+
+	if (oscap_determine_document_type_memory(buffer, size, &(source->scap_type)) != 0)
+		source->scap_type = OSCAP_DOCUMENT_UNKNOWN;
+
+	xmlSetGenericErrorFunc(stderr, NULL);
+	oscap_string_free(xml_error_string);
+	free(prefix);
+}
+
 oscap_document_type_t oscap_source_get_scap_type(struct oscap_source *source)
 {
 	if (source->scap_type == OSCAP_DOCUMENT_UNKNOWN) {
+		// Only the root element is needed to tell the type, there is no
+		// need to build the DOM of the whole document if it isn't there yet.
+		if (source->xml.doc == NULL) {
+			_oscap_source_scan_type(source);
+			if (source->scap_type != OSCAP_DOCUMENT_UNKNOWN)
+				return source->scap_type;
+		}
 		xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
 		if (reader == NULL) {
 			// the oscap error is already set
@@ -178,16 +279,30 @@ oscap_document_type_t oscap_source_get_scap_type(struct oscap_source *source)
 	return source->scap_type;
 }
 
-static void xmlErrorCb(struct oscap_string *buffer, const char * format, ...)
+struct oscap_source_chunk_cursor {
+	const struct oscap_source_chunk *chunk;
+	const struct oscap_source_chunk *end;
+	size_t offset;
+};
+
+static int _oscap_source_chunks_read(void *context, char *buffer, int len)
 {
-	va_list ap;
-	va_start(ap, format);
+	struct oscap_source_chunk_cursor *cursor = context;
+	int done = 0;
 
-	char* error_msg = oscap_vsprintf(format, ap);
-	oscap_string_append_string(buffer, error_msg);
-	oscap_free(error_msg);
+	while (done < len && cursor->chunk < cursor->end) {
+		size_t left = cursor->chunk->size - cursor->offset;
+		size_t n = left < (size_t)(len - done) ? left : (size_t)(len - done);
 
-	va_end(ap);
+		memcpy(buffer + done, cursor->chunk->data + cursor->offset, n);
+		done += n;
+		cursor->offset += n;
+		if (cursor->offset == cursor->chunk->size) {
+			cursor->chunk++;
+			cursor->offset = 0;
+		}
+	}
+	return done;
 }
 
 xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
@@ -214,6 +329,28 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 				}
 			}
 		}
+		else if (source->origin.type == OSCAP_SRC_FROM_MEMORY_CHUNKS) {
+			struct oscap_source_chunk_cursor cursor = {
+				source->origin.chunks, source->origin.chunks + source->origin.chunk_count, 0
+			};
+			source->xml.doc = xmlReadIO(_oscap_source_chunks_read, NULL, &cursor, NULL, NULL, 0);
+			if (source->xml.doc == NULL) {
+				oscap_setxmlerr(xmlGetLastError());
+				const char *error_msg = oscap_string_get_cstr(xml_error_string);
+				oscap_seterr(OSCAP_EFAMILY_XML, "%sUnable to parse XML of '%s'", error_msg, oscap_source_readable_origin(source));
+				oscap_string_clear(xml_error_string);
+			}
+		}
+		else if (source->origin.content != NULL && source->origin.content_size <= INT_MAX) {
+			// The file was read already, parse the same content again.
+			source->xml.doc = xmlReadMemory(source->origin.content, source->origin.content_size, NULL, NULL, 0);
+			if (source->xml.doc == NULL) {
+				oscap_setxmlerr(xmlGetLastError());
+				const char *error_msg = oscap_string_get_cstr(xml_error_string);
+				oscap_seterr(OSCAP_EFAMILY_XML, "%sUnable to parse XML at: '%s'", error_msg, oscap_source_readable_origin(source));
+				oscap_string_clear(xml_error_string);
+			}
+		}
 		else {
 			int fd = open(source->origin.filepath, O_RDONLY);
 			if ( fd == -1 ){
@@ -326,10 +463,53 @@ const char *oscap_source_get_schema_version(struct oscap_source *source)
 	return source->origin.version;
 }
 
+static int _oscap_source_save_memory(const struct oscap_source *source, const char *target)
+{
+	int fd;
+	if (strcmp(target, "-") == 0) {
+		fd = STDOUT_FILENO;
+	} else {
+		fd = open(target, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), target);
+			return -1;
+		}
+	}
+
+	const char *data = source->origin.memory;
+	size_t left = source->origin.memory_size;
+	while (left > 0) {
+		ssize_t written = write(fd, data, left);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), target);
+			break;
+		}
+		data += written;
+		left -= written;
+	}
+
+	if (fd != STDOUT_FILENO)
+		close(fd);
+	return left == 0 ? 0 : -1;
+}
+
 int oscap_source_save_as(struct oscap_source *source, const char *filename)
 {
-	// TODO: This assumes XML and xmlDoc being available
 	const char *target = filename != NULL ? filename : oscap_source_readable_origin(source);
+	if (source->xml.doc == NULL && source->origin.memory != NULL
+#ifdef HAVE_BZ2
+			&& !bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size)
+#endif
+			) {
+		// The document is already serialized (e.g. a streamed export),
+		// there is no need to build its DOM just to save it.
+		return _oscap_source_save_memory(source, target);
+	}
+
+	// TODO: This assumes XML and xmlDoc being available
 	xmlDoc *doc = oscap_source_get_xmlDoc(source);
 	if (doc == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save document to %s: DOM representation not available.", target);
@@ -338,6 +518,44 @@ int oscap_source_save_as(struct oscap_source *source, const char *filename)
 	return oscap_xml_save_filename(target, doc) == 1 ? 0 : -1;
 }
 
+static int _oscap_source_read_file(const struct oscap_source *source, char **buffer, size_t *size)
+{
+	int fd = open(source->origin.filepath, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+
+	char *data = malloc(st.st_size > 0 ? st.st_size : 1);
+	size_t done = 0;
+	while (done < (size_t) st.st_size) {
+		ssize_t ret = read(fd, data + done, st.st_size - done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			break;
+		done += ret;
+	}
+	close(fd);
+
+	if (done != (size_t) st.st_size
+#ifdef HAVE_BZ2
+			|| bz2_memory_is_bzip(data, done)
+#endif
+			) {
+		free(data);
+		return -1;
+	}
+
+	*buffer = data;
+	*size = done;
+	return 0;
+}
+
 int oscap_source_get_raw_memory(struct oscap_source *source, char **buffer, size_t *size)
 {
 	if (source->origin.memory != NULL) {
@@ -347,6 +565,35 @@ int oscap_source_get_raw_memory(struct oscap_source *source, char **buffer, size
 		*size = source->origin.memory_size;
 		return 0;
 	}
+	else if (source->origin.content != NULL) {
+		// The file was read already, there is no need to read it again.
+		char *ret = (char*)malloc(source->origin.content_size > 0 ? source->origin.content_size : 1);
+		memcpy(ret, source->origin.content, source->origin.content_size);
+		*buffer = ret;
+		*size = source->origin.content_size;
+		return 0;
+	}
+	else if (source->origin.type == OSCAP_SRC_FROM_MEMORY_CHUNKS) {
+		size_t total = 0;
+		for (size_t i = 0; i < source->origin.chunk_count; ++i)
+			total += source->origin.chunks[i].size;
+
+		char *ret = (char*)malloc(total > 0 ? total : 1);
+		*buffer = ret;
+		*size = total;
+		for (size_t i = 0; i < source->origin.chunk_count; ++i) {
+			memcpy(ret, source->origin.chunks[i].data, source->origin.chunks[i].size);
+			ret += source->origin.chunks[i].size;
+		}
+		return 0;
+	}
+	else if (source->origin.type == OSCAP_SRC_FROM_USER_XML_FILE &&
+			_oscap_source_read_file(source, buffer, size) == 0) {
+		// The file is taken as it is, there is no need to parse it
+		// only to serialize it again. Compressed files are decompressed
+		// through their DOM below.
+		return 0;
+	}
 	else {
 		xmlDoc *doc = oscap_source_get_xmlDoc(source);
 
@@ -367,3 +614,29 @@ int oscap_source_get_raw_memory(struct oscap_source *source, char **buffer, size
 		return 0;
 	}
 }
+
+int oscap_source_get_serialized_memory(struct oscap_source *source, const char **buffer, size_t *size)
+{
+	if (source->origin.memory != NULL) {
+#ifdef HAVE_BZ2
+		if (bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size))
+			return -1;
+#endif
+		*buffer = source->origin.memory;
+		*size = source->origin.memory_size;
+		return 0;
+	}
+
+	if (source->origin.type != OSCAP_SRC_FROM_USER_XML_FILE)
+		return -1;
+
+	// The file is read rather than mapped, the pieces parsed later
+	// must not change (or fault) when the file is modified meanwhile.
+	if (source->origin.content == NULL &&
+	    _oscap_source_read_file(source, &source->origin.content, &source->origin.content_size) != 0)
+		return -1;
+
+	*buffer = source->origin.content;
+	*size = source->origin.content_size;
+	return 0;
+}
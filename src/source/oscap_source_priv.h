@@ -49,6 +49,24 @@ OSCAP_HIDDEN_START;
  */
 struct oscap_source *oscap_source_new_take_memory(char *buffer, size_t size, const char *filepath);
 
+/// Piece of a serialized document
+struct oscap_source_chunk {
+	const char *data;
+	size_t size;
+};
+
+/**
+ * Create new oscap_source from a document serialized in several pieces of
+ * memory, most often parts of a serialized DataStream. The pieces are
+ * read straight from where they are when the DOM is needed, they are not
+ * copied and they have to outlive the oscap_source.
+ * @param chunks pieces of the document in order
+ * @param count number of the pieces
+ * @param filepath Suggested filename for the file or NULL
+ * @returns newly created oscap_source
+ */
+struct oscap_source *oscap_source_new_from_chunks(const struct oscap_source_chunk *chunks, size_t count, const char *filepath);
+
 /**
  * Build new oscap_source from existing xmlDoc. The xmlDoc becomes owned
  * by oscap_source.
@@ -77,6 +95,19 @@ xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source);
  */
 xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source);
 
+/**
+ * Get the serialized document of this resource. A file is read to memory
+ * once, the content is owned by oscap_source and it doesn't change when the
+ * file does. Compressed content and sources originating from xmlDoc can't be
+ * accessed this way.
+ * @memberof oscap_source
+ * @param source Resource to access
+ * @param buffer Will be filled with a pointer to the document
+ * @param size Will be filled with size of the document
+ * @returns 0 on success, -1 otherwise
+ */
+int oscap_source_get_serialized_memory(struct oscap_source *source, const char **buffer, size_t *size);
+
 OSCAP_HIDDEN_END;
 
 #endif
@@ -30,11 +30,36 @@ function test_api_oval_results {
     cmp $srcdir/results-good.xml exported-results.xml
 }
 
+# The streamed results are the same as the saved DOM, with the directives of
+# the results file and with external directives. A write error is reported.
+function test_api_oval_results_stream {
+    ./test_api_results_stream $srcdir/results.xml exported-stream.xml exported-dom.xml || return 1
+    cmp exported-dom.xml exported-stream.xml || return 1
+    ./test_api_results_stream $srcdir/results.xml exported-stream.xml exported-dom.xml \
+	$srcdir/directives-stream.xml || return 1
+    cmp exported-dom.xml exported-stream.xml || return 1
+    if [ -w /dev/full ] && ./test_api_results_stream $srcdir/results.xml /dev/full exported-dom.xml; then
+	return 1
+    fi
+}
+
 function test_api_oval_directives {
     ./test_api_directives $srcdir/directives.xml exported-directives.xml
     cmp $srcdir/directives.xml exported-directives.xml
 }
 
+function test_api_probe_comm {
+    ./test_api_probe_comm
+}
+
+function test_api_regex_cache {
+    ./test_api_regex_cache
+}
+
+function test_api_string_map {
+    ./test_api_string_map
+}
+
 # Testing.
 
 test_init "test_api_oval.log"
@@ -42,6 +67,10 @@ test_init "test_api_oval.log"
 test_run "test_api_oval_definition" test_api_oval_definition
 test_run "test_api_oval_syschar" test_api_oval_syschar
 test_run "test_api_oval_results" test_api_oval_results
+test_run "test_api_oval_results_stream" test_api_oval_results_stream
 test_run "test_api_oval_directives" test_api_oval_directives
+test_run "test_api_probe_comm" test_api_probe_comm
+test_run "test_api_regex_cache" test_api_regex_cache
+test_run "test_api_string_map" test_api_string_map
 
 test_exit
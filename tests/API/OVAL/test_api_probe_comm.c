@@ -0,0 +1,169 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <seap.h>
+#include <sexp.h>
+#include "oval_probe_ext.c"
+
+/*
+ * The test spawns itself as a probe. Two requests are outstanding, the
+ * probe reports an error for the first one and replies to the second one.
+ * Waiting for the second request must return the reply and leave the error
+ * queued for the first one.
+ */
+#define TEST_PEER_ENV "TEST_API_PROBE_COMM_PEER"
+
+static int peer(void)
+{
+	SEAP_CTX_t *ctx;
+	SEAP_msg_t *req_a, *req_b, *rep;
+	SEXP_t *s_rep;
+	int sd;
+
+	ctx = SEAP_CTX_new();
+	sd  = SEAP_openfd2(ctx, STDIN_FILENO, STDOUT_FILENO, 0);
+
+	if (sd < 0)
+		return (1);
+	if (SEAP_recvmsg(ctx, sd, &req_a) != 0 ||
+	    SEAP_recvmsg(ctx, sd, &req_b) != 0)
+		return (1);
+	if (SEAP_replyerr(ctx, sd, req_a, PROBE_ENOENT) != 0)
+		return (1);
+
+	rep   = SEAP_msg_new();
+	s_rep = SEXP_string_newf("reply-b");
+	SEAP_msg_set(rep, s_rep);
+
+	if (SEAP_reply(ctx, sd, rep, req_b) != 0)
+		return (1);
+
+	/* wait until the library closes the connection */
+	while (SEAP_recvmsg(ctx, sd, &rep) == 0)
+		SEAP_msg_free(rep);
+
+	SEXP_free(s_rep);
+	SEAP_msg_free(req_a);
+	SEAP_msg_free(req_b);
+	SEAP_CTX_free(ctx);
+
+	return (0);
+}
+
+static SEAP_msgid_t send_request(SEAP_CTX_t *ctx, int sd, const char *str)
+{
+	SEAP_msg_t *msg;
+	SEAP_msgid_t id;
+	SEXP_t *s_str;
+
+	msg   = SEAP_msg_new();
+	s_str = SEXP_string_newf("%s", str);
+	SEAP_msg_set(msg, s_str);
+
+	if (SEAP_sendmsg(ctx, sd, msg) != 0) {
+		fprintf(stderr, "SEAP_sendmsg: %u, %s\n", errno, strerror(errno));
+		exit(1);
+	}
+
+	id = SEAP_msg_id(msg);
+	SEXP_free(s_str);
+	SEAP_msg_free(msg);
+
+	return (id);
+}
+
+int main(int argc, char *argv[])
+{
+	SEAP_CTX_t *ctx;
+	SEAP_msg_t *msg;
+	SEAP_msgid_t id_a, id_b;
+	SEXP_t *s_rep;
+	oval_pd_t pd;
+	char self[PATH_MAX], uri[PATH_MAX + 16];
+	int ret;
+
+	if (getenv(TEST_PEER_ENV) != NULL)
+		return (peer());
+
+	if (realpath(argv[0], self) == NULL) {
+		fprintf(stderr, "realpath(%s): %u, %s\n", argv[0], errno, strerror(errno));
+		return (1);
+	}
+
+	setenv(TEST_PEER_ENV, "1", 1);
+	snprintf(uri, sizeof uri, "pipe://%s", self);
+
+	memset(&pd, 0, sizeof pd);
+	ctx     = SEAP_CTX_new();
+	pd.uri  = uri;
+	pd.sd   = SEAP_connect(ctx, uri, 0);
+
+	if (pd.sd < 0) {
+		fprintf(stderr, "SEAP_connect(%s): %u, %s\n", uri, errno, strerror(errno));
+		return (1);
+	}
+
+	id_a = send_request(ctx, pd.sd, "request-a");
+	id_b = send_request(ctx, pd.sd, "request-b");
+
+	pd.req[0].id = id_a;
+	pd.req[1].id = id_b;
+	pd.req_cnt   = 2;
+
+	/* the error for request A arrives while waiting for B */
+	if (oval_probe_comm_recv(ctx, &pd, id_b, 0, &msg) != 0) {
+		fprintf(stderr, "receiving the reply to B failed: %u, %s\n", errno, strerror(errno));
+		return (1);
+	}
+
+	s_rep = SEAP_msg_get(msg);
+	ret   = SEXP_strcmp(s_rep, "reply-b");
+	SEXP_free(s_rep);
+	SEAP_msg_free(msg);
+
+	if (ret != 0) {
+		fprintf(stderr, "unexpected reply to B\n");
+		return (1);
+	}
+
+	pd.req_cnt = 1;
+
+	/* the queued error is reported for request A */
+	if (oval_probe_comm_recv(ctx, &pd, id_a, 0, &msg) != -1 || errno != ECANCELED) {
+		fprintf(stderr, "the error of A wasn't reported\n");
+		return (1);
+	}
+
+	SEAP_close(ctx, pd.sd);
+	SEAP_CTX_free(ctx);
+
+	return (0);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "OVAL/results/oval_regex_cache_impl.h"
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__FILE__, __LINE__, #cond);		\
+			return 1;					\
+		}							\
+	} while (0)
+
+static int check_stats(oval_regex_cache_t *cache, uint64_t hits, uint64_t misses, uint64_t uncached, uint32_t entries)
+{
+	struct oval_regex_stats rs;
+
+	oval_regex_cache_stats(cache, &rs);
+	if (rs.hits == hits && rs.misses == misses && rs.uncached == uncached && rs.entries == entries)
+		return 0;
+
+	fprintf(stderr, "stats: hits=%"PRIu64", misses=%"PRIu64", uncached=%"PRIu64", entries=%"PRIu32"\n",
+		rs.hits, rs.misses, rs.uncached, rs.entries);
+	return 1;
+}
+
+static void *get_in_thread(void *arg)
+{
+	/* the cache set in the main thread isn't used here */
+	return oval_regex_get("a+", 0, NULL, NULL);
+}
+
+int main(int argc, char **argv)
+{
+	oval_regex_cache_t *cache, *other;
+	oval_regex_t *a, *b, *c;
+	const char *err = NULL;
+	int erroffset = -1;
+	pthread_t th;
+	void *res;
+
+	/* without a cache, every caller gets its own pattern */
+	a = oval_regex_get("a+", 0, NULL, NULL);
+	CHECK(a != NULL && !a->cached);
+	CHECK(oval_regex_exec(a, "baab", 4, 0, 0, NULL, 0) >= 0);
+	oval_regex_put(a);
+
+	cache = oval_regex_cache_new(2);
+	CHECK(cache != NULL);
+	CHECK(oval_regex_cache_set(cache) == NULL);
+
+	a = oval_regex_get("a+", 0, NULL, NULL);
+	CHECK(a != NULL && a->cached);
+	CHECK(oval_regex_get("a+", 0, NULL, NULL) == a);
+	CHECK(oval_regex_exec(a, "baab", 4, 0, 0, NULL, 0) >= 0);
+	CHECK(oval_regex_exec(a, "bbb", 3, 0, 0, NULL, 0) == PCRE_ERROR_NOMATCH);
+	oval_regex_put(a);
+	oval_regex_put(a);
+
+	/* the options are a part of the key */
+	b = oval_regex_get("a+", PCRE_CASELESS, NULL, NULL);
+	CHECK(b != NULL && b->cached && b != a);
+	CHECK(oval_regex_exec(b, "AA", 2, 0, 0, NULL, 0) >= 0);
+	oval_regex_put(b);
+
+	/* the cache is full */
+	c = oval_regex_get("c+", 0, NULL, NULL);
+	CHECK(c != NULL && !c->cached);
+	oval_regex_put(c);
+
+	CHECK(oval_regex_get("(", 0, &err, &erroffset) == NULL);
+	CHECK(err != NULL && erroffset == 1);
+
+	CHECK(check_stats(cache, 1, 4, 1, 2) == 0);
+
+	/* the cache is set in the calling thread only */
+	CHECK(pthread_create(&th, NULL, get_in_thread, NULL) == 0);
+	CHECK(pthread_join(th, &res) == 0);
+	CHECK(res != NULL && res != a && !((oval_regex_t *)res)->cached);
+	oval_regex_put(res);
+
+	/* each cache has its own patterns and statistics */
+	other = oval_regex_cache_new(2);
+	CHECK(oval_regex_cache_set(other) == cache);
+	b = oval_regex_get("a+", 0, NULL, NULL);
+	CHECK(b != NULL && b->cached && b != a);
+	oval_regex_put(b);
+	CHECK(check_stats(other, 0, 1, 0, 1) == 0);
+	CHECK(oval_regex_cache_set(cache) == other);
+	oval_regex_cache_free(other);
+
+	CHECK(check_stats(cache, 1, 4, 1, 2) == 0);
+	CHECK(oval_regex_cache_set(NULL) == cache);
+	oval_regex_cache_free(cache);
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Export a results model twice: streamed by oval_results_model_export()
+ * and as a complete DOM saved by xmlSaveFormatFileEnc(). The outputs are
+ * compared by test_api_oval.sh.
+ *
+ * oval_resModel.c is included to reach oval_results_to_dom().
+ */
+#include "results/oval_resModel.c"
+
+int main(int argc, char **argv)
+{
+	struct oval_definition_model *definition_model;
+	struct oval_results_model *results_model;
+	struct oval_directives_model *directives_model = NULL;
+	struct oscap_source *source;
+	xmlDocPtr doc;
+	int ret = 0;
+
+	if (argc != 4 && argc != 5) {
+		fprintf(stderr, "Usage: %s <results> <streamed> <dom> [<directives>]\n", argv[0]);
+		return 2;
+	}
+
+	definition_model = oval_definition_model_new();
+	results_model = oval_results_model_new(definition_model, NULL);
+
+	source = oscap_source_new_from_file(argv[1]);
+	if (oval_results_model_import_source(results_model, source) != 0) {
+		fprintf(stderr, "Can't import '%s'\n", argv[1]);
+		return 1;
+	}
+	oscap_source_free(source);
+
+	if (argc == 5) {
+		directives_model = oval_directives_model_new();
+		source = oscap_source_new_from_file(argv[4]);
+		if (oval_directives_model_import_source(directives_model, source) != 0) {
+			fprintf(stderr, "Can't import '%s'\n", argv[4]);
+			return 1;
+		}
+		oscap_source_free(source);
+	}
+
+	if (oval_results_model_export(results_model, directives_model, argv[2]) != 0) {
+		fprintf(stderr, "Streaming the results failed: %s\n", oscap_err_desc());
+		ret = 1;
+	}
+
+	/* The complete DOM is built when no writer is given */
+	doc = xmlNewDoc(BAD_CAST "1.0");
+	if (oval_results_to_dom(results_model, directives_model, doc, NULL, NULL) != 0
+	    || xmlSaveFormatFileEnc(argv[3], doc, "UTF-8", 1) < 0) {
+		fprintf(stderr, "Saving the DOM failed\n");
+		ret = 1;
+	}
+	xmlFreeDoc(doc);
+
+	if (directives_model != NULL)
+		oval_directives_model_free(directives_model);
+	oval_results_model_free(results_model);
+	oval_definition_model_free(definition_model);
+	oscap_cleanup();
+	return ret;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "OVAL/adt/oval_string_map_impl.h"
+#include "OVAL/adt/oval_collection_impl.h"
+
+#define TEST_KEYS    1000 /* enough to grow the table several times */
+#define TEST_THREADS 4
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__FILE__, __LINE__, #cond);		\
+			return 1;					\
+		}							\
+	} while (0)
+
+static int values[TEST_KEYS + 1];
+static int destroyed;
+
+static void destroy_value(void *val)
+{
+	++destroyed;
+}
+
+static void make_key(char *key, int i)
+{
+	snprintf(key, 16, "key%04d", i);
+}
+
+/*
+ * The keys are key0000, key0001, ... up to `count' with the `missing' one
+ * left out if it isn't -1. The iterators return them in descending order,
+ * like the RB-tree backend does.
+ */
+static int check_keys(struct oval_string_map *map, int count, int missing)
+{
+	struct oval_iterator *it = oval_string_map_keys(map);
+	char key[16];
+	int i;
+
+	for (i = count - 1; i >= 0; --i) {
+		if (i == missing)
+			continue;
+		make_key(key, i);
+		CHECK(oval_collection_iterator_has_more(it));
+		CHECK(strcmp(oval_collection_iterator_next(it), key) == 0);
+	}
+	CHECK(!oval_collection_iterator_has_more(it));
+	oval_collection_iterator_free(it);
+
+	return 0;
+}
+
+static int check_values(struct oval_string_map *map, int count, int missing)
+{
+	struct oval_iterator *it = oval_string_map_values(map);
+	struct oval_collection *collection;
+	int i;
+
+	for (i = count - 1; i >= 0; --i) {
+		if (i == missing)
+			continue;
+		CHECK(oval_collection_iterator_has_more(it));
+		CHECK(oval_collection_iterator_next(it) == &values[i]);
+	}
+	CHECK(!oval_collection_iterator_has_more(it));
+	oval_collection_iterator_free(it);
+
+	/* the iterator of the collection reverses the order */
+	collection = oval_string_map_collect_values(map, NULL);
+	it = oval_collection_iterator(collection);
+	for (i = 0; i < count; ++i) {
+		if (i == missing)
+			continue;
+		CHECK(oval_collection_iterator_has_more(it));
+		CHECK(oval_collection_iterator_next(it) == &values[i]);
+	}
+	CHECK(!oval_collection_iterator_has_more(it));
+	oval_collection_iterator_free(it);
+	oval_collection_free(collection);
+
+	return 0;
+}
+
+static void *iterate_thread(void *arg)
+{
+	return (check_keys(arg, TEST_KEYS, TEST_KEYS / 2) == 0 ? arg : NULL);
+}
+
+int main(int argc, char **argv)
+{
+	struct oval_string_map *map;
+	struct oval_iterator *it;
+	pthread_t th[TEST_THREADS];
+	void *res;
+	char key[16];
+	int i, j;
+
+	map = oval_string_map_new();
+
+	it = oval_string_map_keys(map);
+	CHECK(!oval_collection_iterator_has_more(it));
+	oval_collection_iterator_free(it);
+
+	/* insert in a scrambled order, leave out the middle key for now */
+	for (i = 0; i < TEST_KEYS; ++i) {
+		j = (i * 7919) % TEST_KEYS;
+		if (j == TEST_KEYS / 2)
+			continue;
+		make_key(key, j);
+		oval_string_map_put(map, key, &values[j]);
+	}
+
+	/* the first value is kept */
+	make_key(key, 1);
+	oval_string_map_put(map, key, &values[TEST_KEYS]);
+
+	for (i = 0; i < TEST_KEYS; ++i) {
+		make_key(key, i);
+		CHECK(oval_string_map_get_value(map, key) == (i == TEST_KEYS / 2 ? NULL : &values[i]));
+	}
+	CHECK(oval_string_map_get_value(map, "key") == NULL);
+	CHECK(oval_string_map_get_value(map, "") == NULL);
+
+	/* the sorted entries are reused by the following iterators */
+	CHECK(check_keys(map, TEST_KEYS, TEST_KEYS / 2) == 0);
+	CHECK(check_keys(map, TEST_KEYS, TEST_KEYS / 2) == 0);
+	CHECK(check_values(map, TEST_KEYS, TEST_KEYS / 2) == 0);
+
+	/* and rebuilt after an insertion */
+	make_key(key, TEST_KEYS / 2);
+	oval_string_map_put(map, key, &values[TEST_KEYS / 2]);
+	CHECK(oval_string_map_get_value(map, key) == &values[TEST_KEYS / 2]);
+	CHECK(check_keys(map, TEST_KEYS, -1) == 0);
+	CHECK(check_values(map, TEST_KEYS, -1) == 0);
+
+	oval_string_map_free(map, destroy_value);
+	CHECK(destroyed == TEST_KEYS);
+
+	/* iterators of a filled map can be created concurrently */
+	map = oval_string_map_new();
+	for (i = 0; i < TEST_KEYS; ++i) {
+		if (i == TEST_KEYS / 2)
+			continue;
+		make_key(key, i);
+		oval_string_map_put(map, key, &values[i]);
+	}
+	for (i = 0; i < TEST_THREADS; ++i)
+		CHECK(pthread_create(&th[i], NULL, iterate_thread, map) == 0);
+	for (i = 0; i < TEST_THREADS; ++i) {
+		CHECK(pthread_join(th[i], &res) == 0);
+		CHECK(res == map);
+	}
+	oval_string_map_free0(map);
+
+	return 0;
+}
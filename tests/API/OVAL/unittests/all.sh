@@ -30,4 +30,5 @@ test_run "invalid regular expression" $srcdir/test_invalid_regex.sh
 test_run "glob to regex" $srcdir/test_glob_to_regex.sh
 test_run "test platform schema version" $srcdir/test_platform_version.sh
 test_run "state entity check_existence attribute" $srcdir/test_state_check_existence.sh
+test_run "set object evaluated by a single probe worker" $srcdir/test_set_object_single_thread.sh
 test_exit
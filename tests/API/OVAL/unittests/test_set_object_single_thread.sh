@@ -0,0 +1,16 @@
+#! /bin/bash
+
+result=`mktemp`
+xpath="$XPATH"
+
+set -e
+set -o pipefail
+
+# The worker evaluating the set object waits for the objects it references
+# to be evaluated by the same probe; this must not deadlock a probe limited
+# to a single worker.
+OSCAP_PROBE_MAX_THREADS=1 timeout 120 $OSCAP oval eval --results $result $srcdir/test_set_object_single_thread.xml
+
+[ $($xpath $result 'count(/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"])') == "1" ]
+[ $($xpath $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"][@flag="complete"]/reference)') == "2" ]
+rm $result
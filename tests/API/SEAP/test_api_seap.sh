@@ -480,6 +480,18 @@ function test_api_strto {
     ./test_api_strto
 }
 
+function test_api_seap_mpscq {
+    ./test_api_seap_mpscq 100000 8
+}
+
+function test_api_seap_binary {
+    ./test_api_seap_binary 100000 3
+}
+
+function test_api_seap_memfd {
+    ./test_api_seap_memfd && OSCAP_SEAP_ENCODING=text ./test_api_seap_memfd
+}
+
 # Testing.
 
 test_init "test_api_seap.log"
@@ -494,5 +506,9 @@ test_run "test_api_seap_number_expression"    ./test_api_seap_number
 test_run "test_api_seap_string_expression"    ./test_api_seap_string
 test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
 test_run "test_api_strto"                     ./test_api_strto
+test_run "test_api_seap_mpscq"                test_api_seap_mpscq
+test_run "test_api_seap_binary"               test_api_seap_binary
+test_run "test_api_seap_memfd"                test_api_seap_memfd
+test_run "test_api_seap_arena"                ./test_api_seap_arena
 
 test_exit
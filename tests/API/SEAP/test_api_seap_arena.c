@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include <sexp.h>
+
+/*
+ * Build many short-lived items in an allocation scope and keep some of
+ * them past the end of the scope, like a probe that stores items in the
+ * item cache. The kept items must stay intact until they are freed.
+ */
+#define ITEM_COUNT 20000
+#define KEEP_EVERY 97
+
+static SEXP_t *new_item (unsigned int i)
+{
+        SEXP_t *item, *name, *value, *attrs;
+
+        name  = SEXP_string_newf ("/usr/lib/item-%u", i);
+        value = SEXP_number_newu_64 ((uint64_t)i * 4099);
+        attrs = SEXP_list_new (name, value, NULL);
+        item  = SEXP_list_new (attrs, name, NULL);
+
+        /* make the list span several list blocks */
+        SEXP_list_add (item, value);
+        SEXP_list_add (item, value);
+        SEXP_list_add (item, attrs);
+
+        SEXP_vfree (name, value, attrs, NULL);
+
+        return (item);
+}
+
+static double now (void)
+{
+        struct timeval tv;
+
+        gettimeofday (&tv, NULL);
+
+        return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+}
+
+static int test_mode (SEXP_arena_mode_t mode, const char *name)
+{
+        SEXP_arena_t *arena;
+        SEXP_allocstats_t stats;
+        SEXP_t *kept[ITEM_COUNT / KEEP_EVERY + 1], *item, *rest, *check;
+        unsigned int i, k;
+        double t;
+
+        t = now ();
+        arena = SEXP_arena_begin (mode);
+
+        if (arena == NULL) {
+                fprintf (stderr, "SEXP_arena_begin(%s) failed\n", name);
+                return (1);
+        }
+
+        for (i = 0, k = 0; i < ITEM_COUNT; ++i) {
+                item = new_item (i);
+                rest = SEXP_list_rest (item);
+
+                if (i % KEEP_EVERY == 0)
+                        kept[k++] = SEXP_ref (rest);
+
+                SEXP_vfree (item, rest, NULL);
+        }
+
+        SEXP_arena_end (arena, &stats);
+        t = now () - t;
+
+        printf ("%-6s %.3fs allocs=%"PRIu64" frees=%"PRIu64" peak=%zu chunks=%zu\n",
+                name, t, stats.alloc_cnt, stats.free_cnt, stats.peak_bytes, stats.chunk_cnt);
+
+        if (stats.alloc_cnt == 0 || stats.peak_bytes == 0 || stats.free_cnt > stats.alloc_cnt) {
+                fprintf (stderr, "%s: invalid statistics\n", name);
+                return (1);
+        }
+
+        if ((mode == SEXP_ARENA_CHUNKS) != (stats.chunk_cnt > 0)) {
+                fprintf (stderr, "%s: unexpected chunk count: %zu\n", name, stats.chunk_cnt);
+                return (1);
+        }
+
+        /* the kept items are compared with ones allocated outside of the scope */
+        for (i = 0; i < k; ++i) {
+                item  = new_item (i * KEEP_EVERY);
+                check = SEXP_list_rest (item);
+
+                if (!SEXP_deepcmp (kept[i], check)) {
+                        fprintf (stderr, "%s: kept item %u differs\n", name, i);
+                        return (1);
+                }
+
+                SEXP_vfree (item, check, kept[i], NULL);
+        }
+
+        return (0);
+}
+
+int main (void)
+{
+        if (test_mode (SEXP_ARENA_HEAP, "heap") != 0)
+                return (1);
+        if (test_mode (SEXP_ARENA_CHUNKS, "chunks") != 0)
+                return (1);
+
+        return (0);
+}
@@ -0,0 +1,456 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Round-trip of S-exps through the binary transport encoding and
+ * a comparison with the text encoding. The benchmark part encodes and
+ * decodes a message resembling a collected object with many items.
+ *
+ * Usage: test_api_seap_binary [items] [iterations]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sexp.h>
+#include <strbuf.h>
+
+static char *sb_data (strbuf_t *sb, size_t *len)
+{
+        char *mem;
+
+        *len = strbuf_length (sb);
+        mem  = malloc (*len + 1);
+        strbuf_copy (sb, mem, *len);
+        mem[*len] = '\0';
+
+        return (mem);
+}
+
+static char *encode_t (SEXP_t *s_exp, size_t *len)
+{
+        strbuf_t *sb = strbuf_new (SEAP_STRBUF_MAX);
+        char *mem;
+
+        if (SEXP_sbprintf_t (s_exp, sb) != 0) {
+                fprintf (stderr, "SEXP_sbprintf_t failed\n");
+                abort ();
+        }
+
+        mem = sb_data (sb, len);
+        strbuf_free (sb);
+
+        return (mem);
+}
+
+static char *encode_b (SEXP_t *s_exp, size_t *len)
+{
+        strbuf_t *sb = strbuf_new (SEAP_STRBUF_MAX);
+        char *mem;
+
+        if (SEXP_sbprintf_b (s_exp, sb) != 0) {
+                fprintf (stderr, "SEXP_sbprintf_b failed\n");
+                abort ();
+        }
+
+        mem = sb_data (sb, len);
+        strbuf_free (sb);
+
+        return (mem);
+}
+
+static SEXP_t *decode_t (char *mem, size_t len)
+{
+        SEXP_psetup_t *psetup;
+        SEXP_pstate_t *pstate = NULL;
+        SEXP_t *list, *s_exp;
+
+        psetup = SEXP_psetup_new ();
+        list   = SEXP_parse (psetup, mem, len, &pstate);
+        SEXP_psetup_free (psetup);
+
+        if (list == NULL) {
+                fprintf (stderr, "SEXP_parse failed\n");
+                abort ();
+        }
+
+        s_exp = SEXP_list_first (list);
+        SEXP_free (list);
+
+        return (s_exp);
+}
+
+static SEXP_t *decode_b (const char *mem, size_t len)
+{
+        SEXP_t *s_exp = NULL;
+
+        if (SEXP_parse_b (mem, len, &s_exp) != (ssize_t)len) {
+                fprintf (stderr, "SEXP_parse_b failed\n");
+                abort ();
+        }
+
+        return (s_exp);
+}
+
+/*
+ * Both decoded S-exps must be identical, including number types and
+ * datatypes, i.e. their text encodings must match.
+ */
+/*
+ * Compare the text form only: the text parser turns integral doubles
+ * (e.g. #d0) into integers, so the trees may differ in number types.
+ */
+static int check_same (SEXP_t *a, SEXP_t *b, const char *what)
+{
+        char  *ta, *tb;
+        size_t la, lb;
+        int    ret = 0;
+
+        ta = encode_t (a, &la);
+        tb = encode_t (b, &lb);
+
+        if (la != lb || memcmp (ta, tb, la) != 0) {
+                size_t k, o;
+
+                for (k = 0; k < la && k < lb && ta[k] == tb[k]; ++k);
+                o = k > 32 ? k - 32 : 0;
+
+                fprintf (stderr, "%s: decoded S-exps differ at offset %zu:\n%.64s\n%.64s\n",
+                         what, k, ta + o, tb + o);
+                ret = 1;
+        }
+
+        free (ta);
+        free (tb);
+
+        return (ret);
+}
+
+static int roundtrip (SEXP_t *s_exp, const char *what)
+{
+        SEXP_t *st, *sb;
+        char   *mt, *mb;
+        size_t  lt, lb;
+        int     ret;
+
+        mt = encode_t (s_exp, &lt);
+        mb = encode_b (s_exp, &lb);
+        st = decode_t (mt, lt);
+        sb = decode_b (mb, lb);
+
+        ret = check_same (st, sb, what);
+
+        SEXP_free (st);
+        SEXP_free (sb);
+        free (mt);
+        free (mb);
+
+        return (ret);
+}
+
+static int test_numbers (void)
+{
+        const uint64_t u[] = {
+                0, 1, 127, 128, 255, 256, 65535, 65536,
+                UINT32_MAX, (uint64_t)UINT32_MAX + 1, INT64_MAX, UINT64_MAX
+        };
+        const int64_t i[] = {
+                -1, -127, -128, -129, -32768, -32769,
+                INT32_MIN, (int64_t)INT32_MIN - 1, INT64_MIN + 1
+        };
+        SEXP_t *list, *n;
+        size_t  k;
+        int     ret;
+
+        list = SEXP_list_new (NULL);
+
+        for (k = 0; k < sizeof u / sizeof u[0]; ++k) {
+                n = SEXP_number_newu_64 (u[k]);
+                SEXP_list_add (list, n);
+                SEXP_free (n);
+        }
+
+        for (k = 0; k < sizeof i / sizeof i[0]; ++k) {
+                n = SEXP_number_newi_64 (i[k]);
+                SEXP_list_add (list, n);
+                SEXP_free (n);
+        }
+
+        n = SEXP_number_newb (true);
+        SEXP_list_add (list, n);
+        SEXP_free (n);
+        n = SEXP_number_newb (false);
+        SEXP_list_add (list, n);
+        SEXP_free (n);
+        n = SEXP_number_newf (0.5);
+        SEXP_list_add (list, n);
+        SEXP_free (n);
+        n = SEXP_number_newf (-1024.25);
+        SEXP_list_add (list, n);
+        SEXP_free (n);
+
+        ret = roundtrip (list, "numbers");
+        SEXP_free (list);
+
+        return (ret);
+}
+
+/*
+ * Values which don't survive the text encoding: it uses %g for doubles
+ * and the text parser rejects INT64_MIN.
+ */
+static int test_exact (void)
+{
+        SEXP_t *n, *d;
+        char   *mem;
+        size_t  len;
+        int     ret = 0;
+
+        n   = SEXP_number_newf (0.1);
+        mem = encode_b (n, &len);
+        d   = decode_b (mem, len);
+
+        if (SEXP_number_type (d) != SEXP_NUM_DOUBLE || SEXP_number_getf (d) != 0.1) {
+                fprintf (stderr, "exact: double not preserved\n");
+                ret = 1;
+        }
+
+        SEXP_free (n);
+        SEXP_free (d);
+        free (mem);
+
+        n   = SEXP_number_newi_64 (INT64_MIN);
+        mem = encode_b (n, &len);
+        d   = decode_b (mem, len);
+
+        if (SEXP_number_type (d) != SEXP_NUM_INT64 || SEXP_number_geti_64 (d) != INT64_MIN) {
+                fprintf (stderr, "exact: INT64_MIN not preserved\n");
+                ret = 1;
+        }
+
+        SEXP_free (n);
+        SEXP_free (d);
+        free (mem);
+
+        return (ret);
+}
+
+static SEXP_t *new_item (uint32_t k)
+{
+        SEXP_t *item, *attr, *name, *val, *ent;
+
+        attr = SEXP_list_new (NULL);
+        name = SEXP_string_newf (":id");
+        val  = SEXP_string_newf ("%u", k);
+        SEXP_list_add (attr, name);
+        SEXP_list_add (attr, val);
+        SEXP_free (name);
+        SEXP_free (val);
+
+        name = SEXP_string_newf ("file_item");
+        item = SEXP_list_new (name, attr, NULL);
+        SEXP_vfree (name, attr, NULL);
+
+        name = SEXP_string_newf ("filepath");
+        val  = SEXP_string_newf ("/usr/lib64/lib%u.so.%u \"quoted\" (paren)", k, k % 7);
+        SEXP_datatype_set (val, "string");
+        ent  = SEXP_list_new (name, val, NULL);
+        SEXP_list_add (item, ent);
+        SEXP_vfree (name, val, ent, NULL);
+
+        name = SEXP_string_newf ("size");
+        val  = SEXP_number_newi_64 ((int64_t)k * 4093 - 1000000);
+        SEXP_datatype_set (val, "int");
+        ent  = SEXP_list_new (name, val, NULL);
+        SEXP_list_add (item, ent);
+        SEXP_vfree (name, val, ent, NULL);
+
+        name = SEXP_string_newf ("a_time");
+        val  = SEXP_number_newu_64 (1400000000ULL + k);
+        ent  = SEXP_list_new (name, val, NULL);
+        SEXP_datatype_set (ent, "entity");
+        SEXP_list_add (item, ent);
+        SEXP_vfree (name, val, ent, NULL);
+
+        name = SEXP_string_newf ("uread");
+        val  = SEXP_number_newb (k & 1);
+        ent  = SEXP_list_new (name, val, NULL);
+        SEXP_list_add (item, ent);
+        SEXP_vfree (name, val, ent, NULL);
+
+        name = SEXP_string_newf ("ratio");
+        val  = SEXP_number_newf ((double)k / 4);
+        ent  = SEXP_list_new (name, val, NULL);
+        SEXP_list_add (item, ent);
+        SEXP_vfree (name, val, ent, NULL);
+
+        return (item);
+}
+
+static SEXP_t *new_message (uint32_t items)
+{
+        SEXP_t *msg, *s, *n;
+        uint32_t k;
+
+        s   = SEXP_string_newf ("seap.msg");
+        n   = SEXP_number_newu_32 (items);
+        msg = SEXP_list_new (s, n, NULL);
+        SEXP_vfree (s, n, NULL);
+
+        for (k = 0; k < items; ++k) {
+                s = new_item (k);
+                SEXP_list_add (msg, s);
+                SEXP_free (s);
+        }
+
+        return (msg);
+}
+
+static int test_frames (void)
+{
+        SEXP_t *msg, *s_exp;
+        char   *mem;
+        size_t  len, k;
+        ssize_t ret;
+        int     res = 0;
+
+        msg = new_message (16);
+        mem = encode_b (msg, &len);
+
+        /* incomplete frames */
+        for (k = 0; k < len; ++k) {
+                s_exp = NULL;
+
+                if ((ret = SEXP_parse_b (mem, k, &s_exp)) != 0 || s_exp != NULL) {
+                        fprintf (stderr, "frame: prefix of %zu octets: ret=%zd\n", k, ret);
+                        res = 1;
+                }
+        }
+
+        /* the payload must be consumed exactly */
+        ++mem[1];
+        mem = realloc (mem, len + 1);
+        mem[len] = 0;
+
+        if (SEXP_parse_b (mem, len + 1, &s_exp) != -1 || errno != EILSEQ) {
+                fprintf (stderr, "frame: invalid payload length accepted\n");
+                res = 1;
+        }
+
+        --mem[1];
+        mem[0] = '(';
+
+        if (SEXP_parse_b (mem, len, &s_exp) != -1 || errno != EILSEQ) {
+                fprintf (stderr, "frame: invalid magic accepted\n");
+                res = 1;
+        }
+
+        free (mem);
+        SEXP_free (msg);
+
+        return (res);
+}
+
+static double tv_diff (struct timeval *t0, struct timeval *t1)
+{
+        return ((double)(t1->tv_sec - t0->tv_sec) + (double)(t1->tv_usec - t0->tv_usec) / 1000000.0);
+}
+
+static int benchmark (uint32_t items, uint32_t iterations)
+{
+        struct timeval t0, t1, t2;
+        SEXP_t *msg, *dt, *db;
+        char   *mt, *mb;
+        size_t  lt, lb;
+        double  et = 0, pt = 0, eb = 0, pb = 0;
+        uint32_t i;
+        int     ret;
+
+        msg = new_message (items);
+
+        for (i = 0; i < iterations; ++i) {
+                gettimeofday (&t0, NULL);
+                mt = encode_t (msg, &lt);
+                gettimeofday (&t1, NULL);
+                dt = decode_t (mt, lt);
+                gettimeofday (&t2, NULL);
+
+                et += tv_diff (&t0, &t1);
+                pt += tv_diff (&t1, &t2);
+
+                gettimeofday (&t0, NULL);
+                mb = encode_b (msg, &lb);
+                gettimeofday (&t1, NULL);
+                db = decode_b (mb, lb);
+                gettimeofday (&t2, NULL);
+
+                eb += tv_diff (&t0, &t1);
+                pb += tv_diff (&t1, &t2);
+
+                if (i + 1 < iterations) {
+                        SEXP_free (dt);
+                        SEXP_free (db);
+                        free (mt);
+                        free (mb);
+                }
+        }
+
+        printf ("items=%u iterations=%u\n", items, iterations);
+        printf ("  text:   %10zu octets, encode %.3fs, decode %.3fs\n", lt, et, pt);
+        printf ("  binary: %10zu octets, encode %.3fs, decode %.3fs\n", lb, eb, pb);
+
+        ret = check_same (dt, db, "benchmark");
+
+        SEXP_vfree (msg, dt, db, NULL);
+        free (mt);
+        free (mb);
+
+        return (ret);
+}
+
+int main (int argc, char *argv[])
+{
+        uint32_t items = 100000, iterations = 3;
+        int ret = 0;
+
+        setbuf (stdout, NULL);
+
+        if (argc > 1)
+                items = strtoul (argv[1], NULL, 10);
+        if (argc > 2)
+                iterations = strtoul (argv[2], NULL, 10);
+        if (iterations == 0)
+                iterations = 1;
+
+        ret |= test_numbers ();
+        ret |= test_exact ();
+        ret |= test_frames ();
+        ret |= benchmark (items, iterations);
+
+        return (ret);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <seap.h>
+#include <sexp.h>
+
+/*
+ * The test spawns itself as the peer over the memfd and the pipe schemes
+ * and checks that messages of various sizes (sent inline and through the
+ * ring buffer, wrapping around it several times) come back unchanged.
+ */
+#define TEST_PEER_ENV "TEST_API_SEAP_PEER"
+
+static int peer (void)
+{
+        SEAP_CTX_t *ctx;
+        SEXP_t *s_exp;
+        int sd;
+
+        ctx = SEAP_CTX_new ();
+        sd  = SEAP_openfd2 (ctx, STDIN_FILENO, STDOUT_FILENO, 0);
+
+        if (sd < 0)
+                return (1);
+
+        while (SEAP_recvsexp (ctx, sd, &s_exp) == 0) {
+                if (SEAP_sendsexp (ctx, sd, s_exp) != 0)
+                        return (1);
+
+                SEXP_free (s_exp);
+        }
+
+        SEAP_CTX_free (ctx);
+
+        return (0);
+}
+
+static SEXP_t *new_message (unsigned int id, size_t size)
+{
+        SEXP_t *s_id, *s_data, *msg;
+        char   *data, idbuf[32];
+        size_t  i;
+
+        data = malloc (size);
+
+        for (i = 0; i < size; ++i)
+                data[i] = 'a' + (char)((i + id) % 26);
+
+        snprintf (idbuf, sizeof idbuf, "message-%u", id);
+
+        s_id   = SEXP_string_newf ("%s", idbuf);
+        s_data = SEXP_string_new (data, size);
+        msg    = SEXP_list_new (s_id, s_data, NULL);
+
+        SEXP_free (s_id);
+        SEXP_free (s_data);
+        free (data);
+
+        return (msg);
+}
+
+static double now (void)
+{
+        struct timeval tv;
+
+        gettimeofday (&tv, NULL);
+
+        return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+}
+
+/*
+ * Send `count' messages of `size' octets and check the echoed ones. Up to
+ * `window' messages are in flight; keep it small for large messages, the
+ * peer blocks on sending an echo while we block on sending a message.
+ */
+static int roundtrip (SEAP_CTX_t *ctx, int sd, unsigned int count, size_t size, unsigned int window)
+{
+        SEXP_t *msg, *echo;
+        unsigned int sent, recvd;
+
+        for (sent = 0, recvd = 0; recvd < count; ) {
+                if (sent < count && sent - recvd < window) {
+                        msg = new_message (sent, size);
+
+                        if (SEAP_sendsexp (ctx, sd, msg) != 0) {
+                                fprintf (stderr, "SEAP_sendsexp: %u, %s\n", errno, strerror (errno));
+                                return (1);
+                        }
+
+                        SEXP_free (msg);
+                        ++sent;
+                        continue;
+                }
+
+                if (SEAP_recvsexp (ctx, sd, &echo) != 0) {
+                        fprintf (stderr, "SEAP_recvsexp: %u, %s\n", errno, strerror (errno));
+                        return (1);
+                }
+
+                msg = new_message (recvd, size);
+
+                if (!SEXP_deepcmp (msg, echo)) {
+                        fprintf (stderr, "message %u (%zu octets) differs\n", recvd, size);
+                        return (1);
+                }
+
+                SEXP_free (msg);
+                SEXP_free (echo);
+                ++recvd;
+        }
+
+        return (0);
+}
+
+static int test_scheme (const char *scheme, const char *self)
+{
+        SEAP_CTX_t *ctx;
+        char   uri[PATH_MAX + 16];
+        int    sd, ret;
+        double t;
+
+        snprintf (uri, sizeof uri, "%s://%s", scheme, self);
+
+        ctx = SEAP_CTX_new ();
+        sd  = SEAP_connect (ctx, uri, 0);
+
+        if (sd < 0) {
+                fprintf (stderr, "SEAP_connect(%s): %u, %s\n", uri, errno, strerror (errno));
+                return (1);
+        }
+
+        t = now ();
+        ret = roundtrip (ctx, sd, 64, 16, 8)
+           || roundtrip (ctx, sd, 16, 70 * 1024, 1)
+           || roundtrip (ctx, sd, 4, 5 * 1024 * 1024, 1)
+           || roundtrip (ctx, sd, 48, 1024 * 1024, 1);
+        t = now () - t;
+
+        printf ("%-6s %.3fs\n", scheme, t);
+
+        SEAP_close (ctx, sd);
+        SEAP_CTX_free (ctx);
+
+        return (ret);
+}
+
+int main (int argc, char *argv[])
+{
+        char self[PATH_MAX];
+
+        if (getenv (TEST_PEER_ENV) != NULL)
+                return (peer ());
+
+        if (realpath (argv[0], self) == NULL) {
+                fprintf (stderr, "realpath(%s): %u, %s\n", argv[0], errno, strerror (errno));
+                return (1);
+        }
+
+        setenv (TEST_PEER_ENV, "1", 1);
+
+        if (test_scheme ("memfd", self) != 0)
+                return (1);
+        if (test_scheme ("pipe", self) != 0)
+                return (1);
+
+        return (0);
+}
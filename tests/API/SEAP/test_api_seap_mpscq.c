@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Throughput of the MPSC ring used by the probe item cache. N producer
+ * threads enqueue items (single or in batches), one consumer drains them
+ * in batches and checks that no item is lost and that the items of each
+ * producer arrive in order. A producer canceled while it waits for free
+ * space must not leave the ring locked.
+ *
+ * Usage: test_api_seap_mpscq [items per producer] [max. producers]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "mpscq.h"
+
+#define TEST_QUEUE_CAPACITY 1024
+#define TEST_DRAIN_BATCH    64
+
+struct test_item {
+        uint32_t producer;
+        uint32_t seq;
+        void    *ptr;
+};
+
+struct test_producer {
+        mpscq_t  *q;
+        uint32_t  id;
+        uint32_t  items;
+        uint32_t  batch;
+};
+
+static void *producer_thread (void *arg)
+{
+        struct test_producer *p = arg;
+        struct test_item      items[TEST_DRAIN_BATCH];
+        uint32_t i, n;
+
+        for (i = 0; i < p->items; i += n) {
+                n = p->batch;
+
+                if (n > p->items - i)
+                        n = p->items - i;
+
+                for (uint32_t k = 0; k < n; ++k) {
+                        items[k].producer = p->id;
+                        items[k].seq      = i + k;
+                        items[k].ptr      = NULL;
+                }
+
+                if (mpscq_push (p->q, items, n) != 0) {
+                        fprintf (stderr, "mpscq_push failed\n");
+                        abort ();
+                }
+        }
+
+        return (NULL);
+}
+
+static double tv_diff (struct timeval *t0, struct timeval *t1)
+{
+        return ((double)(t1->tv_sec - t0->tv_sec) + (double)(t1->tv_usec - t0->tv_usec) / 1000000.0);
+}
+
+static int run (uint32_t producers, uint32_t items, uint32_t batch)
+{
+        mpscq_t  *q;
+        pthread_t th[producers];
+        struct test_producer p[producers];
+        uint32_t  expected[producers];
+        struct test_item out[TEST_DRAIN_BATCH];
+        struct timeval t0, t1;
+        uint64_t total, received = 0;
+        uint32_t i, n;
+        double   t;
+        int      ret = 0;
+
+        q = mpscq_new (TEST_QUEUE_CAPACITY, sizeof (struct test_item));
+
+        if (q == NULL) {
+                fprintf (stderr, "mpscq_new failed\n");
+                return (1);
+        }
+
+        total = (uint64_t)producers * items;
+        gettimeofday (&t0, NULL);
+
+        for (i = 0; i < producers; ++i) {
+                p[i].q      = q;
+                p[i].id     = i;
+                p[i].items  = items;
+                p[i].batch  = batch;
+                expected[i] = 0;
+
+                if (pthread_create (&th[i], NULL, producer_thread, &p[i]) != 0) {
+                        fprintf (stderr, "pthread_create failed\n");
+                        abort ();
+                }
+        }
+
+        while (received < total) {
+                n = mpscq_pop (q, out, TEST_DRAIN_BATCH);
+
+                if (n == 0) {
+                        fprintf (stderr, "mpscq_pop failed\n");
+                        abort ();
+                }
+
+                for (i = 0; i < n; ++i) {
+                        if (out[i].producer >= producers || out[i].seq != expected[out[i].producer]) {
+                                fprintf (stderr, "unexpected item: producer=%u, seq=%u\n",
+                                         out[i].producer, out[i].seq);
+                                ret = 1;
+                        } else
+                                ++expected[out[i].producer];
+                }
+
+                received += n;
+        }
+
+        for (i = 0; i < producers; ++i)
+                pthread_join (th[i], NULL);
+
+        gettimeofday (&t1, NULL);
+        t = tv_diff (&t0, &t1);
+
+        printf ("producers=%u batch=%u items=%"PRIu64" time=%.3fs rate=%.0f items/s\n",
+                producers, batch, total, t, t > 0 ? (double)total / t : 0.0);
+
+        mpscq_free (q);
+
+        return (ret);
+}
+
+static void *blocked_producer_thread (void *arg)
+{
+        struct test_item item = { 1, 0, NULL };
+
+        mpscq_push ((mpscq_t *)arg, &item, 1);
+
+        return (NULL);
+}
+
+static int run_cancel (void)
+{
+        mpscq_t  *q;
+        pthread_t th;
+        struct test_item items[TEST_DRAIN_BATCH];
+        uint32_t i, n, received = 0;
+        void    *res;
+        int      ret = 0;
+
+        q = mpscq_new (TEST_DRAIN_BATCH, sizeof (struct test_item));
+
+        if (q == NULL) {
+                fprintf (stderr, "mpscq_new failed\n");
+                return (1);
+        }
+
+        for (i = 0; i < TEST_DRAIN_BATCH; ++i) {
+                items[i].producer = 0;
+                items[i].seq      = i;
+                items[i].ptr      = NULL;
+        }
+
+        /* fill the ring so that the next producer has to wait */
+        if (mpscq_push (q, items, TEST_DRAIN_BATCH) != 0) {
+                fprintf (stderr, "mpscq_push failed\n");
+                abort ();
+        }
+
+        if (pthread_create (&th, NULL, blocked_producer_thread, q) != 0) {
+                fprintf (stderr, "pthread_create failed\n");
+                abort ();
+        }
+
+        usleep (100000);
+        pthread_cancel (th);
+        pthread_join (th, &res);
+
+        if (res != PTHREAD_CANCELED) {
+                fprintf (stderr, "the blocked producer wasn't canceled\n");
+                ret = 1;
+        }
+
+        /* the ring is still usable by the consumer and other producers */
+        while (received < TEST_DRAIN_BATCH) {
+                n = mpscq_pop (q, items, TEST_DRAIN_BATCH);
+
+                if (n == 0) {
+                        fprintf (stderr, "mpscq_pop failed\n");
+                        abort ();
+                }
+
+                received += n;
+        }
+
+        if (mpscq_push (q, items, 1) != 0 || mpscq_pop (q, items, 1) != 1) {
+                fprintf (stderr, "the ring isn't usable after the cancellation\n");
+                ret = 1;
+        }
+
+        mpscq_free (q);
+
+        return (ret);
+}
+
+int main (int argc, char *argv[])
+{
+        uint32_t items = 1000000, max_producers = 8, producers;
+        int ret = 0;
+
+        ret |= run_cancel ();
+
+        if (argc > 1)
+                items = strtoul (argv[1], NULL, 10);
+        if (argc > 2)
+                max_producers = strtoul (argv[2], NULL, 10);
+
+        for (producers = 1; producers <= max_producers; producers <<= 1) {
+                ret |= run (producers, items, 1);
+                ret |= run (producers, items, 32);
+        }
+
+        return (ret);
+}
@@ -4,6 +4,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <strbuf.h>
 #include <string.h>
 #include <inttypes.h>
@@ -13,6 +14,8 @@
 
 static int print_sexp (SEXP_t *s_exp)
 {
+        SEXP_ID_t id[2];
+
         /*
          * print the S-exp in advanced format
          */
@@ -21,6 +24,13 @@ static int print_sexp (SEXP_t *s_exp)
 
         fprintf(stdout, "ID= 0x%"PRIx64"\n", SEXP_ID_v(s_exp));
 
+        SEXP_ID_v128(s_exp, id);
+
+        if (id[0] != SEXP_ID_v(s_exp) || id[1] != SEXP_ID_v2(s_exp)) {
+                fprintf(stderr, "SEXP_ID_v128 doesn't match SEXP_ID_v and SEXP_ID_v2\n");
+                abort();
+        }
+
         return (0);
 }
 
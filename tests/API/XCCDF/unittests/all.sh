@@ -12,6 +12,7 @@ test_run "xccdf:complex-check -- NAND is working properly" ./test_xccdf_shall_pa
 test_run "xccdf:complex-check -- single negation" ./test_xccdf_shall_pass $srcdir/test_xccdf_complex_check_single_negate.xccdf.xml
 test_run "Certain id's of xccdf_items may overlap" ./test_xccdf_shall_pass $srcdir/test_xccdf_overlaping_IDs.xccdf.xml
 test_run "Test Abstract data types." ./test_oscap_common
+test_run "Test hash table lookup performance." ./test_oscap_htable_bench
 test_run "xccdf_rule_result_override" $srcdir/test_xccdf_overrides.sh
 
 test_run "Assert for environment" [ ! -x $srcdir/not_executable ]
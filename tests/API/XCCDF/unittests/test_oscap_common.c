@@ -21,6 +21,7 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include "common/list.h"
 #include "common/util.h"
@@ -229,6 +230,57 @@ static void _test_hit_multiple_items1(void)
 	oscap_htable_free0(h);
 }
 
+static void _test_htable_grow(void)
+{
+	static const int n = 5000;
+	char key[64];
+	int i;
+
+	// The table starts with 1 bucket and has to grow many times.
+	struct oscap_htable *h = oscap_htable_new1(_htable_cmp, 1);
+	for (i = 0; i < n; i++) {
+		snprintf(key, sizeof(key), "xccdf_org.ssgproject.content_rule_%d", i);
+		assume(oscap_htable_add(h, key, (void *)(intptr_t)(i + 1)));
+	}
+	for (i = 0; i < n; i++) {
+		snprintf(key, sizeof(key), "xccdf_org.ssgproject.content_rule_%d", i);
+		assume(!oscap_htable_add(h, key, NULL));
+		assume(oscap_htable_get(h, key) == (void *)(intptr_t)(i + 1));
+	}
+	assume(oscap_htable_get(h, "xccdf_org.ssgproject.content_rule_") == NULL);
+	assume(oscap_htable_get(h, "") == NULL);
+	assume(oscap_htable_get(h, NULL) == NULL);
+	assume(!oscap_htable_add(h, NULL, NULL));
+
+	// Detached items must not come back after the table grows again.
+	for (i = 0; i < n; i += 2) {
+		snprintf(key, sizeof(key), "xccdf_org.ssgproject.content_rule_%d", i);
+		assume(oscap_htable_detach(h, key) == (void *)(intptr_t)(i + 1));
+	}
+	for (i = n; i < 2 * n; i++) {
+		snprintf(key, sizeof(key), "xccdf_org.ssgproject.content_group_%d", i);
+		assume(oscap_htable_add(h, key, (void *)(intptr_t)(i + 1)));
+	}
+	for (i = 0; i < n; i++) {
+		snprintf(key, sizeof(key), "xccdf_org.ssgproject.content_rule_%d", i);
+		assume(oscap_htable_get(h, key) == (i % 2 ? (void *)(intptr_t)(i + 1) : NULL));
+	}
+
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	i = 0;
+	while (oscap_htable_iterator_has_more(hit)) {
+		const struct oscap_htable_item *item = oscap_htable_iterator_next(hit);
+		assume(item != NULL);
+		if (item->key == NULL)
+			continue;
+		assume(oscap_htable_get(h, item->key) == item->value);
+		i++;
+	}
+	assume(i == n / 2 + n);
+	oscap_htable_iterator_free(hit);
+	oscap_htable_free0(h);
+}
+
 static bool _test_list_remove_ptreq(void *a, void *b)
 {
 	return a == b;
@@ -323,6 +375,7 @@ int main(int argc, char *argv[])
 	_test_hit_empty1();
 	_test_hit_single_item1();
 	_test_hit_multiple_items1();
+	_test_htable_grow();
 
 	_test_list_remove();
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+#include "common/list.h"
+#include "common/util.h"
+#include "../../../assume.h"
+
+/*
+ * Lookup benchmark of oscap_htable over a set of IDs shaped like the ones
+ * in the SCAP Security Guide content: a few thousand rules, hundreds of
+ * groups and values, all sharing a long common prefix. The results are
+ * compared against the previous implementation (389 buckets, no resizing)
+ * which is kept here for reference.
+ */
+#define LEGACY_HSIZE 389
+
+struct legacy_item {
+	struct legacy_item *next;
+	char *key;
+	void *value;
+};
+
+struct legacy_htable {
+	struct legacy_item *table[LEGACY_HSIZE];
+};
+
+static unsigned int legacy_hash(const char *str)
+{
+	unsigned h = 0;
+	const unsigned char *p;
+	for (p = (const unsigned char *)str; *p != '\0'; p++)
+		h = (97 * h) + *p;
+	return h % LEGACY_HSIZE;
+}
+
+static void legacy_add(struct legacy_htable *t, const char *key, void *value)
+{
+	unsigned int hashcode = legacy_hash(key);
+	struct legacy_item *item = malloc(sizeof(struct legacy_item));
+	item->key = strdup(key);
+	item->value = value;
+	item->next = t->table[hashcode];
+	t->table[hashcode] = item;
+}
+
+static void *legacy_get(struct legacy_htable *t, const char *key)
+{
+	struct legacy_item *item;
+	for (item = t->table[legacy_hash(key)]; item != NULL; item = item->next)
+		if (strcmp(item->key, key) == 0)
+			return item->value;
+	return NULL;
+}
+
+static void legacy_free(struct legacy_htable *t)
+{
+	struct legacy_item *item, *next;
+	for (int i = 0; i < LEGACY_HSIZE; i++) {
+		for (item = t->table[i]; item != NULL; item = next) {
+			next = item->next;
+			free(item->key);
+			free(item);
+		}
+	}
+	free(t);
+}
+
+static const char *_areas[] = {
+	"accounts_password", "accounts_passwords", "audit_rules", "auditd_data",
+	"file_permissions", "file_owner", "file_groupowner", "mount_option",
+	"package", "service", "sysctl_net_ipv4_conf_all", "sysctl_net_ipv6_conf_default",
+	"sshd", "grub2", "kernel_module", "dconf_gnome", "selinux", "partition_for",
+	"rpm_verify", "set_password_hashing", "no_empty_passwords", "coredump"
+};
+
+static const char *_objects[] = {
+	"var", "var_log", "var_log_audit", "tmp", "home", "etc_passwd", "etc_shadow",
+	"etc_group", "etc_gshadow", "boot", "usr", "dev_shm", "aide", "rsyslog",
+	"chrony", "ntp", "telnet", "rsh", "ypbind", "tftp", "vsftpd", "httpd",
+	"dovecot", "squid", "snmpd", "postfix", "xinetd", "avahi", "cups", "nfs",
+	"bluetooth", "usb_storage", "cramfs", "freevxfs", "jffs2", "hfs", "hfsplus",
+	"squashfs", "udf", "dccp", "sctp", "rds", "tipc", "nodev", "nosuid", "noexec",
+	"umask", "maxrepeat", "minlen", "minclass", "dcredit", "ucredit", "lcredit",
+	"ocredit", "difok", "retry", "deny", "unlock_time", "remember", "warn_age"
+};
+
+#define NAREAS (sizeof(_areas) / sizeof(_areas[0]))
+#define NOBJECTS (sizeof(_objects) / sizeof(_objects[0]))
+
+static char **_generate_ids(size_t *count)
+{
+	static const struct {
+		const char *type;
+		size_t count;
+	} kinds[] = {
+		{ "rule", 2500 }, { "group", 400 }, { "value", 300 }, { "profile", 12 }
+	};
+	size_t n = 0, i, k;
+	char buf[256];
+
+	for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++)
+		n += kinds[k].count;
+
+	char **ids = malloc(n * sizeof(char *));
+	n = 0;
+	for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+		for (i = 0; i < kinds[k].count; i++) {
+			size_t a = i % NAREAS, o = (i / NAREAS) % NOBJECTS, v = i / (NAREAS * NOBJECTS);
+			if (v == 0)
+				snprintf(buf, sizeof(buf), "xccdf_org.ssgproject.content_%s_%s_%s",
+					kinds[k].type, _areas[a], _objects[o]);
+			else
+				snprintf(buf, sizeof(buf), "xccdf_org.ssgproject.content_%s_%s_%s_%zu",
+					kinds[k].type, _areas[a], _objects[o], v);
+			ids[n++] = strdup(buf);
+		}
+	}
+
+	*count = n;
+	return ids;
+}
+
+static double _now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t n, i, found;
+	int rounds = argc > 1 ? atoi(argv[1]) : 200;
+	char **ids = _generate_ids(&n);
+	char **misses = malloc(n * sizeof(char *));
+	char buf[256];
+	double t, t_new, t_legacy;
+
+	for (i = 0; i < n; i++) {
+		// Differ only at the end, as a typo in a reference would.
+		snprintf(buf, sizeof(buf), "%s_", ids[i]);
+		misses[i] = strdup(buf);
+	}
+
+	struct oscap_htable *h = oscap_htable_new();
+	struct legacy_htable *l = calloc(1, sizeof(struct legacy_htable));
+	for (i = 0; i < n; i++) {
+		assume(oscap_htable_add(h, ids[i], ids[i]));
+		legacy_add(l, ids[i], ids[i]);
+	}
+
+	found = 0;
+	t = _now();
+	for (int r = 0; r < rounds; r++) {
+		for (i = 0; i < n; i++) {
+			found += oscap_htable_get(h, ids[i]) == ids[i];
+			found += oscap_htable_get(h, misses[i]) != NULL;
+		}
+	}
+	t_new = _now() - t;
+	assume(found == n * rounds);
+
+	found = 0;
+	t = _now();
+	for (int r = 0; r < rounds; r++) {
+		for (i = 0; i < n; i++) {
+			found += legacy_get(l, ids[i]) == ids[i];
+			found += legacy_get(l, misses[i]) != NULL;
+		}
+	}
+	t_legacy = _now() - t;
+	assume(found == n * rounds);
+
+	printf("%zu IDs, %d rounds of hits and misses\n", n, rounds);
+	printf("oscap_htable: %.1f ns/lookup\n", t_new * 1e9 / (2.0 * n * rounds));
+	printf("legacy:       %.1f ns/lookup\n", t_legacy * 1e9 / (2.0 * n * rounds));
+
+	legacy_free(l);
+	oscap_htable_free0(h);
+	for (i = 0; i < n; i++) {
+		free(ids[i]);
+		free(misses[i]);
+	}
+	free(ids);
+	free(misses);
+
+	return 0;
+}
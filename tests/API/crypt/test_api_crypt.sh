@@ -61,8 +61,9 @@ function test_crapi_mdigest {
     dd if=/dev/urandom of="${TEMPDIR}/d" count=321 bs=1  || return 2
     dd if=/dev/urandom of="${TEMPDIR}/e" count=1   bs=1024k || return 2
     dd if=/dev/urandom of="${TEMPDIR}/f" count=312 bs=1  || return 2
+    dd if=/dev/urandom of="${TEMPDIR}/g" count=301 bs=1k || return 2
     
-    for file in a b c d e f; do
+    for file in a b c d e f g; do
         sum_md5=$((md5sum "${TEMPDIR}/${file}" || openssl md5 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{32\}\).*$|\1|p')
         sum_sha1=$((sha1sum "${TEMPDIR}/${file}" || openssl sha1 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{40\}\).*$|\1|p')
         sum_sha256=$((sha256sum "${TEMPDIR}/${file}" || openssl sha256 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{64\}\).*$|\1|p')
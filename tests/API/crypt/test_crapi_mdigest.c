@@ -56,6 +56,29 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
         return (0);
 }
 
+static void check_sum (const char *filename, const char *fn, const char *alg,
+                       uint8_t *dst, size_t dstlen, const char *orig_sum)
+{
+        char comp_sum[129];
+
+        mem2hex (dst, dstlen, comp_sum, sizeof comp_sum);
+
+        if (strcmp (orig_sum, comp_sum) != 0) {
+                fprintf (stderr, "%s::%s(%s) != %s (== %s)\n", fn, alg, filename, orig_sum, comp_sum);
+                abort ();
+        }
+}
+
+static void check_sums (const char *filename, const char *fn,
+                        uint8_t *md5_dst, size_t md5_dstlen, const char *orig_md5sum,
+                        uint8_t *sha1_dst, size_t sha1_dstlen, const char *orig_sha1sum,
+                        uint8_t *sha256_dst, size_t sha256_dstlen, const char *orig_sha256sum)
+{
+        check_sum (filename, fn, "MD5", md5_dst, md5_dstlen, orig_md5sum);
+        check_sum (filename, fn, "SHA1", sha1_dst, sha1_dstlen, orig_sha1sum);
+        check_sum (filename, fn, "SHA256", sha256_dst, sha256_dstlen, orig_sha256sum);
+}
+
 int main (int argc, char *argv[])
 {
         uint8_t md5_dst[16];
@@ -67,9 +90,9 @@ int main (int argc, char *argv[])
         uint8_t sha256_dst[32];
         size_t  sha256_dstlen = sizeof sha256_dst;
 
-        char *orig_md5sum,  comp_md5sum[(sizeof md5_dst * 2) + 1];
-        char *orig_sha1sum, comp_sha1sum[(sizeof sha1_dst * 2) + 1];
-        char *orig_sha256sum, comp_sha256sum[(sizeof sha256_dst * 2) + 1];
+        char *orig_md5sum;
+        char *orig_sha1sum;
+        char *orig_sha256sum;
         char *filename;
         int   fd;
 
@@ -104,24 +127,41 @@ int main (int argc, char *argv[])
                 abort ();
         }
 
-        mem2hex (md5_dst,  md5_dstlen,  comp_md5sum,  sizeof comp_md5sum);
-        mem2hex (sha1_dst, sha1_dstlen, comp_sha1sum, sizeof comp_sha1sum);
-        mem2hex (sha256_dst, sha256_dstlen, comp_sha256sum, sizeof comp_sha256sum);
-
-        if (strcmp (orig_md5sum, comp_md5sum) != 0) {
-                fprintf (stderr, "crapi_digest::MD5(%s) != %s (== %s)\n", filename, orig_md5sum, comp_md5sum);
-                abort ();
+        check_sums (filename, "crapi_mdigest_fd",
+                    md5_dst, md5_dstlen, orig_md5sum,
+                    sha1_dst, sha1_dstlen, orig_sha1sum,
+                    sha256_dst, sha256_dstlen, orig_sha256sum);
+
+        /*
+         * The same digests requested through the array interface
+         */
+        crapi_mdigest_t req[3] = {
+                { CRAPI_DIGEST_SHA256, &sha256_dst, &sha256_dstlen },
+                { CRAPI_DIGEST_MD5,    &md5_dst,    &md5_dstlen    },
+                { CRAPI_DIGEST_SHA1,   &sha1_dst,   &sha1_dstlen   }
+        };
+
+        memset (md5_dst, 0, sizeof md5_dst);
+        memset (sha1_dst, 0, sizeof sha1_dst);
+        memset (sha256_dst, 0, sizeof sha256_dst);
+        md5_dstlen    = sizeof md5_dst;
+        sha1_dstlen   = sizeof sha1_dst;
+        sha256_dstlen = sizeof sha256_dst;
+
+        if (lseek (fd, 0, SEEK_SET) != 0) {
+                perror ("lseek");
+                return (2);
         }
 
-        if (strcmp (orig_sha1sum, comp_sha1sum) != 0) {
-                fprintf (stderr, "crapi_digest::SHA1(%s) != %s (== %s)\n", filename, orig_sha1sum, comp_sha1sum);
+        if (crapi_mdigest_fdv (fd, req, 3) != 0) {
+                fprintf (stderr, "crapi_mdigest_fdv() != 0\n");
                 abort ();
         }
 
-        if (strcmp (orig_sha256sum, comp_sha256sum) != 0) {
-                fprintf (stderr, "crapi_digest::SHA256(%s) != %s (== %s)\n", filename, orig_sha256sum, comp_sha256sum);
-                abort ();
-        }
+        check_sums (filename, "crapi_mdigest_fdv",
+                    md5_dst, md5_dstlen, orig_md5sum,
+                    sha1_dst, sha1_dstlen, orig_sha1sum,
+                    sha256_dst, sha256_dstlen, orig_sha256sum);
 
         close (fd);
         
@@ -5,4 +5,7 @@
 test_init "test_api_probes.log"
 test_run "fts test" $srcdir/fts.sh
 test_run "probe api smoke test" ./test_api_probes_smoke
+test_run "persistent probe cache" ./test_api_probes_dcache
+test_run "process table snapshot" ./test_api_probes_procsnap
+test_run "textfilecontent54 matcher" ./test_api_probes_tfc54
 test_exit
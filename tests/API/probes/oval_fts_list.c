@@ -4,6 +4,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "sexp.h"
 #include "oval_fts.h"
@@ -18,6 +19,11 @@ int main(int argc, char *argv[])
 	SEXP_psetup_t *psetup = NULL;
 	SEXP_pstate_t *pstate = NULL;
 
+	char   line[4096];
+	char **lines = NULL;
+	size_t count = 0, i;
+	int    pass;
+
 	psetup = SEXP_psetup_new();
 
 	path      = SEXP_list_first(SEXP_parse(psetup, argv[1], strlen(argv[1]), &pstate));
@@ -31,17 +37,43 @@ int main(int argc, char *argv[])
 		"filepath=%p\n"
 		"behaviors=%p\n", path, filename, filepath, behaviors);
 
-	ofts = oval_fts_open(path, filename, filepath, behaviors);
+	/*
+	 * Walk the tree twice. The second walk is served from the directory
+	 * index filled by the first one and must return the same entries;
+	 * any difference is printed so that the result doesn't match.
+	 */
+	for (pass = 0; pass < 2; ++pass) {
+		ofts = oval_fts_open(path, filename, filepath, behaviors);
+
+		if (ofts == NULL)
+			break;
 
-	if (ofts != NULL) {
+		i = 0;
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			printf("%s/%s\n", ofts_ent->path, ofts_ent->file ? ofts_ent->file : "");
+			snprintf(line, sizeof line, "%s/%s", ofts_ent->path, ofts_ent->file ? ofts_ent->file : "");
 			oval_ftsent_free(ofts_ent);
+
+			if (pass == 0) {
+				printf("%s\n", line);
+				lines = realloc(lines, sizeof(char *) * (count + 1));
+				lines[count++] = strdup(line);
+			} else {
+				if (i >= count || strcmp(lines[i], line) != 0)
+					printf("index mismatch: %s\n", line);
+				++i;
+			}
 		}
 
+		if (pass == 1 && i != count)
+			printf("index mismatch: %zu entries, expected %zu\n", i, count);
+
 		oval_fts_close(ofts);
 	}
 
+	for (i = 0; i < count; ++i)
+		free(lines[i]);
+	free(lines);
+
 	SEXP_free(path);
 	SEXP_free(filename);
 	SEXP_free(filepath);
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <seap.h>
+#include <probe-api.h>
+#include "OVAL/probes/probe/dcache.h"
+
+#define PROBE_NAME "probe_textfilecontent54"
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static void write_file (const char *path, const char *data)
+{
+        FILE *fp;
+
+        if ((fp = fopen (path, "w")) == NULL)
+                FAIL(1, "fopen(%s): %s\n", path, strerror (errno));
+
+        fputs (data, fp);
+        fclose (fp);
+}
+
+/*
+ * Overwrite all entries in the cache directory of the probe with garbage
+ */
+static unsigned int corrupt_entries (const char *dir)
+{
+        char path[PATH_MAX];
+        struct dirent *de;
+        unsigned int n = 0;
+        DIR *d;
+
+        if (snprintf (path, sizeof path, "%s/%s", dir, PROBE_NAME) >= (int)sizeof path)
+                FAIL(1, "path too long: %s\n", dir);
+        if ((d = opendir (path)) == NULL)
+                FAIL(1, "opendir(%s): %s\n", path, strerror (errno));
+
+        while ((de = readdir (d)) != NULL) {
+                if (de->d_name[0] == '.')
+                        continue;
+
+                if (snprintf (path, sizeof path, "%s/%s/%s", dir, PROBE_NAME, de->d_name) >= (int)sizeof path)
+                        FAIL(1, "path too long: %s\n", dir);
+
+                write_file (path, "(this is not a cache entry");
+                ++n;
+        }
+
+        closedir (d);
+
+        return (n);
+}
+
+int main (void)
+{
+        char dir[PATH_MAX], path[PATH_MAX], cmd[PATH_MAX + 16];
+        struct probe_dcache_stats stats;
+        probe_dcache_t *cache;
+        SEXP_t *obj, *cobj, *cached, *entry, *s_path, *s_ste, *f_obj;
+
+        snprintf (dir, sizeof dir, "%s/test_api_probes_dcache.XXXXXX",
+                  getenv ("TMPDIR") != NULL ? getenv ("TMPDIR") : "/tmp");
+
+        if (mkdtemp (dir) == NULL)
+                FAIL(1, "mkdtemp: %s\n", strerror (errno));
+
+        if (snprintf (path, sizeof path, "%s/data", dir) >= (int)sizeof path)
+                FAIL(1, "path too long: %s\n", dir);
+
+        write_file (path, "first\n");
+
+        if ((cache = probe_dcache_new (dir, PROBE_NAME)) == NULL)
+                FAIL(1, "probe_dcache_new: %s\n", strerror (errno));
+
+        s_path = SEXP_string_newf ("%s", path);
+        obj    = probe_obj_creat ("textfilecontent54_object", NULL,
+                                  "filepath", NULL, s_path,
+                                  NULL);
+        cobj   = probe_cobj_new (SYSCHAR_FLAG_COMPLETE, NULL, NULL, NULL);
+
+        /* miss & store */
+        if (probe_dcache_get (cache, obj, &entry) != NULL)
+                FAIL(1, "hit in an empty cache\n");
+        if (entry == NULL)
+                FAIL(1, "the object can't be cached\n");
+        if (probe_dcache_add (cache, entry, cobj) != 0)
+                FAIL(1, "probe_dcache_add: %s\n", strerror (errno));
+
+        SEXP_free (entry);
+
+        /* hit */
+        if ((cached = probe_dcache_get (cache, obj, &entry)) == NULL)
+                FAIL(1, "miss after the object was stored\n");
+        if (entry != NULL || !SEXP_deepcmp (cached, cobj))
+                FAIL(1, "unexpected cached collected object\n");
+
+        SEXP_free (cached);
+
+        /* the examined file changes */
+        write_file (path, "second, longer\n");
+
+        if (probe_dcache_get (cache, obj, &entry) != NULL)
+                FAIL(1, "hit after the file changed\n");
+        if (entry == NULL || probe_dcache_add (cache, entry, cobj) != 0)
+                FAIL(1, "can't store the object again\n");
+
+        SEXP_free (entry);
+
+        /* corrupt entries are ignored and replaced */
+        if (corrupt_entries (dir) == 0)
+                FAIL(1, "no cache entry was written\n");
+        if (probe_dcache_get (cache, obj, &entry) != NULL)
+                FAIL(1, "hit on a corrupt entry\n");
+        if (entry == NULL || probe_dcache_add (cache, entry, cobj) != 0)
+                FAIL(1, "can't replace the corrupt entry\n");
+
+        SEXP_free (entry);
+
+        if ((cached = probe_dcache_get (cache, obj, &entry)) == NULL)
+                FAIL(1, "miss after the corrupt entry was replaced\n");
+
+        SEXP_free (cached);
+
+        /* filters refer to states by ID only, such objects aren't cached */
+        s_ste = SEXP_string_newf ("oval:test:ste:1");
+        f_obj = probe_obj_creat ("textfilecontent54_object", NULL,
+                                 "filepath", NULL, s_path,
+                                 "filter",   NULL, s_ste,
+                                 NULL);
+
+        if (probe_dcache_get (cache, f_obj, &entry) != NULL || entry != NULL)
+                FAIL(1, "an object with a filter was cached\n");
+
+        SEXP_vfree (s_ste, f_obj, NULL);
+
+        probe_dcache_stats (cache, &stats);
+
+        if (stats.lookups != 6 || stats.hits != 2 || stats.stale != 1 || stats.stores != 3 ||
+            stats.uncachable != 1)
+                FAIL(1, "unexpected stats: lookups=%llu hits=%llu stale=%llu stores=%llu uncachable=%llu\n",
+                     (unsigned long long)stats.lookups, (unsigned long long)stats.hits,
+                     (unsigned long long)stats.stale, (unsigned long long)stats.stores,
+                     (unsigned long long)stats.uncachable);
+
+        probe_dcache_free (cache);
+
+        /* a directory writable by others is refused */
+        if (snprintf (path, sizeof path, "%s/%s", dir, PROBE_NAME) >= (int)sizeof path)
+                FAIL(1, "path too long: %s\n", dir);
+        if (chmod (path, 0777) != 0)
+                FAIL(1, "chmod(%s): %s\n", path, strerror (errno));
+        if ((cache = probe_dcache_new (dir, PROBE_NAME)) != NULL || errno != EPERM)
+                FAIL(1, "a cache directory writable by others was used\n");
+
+        SEXP_vfree (s_path, obj, NULL);
+
+        /*
+         * The ndb backend of the RPM database updates its files in place,
+         * the mtime of the database directory doesn't change then
+         */
+        if (snprintf (path, sizeof path, "%s/rpmdb", dir) >= (int)sizeof path)
+                FAIL(1, "path too long: %s\n", dir);
+        if (mkdir (path, 0700) != 0)
+                FAIL(1, "mkdir(%s): %s\n", path, strerror (errno));
+        if (setenv ("OSCAP_PROBE_RPMDB_PATH", path, 1) != 0)
+                FAIL(1, "setenv: %s\n", strerror (errno));
+        if (snprintf (path, sizeof path, "%s/rpmdb/Packages.db", dir) >= (int)sizeof path)
+                FAIL(1, "path too long: %s\n", dir);
+
+        write_file (path, "first\n");
+
+        if ((cache = probe_dcache_new (dir, "probe_rpminfo")) == NULL)
+                FAIL(1, "probe_dcache_new: %s\n", strerror (errno));
+
+        s_path = SEXP_string_newf ("bash");
+        obj    = probe_obj_creat ("rpminfo_object", NULL,
+                                  "name", NULL, s_path,
+                                  NULL);
+
+        if (probe_dcache_get (cache, obj, &entry) != NULL || entry == NULL)
+                FAIL(1, "the rpminfo object can't be cached\n");
+        if (probe_dcache_add (cache, entry, cobj) != 0)
+                FAIL(1, "probe_dcache_add: %s\n", strerror (errno));
+
+        SEXP_free (entry);
+
+        if ((cached = probe_dcache_get (cache, obj, &entry)) == NULL)
+                FAIL(1, "miss after the rpminfo object was stored\n");
+
+        SEXP_free (cached);
+
+        write_file (path, "second, longer\n");
+
+        if (probe_dcache_get (cache, obj, &entry) != NULL)
+                FAIL(1, "hit after Packages.db changed\n");
+
+        SEXP_free (entry);
+        probe_dcache_free (cache);
+        SEXP_vfree (s_path, obj, cobj, NULL);
+
+        snprintf (cmd, sizeof cmd, "rm -rf '%s'", dir);
+
+        return (system (cmd) == 0 ? 0 : 1);
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * The process table snapshot is taken from a fake /proc tree created in
+ * the current directory.
+ */
+#define PROCSNAP_PROCDIR "procsnap.root"
+
+#include "procsnap.c"
+
+#if defined(__linux__)
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static void write_file (const char *path, const char *data, size_t len)
+{
+        FILE *fp;
+
+        if ((fp = fopen (path, "w")) == NULL)
+                FAIL(1, "fopen(%s): %s\n", path, strerror (errno));
+
+        fwrite (data, 1, len, fp);
+        fclose (fp);
+}
+
+/* write a string literal, including embedded NUL bytes */
+#define WRITE_STR(path, str) write_file (path, str, sizeof (str) - 1)
+
+static void write_stat (int pid, int ppid, unsigned long long start_time)
+{
+        char path[PATH_MAX], data[512];
+
+        snprintf (path, sizeof path, PROCSNAP_PROCDIR "/%d/stat", pid);
+        snprintf (data, sizeof data,
+                  "%d (my (odd) cmd) S %d %d %d 34816 -1 4194560 10 0 0 0 5 3 0 0 20 0 1 0 %llu "
+                  "10000 100 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n",
+                  pid, ppid, pid, pid, start_time);
+        write_file (path, data, strlen (data));
+}
+
+static void make_proc (int pid, int ppid, unsigned long long start_time)
+{
+        char path[PATH_MAX];
+
+        snprintf (path, sizeof path, PROCSNAP_PROCDIR "/%d", pid);
+        mkdir (path, 0700);
+        snprintf (path, sizeof path, PROCSNAP_PROCDIR "/%d/fd", pid);
+        mkdir (path, 0700);
+
+        write_stat (pid, ppid, start_time);
+}
+
+static void make_socket (int pid, int fd, const char *target)
+{
+        char path[PATH_MAX];
+
+        snprintf (path, sizeof path, PROCSNAP_PROCDIR "/%d/fd/%d", pid, fd);
+
+        if (symlink (target, path) != 0)
+                FAIL(1, "symlink(%s): %s\n", path, strerror (errno));
+}
+
+static procsnap_proc_t *find_pid (procsnap_t *snap, int pid)
+{
+        size_t i;
+
+        for (i = 0; i < procsnap_count (snap); ++i) {
+                if (procsnap_get (snap, i)->pid == pid)
+                        return procsnap_get (snap, i);
+        }
+
+        return (NULL);
+}
+
+/*
+ * Uid and CapEff lines after a Groups line that doesn't fit in a page
+ */
+static void write_status (int pid)
+{
+        char path[PATH_MAX], *data;
+        size_t len = 0, i;
+
+        data = malloc (65536);
+        len += sprintf (data + len, "Name:\tcmd\nState:\tS (sleeping)\nGroups:\t");
+
+        for (i = 0; i < 4096; ++i)
+                len += sprintf (data + len, "%zu ", 100000 + i);
+
+        len += sprintf (data + len, "\nUid:\t1000\t1001\t1001\t1001\n"
+                                    "CapInh:\t0000000000000000\n"
+                                    "CapEff:\t0000000000003000");
+
+        snprintf (path, sizeof path, PROCSNAP_PROCDIR "/%d/status", pid);
+        write_file (path, data, len);
+        free (data);
+}
+
+int main (void)
+{
+        procsnap_t *snap;
+        procsnap_proc_t *p, *p100, *p200;
+        char path[PATH_MAX];
+
+        if (system ("rm -rf " PROCSNAP_PROCDIR) != 0 || mkdir (PROCSNAP_PROCDIR, 0700) != 0)
+                FAIL(1, "mkdir(" PROCSNAP_PROCDIR "): %s\n", strerror (errno));
+
+        WRITE_STR(PROCSNAP_PROCDIR "/stat", "cpu 1 2 3\nbtime 1000\nprocesses 5\n");
+
+        make_proc (2, 0, 1);      /* kthreadd */
+        make_proc (3, 2, 1);      /* kernel thread */
+        make_proc (100, 1, 5000);
+        make_proc (200, 1, 6000);
+        make_proc (300, 1, 7000);
+
+        write_status (100);
+        WRITE_STR(PROCSNAP_PROCDIR "/100/loginuid", "1000");
+        WRITE_STR(PROCSNAP_PROCDIR "/100/cmdline", "cmd\0-l\0arg\n\0\0");
+        WRITE_STR(PROCSNAP_PROCDIR "/300/status", "Uid:\t0\t0\t0\t0\n");
+
+        make_socket (100, 3, "socket:[4242]");
+        make_socket (100, 4, "/dev/null");
+        make_socket (200, 5, "socket:[4242]");
+        make_socket (200, 6, "socket:[77]");
+
+        snap = procsnap_new ();
+
+        if (procsnap_load (snap) != 0)
+                FAIL(1, "procsnap_load failed\n");
+
+        /* parsing of the stat files */
+        if (procsnap_count (snap) != 3)
+                FAIL(1, "expected 3 processes, got %zu\n", procsnap_count (snap));
+        if (procsnap_boot_time (snap) != 1000)
+                FAIL(1, "boot time: %lu\n", procsnap_boot_time (snap));
+        if (find_pid (snap, 2) != NULL || find_pid (snap, 3) != NULL)
+                FAIL(1, "kernel threads are in the snapshot\n");
+
+        p100 = find_pid (snap, 100);
+        p200 = find_pid (snap, 200);
+
+        if (p100 == NULL || p200 == NULL || find_pid (snap, 300) == NULL)
+                FAIL(1, "a process is missing\n");
+        if (strcmp (p100->comm, "my (odd) cmd") != 0)
+                FAIL(1, "comm: \"%s\"\n", p100->comm);
+        if (p100->state != 'S' || p100->ppid != 1 || p100->pgrp != 100 ||
+            p100->tty_nr != 34816 || p100->utime != 5 || p100->stime != 3 ||
+            p100->priority != 20 || p100->start_time != 5000)
+                FAIL(1, "the stat file of 100 wasn't parsed correctly\n");
+
+        /* lazily attached information */
+        procsnap_attach (snap, p100, PROCSNAP_UIDS | PROCSNAP_CMDLINE | PROCSNAP_LABEL);
+
+        if (p100->ruid != 1000 || p100->euid != 1001 || p100->loginuid != 1000)
+                FAIL(1, "uids: %d %d %u\n", p100->ruid, p100->euid, p100->loginuid);
+        if (!p100->cap_valid || p100->cap_eff != 0x3000)
+                FAIL(1, "CapEff after a long Groups line wasn't read\n");
+        if (p100->cmdline == NULL || strcmp (p100->cmdline, "cmd -l arg ") != 0)
+                FAIL(1, "cmdline: \"%s\"\n", p100->cmdline != NULL ? p100->cmdline : "(null)");
+        if (p100->label != NULL)
+                FAIL(1, "unexpected label\n");
+
+        /* the pid was reused after the snapshot was taken */
+        write_stat (300, 1, 8000);
+        p = find_pid (snap, 300);
+        procsnap_attach (snap, p, PROCSNAP_UIDS);
+
+        if (p->ruid != -1 || p->euid != -1 || p->cap_valid)
+                FAIL(1, "the information of a reused pid was read\n");
+
+        /* socket index; a shared socket belongs to the first process */
+        p = procsnap_find_socket (snap, 4242);
+
+        if (p != (p100 < p200 ? p100 : p200))
+                FAIL(1, "socket 4242: wrong process\n");
+        if (procsnap_find_socket (snap, 77) != p200)
+                FAIL(1, "socket 77 wasn't found\n");
+        if (procsnap_find_socket (snap, 99) != NULL)
+                FAIL(1, "found a socket that isn't open\n");
+        if (p100->socket_count != 1 || p200->socket_count != 2)
+                FAIL(1, "socket counts: %zu %zu\n", p100->socket_count, p200->socket_count);
+        if (p200->ruid != -1 || (p200->attached & PROCSNAP_UIDS) == 0)
+                FAIL(1, "uids of 200 weren't attached by the socket index\n");
+
+        /* a reset snapshot walks the tree again */
+        snprintf (path, sizeof path, "rm -rf " PROCSNAP_PROCDIR "/200");
+
+        if (system (path) != 0)
+                FAIL(1, "%s failed\n", path);
+
+        procsnap_reset (snap);
+
+        if (procsnap_load (snap) != 0 || procsnap_count (snap) != 2)
+                FAIL(1, "the snapshot wasn't taken again after a reset\n");
+        if (procsnap_find_socket (snap, 77) != NULL)
+                FAIL(1, "the socket index wasn't reset\n");
+
+        procsnap_free (snap);
+        system ("rm -rf " PROCSNAP_PROCDIR);
+
+        return (0);
+}
+
+#else
+int main (void)
+{
+        return (0);
+}
+#endif /* __linux__ */
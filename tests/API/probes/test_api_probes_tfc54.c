@@ -0,0 +1,351 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * The matchers of the textfilecontent54 probe with small thresholds, so
+ * that a few hundred KiB file is mapped or matched in many windows.
+ */
+#define TFC54_MMAP_MINSIZE   (16 * 1024)
+#define TFC54_STREAM_MINSIZE (256 * 1024)
+#define TFC54_STREAM_CHUNK   4096
+#define TFC54_STREAM_CONTEXT 64
+
+#include "textfilecontent54.c"
+
+#define TFC54_TEST_FILE "tfc54.test"
+#define FOUND_MAX       4096
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static SEXP_t *result;
+static char   *found[FOUND_MAX];
+static size_t  found_cnt;
+static void  (*collect_hook)(size_t) = NULL;
+
+/*
+ * The probe library isn't linked, the calls of the probe to it are
+ * answered here. Collected items are reduced to their text.
+ */
+SEXP_t *probe_ctx_getobject (probe_ctx *ctx)
+{
+        return (NULL);
+}
+
+SEXP_t *probe_ctx_getresult (probe_ctx *ctx)
+{
+        return (result);
+}
+
+int probe_setoption (int option, ...)
+{
+        return (0);
+}
+
+oval_result_t probe_entobj_cmp (SEXP_t *ent_obj, SEXP_t *val)
+{
+        return (OVAL_RESULT_TRUE);
+}
+
+int probe_item_collect (probe_ctx *ctx, SEXP_t *item)
+{
+        SEXP_t *text;
+
+        if (found_cnt == FOUND_MAX)
+                FAIL(1, "too many items\n");
+
+        text = probe_obj_getentval (item, "text", 1);
+        found[found_cnt++] = SEXP_string_cstr (text);
+        SEXP_free (text);
+        SEXP_free (item);
+
+        if (collect_hook != NULL)
+                collect_hook (found_cnt);
+
+        return (0);
+}
+
+static void found_clear (void)
+{
+        while (found_cnt > 0)
+                free (found[--found_cnt]);
+}
+
+static void pfd_init (struct pfdata *pfd, const char *pattern, bool multiline)
+{
+        memset (pfd, 0, sizeof *pfd);
+        pfd->pattern = oscap_strdup (pattern);
+        pfd->context = TFC54_STREAM_CONTEXT;
+#if defined USE_REGEX_PCRE
+        const char *error;
+        int erroffset;
+
+        pfd->re_opts = PCRE_UTF8 | (multiline ? PCRE_MULTILINE : 0);
+        pfd->compiled_regex = pcre_compile (pattern, pfd->re_opts, &error, &erroffset, NULL);
+
+        if (pfd->compiled_regex == NULL)
+                FAIL(1, "pcre_compile(%s): %s\n", pattern, error);
+# if defined(TFC54_STREAM) && defined(PCRE_INFO_MAXLOOKBEHIND)
+        int lookbehind = 0;
+
+        if (pcre_fullinfo (pfd->compiled_regex, NULL, PCRE_INFO_MAXLOOKBEHIND, &lookbehind) == 0
+            && (size_t)lookbehind * 4 + 1 > pfd->context)
+                pfd->context = (size_t)lookbehind * 4 + 1;
+# endif
+#elif defined USE_REGEX_POSIX
+        static regex_t re;
+
+        pfd->re_opts = REG_EXTENDED | (multiline ? REG_NEWLINE : 0);
+        pfd->compiled_regex = &re;
+
+        if (regcomp (pfd->compiled_regex, pattern, pfd->re_opts) != 0)
+                FAIL(1, "regcomp(%s) failed\n", pattern);
+#endif
+        result = probe_cobj_new (SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+}
+
+static void pfd_free (struct pfdata *pfd)
+{
+        oscap_free (pfd->pattern);
+        oscap_free (pfd->instance_res);
+#if defined USE_REGEX_PCRE
+        pcre_free (pfd->compiled_regex);
+#elif defined USE_REGEX_POSIX
+        regfree (pfd->compiled_regex);
+#endif
+        SEXP_free (result);
+        result = NULL;
+        found_clear ();
+}
+
+/*
+ * Match the test file the way the probe does and compare the items
+ * with those found in the whole file read into memory.
+ */
+static void check_file (const char *data, size_t size, const char *pattern, bool multiline, size_t expected)
+{
+        struct pfdata pfd;
+        char *ref[FOUND_MAX];
+        size_t ref_cnt, i;
+        FILE *fp;
+
+        if ((fp = fopen (TFC54_TEST_FILE, "w")) == NULL || fwrite (data, 1, size, fp) != size)
+                FAIL(1, "can't write " TFC54_TEST_FILE ": %s\n", strerror (errno));
+        fclose (fp);
+
+        pfd_init (&pfd, pattern, multiline);
+
+        if (process_buffer (&pfd, ".", TFC54_TEST_FILE, data, size) != 0)
+                FAIL(1, "%s: the reference matcher failed\n", pattern);
+        if (found_cnt != expected)
+                FAIL(1, "%s: expected %zu items, the reference matcher found %zu\n", pattern, expected, found_cnt);
+
+        ref_cnt = found_cnt;
+        memcpy (ref, found, ref_cnt * sizeof (char *));
+        found_cnt = 0;
+
+        if (process_file (".", TFC54_TEST_FILE, &pfd) != 0)
+                FAIL(1, "%s: the matcher failed\n", pattern);
+        if (found_cnt != ref_cnt)
+                FAIL(1, "%s: %zu items found, expected %zu\n", pattern, found_cnt, ref_cnt);
+
+        for (i = 0; i < ref_cnt; ++i) {
+                if (strcmp (found[i], ref[i]) != 0)
+                        FAIL(1, "%s: item %zu is \"%.40s\", expected \"%.40s\"\n", pattern, i + 1, found[i], ref[i]);
+                free (ref[i]);
+        }
+
+        pfd_free (&pfd);
+}
+
+/*
+ * Filler lines, `tail' is written at each offset in `at'
+ */
+static char *make_data (size_t size, const size_t *at, size_t at_cnt, const char *tail)
+{
+        char *data;
+        size_t i;
+
+        data = malloc (size);
+
+        for (i = 0; i < size; ++i)
+                data[i] = (i % 61 == 60) ? '\n' : 'a' + i % 23;
+
+        for (i = 0; i < at_cnt; ++i)
+                memcpy (data + at[i], tail, strlen (tail));
+
+        return (data);
+}
+
+#if defined(TFC54_STREAM)
+static void test_stream (void)
+{
+        const size_t size = TFC54_STREAM_MINSIZE + 10 * TFC54_STREAM_CHUNK;
+        size_t at[32], at_cnt = 0, k;
+        char *data, *p;
+
+        /* matches around the window boundaries, lines starting right at them */
+        for (k = 1; k < 20; k += 2) {
+                at[at_cnt++] = k * TFC54_STREAM_CHUNK - 7;
+                at[at_cnt++] = (k + 1) * TFC54_STREAM_CHUNK - 1;
+        }
+
+        data = make_data (size, at, at_cnt, "\n<tag>value 12345</tag>\n");
+        check_file (data, size, "<tag>[^<]*</tag>", false, at_cnt);
+
+        /* ^ and $ at the window boundaries, a lookbehind reaching back over them */
+        for (k = 0; k < at_cnt; ++k)
+                memcpy (data + at[k], "\nkey=value\nid=12345\n", 20);
+
+        check_file (data, size, "^key=(\\w+)$", true, at_cnt);
+        check_file (data, size, "(?<=id=)\\d+", false, at_cnt);
+        free (data);
+
+        /* the first window ends right after the lookbehind */
+        at[0] = TFC54_STREAM_CHUNK - 4;
+        data  = make_data (size, at, 1, "\nid=12345\n");
+        check_file (data, size, "(?<=id=)\\d+", false, 1);
+
+        /* matches longer than a window are retried with more data */
+        p = data + 3 * TFC54_STREAM_CHUNK - 100;
+        memcpy (p, "BEGIN", 5);
+        memset (p + 5, 'x', 5 * TFC54_STREAM_CHUNK);
+        memcpy (p + 5 + 5 * TFC54_STREAM_CHUNK, "END", 3);
+        p = data + size - TFC54_STREAM_CHUNK / 2;
+        memcpy (p, "BEGINxEND", 9);
+
+        check_file (data, size, "BEGINx*END", false, 2);
+
+        /* a partial match which doesn't become a match */
+        data[3 * TFC54_STREAM_CHUNK - 95 + 5 * TFC54_STREAM_CHUNK] = 'y';
+
+        check_file (data, size, "BEGINx*END", false, 1);
+
+        free (data);
+}
+#endif /* TFC54_STREAM */
+
+#if defined(TFC54_MMAP)
+static volatile sig_atomic_t sigbus_chained = 0;
+
+static void test_sigbus_handler (int sig)
+{
+        sigbus_chained = 1;
+}
+
+static void truncate_file (size_t n)
+{
+        if (n == 1 && truncate (TFC54_TEST_FILE, 0) != 0)
+                FAIL(1, "truncate(): %s\n", strerror (errno));
+}
+
+static void raise_sigbus (size_t n)
+{
+        if (n == 1)
+                raise (SIGBUS);
+}
+
+static void run_hooked (size_t size, size_t at_cnt, void (*hook)(size_t), size_t *cnt, oval_syschar_collection_flag_t *flag)
+{
+        struct pfdata pfd;
+        size_t at[16], i;
+        char *data;
+        FILE *fp;
+
+        for (i = 0; i < at_cnt; ++i)
+                at[i] = i * (size / at_cnt);
+
+        data = make_data (size, at, at_cnt, "<tag>");
+
+        if ((fp = fopen (TFC54_TEST_FILE, "w")) == NULL || fwrite (data, 1, size, fp) != size)
+                FAIL(1, "can't write " TFC54_TEST_FILE ": %s\n", strerror (errno));
+        fclose (fp);
+        free (data);
+
+        pfd_init (&pfd, "<tag>", false);
+        collect_hook = hook;
+        process_file (".", TFC54_TEST_FILE, &pfd);
+        collect_hook = NULL;
+
+        *cnt  = found_cnt;
+        *flag = probe_cobj_get_flag (result);
+        pfd_free (&pfd);
+}
+
+static void test_sigbus (void)
+{
+        struct sigaction act;
+        oval_syschar_collection_flag_t flag;
+        size_t cnt;
+
+        /* the handler of the probe chains this one */
+        memset (&act, 0, sizeof act);
+        sigemptyset (&act.sa_mask);
+        act.sa_handler = test_sigbus_handler;
+
+        if (sigaction (SIGBUS, &act, NULL) != 0 || tfc54_sigbus_init () != 0)
+                FAIL(1, "sigaction(): %s\n", strerror (errno));
+
+        /* a mapped file truncated while it is matched */
+        run_hooked (4 * TFC54_MMAP_MINSIZE, 8, truncate_file, &cnt, &flag);
+
+        if (flag != SYSCHAR_FLAG_ERROR || cnt != 1)
+                FAIL(1, "truncated mapping: %zu items, flag %d\n", cnt, flag);
+        if (sigbus_chained)
+                FAIL(1, "the fault in the mapping was passed on\n");
+
+#if defined(TFC54_STREAM)
+        /* a file read in windows ends where it was truncated */
+        run_hooked (2 * TFC54_STREAM_MINSIZE, 8, truncate_file, &cnt, &flag);
+
+        if (flag == SYSCHAR_FLAG_ERROR || cnt < 1 || cnt == 8)
+                FAIL(1, "truncated stream: %zu items, flag %d\n", cnt, flag);
+#endif
+        /* SIGBUS which isn't a fault in the mapping is passed on */
+        run_hooked (4 * TFC54_MMAP_MINSIZE, 8, raise_sigbus, &cnt, &flag);
+
+        if (!sigbus_chained)
+                FAIL(1, "SIGBUS wasn't passed to the previous handler\n");
+        if (flag == SYSCHAR_FLAG_ERROR || cnt != 8)
+                FAIL(1, "matching was interrupted: %zu items, flag %d\n", cnt, flag);
+}
+#endif /* TFC54_MMAP */
+
+int main (void)
+{
+        over = OVAL_SCHEMA_VERSION(5.10);
+
+#if defined(TFC54_STREAM)
+        test_stream ();
+#endif
+#if defined(TFC54_MMAP)
+        test_sigbus ();
+#endif
+        unlink (TFC54_TEST_FILE);
+
+        return (0);
+}
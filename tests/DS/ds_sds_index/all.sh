@@ -8,4 +8,7 @@ test_init ds_sds_index.log
 test_run "ds_sds_index" ./test_ds_sds_index $srcdir/sds.xml
 test_run "ds_sds_index_multiple" ./test_ds_sds_index_multiple $srcdir/sds_multiple.xml
 test_run "ds_sds_index_invalid" ./test_ds_sds_index_invalid $srcdir/sds_invalid.xml
+test_run "ds_sds_index_ranges" ./test_ds_sds_index_ranges $srcdir/../sds_ranges/sds.xml \
+	$srcdir/../eval_simple/sds.xml $srcdir/../eval_xccdf_id/sds-complex.xml $srcdir/../cpe_in_ds/sds.xml \
+	$srcdir/sds.xml $srcdir/sds_multiple.xml
 test_exit
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+
+#include "common/public/oscap.h"
+#include "common/public/oscap_error.h"
+#include "DS/ds_sds_session_priv.h"
+#include "DS/public/ds_sds_session.h"
+#include "DS/public/scap_ds.h"
+#include "DS/sds_index_priv.h"
+#include "source/oscap_source_priv.h"
+#include "source/public/oscap_source.h"
+
+/*
+ * The data stream collection is indexed by byte ranges, unless it has
+ * a DOCTYPE or isn't encoded in UTF-8. The components split from the
+ * ranges have to be byte-identical to the ones split from the DOM.
+ */
+
+static int failures = 0;
+
+static char *read_file(const char *path, size_t *size)
+{
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) {
+		fprintf(stderr, "fopen(%s): %s\n", path, strerror(errno));
+		exit(2);
+	}
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	char *buffer = malloc(len + 1);
+	if (fread(buffer, 1, len, fp) != (size_t) len) {
+		fprintf(stderr, "fread(%s): %s\n", path, strerror(errno));
+		exit(2);
+	}
+	fclose(fp);
+	*size = len;
+	return buffer;
+}
+
+/* replaces the XML declaration with `decl' */
+static char *new_variant(const char *buffer, size_t size, const char *decl, size_t *variant_size)
+{
+	const char *end = strstr(buffer, "?>");
+	if (strncmp(buffer, "<?xml", 5) != 0 || end == NULL) {
+		fprintf(stderr, "The document doesn't start with an XML declaration.\n");
+		exit(2);
+	}
+	end += 2;
+
+	size_t rest = size - (end - buffer);
+	*variant_size = strlen(decl) + rest;
+	char *variant = malloc(*variant_size);
+	memcpy(variant, decl, strlen(decl));
+	memcpy(variant + strlen(decl), end, rest);
+	return variant;
+}
+
+static void check_scan(const char *path, const char *variant, const char *buffer, size_t size, int expected)
+{
+	xmlTextReader *reader = xmlReaderForMemory(buffer, size, NULL, NULL, 0);
+	struct ds_sds_index *index = reader != NULL ? ds_sds_index_parse(reader) : NULL;
+	xmlFreeTextReader(reader);
+
+	if (index == NULL) {
+		fprintf(stderr, "FAIL: %s (%s): the index can't be parsed\n", path, variant);
+		++failures;
+		return;
+	}
+	int ret = ds_sds_index_scan(index, buffer, size);
+	if (ret != expected) {
+		fprintf(stderr, "FAIL: %s (%s): ds_sds_index_scan returned %d, expected %d\n", path, variant, ret, expected);
+		++failures;
+	}
+	ds_sds_index_free(index);
+}
+
+static int split(struct oscap_source *source, const char *target_dir, int ranges)
+{
+	int ret = -1;
+	const char *datastream_id = NULL;
+	const char *component_id = NULL;
+	const struct ds_sds_element_range *range = NULL;
+
+	struct ds_sds_session *session = ds_sds_session_new_from_source(source);
+	if (session == NULL)
+		goto cleanup;
+	if (ds_sds_index_select_checklist(ds_sds_session_get_sds_idx(session), &datastream_id, &component_id) != 0)
+		goto cleanup;
+	if (ds_sds_session_get_component_range(session, component_id, &range) != (ranges ? 0 : 1)) {
+		fprintf(stderr, "FAIL: the components are %sparsed from their ranges\n", ranges ? "not " : "");
+		goto cleanup;
+	}
+	ds_sds_session_set_datastream_id(session, datastream_id);
+	ds_sds_session_set_target_dir(session, target_dir);
+	if (ds_sds_session_register_component_with_dependencies(session, "checklists", component_id, NULL) != 0)
+		goto cleanup;
+	ret = ds_sds_session_dump_component_files(session);
+
+cleanup:
+	if (ret != 0 && oscap_err()) {
+		char *error = oscap_err_get_full_error();
+		fprintf(stderr, "%s\n", error);
+		free(error);
+	}
+	ds_sds_session_free(session);
+	oscap_source_free(source);
+	return ret;
+}
+
+static void check_split(const char *path, const char *buffer, size_t size)
+{
+	char dir[PATH_MAX], ranges_dir[PATH_MAX + 8], dom_dir[PATH_MAX + 8], cmd[3 * PATH_MAX];
+
+	snprintf(dir, sizeof(dir), "%s/test_ds_sds_index_ranges.XXXXXX",
+		getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp");
+	if (mkdtemp(dir) == NULL) {
+		fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+		exit(2);
+	}
+	snprintf(ranges_dir, sizeof(ranges_dir), "%s/ranges", dir);
+	snprintf(dom_dir, sizeof(dom_dir), "%s/dom", dir);
+	if (mkdir(ranges_dir, 0700) != 0 || mkdir(dom_dir, 0700) != 0) {
+		fprintf(stderr, "mkdir: %s\n", strerror(errno));
+		exit(2);
+	}
+
+	// A source built from a DOM has no serialized form to take ranges from.
+	xmlDoc *doc = xmlReadMemory(buffer, size, NULL, NULL, 0);
+	if (split(oscap_source_new_from_memory(buffer, size, path), ranges_dir, 1) != 0 ||
+	    split(oscap_source_new_from_xmlDoc(doc, path), dom_dir, 0) != 0) {
+		fprintf(stderr, "FAIL: %s: the components can't be split\n", path);
+		++failures;
+	}
+	else {
+		snprintf(cmd, sizeof(cmd), "diff -r '%s' '%s'", ranges_dir, dom_dir);
+		if (system(cmd) != 0) {
+			fprintf(stderr, "FAIL: %s: the components split from the ranges differ\n", path);
+			++failures;
+		}
+	}
+
+	snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+	if (system(cmd) != 0)
+		exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		printf("Invalid arguments, usage: ./test_ds_sds_index_ranges FILE...\n");
+		return 2;
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		size_t size, variant_size;
+		char *buffer = read_file(argv[i], &size);
+
+		check_scan(argv[i], "UTF-8", buffer, size, 0);
+		check_split(argv[i], buffer, size);
+
+		char *variant = new_variant(buffer, size,
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE ds:data-stream-collection>", &variant_size);
+		check_scan(argv[i], "DOCTYPE", variant, variant_size, -1);
+		free(variant);
+
+		variant = new_variant(buffer, size,
+			"<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>", &variant_size);
+		check_scan(argv[i], "ISO-8859-1", variant, variant_size, -1);
+		free(variant);
+
+		free(buffer);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#!/bin/bash
+
+set -e -o pipefail
+
+. ../../test_common.sh
+
+test_init rds_embed.log
+test_run "rds_embed" ./test_rds_embed
+test_exit
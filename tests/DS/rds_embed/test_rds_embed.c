@@ -0,0 +1,184 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Documents embedded into an ARF are copied as they were serialized when
+ * possible. rds.c is included to reach ds_rds_find_root_element() and
+ * ds_rds_write_source().
+ */
+#include "DS/rds.c"
+
+static int failures = 0;
+
+/* `expected' is the root element found in `doc', NULL if it can't be copied */
+static void check_root(const char *doc, const char *expected)
+{
+	size_t len = 0;
+	const char *root = ds_rds_find_root_element(doc, strlen(doc), &len);
+
+	if (expected == NULL && root == NULL)
+		return;
+	if (expected != NULL && root != NULL && strlen(expected) == len && memcmp(root, expected, len) == 0)
+		return;
+
+	fprintf(stderr, "FAIL: '%s'\n  expected: '%s'\n  found:    '%.*s'\n", doc,
+		expected != NULL ? expected : "(null)", root != NULL ? (int) len : 6, root != NULL ? root : "(null)");
+	++failures;
+}
+
+struct write_source_arg {
+	struct oscap_source *source;
+};
+
+static int write_source(xmlTextWriterPtr writer, void *arg)
+{
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	xmlNodePtr content = xmlNewNode(NULL, BAD_CAST "content");
+	xmlDocSetRootElement(doc, content);
+
+	int ret = 0;
+	if (oscap_xml_writer_start_node(writer, content) != 0 ||
+	    ds_rds_write_source(writer, content, ((struct write_source_arg *) arg)->source) != 0 ||
+	    oscap_xml_writer_end_node(writer, content) != 0)
+		ret = -1;
+
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+/* the document embedded into a <content> element */
+static void check_write(const char *doc, size_t size, const char *expected)
+{
+	struct write_source_arg arg = { oscap_source_new_from_memory(doc, size, "embedded.xml") };
+	char *buffer = NULL;
+	size_t buffer_size = 0;
+
+	if (oscap_xml_save_writer_memory(&buffer, &buffer_size, write_source, &arg) != 0) {
+		fprintf(stderr, "FAIL: '%s' couldn't be embedded\n", doc);
+		++failures;
+	}
+	else if (buffer_size != strlen(expected) || memcmp(buffer, expected, buffer_size) != 0) {
+		fprintf(stderr, "FAIL: '%s'\n  expected: '%s'\n  written:  '%.*s'\n", doc, expected, (int) buffer_size, buffer);
+		++failures;
+	}
+
+	free(buffer);
+	oscap_source_free(arg.source);
+}
+
+/* nodes under a node whose start tag wasn't written are refused */
+static int write_unstarted(xmlTextWriterPtr writer, void *arg)
+{
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	xmlNodePtr content = xmlNewNode(NULL, BAD_CAST "content");
+	xmlDocSetRootElement(doc, content);
+	xmlNodePtr report = xmlNewChild(content, NULL, BAD_CAST "report", NULL);
+	xmlNodePtr first = xmlNewChild(report, NULL, BAD_CAST "first", NULL);
+	xmlNodePtr second = xmlNewChild(report, NULL, BAD_CAST "second", NULL);
+
+	int ret = 0;
+	if (oscap_xml_writer_start_node(writer, content) != 0 ||
+	    oscap_xml_writer_flush_node(writer, first) != -1 ||
+	    oscap_xml_writer_start_node(writer, second) != -1 ||
+	    oscap_xml_writer_end_node(writer, report) != -1 ||
+	    oscap_xml_writer_end_node(writer, content) != 0)
+		ret = -1;
+
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+static void check_unstarted(void)
+{
+	char *buffer = NULL;
+	size_t buffer_size = 0;
+	const char *expected = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<content/>\n";
+
+	if (oscap_xml_save_writer_memory(&buffer, &buffer_size, write_unstarted, NULL) != 0) {
+		fprintf(stderr, "FAIL: the nodes under an unstarted node weren't refused\n");
+		++failures;
+	}
+	else if (buffer_size != strlen(expected) || memcmp(buffer, expected, buffer_size) != 0) {
+		fprintf(stderr, "FAIL: unstarted node\n  expected: '%s'\n  written:  '%.*s'\n", expected, (int) buffer_size, buffer);
+		++failures;
+	}
+
+	free(buffer);
+}
+
+int main(int argc, char **argv)
+{
+	check_root("<a/>", "<a/>");
+	check_root("  <a>x</a>\n\n", "<a>x</a>");
+
+	/* XML declaration, byte order mark */
+	check_root("<?xml version=\"1.0\"?>\n<a/>", "<a/>");
+	check_root("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<a/>\n", "<a/>");
+	check_root("\xEF\xBB\xBF<?xml version=\"1.0\" encoding=\"UTF-8\"?><a/>", "<a/>");
+	check_root("\xEF\xBB\xBF<a/>", "<a/>");
+	check_root("<?xml version='1.0' encoding='utf-8'?><a/>", "<a/>");
+	check_root("<?xml version=\"1.0\" encoding = 'US-ASCII' ?><a/>", "<a/>");
+	check_root("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?><a/>", NULL);
+	check_root("<?xml version='1.0' encoding='UTF-16'?><a/>", NULL);
+	check_root("<?xml version='1.0' encoding='UTF-8\"?><a/>", NULL);
+	check_root("<?xml version='1.0' encoding=UTF-8?><a/>", NULL);
+	check_root("<?xml version='1.0'", NULL);
+
+	/* comments and processing instructions around the root element */
+	check_root("<?xml version=\"1.0\"?>\n<!-- <b/> -->\n<?xml-stylesheet href=\"a.xsl\"?>\n<a><!-- c --></a>",
+		   "<a><!-- c --></a>");
+	check_root("<?xml-stylesheet href=\"a.xsl\"?><a/>", "<a/>");
+	check_root("<a><?pi?></a>\n<!-- end -->\n<?pi x?>\n", "<a><?pi?></a>");
+	check_root("<a/><!---->", "<a/>");
+	check_root("<a-->x</a-->", "<a-->x</a-->");
+	check_root("<a--><!-- c --></a-->", "<a--><!-- c --></a-->");
+	check_root("<!-- unterminated <a/>", NULL);
+	check_root("<?pi <a/>", NULL);
+	check_root("<!-- only a comment -->", NULL);
+	check_root("", NULL);
+
+	/* DOCTYPE, the DOM is serialized instead */
+	check_root("<?xml version=\"1.0\"?>\n<!DOCTYPE a [<!ENTITY e \"x\">]>\n<a>&e;</a>", NULL);
+	check_root("<!-- c --><!DOCTYPE a><a/>", NULL);
+
+	/* the serialized documents in the ARF */
+	const char *doc = "\xEF\xBB\xBF<?xml version='1.0' encoding='utf-8'?>\n"
+			  "<!-- leading -->\n<a xmlns=\"urn:a\">\n  <b>x</b>\n</a>\n<!-- trailing -->\n";
+	check_write(doc, strlen(doc),
+		    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<content>\n  "
+		    "<a xmlns=\"urn:a\">\n  <b>x</b>\n</a>\n</content>\n");
+
+	doc = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n<a>\xE9</a>\n";
+	check_write(doc, strlen(doc),
+		    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<content>\n  <a>\xC3\xA9</a>\n</content>\n");
+
+	doc = "<?xml version=\"1.0\"?>\n<!DOCTYPE a [<!ENTITY e \"x&f;\"><!ENTITY f \"<b>y</b>\">]>\n<a>&e;&amp;</a>\n";
+	check_write(doc, strlen(doc),
+		    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<content>\n  <a>x<b>y</b>&amp;</a>\n</content>\n");
+
+	check_unstarted();
+
+	oscap_cleanup();
+	return failures == 0 ? 0 : 1;
+}
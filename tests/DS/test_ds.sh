@@ -250,6 +250,13 @@ function test_rds
         ret_val=1
     fi
 
+    # The embedded documents are streamed into the ARF
+    $OSCAP ds rds-validate "$DS_FILE"
+
+    if [ $? -ne 0 ]; then
+        ret_val=1
+    fi
+
     assert_correct_xlinks $DS_FILE
 
     #pushd "$DS_TARGET_DIR"
@@ -332,6 +339,45 @@ function test_rds_split {
     return 0
 }
 
+# The components are split straight from their ranges in the data stream.
+# They have to be the same as the ones split from the DOM of the whole data
+# stream, which is parsed when the data stream has a DOCTYPE or when it is
+# not encoded in UTF-8. The validation is skipped since sds_ranges/sds.xml
+# uses foreign attributes and elements which the schemas don't allow.
+function test_sds_split_ranges {
+
+    local DS_FILE="$(cd "$(dirname "${srcdir}/$1")" && pwd)/$(basename "$1")"
+    local ASCII_ONLY="$2"
+    local WORK_DIR="`mktemp -d`"
+    local variants="ranges doctype"
+
+    cp "$DS_FILE" "$WORK_DIR/ranges.xml"
+    sed '1a <!DOCTYPE ds:data-stream-collection>' "$DS_FILE" > "$WORK_DIR/doctype.xml"
+    if [ "$ASCII_ONLY" == "1" ]; then
+        sed '1s/encoding="[^"]*"/encoding="ISO-8859-1"/' "$DS_FILE" > "$WORK_DIR/latin1.xml"
+        variants="$variants latin1"
+    fi
+
+    for variant in $variants; do
+        mkdir "$WORK_DIR/$variant"
+        pushd "$WORK_DIR/$variant"
+        $OSCAP ds sds-split --skip-valid "$WORK_DIR/$variant.xml" "$WORK_DIR/$variant"
+        rm -f oscap_debug.log.*
+        popd
+    done
+
+    for variant in $variants; do
+        if ! diff -r "$WORK_DIR/ranges" "$WORK_DIR/$variant"; then
+            echo "The components split from ranges differ from the $variant ones!"
+            echo
+            return 1
+        fi
+    done
+
+    rm -r "$WORK_DIR"
+    return 0
+}
+
 # Testing.
 test_init "test_ds.log"
 
@@ -345,6 +391,10 @@ test_run "sds_extended_component" test_sds sds_extended_component fake-check-xcc
 test_run "sds_extended_component_plain_text" test_sds sds_extended_component_plain_text fake-check-xccdf.xml 0
 test_run "sds_extended_component_plain_text_entities" test_sds sds_extended_component_plain_text_entities fake-check-xccdf.xml 0
 test_run "sds_extended_component_plain_text_whitespace" test_sds sds_extended_component_plain_text_whitespace fake-check-xccdf.xml 0
+test_run "sds_split_ranges_simple" test_sds_split_ranges eval_simple/sds.xml 0
+test_run "sds_split_ranges_complex" test_sds_split_ranges eval_xccdf_id/sds-complex.xml 1
+test_run "sds_split_ranges_cpe" test_sds_split_ranges cpe_in_ds/sds.xml 0
+test_run "sds_split_ranges" test_sds_split_ranges sds_ranges/sds.xml 1
 
 test_run "eval_simple" test_eval eval_simple/sds.xml
 test_run "cpe_in_ds" test_eval cpe_in_ds/sds.xml
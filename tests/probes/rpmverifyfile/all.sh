@@ -5,4 +5,5 @@
 test_init "test_probes_rpmverifyfile.log"
 test_run "rpmverifyfile probe test with OVAL 5.11.1" $srcdir/test_probes_rpmverifyfile.sh
 test_run "rpmverifyfile probe test with OVAL 5.11" $srcdir/test_probes_rpmverifyfile_older.sh
+test_run "rpmverifyfile probe test of file owners" $srcdir/test_probes_rpmverifyfile_owners.sh
 test_exit
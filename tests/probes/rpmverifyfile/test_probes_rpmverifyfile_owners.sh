@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+
+# Copyright 2026 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+#
+# The files of several packages are verified by concurrent threads. The
+# owners of files not owned by root are looked up by librpm, the items have
+# to be the same as when the packages are verified by a single thread.
+
+. ../../test_common.sh
+
+set -e -o pipefail
+
+function test_probes_rpmverifyfile_owners {
+    probecheck "rpmverifyfile" || return 255
+    require "rpm" || return 255
+
+    DF="test_probes_rpmverifyfile_owners.xml"
+    RF="results.xml"
+
+    rm -f $DF $RF serial-$RF
+
+    # packages with files owned by other users or groups than root, and a
+    # few more, so that there are several packages to verify in parallel
+    local OWNED=`rpm -qa --qf '[%{FILEUSERNAME}:%{FILEGROUPNAME} %{NAME}\n]' | \
+        awk '$1 != "root:root" { print $2 }' | sort -u | head -n 4`
+    if [ -z "$OWNED" ]; then
+        echo "No package with files not owned by root found!"
+        return 255
+    fi
+    local OTHERS=`rpm -qa --qf '%{NAME}\n' | sort -u | head -n 3`
+    local NAMES=$(echo $OWNED $OTHERS | tr ' ' '\n' | sort -u | \
+        sed 's/[.+]/\\&/g' | paste -s -d '|')
+
+    cat > $DF <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:lin-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux">
+  <generator>
+    <oval:schema_version>5.11.1</oval:schema_version>
+    <oval:timestamp>2026-10-16T00:00:00-00:00</oval:timestamp>
+  </generator>
+  <definitions>
+    <definition id="oval:x:def:1" version="1" class="miscellaneous">
+      <metadata>
+        <title>Verify the owners of the files of several packages.</title>
+        <description>Evaluate to ...</description>
+      </metadata>
+      <criteria>
+        <criterion comment="Verify the owners of the files" test_ref="oval:x:tst:1"/>
+      </criteria>
+    </definition>
+  </definitions>
+  <tests>
+    <lin-def:rpmverifyfile_test id="oval:x:tst:1" version="1" comment="Test" check="all">
+      <lin-def:object object_ref="oval:x:obj:1"/>
+    </lin-def:rpmverifyfile_test>
+  </tests>
+  <objects>
+    <lin-def:rpmverifyfile_object id="oval:x:obj:1" version="1" comment="Object">
+      <lin-def:behaviors nolinkto="true" nosize="true" nomtime="true" nomode="true" nordev="true" nofiledigest="true" nocaps="true"/>
+      <lin-def:name operation="pattern match">^($NAMES)\$</lin-def:name>
+      <lin-def:epoch operation="pattern match"/>
+      <lin-def:version operation="pattern match"/>
+      <lin-def:release operation="pattern match"/>
+      <lin-def:arch operation="pattern match"/>
+      <lin-def:filepath operation="pattern match">.*</lin-def:filepath>
+    </lin-def:rpmverifyfile_object>
+  </objects>
+</oval_definitions>
+EOF
+
+    OSCAP_PROBE_COLLECT_THREADS=4 $OSCAP oval eval --results $RF $DF
+    OSCAP_PROBE_COLLECT_THREADS=1 $OSCAP oval eval --results serial-$RF $DF
+
+    result=$RF
+    sd='oval_results/results/system/oval_system_characteristics/system_data/'
+    [ "`$XPATH $RF 'count('$sd'lin-sys:rpmverifyfile_item/lin-sys:ownership_differs[text()!="not performed"])'`" != "0" ]
+    [ "`$XPATH $RF 'count('$sd'lin-sys:rpmverifyfile_item/lin-sys:group_differs[text()!="not performed"])'`" != "0" ]
+
+    diff <(sed -n '/<system_data>/,/<\/system_data>/p' serial-$RF) \
+         <(sed -n '/<system_data>/,/<\/system_data>/p' $RF)
+
+    rm -f $DF $RF serial-$RF
+}
+
+test_probes_rpmverifyfile_owners
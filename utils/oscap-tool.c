@@ -34,6 +34,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <cvss_score.h>
 #include <oscap_debug.h>
 
@@ -264,6 +265,25 @@ int oscap_module_call(struct oscap_action *action)
     return OSCAP_UNIMPL_MOD;
 }
 
+/*
+ * Report how many collected objects the probes took from the persistent
+ * cache. The counters are complete once the probes have been closed.
+ */
+static void oscap_print_probe_cache_stats(void)
+{
+	const char *dir = getenv("OSCAP_PROBE_CACHE_DIR");
+	uint64_t lookups, hits;
+
+	if (dir == NULL || dir[0] == '\0')
+		return;
+
+	oval_probe_cache_stats(&lookups, &hits);
+
+	if (lookups > 0)
+		fprintf(stderr, "Probe cache %s: %"PRIu64" of %"PRIu64" objects found (%.1f%% hit rate)\n",
+		        dir, hits, lookups, 100.0 * (double)hits / (double)lookups);
+}
+
 static void getopt_parse_env(struct oscap_module *module, int *argc, char ***argv)
 {
 	int ofs, nargc, eargc;
@@ -344,6 +364,7 @@ int oscap_module_process(struct oscap_module *module, int argc, char **argv)
 
         if (module->func) {
             ret = oscap_module_call(&action);
+            oscap_print_probe_cache_stats();
             goto cleanup;
         }
         else if (module->submodules) {